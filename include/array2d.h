@@ -29,17 +29,20 @@
 #include "ctsupport.h"
 
 
+// The columns are stored one after another in a single aligned block, so
+// the whole array may also be used as one span of size() elements from data().
+
 template<class T>
 class Array2d {
  public:
     Array2d (unsigned int x, unsigned int y)
-        : m_nx(x), m_ny(y), array_data(0)
+        : m_nx(x), m_ny(y), array_data(0), m_pBlock(0)
         {
             allocArray();
         }
 
     Array2d ()
-        : m_nx(0), m_ny(0), array_data(0)
+        : m_nx(0), m_ny(0), array_data(0), m_pBlock(0)
         {}
 
     ~Array2d ()
@@ -64,6 +67,12 @@ class Array2d {
     T getPoint (unsigned int x, unsigned int y) const
         { return (array_data ? array_data[x][y] : NULL); }
 
+    T* data () const
+        { return m_pBlock; }
+
+    size_t size () const
+        { return static_cast<size_t>(m_nx) * m_ny; }
+
     unsigned int sizeofPixel () const
         {  return sizeof(T); }
 
@@ -78,24 +87,27 @@ class Array2d {
     unsigned int m_nx;
     unsigned int m_ny;
     T** array_data;
+    T* m_pBlock;
 
+    // T is a plain numeric type, so the block needs no construction
     void allocArray ()
         {
             if (array_data)
                 deleteArray();
 
+            m_pBlock = static_cast<T*>(alignedAlloc (sizeof(T) * size()));
             array_data = new T*[m_nx];
 
             for (unsigned int i = 0; i < m_nx; i++)
-                array_data[i] = new T[m_ny];
+                array_data[i] = m_pBlock + static_cast<size_t>(i) * m_ny;
         }
 
     void deleteArray ()
         {
             if (array_data) {
-                for (unsigned int i = 0; i < m_nx; i++)
-                    delete array_data [i];
-                delete array_data;
+                alignedFree (m_pBlock);
+                m_pBlock = NULL;
+                delete [] array_data;
                 array_data = NULL;
             }
         }
@@ -40,6 +40,7 @@
 #include <vector>
 #include "ctsupport.h"
 #include "fnetorderstream.h"
+#include "arraycodec.h"
 #include "array2d.h"
 
 class Array2dFileLabel
@@ -165,6 +166,10 @@ public:
   kuint32 ny (void) const
   { return m_ny; }
 
+  // Number of pixels of the real or of the imaginary array
+  size_t size (void) const
+  { return static_cast<size_t>(m_nx) * m_ny; }
+
   bool isComplex() const
   { return m_dataType == DATA_TYPE_COMPLEX; }
 
@@ -177,6 +182,13 @@ public:
   void setDataType (int dataType)
   { m_dataType = dataType; }
 
+  // ArrayCodec of the pixels written by fileWrite, CODEC_NONE for the plain file format
+  void setCompression (int idCodec)
+  { m_iCompression = idCodec; }
+
+  int compression () const
+  { return m_iCompression; }
+
   void setAxisIncrement (double axisIncX, double axisIncY);
 
   bool reallocRealToComplex ();
@@ -200,10 +212,31 @@ public:
 
   bool fileRead (const std::string& filename);
 
+  // Maps the pixels of a plain file instead of reading them. Pixels that are
+  // changed are copied in memory and never written to the file, unless
+  // bReadOnly is set, when the pixels must not be changed. Files that can
+  // not be mapped, such as compressed files, are read with fileRead.
+  bool fileReadMapped (const char* const filename, bool bReadOnly = false);
+
+  bool isMapped () const
+  { return m_pMap != NULL; }
+
   bool fileWrite (const char* const filename);
 
   bool fileWrite (const std::string& filename);
 
+  // Read or write the dataset at the origin of an open stream
+  bool fileRead (frnetorderstream& fs);
+
+  bool fileWrite (frnetorderstream& fs);
+
+  // Write a file of iTotalNX columns, one band of this object's columns at a time
+  bool fileBandWriteBegin (const char* const filename, int iTotalNX);
+
+  bool fileBandWrite (int iStartColumn, int iNumColumns);
+
+  bool fileBandWriteEnd ();
+
   const std::string& getFilename (void) const
   {  return m_filename; }
 
@@ -221,6 +254,8 @@ protected:
          typedef std::vector<Array2dFileLabel*> labelContainer;
 
    static const kuint16 m_signature;
+   static const kuint16 m_signatureCompressed;
+   static const kuint32 s_nCompressedBlockColumns;
    kuint16 m_headersize;
    std::string  m_filename;
 
@@ -237,8 +272,17 @@ protected:
    labelContainer m_labels;
    kuint16 m_numFileLabels;
    kuint16 m_dataType;
-   unsigned char** m_arrayData;
+   unsigned char** m_arrayData;             // Column pointers into m_pArrayBlock
    unsigned char** m_imaginaryArrayData;
+   unsigned char* m_pArrayBlock;            // Aligned pixels of all columns
+   unsigned char* m_pImaginaryArrayBlock;
+   void* m_pMap;                            // Mapped file holding the blocks from fileReadMapped
+   size_t m_nMapBytes;
+   frnetorderstream* m_pBandStream;
+   kuint32 m_bandTotalNX;
+   int m_iCompression;
+   kuint32 m_nBlockColumns;              // Columns compressed together
+   std::vector<kuint64> m_vecBlockOffset;  // File offsets of the compressed blocks and of the labels
 
 private:
   void init (void);
@@ -255,13 +299,22 @@ private:
 
   bool labelsWrite (frnetorderstream& fs);
 
+  off_t labelsOffset () const;
+
+  bool arrayDataReadCompressed (frnetorderstream& fs);
+
+  bool arrayDataWriteCompressed (frnetorderstream& fs);
+
   bool labelSeek (int label_num);
 
   void allocArrays ();
   void freeArrays ();
 
-  void allocArray (unsigned char**& rppData);
-  void freeArray (unsigned char**& rppData);
+  void allocArray (unsigned char**& rppData, unsigned char*& rpBlock);
+  void freeArray (unsigned char**& rppData, unsigned char*& rpBlock);
+  void setColumns (unsigned char**& rppData, unsigned char* pBlock);
+  bool isMappedBlock (const unsigned char* pBlock) const;
+  void unmapArrays ();
 
   Array2dFile (const Array2dFile& rhs);        // copy constructor
   Array2dFile& operator= (const Array2dFile&); // assignment operator
@@ -0,0 +1,71 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:          arraycodec.h
+**   Purpose:       Header file for compression of floating point arrays
+**   Programmer:    Kevin Rosenberg
+**   Date Started:  October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef ARRAYCODEC_H
+#define ARRAYCODEC_H
+
+#include <vector>
+#include <string>
+
+
+// Encodes arrays of 4 or 8 byte floating point values for the compressed
+// projection and image files. Encoded arrays are little endian on every
+// host, as are the uncompressed files.
+//
+//   none      Values unchanged
+//   deflate   Bytes of the values grouped by significance, then deflated.
+//             Lossless.
+//   float16   Values rounded to IEEE half precision, then grouped and
+//             deflated. About three decimal digits are kept and magnitudes
+//             above 65504 become infinite.
+class ArrayCodec {
+public:
+  static const int CODEC_INVALID;
+  static const int CODEC_NONE;
+  static const int CODEC_DEFLATE;
+  static const int CODEC_FLOAT16;
+
+  static int getCodecCount() {return s_iCodecCount;}
+  static const char* const* getCodecNameArray() {return s_aszCodecName;}
+  static const char* const* getCodecTitleArray() {return s_aszCodecTitle;}
+  static int convertCodecNameToID (const char* const codecName);
+  static const char* convertCodecIDToName (const int codecID);
+  static const char* convertCodecIDToTitle (const int codecID);
+
+  // True when the codec can be used, compressing codecs need zlib
+  static bool isAvailable (int idCodec);
+
+  static bool encode (int idCodec, const void* pValues, size_t nValues, size_t valueSize,
+                      std::vector<unsigned char>& vecEncoded);
+  static bool decode (int idCodec, const unsigned char* pEncoded, size_t nEncodedBytes,
+                      void* pValues, size_t nValues, size_t valueSize);
+
+private:
+  static const char* const s_aszCodecName[];
+  static const char* const s_aszCodecTitle[];
+  static const int s_iCodecCount;
+};
+
+#endif
@@ -33,6 +33,7 @@
 
 
 class Backproject;
+class SystemMatrix;
 class ImageFile;
 class Projections;
 struct ReconstructionROI;
@@ -45,6 +46,7 @@ class Backprojector
   static const int BPROJ_TABLE;
   static const int BPROJ_DIFF;
   static const int BPROJ_IDIFF;
+  static const int BPROJ_MATRIX;
 
   static const int INTERP_INVALID;
   static const int INTERP_NEAREST;
@@ -198,6 +200,31 @@ class BackprojectIntDiff : public BackprojectDiff
   void BackprojectView (const double* const t, const double view_angle);
 };
 
+
+// Transpose of the SystemMatrix, parallel geometry only
+class BackprojectMatrix : public Backproject
+{
+ public:
+  BackprojectMatrix (const Projections& proj, ImageFile& im, int interpID, const int interpFactor, const ReconstructionROI* pROI);
+  virtual ~BackprojectMatrix ();
+
+  virtual void BackprojectView (const double* const t, const double view_angle);
+  virtual void PostProcessing (); // call after backprojecting all views
+
+  bool fail() const {return m_bFail;}
+  const std::string& failMessage() const {return m_strFailMessage;}
+
+ protected:
+  SystemMatrix* m_pMatrix;
+  std::vector<double> m_vecImage;
+  std::vector<double> m_vecRaysums;
+  int m_iLastView;
+  bool m_bFail;
+  std::string m_strFailMessage;
+
+  int findView (double viewAngle);
+};
+
 class BackprojectEquilinear : public BackprojectTable
 {
  public:
@@ -162,6 +162,8 @@ extern "C" {
 
 #include "ctsupport.h"
 #include "fnetorderstream.h"
+#include "workerthreads.h"
+#include "arraycodec.h"
 
 #ifdef HAVE_SGP
   #include "ezplot.h"
@@ -180,6 +182,10 @@ extern "C" {
 #include "procsignal.h"
 #include "projections.h"
 #include "reconstruct.h"
+#include "systemmatrix.h"
+#include "parallelrebin.h"
+#include "helicalweights.h"
+#include "volumefile.h"
 #include "plotfile.h"
 #include "trace.h"
 
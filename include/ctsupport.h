@@ -44,6 +44,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <new>
 
 #if defined(MSVC) || HAVE_SSTREAM
 #include <sstream>
@@ -137,6 +138,12 @@ typedef unsigned char kuint8;
     typedef double kfloat64;
 #endif
 
+#ifdef MSVC
+    typedef unsigned __int64 kuint64;
+#else
+    typedef unsigned long long kuint64;
+#endif
+
 
 inline const char*
 fileBasename (const char* const filename)
@@ -237,6 +244,28 @@ inline void minmax_array (const T* array, const int n, T& min, T& max)
       max = array[i];
 }
 
+// Memory aligned to ALIGNED_ALLOC_BYTES, a cache line and the widest vector
+// registers, for pixel and sample arrays. Throws std::bad_alloc like new
+// when memory is exhausted. Freed with alignedFree.
+#define ALIGNED_ALLOC_BYTES 64
+
+inline void* alignedAlloc (size_t nBytes)
+{
+  char* pAlloc = static_cast<char*>(malloc (nBytes + ALIGNED_ALLOC_BYTES + sizeof(void*)));
+  if (! pAlloc)
+    throw std::bad_alloc();
+  size_t iAligned = reinterpret_cast<size_t>(pAlloc + sizeof(void*) + ALIGNED_ALLOC_BYTES - 1) & ~static_cast<size_t>(ALIGNED_ALLOC_BYTES - 1);
+  void** ppAligned = reinterpret_cast<void**>(iAligned);
+  ppAligned[-1] = pAlloc;       // the start of the allocation precedes the aligned block
+  return ppAligned;
+}
+
+inline void alignedFree (void* p)
+{
+  if (p)
+    free (static_cast<void**>(p)[-1]);
+}
+
 
 //////////////////////////////////////////////////////////////
 // FUNTION DECLARATIONS
@@ -113,11 +113,44 @@ SwapBytes8IfLittleEndian (void* buffer)
 void ConvertNetworkOrder (void* buffer, size_t bytes);
 void ConvertReverseNetworkOrder (void* buffer, size_t bytes);
 
+// Reverses the bytes of each of nElements elements of 2, 4 or 8 bytes
+void SwapBytesArray (void* buffer, size_t nElements, size_t elementSize);
+
 using std::fstream;
 class fnetorderstream : public fstream {
  public:
   fnetorderstream (const char* filename, std::ios::openmode mode)
-          : fstream (filename, mode) {}
+          : fstream (streamFilename (filename, mode), streamMode (filename, mode)),
+            m_origin(0), m_bSequential (isStandardStream (filename)), m_pos(0) {}
+
+  // The filename "-" is the standard output when opened for writing and
+  // the standard input otherwise. Such streams may be pipes, so they are
+  // sequential: positions are counted as bytes pass, seeking forward skips
+  // or writes zero bytes and seeking backward fails.
+  static bool isStandardStream (const char* const filename)
+      { return filename[0] == '-' && filename[1] == 0; }
+  bool isSequential () const
+      { return m_bSequential; }
+
+  // Positions are relative to the origin, the start of a dataset stored
+  // inside a larger file such as a VolumeFile
+  void setOrigin (std::streamoff origin)
+      { m_origin = origin; }
+  std::streamoff origin () const
+      { return m_origin; }
+  fnetorderstream& seekg (std::streamoff pos);
+  fnetorderstream& seekp (std::streamoff pos);
+  std::streamoff tellg ()
+      { if (m_bSequential) return m_pos;
+        std::streamoff pos = fstream::tellg(); return pos < 0 ? pos : pos - m_origin; }
+  std::streamoff tellp ()
+      { if (m_bSequential) return m_pos;
+        std::streamoff pos = fstream::tellp(); return pos < 0 ? pos : pos - m_origin; }
+
+  fnetorderstream& read (char* s, std::streamsize n)
+      { fstream::read (s, n); m_pos += gcount(); return *this; }
+  fnetorderstream& write (const char* s, std::streamsize n)
+      { fstream::write (s, n); if (! fail()) m_pos += n; return *this; }
 
   ~fnetorderstream (void)
       {}
@@ -131,6 +164,22 @@ class fnetorderstream : public fstream {
   virtual void  readInt32 (kuint32& n);
   virtual void  readFloat32 (kfloat32& n);
   virtual void  readFloat64 (kfloat64& n);
+
+  // Arrays of elements of 2, 4 or 8 bytes with one read or write
+  virtual void writeArray (const void* buffer, size_t nElements, size_t elementSize);
+  virtual void readArray (void* buffer, size_t nElements, size_t elementSize);
+
+ protected:
+  void writeArraySwapped (const void* buffer, size_t nElements, size_t elementSize, bool bSwap);
+  void readArraySwapped (void* buffer, size_t nElements, size_t elementSize, bool bSwap);
+
+ private:
+  std::streamoff m_origin;
+  bool m_bSequential;
+  std::streamoff m_pos;         // Bytes passed of a sequential stream
+
+  static const char* streamFilename (const char* filename, std::ios::openmode mode);
+  static std::ios::openmode streamMode (const char* filename, std::ios::openmode mode);
 };
 
 
@@ -148,6 +197,9 @@ class frnetorderstream : public fnetorderstream {
   virtual void readInt32 (kuint32& n);
   virtual void readFloat32 (kfloat32& n);
   virtual void readFloat64 (kfloat64& n);
+
+  virtual void writeArray (const void* buffer, size_t nElements, size_t elementSize);
+  virtual void readArray (void* buffer, size_t nElements, size_t elementSize);
 };
 
 #endif
@@ -0,0 +1,96 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**      Name:         helicalweights.h
+**      Purpose:      Weight tables for helical interpolation and half-scan feathering
+**      Programmer:   Kevin Rosenberg
+**      Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef __HELICALWEIGHTS_H
+#define __HELICALWEIGHTS_H
+
+#include <string>
+#include <vector>
+
+class Projections;
+class DetectorArray;
+
+
+// CLASS IDENTIFICATION
+//   ProjectionWeightMap
+//
+// PURPOSE
+//   Weights that produce a set of target views from source views. Each
+//   target sample is its own source sample, view iTargetView + offset,
+//   times a direct weight, plus a list of weighted source samples. Tables
+//   for Helical180LI and HalfScanFeather are built once per geometry and
+//   shared through a small cache.
+//
+// NOTES
+//   Fan angles of the detectors are taken as for the backprojectors: zero
+//   for parallel geometry, atan(pos/sourceDetectorLength) for equilinear
+//   and the detector position itself for equiangular geometry.
+
+class ProjectionWeightMap
+{
+ public:
+    static const int MAP_HELICAL_180LI;
+    static const int MAP_HALFSCAN_FEATHER;
+
+    // Finds or builds the table of a kind for the geometry of proj
+    static const ProjectionWeightMap* acquire (const Projections& proj, int idMap, std::string& strFailMessage);
+    static void release (const ProjectionWeightMap* pMap);
+    static void clearCache ();
+
+    static std::string makeKey (const Projections& proj, int idMap);
+
+    int nTargetView() const {return m_nTargetView;}
+    int nSourceView() const {return m_nSourceView;}
+    int nDet() const {return m_nDet;}
+
+    // Computes target view iTargetView from the source views starting at iSourceOffset
+    void applyView (const Projections& proj, int iSourceOffset, int iTargetView, DetectorArray& rTarget) const;
+    // Computes all views of rTarget, divided among nThreads threads
+    void apply (const Projections& proj, int iSourceOffset, Projections& rTarget, int nThreads = 1) const;
+
+ private:
+    std::string m_strKey;
+    int m_iReferences;
+    int m_nTargetView;
+    int m_nSourceView;
+    int m_nDet;
+    std::vector<double> m_vecDirectWeight;   // nTargetView * nDet
+    std::vector<kuint32> m_vecRowStart;      // nTargetView * nDet + 1
+    std::vector<kuint32> m_vecSource;        // iSourceView * nDet + iDet
+    std::vector<double> m_vecWeight;
+
+    static std::vector<ProjectionWeightMap*> s_vecCache;
+    static const unsigned int s_nMaxCacheEntries;
+
+    ProjectionWeightMap ();
+
+    bool buildHelical180LI (const Projections& proj, std::string& strFailMessage);
+    bool buildHalfScanFeather (const Projections& proj, std::string& strFailMessage);
+
+    ProjectionWeightMap (const ProjectionWeightMap& rhs);
+    ProjectionWeightMap& operator= (const ProjectionWeightMap& rhs);
+};
+
+#endif
@@ -59,6 +59,13 @@ public:
   kfloat32** const getImaginaryArray (void) const
        { return (kfloat32** const) (m_imaginaryArrayData); }
 
+  // All pixels, column after column, size() values
+  kfloat32* data (void) const
+      { return reinterpret_cast<kfloat32*>(m_pArrayBlock); }
+
+  kfloat32* imaginaryData (void) const
+      { return reinterpret_cast<kfloat32*>(m_pImaginaryArrayBlock); }
+
 #ifdef HAVE_MPI
   MPI::Datatype getMPIDataType (void) const
       { return MPI::FLOAT; }
@@ -89,6 +96,13 @@ class F64Image : public Array2dFile
   kfloat64** const getImaginaryArray (void) const
       { return (kfloat64** const) (m_imaginaryArrayData); }
 
+  // All pixels, column after column, size() values
+  kfloat64* data (void) const
+      { return reinterpret_cast<kfloat64*>(m_pArrayBlock); }
+
+  kfloat64* imaginaryData (void) const
+      { return reinterpret_cast<kfloat64*>(m_pImaginaryArrayBlock); }
+
 #ifdef HAVE_MPI
   MPI::Datatype getMPIDataType (void) const
       { return MPI::DOUBLE; }
@@ -27,11 +27,17 @@
 #include <vector.h>
 #include <string>
 
+// Processes may run worker threads, but only the thread that made the
+// MPIWorld makes MPI calls (MPI_THREAD_FUNNELED)
 class MPIWorld
 {
  public:
     MPIWorld (int& argc, char* const *& argv);
 
+    // True when the MPI library allows threads in the processes
+    bool threadsSupported (void) const
+        { return m_iThreadSupport >= MPI::THREAD_FUNNELED; }
+
     void setTotalWorkUnits (int totalUnits);
 
     int getRank (void) const
@@ -66,6 +72,7 @@ class MPIWorld
 private:
     int m_myRank;
     int m_nProcessors;
+    int m_iThreadSupport;
     vector<int> m_vLocalWorkUnits;
     vector<int> m_vStartWorkUnit;
     vector<int> m_vEndWorkUnit;
@@ -0,0 +1,109 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**      Name:         parallelrebin.h
+**      Purpose:      Rebinning of divergent beam projections to parallel geometry
+**      Programmer:   Kevin Rosenberg
+**      Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef __PARALLELREBIN_H
+#define __PARALLELREBIN_H
+
+#include <string>
+#include <vector>
+
+class Projections;
+class DetectorArray;
+struct ParallelRebinTable;
+
+
+// CLASS IDENTIFICATION
+//   ParallelRebinner
+//
+// PURPOSE
+//   Rebins equiangular and equilinear projections to parallel geometry.
+//   Each parallel ray (theta,t) is the divergent ray with fan angle
+//   gamma = asin(t/F) at gantry angle beta = theta - gamma, so the two
+//   source views and detectors of every parallel raysum and their bilinear
+//   weights are computed directly from the scanner geometry.
+//
+// NOTES
+//   The tables are shared by all rebinners of the same geometry and kept in
+//   a small cache, so repeated rebinning of a geometry only reads them.
+//   Scans that do not cover a full rotation use the complementary ray at
+//   beta + pi + 2*gamma when the direct ray was not measured. Views may be
+//   rebinned one at a time so the parallel projections need not be stored.
+
+class ParallelRebinner
+{
+ public:
+    ParallelRebinner (const Projections& rProj, int nThreads = 1);
+
+    ~ParallelRebinner ();
+
+    bool fail() const {return m_bFail;}
+    const std::string& failMessage() const {return m_strFailMessage;}
+
+    bool fromCache() const {return m_bFromCache;}
+    const std::string& key() const {return m_strKey;}
+
+    int nView() const {return m_nView;}
+    int nDet() const {return m_nDet;}
+    double rotStart() const {return m_dRotStart;}
+    double rotInc() const {return m_dRotInc;}
+    double detStart() const {return m_dDetStart;}
+    double detInc() const {return m_dDetInc;}
+
+    // Parallel projections with the rebinned geometry, views are only allocated when requested
+    Projections* newParallelProjections (bool bAllocateViews = true) const;
+
+    // Fills a parallel view, rDetArray must hold nDet detectors
+    void rebinView (int iView, DetectorArray& rDetArray) const;
+    // Fills all views of projections from newParallelProjections
+    void rebinViews (Projections& rParallelProj, int nThreads = 1) const;
+
+    static std::string makeKey (const Projections& proj);
+    static void clearCache ();
+
+ private:
+    const Projections& m_rProj;
+    bool m_bFail;
+    std::string m_strFailMessage;
+    std::string m_strKey;
+    bool m_bFromCache;
+    int m_nView;
+    int m_nDet;
+    double m_dRotStart;
+    double m_dRotInc;
+    double m_dDetStart;
+    double m_dDetInc;
+    ParallelRebinTable* m_pTable;
+
+    static std::vector<ParallelRebinTable*> s_vecCache;
+    static const unsigned int s_nMaxCacheEntries;
+
+    void buildTable (ParallelRebinTable& table, int nThreads) const;
+    static void releaseTable (ParallelRebinTable* pTable);
+
+    ParallelRebinner (const ParallelRebinner& rhs);
+    ParallelRebinner& operator= (const ParallelRebinner& rhs);
+};
+
+#endif
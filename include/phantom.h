@@ -27,6 +27,7 @@
 #define PHANTOM_H
 
 #include <list>
+#include <vector>
 #include "ctsupport.h"
 
 typedef enum {
@@ -41,6 +42,17 @@ typedef enum {
 /* Codes for Coordinate Types      */
 /* Defines coords for isPointInside() */
 
+// Parameters of a PhantomElement at a time within a scan. Time is the
+// fraction of the scan, from 0 at the first view to 1 at the last view.
+
+struct PhantomKeyframe {
+  double m_dTime;
+  double m_cx, m_cy;
+  double m_u, m_v;
+  double m_rot;            // degrees
+  double m_atten;
+};
+
 typedef enum {
   PELEM_COORD,         /* Normalized PElem Coordinates */
   PHM_COORD           /* World phantom Coordinates */
@@ -60,6 +72,12 @@ class PhantomElement
 
     bool clipLineWorldCoords (double& x1, double& y1, double& x2, double& y2) const;
 
+    void addRaysums (const int nRays, const double* const x1, const double* const y1,
+                     const double* const x2, const double* const y2, double* const pdRaysum) const;
+
+    bool addStripRaysums (const int nStrips, const double* const xs, const double* const ys,
+                          const double* const xd, const double* const yd, double* const pdRaysum) const;
+
     const int nOutlinePoints() const {return m_nPoints;}
     double* rectLimits() {return m_rectLimits;}
     double* xOutline() {return m_xOutline;}
@@ -76,6 +94,11 @@ class PhantomElement
     const double cy() const {return m_cy;}
     const double u() const {return m_u;}
     const double v() const {return m_v;}
+    const char* const typeName() const {return convertTypeToName (m_type);}
+
+    void addKeyframe (const double dTime, const double cx, const double cy, const double u, const double v, const double rot, const double atten);
+    void getParametersAtTime (const double dTime, double& cx, double& cy, double& u, double& v, double& rot, double& atten) const;
+    bool isDynamic () const {return m_vecKeyframes.size() > 0;}
 
     static PhmElemType convertNameToType (const char* const typeName);
 
@@ -96,6 +119,7 @@ class PhantomElement
     double* m_xOutline;
     double* m_yOutline;
     double  m_rectLimits[4];
+    std::vector<PhantomKeyframe> m_vecKeyframes;  // sorted by time, first is element's own parameters
 
     static const int POINTS_PER_CIRCLE;
     static const double SCALE_PELEM_EXTENT;  // increase pelem limits by 0.5%
@@ -112,6 +136,11 @@ class PhantomElement
 
     static int numCirclePoints (double theta);
 
+    static double chordUnitCircle (double h);
+    static double chordIntegralUnitCircle (double h);
+    static double chordUnitSquare (double h, double absUx, double absUy);
+    static double chordIntegralUnitSquare (double h, double absUx, double absUy);
+
     PhantomElement (const PhantomElement& rhs);        // copy constructor
     PhantomElement& operator= (const PhantomElement&); // assignment operator
 };
@@ -155,12 +184,16 @@ class Phantom
 
     bool createFromFile (const char* const fname);
 
+    bool createFromPhantomAtTime (const Phantom& phm, const double dTime);
+
     bool fileWrite (const char* const fname);
 
     void addPElem (const PhantomElement& pelem);
 
     void addPElem (const char* const composition, const double cx, const double cy, const double u, const double v, const double rot, const double atten);
 
+    bool addKeyframe (const double dTime, const double cx, const double cy, const double u, const double v, const double rot, const double atten);
+
     void convertToImagefile (ImageFile& im, double dViewRatio, const int in_nsample, const int trace) const;
     void convertToImagefile (ImageFile& im, double dViewRatio, const int in_nsample, const int trace,
       const int colStart, const int colCount, bool bStoreAtColumnPos) const;
@@ -200,6 +233,7 @@ class Phantom
           std::list<PhantomElement*>& listPElem() {return m_listPElem;}
     const std::list<PhantomElement*>& listPElem() const {return m_listPElem;}
     const int nPElem() const {return m_nPElem;}
+    bool isDynamic() const {return m_bDynamic;}
 
     static const int getPhantomCount() {return s_iPhantomCount;}
     static const char** getPhantomNameArray() {return s_aszPhantomName;}
@@ -215,6 +249,7 @@ class Phantom
     mutable std::list<PhantomElement*> m_listPElem;      // pelem lists
     std::string m_name;
     int m_id;
+    bool m_bDynamic;                        // true if any pelem has keyframes
     bool m_fail;
     std::string m_failMessage;
     static const char* s_aszPhantomName[];
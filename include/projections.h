@@ -30,6 +30,7 @@ class Scanner;
 class DetectorArray;
 class Array2dFileLabel;
 class fnetorderstream;
+struct ProjectionsFileMap;
 
 #include "array2dfile.h"
 #include "imagefile.h"
@@ -112,25 +113,50 @@ class Projections
   static const char* convertInterpIDToName (const int interpID);
   static const char* convertInterpIDToTitle (const int interpID);
 
-  void initFromScanner (const Scanner& scanner);
+  void initFromScanner (const Scanner& scanner, bool bStoreViews = true);
   bool initFromSomatomAR_STAR (int iNViews, int iNDets, unsigned char* pData, unsigned long lDataLength);
 
   void printProjectionData (int startView, int endView);
   void printProjectionData ();
   void printScanInfo (std::ostringstream& os) const;
 
-  int Helical180LI(int interpView);
-  int Helical180LI_Equiangular(int interpView);
-  int HalfScanFeather(void);
+  int Helical180LI (int interpView, int nThreads = 0);
+  int Helical180LI (int interpView, Projections& rSlice, int nThreads = 0) const;
+  int HalfScanFeather (int nThreads = 0);
 
   bool read (const std::string& fname);
   bool read (const char* fname);
+  // Maps the file, views are decoded as they are used and at most
+  // nCacheViews decoded views are kept, 0 keeps all decoded views
+  bool readMapped (const std::string& fname, int nCacheViews = 0);
+  bool readMapped (const char* fname, int nCacheViews = 0);
+  bool isMapped() const {return m_pFileMap != NULL;}
   bool write (const char* fname);
   bool write (const std::string& fname);
+  // Read or write the dataset at the origin of an open stream
+  bool read (fnetorderstream& fs);
+  bool write (fnetorderstream& fs);
+  // Read or write a file a number of views at a time, so views passing
+  // through a pipe are used while later views are being produced
+  bool readViewsBegin (const char* const fname, bool bStoreViews = true);
+  bool readViewsNext (int nViews);
+  bool readViewNext (DetectorArray& darray);
+  void readViewsEnd ();
+  bool writeViewsBegin (const char* const fname);
+  // Continues a file begun by writeViewsBegin for the same scan after its
+  // last complete multiple of nViewMultiple views, see nStreamedViews
+  bool writeViewsResume (const char* const fname, int nViewMultiple = 1);
+  bool writeViewsNext (int nViews);
+  bool writeViewsNext (const Projections& rViews, int nViews);
+  bool writeViewNext (const DetectorArray& darray);
+  bool writeViewsEnd ();
+  int nStreamedViews () const {return m_nStreamedViews;}
   bool detarrayRead (fnetorderstream& fs, DetectorArray& darray, const int view_num);
   bool detarrayWrite (fnetorderstream& fs, const DetectorArray& darray, const int view_num);
+  bool detarrayReadNext (fnetorderstream& fs, DetectorArray& darray);
+  bool detarrayWriteNext (fnetorderstream& fs, const DetectorArray& darray);
 
-  Projections* interpolateToParallel() const;
+  Projections* interpolateToParallel (int nThreads = 0) const;
 
   bool convertPolar (ImageFile& rIF, int iInterpolation);
   bool convertFFTPolar (ImageFile& rIF, int iInterpolation, int iZeropad);
@@ -143,11 +169,22 @@ class Projections
   bool reconstruct (ImageFile& im, const char* const filterName, double filt_param, const char* const filterMethodName, const int zeropad, const char* frequencyFilterName, const char* const interpName, int interp_param, const char* const backprojName, const int trace) const;
 
   void setNView (int nView);  // used in MPI to restrict # of views
+  // Header fields as numbers, so processes reading their own ranges of the
+  // views of a file share the header read by one of them
+  void getHeaderValues (std::vector<double>& vecValues) const;
+  bool setHeaderValues (const std::vector<double>& vecValues);
+  // Offset from the start of the dataset of the record of a view of a file
+  // whose header was read, the end of the views for iView == nView()
+  kuint64 viewRecordOffset (int iView) const;
+  // Fills the views from consecutive view records read from a file
+  bool decodeViewRecords (const unsigned char* pRecords, size_t nBytes);
   void setRotInc (double rotInc) { m_rotInc = rotInc;}
   void setDetInc (double detInc) { m_detInc = detInc;}
   void setCalcTime (double calcTime) {m_calcTime = calcTime;}
   void setRemark (const char* remark) {m_remark = remark; m_label.setLabelString(remark);}
   void setRemark (const std::string& remark) {setRemark(remark.c_str());}
+  // ArrayCodec used for the views by write, CODEC_NONE for the plain file format
+  void setCompression (int idCodec) {m_iCompression = idCodec;}
 
   double detStart() const {return m_detStart;}
   double rotStart() const {return m_rotStart;}
@@ -159,9 +196,11 @@ class Projections
   int nDet() const {return m_nDet;}
   int nView() const {return m_nView;}
   int geometry() const {return m_geometry;}
+  int compression() const {return m_iCompression;}
   double focalLength() const {return m_dFocalLength;}
   double sourceDetectorLength() const { return m_dSourceDetectorLength;}
   double viewDiameter() const {return m_dViewDiameter; }
+  double fanBeamAngle() const {return m_dFanBeamAngle; }
   double phmLen() const { return m_dViewDiameter / SQRT2; }
   void setPhmLen(double phmLen) { m_dViewDiameter = phmLen * SQRT2; }
 
@@ -170,10 +209,16 @@ class Projections
   const Array2dFileLabel& getLabel() const {return m_label;}
 
   DetectorArray& getDetectorArray (const int iview)
-      { return (*m_projData[iview]); }
+      { if (m_bDecodeViews) decodeMappedView (iview); return (m_projData[iview]); }
 
   const DetectorArray& getDetectorArray (const int iview) const
-      { return (*m_projData[iview]); }
+      { if (m_bDecodeViews) decodeMappedView (iview); return (m_projData[iview]); }
+
+  // All views, nView rows of nDet values, NULL for mapped projections
+  DetectorValue* getSinogram() {return m_pSinogram;}
+  const DetectorValue* getSinogram() const {return m_pSinogram;}
+  double* getViewAngles() {return m_pdViewAngle;}
+  const double* getViewAngles() const {return m_pdViewAngle;}
 
   static bool copyHeader (const char* const filename, std::ostream& os);
   static bool copyHeader (const std::string& filename, std::ostream& os);
@@ -184,7 +229,15 @@ class Projections
  private:
   int m_headerSize;             // Size of disk file header
   int m_geometry;               // Geometry of scanner
-  class DetectorArray **m_projData;     // Pointer to array of detarray_st pointers
+  DetectorValue* m_pSinogram;   // nView x nDet values, from alignedAlloc
+  double* m_pdViewAngle;        // Angle of each view
+  class DetectorArray *m_projData;      // Views of the rows of m_pSinogram or of the mapped file
+  ProjectionsFileMap* m_pFileMap;       // Mapped file from readMapped
+  bool m_bDecodeViews;          // Mapped views are decoded by getDetectorArray
+  int m_iCompression;           // ArrayCodec of the views in the file
+  std::vector<kuint64> m_vecViewOffset; // File offset of each view record and of the end, compressed files
+  fnetorderstream* m_pViewStream;       // File being read or written by views
+  int m_nStreamedViews;         // Views read or written of m_pViewStream
   std::string m_remark;         // description of raysum data
   int m_nDet;                   // number of detectors in array
   int m_nView;                  // number of rotated views
@@ -207,6 +260,7 @@ class Projections
   Array2dFileLabel m_label;
 
   const static kuint16 m_signature;
+  const static kuint16 m_signatureCompressed;
 
   static const char* const s_aszInterpName[];
   static const char* const s_aszInterpTitle[];
@@ -217,7 +271,12 @@ class Projections
   void newProjData ();
   void deleteProjData ();
 
-  void init (const int nView, const int nDet);
+  void init (const int nView, const int nDet, bool bStoreViews = true);
+  void copyHeaderFields (const Projections& proj);
+  void takeProjData (Projections& proj);
+  void decodeMappedView (int iView) const;
+
+  friend class ParallelRebinner;
 
   // prevent default methods
   Projections& operator= (const Projections& rhs);   // assignment
@@ -225,4 +284,75 @@ class Projections
 };
 
 
+// CLASS IDENTIFICATION
+//   ProjectionsWriter
+//
+// PURPOSE
+//   Writes the views of a scan to a projection file as they are collected.
+//   Views are collected into chunks of a few views, and a background thread
+//   appends each full chunk to the file while the next one is collected, so
+//   memory does not grow with the number of views and writing is hidden
+//   behind the projection calculations. Views reach the file as chunks are
+//   completed, and close() rewrites the header with the final calculation
+//   time.
+//
+// NOTES
+//   Without threads each chunk is written when it is completed. Each chunk
+//   is flushed once written, so a file left by a stopped job holds every
+//   chunk completed before it stopped and opening it with bResume continues
+//   the scan from there.
+
+class ProjectionsWriter
+{
+ public:
+  ProjectionsWriter (const Scanner& scanner, int nChunkViews = 16, int nChunks = 3);
+  ~ProjectionsWriter ();
+
+  // The remark and compression of the file are set here before open
+  Projections& getHeader () {return m_header;}
+  // With bResume the views of an interrupted file are kept, nResumedViews
+  // of them, and collection continues with the next view
+  bool open (const char* const filename, bool bResume = false);
+  int nResumedViews () const {return m_nResumedViews;}
+  // A chunk of nChunkViews views to collect the next views of the scan into,
+  // waiting while all chunks are being written
+  Projections& getChunk ();
+  // Queues the first nViews views of the chunk from getChunk for writing
+  bool writeChunk (int nViews);
+  // Waits for the queued chunks, finalizes the header and closes the file
+  bool close (double dCalcTime);
+
+  int nChunkViews () const {return m_nChunkViews;}
+  bool fail () const;
+
+  // Body of the background thread
+  void writeQueuedChunks ();
+
+ private:
+  void setFail ();
+
+  Projections m_header;
+  std::vector<Projections*> m_vecChunk;
+  int m_nChunkViews;
+  int m_nResumedViews;
+  int m_iCurrentChunk;
+  bool m_bOpen;
+  bool m_bFail;                 // Set by the background thread too
+#ifdef HAVE_PTHREAD
+  mutable pthread_mutex_t m_mutexFail;
+  struct ChunkWrite {
+    int m_iChunk;
+    int m_nViews;
+  };
+  BoundedQueue<int>* m_pQueueFree;
+  BoundedQueue<ChunkWrite>* m_pQueueWrite;
+  pthread_t m_idThread;
+  bool m_bThreadStarted;
+#endif
+
+  ProjectionsWriter (const ProjectionsWriter& rhs);
+  ProjectionsWriter& operator= (const ProjectionsWriter& rhs);
+};
+
+
 #endif
@@ -30,8 +30,15 @@ class Projections;
 class ImageFile;
 class Backprojector;
 class ProcessSignal;
+class WorkerThreads;
+class JosephProjector;
+class SystemMatrix;
+class ParallelRebinner;
+class DetectorArray;
 
 #include <string>
+#include <vector>
+#include "trace.h"
 
 struct ReconstructionROI {
   double m_dXMin;
@@ -42,9 +49,18 @@ struct ReconstructionROI {
 
 class Reconstructor
 {
+ public:
+    static const int METHOD_INVALID;
+    static const int METHOD_FBP;
+    static const int METHOD_SART;
+    static const int METHOD_OS_SART;
+    static const int METHOD_OS_EM;
+
  private:
     const Projections& m_rOriginalProj;
     const Projections* m_pProj;
+    ParallelRebinner* m_pRebinner;
+    DetectorArray* m_pRebinnedView;     // when views are rebinned as they are reconstructed
     ImageFile& m_rImagefile;
     ProcessSignal* m_pProcessSignal;
     Backprojector* m_pBackprojector;
@@ -53,9 +69,17 @@ class Reconstructor
     const bool m_bRebinToParallel;
     bool m_bFail;
     std::string m_strFailMessage;
+    int m_nBackprojectedViews;          // leading views of the scan summed into the image
+    int m_nCheckpointViews;
+    std::string m_strCheckpointFile;
 
     double* m_adPlotXAxis;
 
+    static const char* const s_szCheckpointLabel;
+
+    void viewBackprojected ();
+    bool writeCheckpoint ();
+
  public:
     Reconstructor (const Projections& rProj, ImageFile& rIF, const char* const filterName, double filt_param,
       const char* const filterMethodName, const int zeropad, const char* filterGenerationName,
@@ -73,6 +97,113 @@ class Reconstructor
 
     void reconstructView (int iStartView = 0, int iViewCount = -1, SGP* pSGP = NULL, bool bBackprojectView = true, double dGraphWidth = 1.);
     void postProcessing ();
+
+    // Reconstructors of the same scan that differ only in their image or
+    // ROI can share filtering: filterView fills nFilteredProjections()
+    // values and returns the view angle, which backprojectFilteredView of
+    // any of them sums into its image
+    int nFilteredProjections () const {return m_nFilteredProjections;}
+    double filterView (int iView, double* adFilteredProj);
+    void backprojectFilteredView (const double* adFilteredProj, double dViewAngle);
+
+    // Reads, filters and backprojects the views of a file opened by
+    // Projections::readViewsBegin on separate threads
+    bool reconstructStreamedViews (Projections& rProj, int nQueueViews = 16);
+
+    // Every nCheckpointViews views the partial image is written to a
+    // checkpoint file, which resumeCheckpoint reads back into the image of
+    // a new Reconstructor of the same scan, so reconstructAllViews and
+    // reconstructStreamedViews continue with the next view. Views must be
+    // reconstructed in order, and the matrix backprojector, which keeps its
+    // own image, can not be checkpointed.
+    void setCheckpoint (const char* const filename, int nCheckpointViews);
+    bool resumeCheckpoint (const char* const filename);
+    int nBackprojectedViews () const {return m_nBackprojectedViews;}
+
+    static const int getMethodCount() {return s_iMethodCount;}
+    static const char* const* getMethodNameArray() {return s_aszMethodName;}
+    static const char* const* getMethodTitleArray() {return s_aszMethodTitle;}
+    static int convertMethodNameToID (const char* const methodName);
+    static const char* convertMethodIDToName (const int methodID);
+    static const char* convertMethodIDToTitle (const int methodID);
+
+ private:
+    static const char* const s_aszMethodName[];
+    static const char* const s_aszMethodTitle[];
+    static const int s_iMethodCount;
+};
+
+
+// Algebraic (SART, OS-SART) and statistical (OS-EM) reconstruction. Each ray
+// is traced through the image by Joseph's method, and the correction is
+// spread back along the same weights so the backprojector is the exact
+// transpose of the forward projector. The image covers the same area as
+// filtered backprojection. Views are grouped in interleaved ordered subsets;
+// the rays of a subset are divided among worker threads.
+
+class IterativeReconstructor
+{
+ public:
+    IterativeReconstructor (const Projections& rProj, ImageFile& rIF, const char* const methodName,
+      int nSubsets = 1, double dRelaxation = 1., int nThreads = 1, const int iTrace = Trace::TRACE_NONE);
+
+    ~IterativeReconstructor ();
+
+    bool fail() const {return m_bFail;}
+    const std::string& failMessage() const {return m_strFailMessage;}
+
+    int getNumSubsets () const {return m_nSubsets;}
+
+    // Matrix must stay valid while reconstructing, NULL to trace rays
+    bool setSystemMatrix (const SystemMatrix* pMatrix);
+
+    // Process all subsets once, returns relative residual of the projections
+    double reconstructIteration ();
+    void reconstructIterations (int nIterations);
+
+    int getIterationCount () const {return m_vecIterationResidual.size();}
+    double getIterationResidual (int iIteration) const {return m_vecIterationResidual[iIteration];}
+    double getIterationTime (int iIteration) const {return m_vecIterationTime[iIteration];}
+
+ private:
+    const Projections& m_rProj;
+    ImageFile& m_rImagefile;
+    int m_idMethod;
+    int m_nSubsets;
+    double m_dRelaxation;
+    int m_iTrace;
+    bool m_bFail;
+    std::string m_strFailMessage;
+
+    int m_nx;
+    int m_ny;
+    double m_dXMin;
+    double m_dYMin;
+    double m_dXInc;
+    double m_dYInc;
+
+    JosephProjector* m_pProjector;
+    const SystemMatrix* m_pMatrix;
+    std::vector<double> m_vecImage;          // working image, pixel (ix,iy) at ix * ny + iy
+    WorkerThreads* m_pThreads;
+    std::vector<int> m_vecSubsetOrder;
+    std::vector<int> m_vecSubsetViews;       // views of the subset being processed
+    std::vector< std::vector<double> > m_vecThreadCorrection;
+    std::vector< std::vector<double> > m_vecThreadWeight;
+    std::vector<double> m_vecThreadResidual;
+    std::vector<double> m_vecThreadDataNorm;
+
+    std::vector<double> m_vecIterationResidual;
+    std::vector<double> m_vecIterationTime;
+
+    void processSubset (int iSubset);
+    void processRays (int iThread, int iStartRay, int iNumRays);
+    void copyImage ();
+
+    friend class IterativeSubsetTask;
+
+    IterativeReconstructor (const IterativeReconstructor& rhs);
+    IterativeReconstructor& operator= (const IterativeReconstructor& rhs);
 };
 
 #endif
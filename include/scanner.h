@@ -29,12 +29,15 @@
 #include "trace.h"
 
 class Projections;
+class ImageFile;
 class Phantom;
 class PhantomElement;
 class SGP;
 
 // Projections are collected along an array of ndet detectors.  The data
-// for these detectors is stored in the class DetectorArray
+// for these detectors is stored in the class DetectorArray. A DetectorArray
+// either owns its values or is a view of one row of the sinogram of a
+// Projections, whose values and view angle are attached to it.
 
 typedef float DetectorValue;
 
@@ -42,20 +45,25 @@ class DetectorArray
 {
  public:
   DetectorArray (const int ndet);
+  DetectorArray ();
   ~DetectorArray ();
 
+  void attach (DetectorValue* pDetValues, double* pdViewAngle, int nDet);
+
   const int nDet() const {return m_nDet;}
-  const double viewAngle() const {return m_viewAngle;}
+  const double viewAngle() const {return *m_pdViewAngle;}
   DetectorValue* detValues() {return m_detValues;}
   const DetectorValue* detValues() const {return m_detValues;}
 
   void setViewAngle (double viewAngle)
-      { m_viewAngle = viewAngle; }
+      { *m_pdViewAngle = viewAngle; }
 
  private:
   DetectorValue* m_detValues;   // Pointer to array of values recorded by detector
   int m_nDet;                   // Number of detectors in array */
   double m_viewAngle;           // View angle in radians
+  double* m_pdViewAngle;        // m_viewAngle or the angle of an attached view
+  bool m_bOwnValues;
 
   DetectorArray& operator=(const DetectorArray& rhs);   // assignment
   DetectorArray (const DetectorArray& rhs);             // copy constructor
@@ -71,8 +79,15 @@ class Scanner
   static const int GEOMETRY_EQUIANGULAR;
   static const int GEOMETRY_LINOGRAM;
 
+  static const int APERTURE_INVALID;
+  static const int APERTURE_UNIFORM;
+  static const int APERTURE_STRIP;
 
   Scanner (const Phantom& phm, const char* const geometryName, int nDet,
+    int nView, int iOffsetView, int nSample, const double rot_anglen,
+    double dFocalLengthRatio, double dCenterDetectorRatio, double dViewRatio, double dScanRatio,
+    const char* const apertureName = "uniform");
+  Scanner (const ImageFile& im, const char* const geometryName, int nDet,
     int nView, int iOffsetView, int nSample, const double rot_anglen,
     double dFocalLengthRatio, double dCenterDetectorRatio, double dViewRatio, double dScanRatio);
   ~Scanner();
@@ -84,6 +99,8 @@ class Scanner
 
   void collectProjections (Projections& proj, const Phantom& phm, const int iStartView, const int iNumViews, const int iOffsetView, int iStorageOffset, const int trace = Trace::TRACE_NONE, SGP* pSGP = NULL);
 
+  bool collectProjections (Projections& proj, const ImageFile& im, const int iStartView, const int iNumViews, const int iOffsetView, int iStorageOffset, const int nThreads = 1, const int trace = Trace::TRACE_NONE);
+
   void setNView (int nView);
   void setOffsetView (int iOffsetView);
 
@@ -106,6 +123,7 @@ class Scanner
   double fanBeamAngle() const {return m_dFanBeamAngle;}
 
   int geometry() const {return m_idGeometry;}
+  int aperture() const {return m_idAperture;}
 
   static int getGeometryCount() {return s_iGeometryCount;}
   static const char* const* getGeometryNameArray() {return s_aszGeometryName;}
@@ -114,10 +132,18 @@ class Scanner
   static const char* convertGeometryIDToName (const int idGeometry);
   static const char* convertGeometryIDToTitle (const int idGeometry);
 
+  static int getApertureCount() {return s_iApertureCount;}
+  static const char* const* getApertureNameArray() {return s_aszApertureName;}
+  static const char* const* getApertureTitleArray() {return s_aszApertureTitle;}
+  static int convertApertureNameToID (const char* const apertureName);
+  static const char* convertApertureIDToName (const int idAperture);
+  static const char* convertApertureIDToTitle (const int idAperture);
+
  private:
   bool m_fail;
   std::string m_failMessage;
   int m_idGeometry;
+  int m_idAperture;
   unsigned int m_nDet;          /* Number of detectors in array */
   unsigned int m_nView;         /* Number of rotated views */
   unsigned int m_iOffsetView;
@@ -151,8 +177,6 @@ class Scanner
     double dAngularDet;
   } m_initPos;
 
-  GRFMTX_2D m_rotmtxIncrement;
-
 #ifdef HAVE_SGP
   SGP* m_pSGP;                  // Pointer to graphics device
   double m_dXMinWin;            // Extent of graphics window
@@ -165,9 +189,22 @@ class Scanner
   static const char* const s_aszGeometryName[];
   static const char* const s_aszGeometryTitle[];
   static const int s_iGeometryCount;
+  static const char* const s_aszApertureName[];
+  static const char* const s_aszApertureTitle[];
+  static const int s_iApertureCount;
+
+  void init (const double xmin, const double xmax, const double ymin, const double ymax,
+    const char* const geometryName, int nDet, int nView, int iOffsetView, int nSample, const double rot_anglen,
+    double dFocalLengthRatio, double dCenterDetectorRatio, double dViewRatio, double dScanRatio,
+    const char* const apertureName);
 
   void projectSingleView (const Phantom& phm, DetectorArray& darray, const double xd1, const double yd1, const double xd2, const double yd2, const double xs1, const double ys1, const double xs2, const double ys2, const double dDetAngle);
 
+  void projectImageViews (Projections& proj, const ImageFile& im, const int iStartView, const int iNumViews, const int iOffsetView, const int iStorageOffset);
+
+  void calcViewRays (const int nDet, const double xd1, const double yd1, const double xd2, const double yd2, const double xs1, const double ys1, const double xs2, const double ys2, const double dDetAngle,
+    double* const pXD, double* const pYD, double* const pXS, double* const pYS) const;
+
   double projectSingleLine (const Phantom& phm, const double x1, const double y1, const double x2, const double y2);
 
   double projectLineAgainstPElem (const PhantomElement& pelem, const double x1, const double y1, const double x2, const double y2);
@@ -176,6 +213,7 @@ class Scanner
   void traceShowParamXOR (const char* szLabel, const char *fmt, int row, int color, ...);
   void traceShowParamRasterOp (int iRasterOp, const char* szLabel, const char* fmt, int row, int color, va_list va);
 
+  friend class ImageProjectorTask;
 
 };
 
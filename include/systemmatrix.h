@@ -0,0 +1,210 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**      Name:         systemmatrix.h
+**      Purpose:      Ray-driven projector and its sparse system matrix
+**      Programmer:   Kevin Rosenberg
+**      Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef __SYSTEMMATRIX_H
+#define __SYSTEMMATRIX_H
+
+#include <string>
+#include <vector>
+
+class Projections;
+
+
+// CLASS IDENTIFICATION
+//   JosephProjector
+//
+// PURPOSE
+//   Traces the central ray of each detector of a projection file through an
+//   image grid by Joseph's method. Rotation is about the origin and pixel
+//   (ix,iy) is stored at ix * ny + iy in flat image arrays.
+
+class JosephProjector
+{
+ public:
+    JosephProjector (const Projections& proj, int nx, int ny,
+      double xMin, double xMax, double yMin, double yMax);
+
+    int nx() const {return m_nx;}
+    int ny() const {return m_ny;}
+    int nDet() const {return m_nDet;}
+    int nView() const {return m_nView;}
+    double rayLength() const {return m_dRayLength;}
+
+    // Ray endpoints in pixel coordinates, pixel centers are at integers
+    void calcPixelRay (int iView, int iDet, double& px1, double& py1, double& px2, double& py2) const;
+
+    // Calls op (ix, iy, weight) for each pixel on a ray, weights are in world length
+    template<class RayOperation>
+    void traceRay (int iView, int iDet, RayOperation& op) const
+    {
+      double px1, py1, px2, py2;
+      calcPixelRay (iView, iDet, px1, py1, px2, py2);
+      traceJosephRay (m_nx, m_ny, px1, py1, px2, py2, m_dRayLength, op);
+    }
+
+    template<class RayOperation>
+    static void traceJosephRay (const int nx, const int ny, const double px1, const double py1,
+                                const double px2, const double py2, const double dWorldLength, RayOperation& op)
+    {
+      const double dpx = px2 - px1;
+      const double dpy = py2 - py1;
+
+      if (fabs (dpx) >= fabs (dpy)) {
+        if (fabs (dpx) < 1E-12)
+          return;
+        const double dSlope = dpy / dpx;
+        const double dStep = dWorldLength / fabs (dpx);
+        const int ixStart = imax (0, static_cast<int>(ceil (std::min (px1, px2))));
+        const int ixEnd = std::min (nx - 1, static_cast<int>(floor (std::max (px1, px2))));
+        for (int ix = ixStart; ix <= ixEnd; ix++) {
+          const double py = py1 + (ix - px1) * dSlope;
+          const double dFloor = floor (py);
+          const int iy = static_cast<int>(dFloor);
+          const double dFrac = py - dFloor;
+          if (iy >= 0 && iy < ny)
+            op (ix, iy, (1 - dFrac) * dStep);
+          if (iy + 1 >= 0 && iy + 1 < ny)
+            op (ix, iy + 1, dFrac * dStep);
+        }
+      } else {
+        const double dSlope = dpx / dpy;
+        const double dStep = dWorldLength / fabs (dpy);
+        const int iyStart = imax (0, static_cast<int>(ceil (std::min (py1, py2))));
+        const int iyEnd = std::min (ny - 1, static_cast<int>(floor (std::max (py1, py2))));
+        for (int iy = iyStart; iy <= iyEnd; iy++) {
+          const double px = px1 + (iy - py1) * dSlope;
+          const double dFloor = floor (px);
+          const int ix = static_cast<int>(dFloor);
+          const double dFrac = px - dFloor;
+          if (ix >= 0 && ix < nx)
+            op (ix, iy, (1 - dFrac) * dStep);
+          if (ix + 1 >= 0 && ix + 1 < nx)
+            op (ix + 1, iy, dFrac * dStep);
+        }
+      }
+    }
+
+ private:
+    const Projections& m_rProj;
+    int m_nx;
+    int m_ny;
+    int m_nDet;
+    int m_nView;
+    double m_dXMin;
+    double m_dYMin;
+    double m_dXInc;
+    double m_dYInc;
+    double m_dRayLength;
+    double m_dAngularDetIncrement;
+};
+
+
+// CLASS IDENTIFICATION
+//   SystemMatrix
+//
+// PURPOSE
+//   Compressed sparse row form of the JosephProjector for one geometry.
+//   Row iView * nDet + iDet holds the pixel weights of that ray. Weights are
+//   kfloat32 and column indices are 16 bits wide when the image has at most
+//   65536 pixels.
+//
+// NOTES
+//   When a cache directory is given, the matrix is read from a file named by
+//   a hash of the geometry, memory-mapped where supported, and is written
+//   there after being built. The matrix is refused when its estimated size
+//   exceeds the memory limit in megabytes, 0 for no limit. A NULL directory
+//   or negative limit selects the defaults.
+
+class SystemMatrix
+{
+ public:
+    SystemMatrix (const Projections& proj, int nx, int ny, double xMin, double xMax, double yMin, double yMax,
+      int nThreads = 1, const char* const pszCacheDirectory = NULL, double dMemoryLimitMB = -1);
+
+    ~SystemMatrix ();
+
+    bool fail() const {return m_bFail;}
+    const std::string& failMessage() const {return m_strFailMessage;}
+
+    const std::string& key() const {return m_strKey;}
+    bool fromCache() const {return m_bFromCache;}
+    bool isMapped() const {return m_pMapping != NULL;}
+    int nRows() const {return m_nRows;}
+    int nCols() const {return m_nCols;}
+    unsigned long nNonZero() const {return m_nNonZero;}
+    double sizeMB() const {return m_lBufferSize / 1048576.;}
+
+    // Sum of the row's weights times the image, and the sum of the weights
+    double rowSum (int iRow, const double* pdImage, double& dRowWeight) const;
+    // Adds value times the row's weights to the image and the weights to pdWeight
+    void rowSpread (int iRow, double dValue, double* pdImage, double* pdWeight) const;
+
+    // Raysums = A * image for nRows rows, pdRaysums[0] holds row iStartRow
+    void multiply (const double* pdImage, double* pdRaysums, int iStartRow, int nRows) const;
+    void multiply (const double* pdImage, double* pdRaysums, int nThreads) const;
+    // Image += transpose(A) * raysums for nRows rows, pdRaysums[0] holds row iStartRow
+    void multiplyTranspose (const double* pdRaysums, double* pdImage, int iStartRow, int nRows) const;
+
+    static std::string makeKey (const Projections& proj, int nx, int ny,
+      double xMin, double xMax, double yMin, double yMax);
+    static double estimateSizeMB (const Projections& proj, int nx, int ny);
+
+    static void setDefaultCacheDirectory (const char* const pszDirectory);
+    static const std::string& getDefaultCacheDirectory() {return s_strDefaultCacheDirectory;}
+    static void setDefaultMemoryLimitMB (double dMemoryLimitMB) {s_dDefaultMemoryLimitMB = dMemoryLimitMB;}
+    static double getDefaultMemoryLimitMB() {return s_dDefaultMemoryLimitMB;}
+
+ private:
+    bool m_bFail;
+    std::string m_strFailMessage;
+    std::string m_strKey;
+    bool m_bFromCache;
+    int m_nRows;
+    int m_nCols;
+    unsigned long m_nNonZero;
+    int m_iIndexBytes;
+
+    std::vector<double> m_vecBuffer;     // 8-byte aligned storage when not mapped
+    void* m_pMapping;
+    size_t m_lBufferSize;
+    const kuint32* m_pRowStart;
+    const kfloat32* m_pWeights;
+    const kuint16* m_pIndex16;
+    const kuint32* m_pIndex32;
+
+    static std::string s_strDefaultCacheDirectory;
+    static double s_dDefaultMemoryLimitMB;
+
+    bool build (const JosephProjector& projector, int nThreads);
+    bool readCache (const std::string& strFilename);
+    bool writeCache (const std::string& strFilename) const;
+    bool setPointers (const char* pBuffer, size_t lSize);
+    void unmap ();
+
+    SystemMatrix (const SystemMatrix& rhs);
+    SystemMatrix& operator= (const SystemMatrix& rhs);
+};
+
+#endif
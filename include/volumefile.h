@@ -0,0 +1,137 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**      Name:         volumefile.h
+**      Purpose:      Container file of many image and projection datasets
+**      Programmer:   Kevin Rosenberg
+**      Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef __VOLUMEFILE_H
+#define __VOLUMEFILE_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+class Array2dFile;
+class Projections;
+class frnetorderstream;
+
+
+// CLASS IDENTIFICATION
+//   VolumeFile
+//
+// PURPOSE
+//   Holds many image and projection datasets in one file. Each entry is a
+//   complete .if or .pj dataset, with its own header and labels, starting
+//   at a page aligned offset so projections can be mapped in place. A table
+//   of contents after the last entry gives the type, name, offset and size
+//   of each entry.
+//
+// NOTES
+//   Datasets are named by paths of the form "volume.ctv:entry", where entry
+//   is the name of the entry or #n for the entry with index n. Such paths
+//   may be given to Array2dFile::fileRead and fileWrite and to
+//   Projections::read, readMapped and write, which open the volume and
+//   locate the entry from the table of contents. Writing an entry that
+//   exists replaces it; its old payload is not reclaimed.
+
+class VolumeFile
+{
+ public:
+    static const int ENTRY_INVALID;
+    static const int ENTRY_IMAGE;
+    static const int ENTRY_PROJECTIONS;
+
+    static const char* const s_szExtension;
+
+    VolumeFile ();
+    ~VolumeFile ();
+
+    // Opens a volume, creating it when bWrite is set and the file does not exist
+    bool open (const char* const filename, bool bWrite = false);
+    // Writes the table of contents of a modified volume and closes the file
+    bool close ();
+    bool isOpen () const {return m_pStream != NULL;}
+
+    const std::string& getFilename () const {return m_strFilename;}
+    int nEntries () const {return m_vecEntry.size();}
+    // Index of the entry with a name or of the form #n, -1 when there is none
+    int findEntry (const char* const name) const;
+    const std::string& entryName (int iEntry) const {return m_vecEntry[iEntry].m_strName;}
+    const std::string& entryRemark (int iEntry) const {return m_vecEntry[iEntry].m_strRemark;}
+    int entryType (int iEntry) const {return m_vecEntry[iEntry].m_iType;}
+    kuint64 entryOffset (int iEntry) const {return m_vecEntry[iEntry].m_offset;}
+    kuint64 entrySize (int iEntry) const {return m_vecEntry[iEntry].m_size;}
+    std::string entryPath (int iEntry) const;
+
+    bool readImage (int iEntry, Array2dFile& rImage) const;
+    bool readProjections (int iEntry, Projections& rProj) const;
+    bool writeImage (const char* const name, Array2dFile& rImage);
+    bool writeProjections (const char* const name, Projections& rProj);
+
+    void printEntries (std::ostream& os) const;
+
+    static const char* convertEntryTypeIDToName (int iType);
+
+    // True for "volume.ctv:entry" paths
+    static bool isEntryPath (const char* const path);
+    static bool splitEntryPath (const char* const path, std::string& strVolume, std::string& strEntry);
+    // Finds the volume file and the offset of the dataset of an entry path
+    static bool locateEntry (const char* const path, std::string& strVolume, kuint64& offset);
+
+ private:
+    struct Entry {
+      int m_iType;
+      std::string m_strName;
+      std::string m_strRemark;
+      kuint64 m_offset;
+      kuint64 m_size;
+    };
+
+    std::string m_strFilename;
+    frnetorderstream* m_pStream;
+    bool m_bWrite;
+    bool m_bModified;
+    kuint64 m_endOffset;          // End of the last entry
+    std::vector<Entry> m_vecEntry;
+#ifdef HAVE_PTHREAD
+    mutable pthread_mutex_t m_mutex;
+#endif
+
+    static const kuint16 m_signature;
+    static const kuint16 s_iHeaderSize;
+    static const kuint32 s_iVersion;
+    static const kuint32 s_iEntryAlignment;
+
+    bool headerRead ();
+    bool headerWrite (kuint64 tocOffset, kuint64 tocBytes);
+    bool tocRead (kuint64 tocOffset, kuint32 nEntries);
+    bool beginEntry (kuint64& offset);
+    void endEntry (int iType, const char* const name, const std::string& strRemark, kuint64 offset);
+
+    VolumeFile (const VolumeFile& rhs);
+    VolumeFile& operator= (const VolumeFile& rhs);
+};
+
+#endif
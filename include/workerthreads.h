@@ -0,0 +1,158 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:          workerthreads.h
+**   Purpose:       Header file for splitting work units across threads
+**   Programmer:    Kevin Rosenberg
+**   Date Started:  October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#ifndef WORKERTHREADS_H
+#define WORKERTHREADS_H
+
+#include <vector>
+#include <deque>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+
+// Work performed by a single thread on a contiguous range of work units.
+// Each thread is handed a disjoint range, so tasks only need to guard
+// state that is shared outside of their own range.
+class WorkerThreadTask {
+public:
+  virtual ~WorkerThreadTask()
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits) = 0;
+};
+
+
+// Splits work units among threads in the same manner as MPIWorld splits
+// them among processes. Without POSIX threads, the ranges are run in turn
+// by the calling thread.
+class WorkerThreads {
+public:
+  WorkerThreads (int nThreads = 0);   // 0 uses the number of processors
+
+  void setTotalWorkUnits (int totalUnits);
+
+  int getNumThreads () const
+  { return m_nThreads; }
+
+  int getTotalWorkUnits () const
+  { return m_iTotalWorkUnits; }
+
+  int getStartWorkUnit (int iThread) const
+  { return m_vStartWorkUnit[iThread]; }
+
+  int getEndWorkUnit (int iThread) const
+  { return m_vEndWorkUnit[iThread]; }
+
+  int getLocalWorkUnits (int iThread) const
+  { return m_vLocalWorkUnits[iThread]; }
+
+  bool run (WorkerThreadTask& task);
+
+  static int getNumberOfProcessors ();
+
+private:
+  int m_nThreads;
+  int m_iTotalWorkUnits;
+  std::vector<int> m_vLocalWorkUnits;
+  std::vector<int> m_vStartWorkUnit;
+  std::vector<int> m_vEndWorkUnit;
+};
+
+
+#ifdef HAVE_PTHREAD
+// Queue of at most nMaxItems items connecting the threads of a pipeline.
+// push waits while the queue is full and pop while it is empty. After
+// close, push fails and pop fails once the queue is empty.
+template<class T>
+class BoundedQueue {
+public:
+  BoundedQueue (size_t nMaxItems)
+    : m_nMaxItems(nMaxItems), m_bClosed(false)
+  {
+    pthread_mutex_init (&m_mutex, NULL);
+    pthread_cond_init (&m_condNotEmpty, NULL);
+    pthread_cond_init (&m_condNotFull, NULL);
+  }
+
+  ~BoundedQueue ()
+  {
+    pthread_cond_destroy (&m_condNotFull);
+    pthread_cond_destroy (&m_condNotEmpty);
+    pthread_mutex_destroy (&m_mutex);
+  }
+
+  bool push (const T& item)
+  {
+    pthread_mutex_lock (&m_mutex);
+    while (m_queue.size() >= m_nMaxItems && ! m_bClosed)
+      pthread_cond_wait (&m_condNotFull, &m_mutex);
+    const bool bOk = ! m_bClosed;
+    if (bOk) {
+      m_queue.push_back (item);
+      pthread_cond_signal (&m_condNotEmpty);
+    }
+    pthread_mutex_unlock (&m_mutex);
+    return bOk;
+  }
+
+  bool pop (T& item)
+  {
+    pthread_mutex_lock (&m_mutex);
+    while (m_queue.empty() && ! m_bClosed)
+      pthread_cond_wait (&m_condNotEmpty, &m_mutex);
+    const bool bOk = ! m_queue.empty();
+    if (bOk) {
+      item = m_queue.front();
+      m_queue.pop_front();
+      pthread_cond_signal (&m_condNotFull);
+    }
+    pthread_mutex_unlock (&m_mutex);
+    return bOk;
+  }
+
+  void close ()
+  {
+    pthread_mutex_lock (&m_mutex);
+    m_bClosed = true;
+    pthread_cond_broadcast (&m_condNotEmpty);
+    pthread_cond_broadcast (&m_condNotFull);
+    pthread_mutex_unlock (&m_mutex);
+  }
+
+private:
+  std::deque<T> m_queue;
+  size_t m_nMaxItems;
+  bool m_bClosed;
+  pthread_mutex_t m_mutex;
+  pthread_cond_t m_condNotEmpty;
+  pthread_cond_t m_condNotFull;
+
+  BoundedQueue (const BoundedQueue& rhs);
+  BoundedQueue& operator= (const BoundedQueue& rhs);
+};
+#endif
+
+#endif
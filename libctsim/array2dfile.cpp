@@ -24,15 +24,29 @@
 ******************************************************************************/
 
 #include "array2dfile.h"
+#include "volumefile.h"
 #include <ctime>
 #ifdef MSVC
 typedef long off_t;
 #endif
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define HAVE_MAPPED_IMAGES
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 #include <sstream>
 
 const kuint16 Array2dFile::m_signature = ('I'*256+'F');
 
+// Compressed files add the ArrayCodec and the columns per block to the
+// header, which is followed by an index of file offsets of the blocks of
+// columns, real blocks before imaginary ones, with the labels at the last
+// offset. Each block is encoded separately so it can be read alone.
+const kuint16 Array2dFile::m_signatureCompressed = ('I'*256+'Z');
+const kuint32 Array2dFile::s_nCompressedBlockColumns = 16;
+
 ///////////////////////////////////////////////////////////////////////////
 // CLASS IMPLEMENTATION
 //
@@ -200,6 +214,7 @@ Array2dFile::Array2dFile (int x, int y, int pixelSize, int pixelFormat, int data
 
 Array2dFile::~Array2dFile (void)
 {
+  delete m_pBandStream;
   freeArrays ();
   for (labelIterator l = m_labels.begin(); l != m_labels.end(); l++)
     delete *l;
@@ -217,6 +232,10 @@ Array2dFile::init (void)
   m_pixelFormat = PIXEL_INVALID;
   m_arrayData = NULL;
   m_imaginaryArrayData = NULL;
+  m_pArrayBlock = NULL;
+  m_pImaginaryArrayBlock = NULL;
+  m_pMap = NULL;
+  m_nMapBytes = 0;
   m_dataType = DATA_TYPE_INVALID;
   m_nx = 0;
   m_ny = 0;
@@ -227,6 +246,10 @@ Array2dFile::init (void)
   m_minX = m_maxX = m_minY = m_maxY = 0;
   m_offsetPV = 0;
   m_scalePV = 1;
+  m_pBandStream = NULL;
+  m_bandTotalNX = 0;
+  m_iCompression = ArrayCodec::CODEC_NONE;
+  m_nBlockColumns = s_nCompressedBlockColumns;
 }
 
 
@@ -253,7 +276,7 @@ Array2dFile::reallocComplexToReal ()
   if (m_dataType != DATA_TYPE_COMPLEX)
     return false;
 
-  freeArray (m_imaginaryArrayData);
+  freeArray (m_imaginaryArrayData, m_pImaginaryArrayBlock);
   m_dataType = DATA_TYPE_REAL;
 
   return true;
@@ -266,7 +289,7 @@ Array2dFile::reallocRealToComplex ()
   if (m_dataType != DATA_TYPE_REAL)
     return false;
 
-  allocArray (m_imaginaryArrayData);
+  allocArray (m_imaginaryArrayData, m_pImaginaryArrayBlock);
   m_dataType = DATA_TYPE_COMPLEX;
 
   return true;
@@ -277,44 +300,94 @@ Array2dFile::reallocRealToComplex ()
 void
 Array2dFile::allocArrays ()
 {
-  if (m_arrayData)
-    freeArray (m_arrayData);
-  if (m_imaginaryArrayData)
-    freeArray (m_imaginaryArrayData);
+  freeArrays ();
 
-  allocArray (m_arrayData);
+  allocArray (m_arrayData, m_pArrayBlock);
   if (m_dataType == DATA_TYPE_COMPLEX)
-    allocArray (m_imaginaryArrayData);
+    allocArray (m_imaginaryArrayData, m_pImaginaryArrayBlock);
 }
 
+// NAME
+//   allocArray           Allocate the pixels and column pointers of an array
+//
+// NOTES
+//   All columns are in one aligned block, so the array may be read, written
+//   and processed as a single span as well as column by column.
+
 void
-Array2dFile::allocArray (unsigned char**& rppData)
+Array2dFile::allocArray (unsigned char**& rppData, unsigned char*& rpBlock)
 {
   m_arraySize = m_nx * m_ny * m_pixelSize;
+  rpBlock = static_cast<unsigned char*>(alignedAlloc (size() * m_pixelSize));
+  setColumns (rppData, rpBlock);
+}
+
+void
+Array2dFile::setColumns (unsigned char**& rppData, unsigned char* pBlock)
+{
+  size_t columnBytes = static_cast<size_t>(m_ny) * m_pixelSize;
   rppData = new unsigned char* [m_nx];
-  int columnBytes = m_ny * m_pixelSize;
   for (unsigned int i = 0; i < m_nx; i++)
-    rppData[i] = new unsigned char [columnBytes];
+    rppData[i] = pBlock + i * columnBytes;
 }
 
 void
 Array2dFile::freeArrays ()
 {
-  if (m_arrayData)
-    freeArray (m_arrayData);
+  freeArray (m_arrayData, m_pArrayBlock);
+  freeArray (m_imaginaryArrayData, m_pImaginaryArrayBlock);
 
-  if (m_imaginaryArrayData)
-    freeArray (m_imaginaryArrayData);
+#ifdef HAVE_MAPPED_IMAGES
+  if (m_pMap)
+    munmap (m_pMap, m_nMapBytes);
+#endif
+  m_pMap = NULL;
+  m_nMapBytes = 0;
+}
 
+void
+Array2dFile::freeArray (unsigned char**& rppData, unsigned char*& rpBlock)
+{
+  if (! isMappedBlock (rpBlock))
+    alignedFree (rpBlock);
+  rpBlock = NULL;
+  delete [] rppData;
+  rppData = NULL;
 }
 
+// NAME
+//   unmapArrays          Copy mapped pixels to memory and release the mapping
+
 void
-Array2dFile::freeArray (unsigned char**& rppData)
+Array2dFile::unmapArrays ()
+{
+  if (! m_pMap)
+    return;
+
+  const size_t nArrayBytes = size() * m_pixelSize;
+  unsigned char* pBlock = static_cast<unsigned char*>(alignedAlloc (nArrayBytes));
+  unsigned char* pImaginaryBlock = NULL;
+  memcpy (pBlock, m_pArrayBlock, nArrayBytes);
+  if (m_pImaginaryArrayBlock) {
+    pImaginaryBlock = static_cast<unsigned char*>(alignedAlloc (nArrayBytes));
+    memcpy (pImaginaryBlock, m_pImaginaryArrayBlock, nArrayBytes);
+  }
+
+  freeArrays ();
+  m_pArrayBlock = pBlock;
+  setColumns (m_arrayData, m_pArrayBlock);
+  if (pImaginaryBlock) {
+    m_pImaginaryArrayBlock = pImaginaryBlock;
+    setColumns (m_imaginaryArrayData, m_pImaginaryArrayBlock);
+  }
+}
+
+bool
+Array2dFile::isMappedBlock (const unsigned char* pBlock) const
 {
-   for (unsigned int i = 0; i < m_nx; i++)
-      delete rppData[i];
-    delete rppData;
-    rppData = NULL;
+  const unsigned char* pMap = static_cast<const unsigned char*>(m_pMap);
+
+  return pMap && pBlock >= pMap && pBlock < pMap + m_nMapBytes;
 }
 
 
@@ -327,13 +400,53 @@ Array2dFile::fileWrite (const std::string& filename)
 bool
 Array2dFile::fileWrite (const char* const filename)
 {
+  // rewriting the mapped file would change the pixels while they are written
+  if (isMapped() && m_filename == filename)
+    unmapArrays ();
   m_filename = filename;
 
+  std::string strVolume, strEntry;
+  if (VolumeFile::splitEntryPath (filename, strVolume, strEntry)) {
+    VolumeFile volume;
+    if (! volume.open (strVolume.c_str(), true))
+      return false;
+    bool bOk = volume.writeImage (strEntry.c_str(), *this);
+    return volume.close() && bOk;
+  }
+
   frnetorderstream fs (m_filename.c_str(), std::ios::out | std::ios::in | std::ios::trunc | std::ios::binary);
   if (fs.fail()) {
     sys_error (ERR_WARNING, "Error opening file %s for writing [fileCreate]", m_filename.c_str());
     return false;
   }
+
+  return fileWrite (fs);
+}
+
+// NAME
+//   fileWrite            Write the image at the origin of an open stream
+//
+// NOTES
+//   Used by VolumeFile to write an image as an entry of a volume
+
+bool
+Array2dFile::fileWrite (frnetorderstream& fs)
+{
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    if (! ArrayCodec::isAvailable (m_iCompression)) {
+      sys_error (ERR_WARNING, "Compression %d is not available [fileWrite]", m_iCompression);
+      return false;
+    }
+    if (m_pixelFormat != PIXEL_FLOAT32 && m_pixelFormat != PIXEL_FLOAT64) {
+      sys_error (ERR_WARNING, "Only floating point pixels can be compressed [fileWrite]");
+      return false;
+    }
+    if (fs.isSequential()) {
+      sys_error (ERR_WARNING, "Compressed images can not be written to a pipe [fileWrite]");
+      return false;
+    }
+  }
+
   if (! headerWrite(fs))
     return false;
 
@@ -346,6 +459,93 @@ Array2dFile::fileWrite (const char* const filename)
   return true;
 }
 
+
+// NAME
+//   fileBandWriteBegin   Start writing a file one band of columns at a time
+//
+// DESCRIPTION
+//   Allows writing an image of iTotalNX columns while holding only a band of
+//   columns in memory. This object's array holds the current band, which is
+//   written with fileBandWrite(). fileBandWriteEnd() writes the labels and
+//   closes the file.
+
+bool
+Array2dFile::fileBandWriteBegin (const char* const filename, int iTotalNX)
+{
+  if (m_dataType == DATA_TYPE_COMPLEX) {
+    sys_error (ERR_WARNING, "Band writing of complex images is not supported [fileBandWriteBegin]");
+    return false;
+  }
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    sys_error (ERR_WARNING, "Band writing of compressed images is not supported [fileBandWriteBegin]");
+    return false;
+  }
+  if (iTotalNX < static_cast<int>(m_nx)) {
+    sys_error (ERR_WARNING, "Total columns %d less than band columns %d [fileBandWriteBegin]", iTotalNX, m_nx);
+    return false;
+  }
+  if (VolumeFile::isEntryPath (filename)) {
+    sys_error (ERR_WARNING, "Band writing into a volume is not supported [fileBandWriteBegin]");
+    return false;
+  }
+
+  delete m_pBandStream;
+  m_filename = filename;
+  m_pBandStream = new frnetorderstream (m_filename.c_str(), std::ios::out | std::ios::in | std::ios::trunc | std::ios::binary);
+  if (m_pBandStream->fail()) {
+    sys_error (ERR_WARNING, "Error opening file %s for writing [fileBandWriteBegin]", m_filename.c_str());
+    delete m_pBandStream;
+    m_pBandStream = NULL;
+    return false;
+  }
+  m_bandTotalNX = iTotalNX;
+
+  kuint32 nxBand = m_nx;
+  m_nx = m_bandTotalNX;
+  bool bOk = headerWrite (*m_pBandStream);
+  m_nx = nxBand;
+
+  return bOk;
+}
+
+bool
+Array2dFile::fileBandWrite (int iStartColumn, int iNumColumns)
+{
+  if (! m_pBandStream || ! m_arrayData) {
+    sys_error (ERR_WARNING, "Band write without fileBandWriteBegin [fileBandWrite]");
+    return false;
+  }
+  if (iStartColumn < 0 || iNumColumns > static_cast<int>(m_nx) || iStartColumn + iNumColumns > static_cast<int>(m_bandTotalNX)) {
+    sys_error (ERR_WARNING, "Invalid band columns %d-%d [fileBandWrite]", iStartColumn, iStartColumn + iNumColumns - 1);
+    return false;
+  }
+
+  frnetorderstream& fs = *m_pBandStream;
+  int columnSize = m_ny * m_pixelSize;
+  fs.seekp (m_headersize + static_cast<off_t>(iStartColumn) * columnSize);
+  for (int ix = 0; ix < iNumColumns; ix++)
+    fs.writeArray (m_arrayData[ix], m_ny, m_pixelSize);
+
+  return ! fs.fail();
+}
+
+bool
+Array2dFile::fileBandWriteEnd ()
+{
+  if (! m_pBandStream)
+    return false;
+
+  kuint32 nxBand = m_nx;
+  m_nx = m_bandTotalNX;
+  bool bOk = headerWrite (*m_pBandStream) && labelsWrite (*m_pBandStream);
+  m_nx = nxBand;
+
+  delete m_pBandStream;
+  m_pBandStream = NULL;
+
+  return bOk;
+}
+
 bool
 Array2dFile::fileRead (const std::string& filename)
 {
@@ -357,13 +557,30 @@ Array2dFile::fileRead (const char* const filename)
 {
   m_filename = filename;
 
-  frnetorderstream fs (m_filename.c_str(), std::ios::out | std::ios::in | std::ios::binary);
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::splitEntryPath (filename, strVolume, m_filename)
+      && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+  m_filename = filename;
+
+  frnetorderstream fs (strVolume.c_str(), std::ios::in | std::ios::binary);
 
   if (fs.fail()) {
-    sys_error (ERR_WARNING, "Unable to open file %s [fileRead]", m_filename.c_str());
+    sys_error (ERR_WARNING, "Unable to open file %s [fileRead]", strVolume.c_str());
     return false;
   }
+  fs.setOrigin (entryOffset);
 
+  return fileRead (fs);
+}
+
+// NAME
+//   fileRead             Read an image from the origin of an open stream
+
+bool
+Array2dFile::fileRead (frnetorderstream& fs)
+{
   if (! headerRead(fs))
     return false;
 
@@ -378,6 +595,82 @@ Array2dFile::fileRead (const char* const filename)
   return true;
 }
 
+// NAME
+//   fileReadMapped       Map the pixels of an image file
+//
+// NOTES
+//   The pixels of a plain file on a little endian host are used in place
+//   from a private mapping, so only the parts of a large image that are
+//   used are paged in, and the pixels are shared with the page cache until
+//   they are changed. The labels are read as usual.
+
+bool
+Array2dFile::fileReadMapped (const char* const filename, bool bReadOnly)
+{
+#ifndef HAVE_MAPPED_IMAGES
+  return fileRead (filename);
+#else
+  if (fnetorderstream::isStandardStream (filename))
+    return fileRead (filename);
+
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::splitEntryPath (filename, strVolume, m_filename)
+      && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+  m_filename = filename;
+
+  frnetorderstream fs (strVolume.c_str(), std::ios::in | std::ios::binary);
+  if (fs.fail()) {
+    sys_error (ERR_WARNING, "Unable to open file %s [fileReadMapped]", strVolume.c_str());
+    return false;
+  }
+  fs.setOrigin (entryOffset);
+  if (! headerRead (fs))
+    return false;
+
+  const size_t nArrayBytes = size() * m_pixelSize;
+  const size_t nArrays = m_dataType == DATA_TYPE_COMPLEX ? 2 : 1;
+  const kuint64 dataOffset = entryOffset + m_headersize;
+  if (m_iCompression != ArrayCodec::CODEC_NONE || NativeBigEndian() || nArrayBytes == 0
+      || m_pixelSize == 0 || dataOffset % m_pixelSize != 0) {
+    allocArrays ();
+    return arrayDataRead (fs) && labelsRead (fs);
+  }
+
+  const kuint64 mapOffset = dataOffset - dataOffset % sysconf (_SC_PAGESIZE);
+  const size_t nMapBytes = static_cast<size_t>(dataOffset - mapOffset) + nArrays * nArrayBytes;
+  int fd = open (strVolume.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat statFile;
+  if (fstat (fd, &statFile) != 0 || static_cast<kuint64>(statFile.st_size) < mapOffset + nMapBytes) {
+    sys_error (ERR_WARNING, "Image file %s is shorter than its pixels [fileReadMapped]", filename);
+    close (fd);
+    return false;
+  }
+  void* pMap = mmap (NULL, nMapBytes, bReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(mapOffset));
+  close (fd);
+  if (pMap == MAP_FAILED) {
+    sys_error (ERR_WARNING, "Unable to map image file %s [fileReadMapped]", filename);
+    return false;
+  }
+
+  freeArrays ();
+  m_pMap = pMap;
+  m_nMapBytes = nMapBytes;
+  m_arraySize = nArrayBytes;
+  m_pArrayBlock = static_cast<unsigned char*>(pMap) + (dataOffset - mapOffset);
+  setColumns (m_arrayData, m_pArrayBlock);
+  if (m_dataType == DATA_TYPE_COMPLEX) {
+    m_pImaginaryArrayBlock = m_pArrayBlock + nArrayBytes;
+    setColumns (m_imaginaryArrayData, m_pImaginaryArrayBlock);
+  }
+
+  return labelsRead (fs);
+#endif
+}
+
 void
 Array2dFile::setAxisIncrement (double incX, double incY)
 {
@@ -391,8 +684,8 @@ Array2dFile::setAxisExtent (double minX, double maxX, double minY, double maxY)
 {
   m_axisExtentKnown = true;
   m_minX = minX;
-  m_maxY = maxX;
-  m_minX = minX;
+  m_maxX = maxX;
+  m_minY = minY;
   m_maxY = maxY;
 }
 
@@ -425,16 +718,28 @@ Array2dFile::headerRead (frnetorderstream& fs)
   fs.readFloat64 (m_maxY);
   fs.readFloat64 (m_offsetPV);
   fs.readFloat64 (m_scalePV);
+  m_iCompression = ArrayCodec::CODEC_NONE;
+  if (file_signature == m_signatureCompressed) {
+    kuint16 codec, reserved;
+    fs.readInt16 (codec);
+    fs.readInt16 (reserved);
+    fs.readInt32 (m_nBlockColumns);
+    m_iCompression = codec;
+  }
 
   int read_m_headersize = fs.tellg();
   if (read_m_headersize != m_headersize) {
     sys_error (ERR_WARNING, "Read m_headersize %d != file m_headersize %d", read_m_headersize, m_headersize);
     return false;
   }
-  if (file_signature != m_signature) {
+  if (file_signature != m_signature && file_signature != m_signatureCompressed) {
     sys_error (ERR_WARNING, "File signature %d != true signature %d", file_signature, m_signature);
     return false;
   }
+  if (! ArrayCodec::isAvailable (m_iCompression) || m_nBlockColumns == 0) {
+    sys_error (ERR_WARNING, "File %s uses compression %d, which is not available", m_filename.c_str(), m_iCompression);
+    return false;
+  }
 
   return ! fs.fail();
 }
@@ -450,9 +755,14 @@ Array2dFile::headerWrite (frnetorderstream& fs)
 
   m_numFileLabels = m_labels.size();
 
+  // the size is known before the header is written, so it is written in order
+  m_headersize = 8 * sizeof(kuint16) + 2 * sizeof(kuint32) + 8 * sizeof(kfloat64);
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    m_headersize += 2 * sizeof(kuint16) + sizeof(kuint32);
+
   fs.seekp (0);
   fs.writeInt16 (m_headersize);
-  fs.writeInt16 (m_signature);
+  fs.writeInt16 (m_iCompression != ArrayCodec::CODEC_NONE ? m_signatureCompressed : m_signature);
   fs.writeInt16 (m_pixelFormat);
   fs.writeInt16 (m_pixelSize);
   fs.writeInt16 (m_numFileLabels);
@@ -469,12 +779,16 @@ Array2dFile::headerWrite (frnetorderstream& fs)
   fs.writeFloat64 (m_maxY);
   fs.writeFloat64 (m_offsetPV);
   fs.writeFloat64 (m_scalePV);
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    kuint16 codec = m_iCompression;
+    kuint16 reserved = 0;
+    m_nBlockColumns = s_nCompressedBlockColumns;
+    fs.writeInt16 (codec);
+    fs.writeInt16 (reserved);
+    fs.writeInt32 (m_nBlockColumns);
+  }
 
-  m_headersize = static_cast<kuint16>(fs.tellp());
-  fs.seekp (0);
-  fs.writeInt16 (m_headersize);
-
-  return ! fs.fail();
+  return ! fs.fail() && fs.tellp() == m_headersize;
 }
 
 
@@ -489,32 +803,14 @@ Array2dFile::arrayDataWrite (frnetorderstream& fs)
   if (! m_arrayData)
     return false;
 
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    return arrayDataWriteCompressed (fs);
+
+  // each array is written with one call, bytes are swapped on big endian hosts
   fs.seekp (m_headersize);
-  int columnSize = m_ny * m_pixelSize;
-  for (unsigned int ix = 0; ix < m_nx; ix++) {
-    unsigned char* ptrColumn = m_arrayData[ix];
-    if (NativeBigEndian()) {
-      for (unsigned int iy = 0; iy < m_ny; iy++) {
-        ConvertReverseNetworkOrder (ptrColumn, m_pixelSize);
-        fs.write (reinterpret_cast<const char*>(ptrColumn), m_pixelSize);
-        ptrColumn += m_pixelSize;
-      }
-    } else
-      fs.write (reinterpret_cast<const char*>(ptrColumn), columnSize);
-  }
-  if (m_dataType == DATA_TYPE_COMPLEX) {
-    for (unsigned int ix = 0; ix < m_nx; ix++) {
-      unsigned char* ptrColumn = m_imaginaryArrayData[ix];
-      if (NativeBigEndian()) {
-        for (unsigned int iy = 0; iy < m_ny; iy++) {
-          ConvertReverseNetworkOrder (ptrColumn, m_pixelSize);
-          fs.write (reinterpret_cast<const char*>(ptrColumn), m_pixelSize);
-          ptrColumn += m_pixelSize;
-        }
-      } else
-        fs.write (reinterpret_cast<const char*>(ptrColumn), columnSize);
-    }
-  }
+  fs.writeArray (m_pArrayBlock, size(), m_pixelSize);
+  if (m_dataType == DATA_TYPE_COMPLEX)
+    fs.writeArray (m_pImaginaryArrayBlock, size(), m_pixelSize);
 
   return true;
 }
@@ -531,40 +827,98 @@ Array2dFile::arrayDataRead (frnetorderstream& fs)
   if (! m_arrayData)
     return false;
 
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    return arrayDataReadCompressed (fs);
+
   fs.seekg (m_headersize);
-  int columnSize = m_ny * m_pixelSize;
-  for (unsigned int ix = 0; ix < m_nx; ix++) {
-    unsigned char* ptrColumn = m_arrayData[ix];
-    if (NativeBigEndian()) {
-      for (unsigned int iy = 0; iy < m_ny; iy++) {
-        fs.read (reinterpret_cast<char*>(ptrColumn), m_pixelSize);
-        ConvertReverseNetworkOrder (ptrColumn, m_pixelSize);
-        ptrColumn += m_pixelSize;
-      }
-    } else
-      fs.read (reinterpret_cast<char*>(ptrColumn), columnSize);
+  fs.readArray (m_pArrayBlock, size(), m_pixelSize);
+  if (m_dataType == DATA_TYPE_COMPLEX)
+    fs.readArray (m_pImaginaryArrayBlock, size(), m_pixelSize);
+
+  return true;
+}
+
+bool
+Array2dFile::arrayDataWriteCompressed (frnetorderstream& fs)
+{
+  const unsigned int nBlockX = (m_nx + m_nBlockColumns - 1) / m_nBlockColumns;
+  const unsigned int nBlocks = m_dataType == DATA_TYPE_COMPLEX ? 2 * nBlockX : nBlockX;
+  const size_t columnBytes = static_cast<size_t>(m_ny) * m_pixelSize;
+
+  // the index is written once the sizes of the blocks are known
+  m_vecBlockOffset.assign (nBlocks + 1, 0);
+  fs.seekp (m_headersize);
+  fs.writeArray (&m_vecBlockOffset[0], nBlocks + 1, sizeof(kuint64));
+
+  // the columns of a block are adjacent in the array, so they are encoded in place
+  std::vector<unsigned char> vecEncoded;
+  for (unsigned int iBlock = 0; iBlock < nBlocks; iBlock++) {
+    unsigned char* pBlock = iBlock < nBlockX ? m_pArrayBlock : m_pImaginaryArrayBlock;
+    const unsigned int ixStart = (iBlock % nBlockX) * m_nBlockColumns;
+    const unsigned int nColumns = std::min (m_nBlockColumns, m_nx - ixStart);
+    if (! ArrayCodec::encode (m_iCompression, pBlock + ixStart * columnBytes, nColumns * m_ny, m_pixelSize, vecEncoded))
+      return false;
+    m_vecBlockOffset[iBlock] = fs.tellp();
+    fs.write (reinterpret_cast<const char*>(&vecEncoded[0]), vecEncoded.size());
   }
-  if (m_dataType == DATA_TYPE_COMPLEX) {
-    for (unsigned int ix = 0; ix < m_nx; ix++) {
-      unsigned char* ptrColumn = m_imaginaryArrayData[ix];
-      if (NativeBigEndian()) {
-        for (unsigned int iy = 0; iy < m_ny; iy++) {
-          fs.read (reinterpret_cast<char*>(ptrColumn), m_pixelSize);
-          ConvertReverseNetworkOrder (ptrColumn, m_pixelSize);
-          ptrColumn += m_pixelSize;
-        }
-      } else
-        fs.read (reinterpret_cast<char*>(ptrColumn), columnSize);
+  m_vecBlockOffset[nBlocks] = fs.tellp();
+  fs.seekp (m_headersize);
+  fs.writeArray (&m_vecBlockOffset[0], nBlocks + 1, sizeof(kuint64));
+
+  return ! fs.fail();
+}
+
+
+bool
+Array2dFile::arrayDataReadCompressed (frnetorderstream& fs)
+{
+  const unsigned int nBlockX = (m_nx + m_nBlockColumns - 1) / m_nBlockColumns;
+  const unsigned int nBlocks = m_dataType == DATA_TYPE_COMPLEX ? 2 * nBlockX : nBlockX;
+  const size_t columnBytes = static_cast<size_t>(m_ny) * m_pixelSize;
+
+  m_vecBlockOffset.resize (nBlocks + 1);
+  fs.seekg (m_headersize);
+  fs.readArray (&m_vecBlockOffset[0], nBlocks + 1, sizeof(kuint64));
+  if (fs.fail())
+    return false;
+
+  std::vector<unsigned char> vecEncoded;
+  for (unsigned int iBlock = 0; iBlock < nBlocks; iBlock++) {
+    if (m_vecBlockOffset[iBlock + 1] < m_vecBlockOffset[iBlock]) {
+      sys_error (ERR_WARNING, "Invalid block index in %s [arrayDataRead]", m_filename.c_str());
+      return false;
+    }
+    unsigned char* pBlock = iBlock < nBlockX ? m_pArrayBlock : m_pImaginaryArrayBlock;
+    const unsigned int ixStart = (iBlock % nBlockX) * m_nBlockColumns;
+    const unsigned int nColumns = std::min (m_nBlockColumns, m_nx - ixStart);
+    vecEncoded.resize (m_vecBlockOffset[iBlock + 1] - m_vecBlockOffset[iBlock]);
+    fs.seekg (m_vecBlockOffset[iBlock]);
+    fs.read (reinterpret_cast<char*>(&vecEncoded[0]), vecEncoded.size());
+    if (fs.fail() || ! ArrayCodec::decode (m_iCompression, &vecEncoded[0], vecEncoded.size(),
+                                            pBlock + ixStart * columnBytes, nColumns * m_ny, m_pixelSize)) {
+      sys_error (ERR_WARNING, "Error reading block %d of %s [arrayDataRead]", iBlock, m_filename.c_str());
+      return false;
     }
   }
 
   return true;
 }
 
+
+off_t
+Array2dFile::labelsOffset () const
+{
+  if (m_iCompression != ArrayCodec::CODEC_NONE && ! m_vecBlockOffset.empty())
+    return m_vecBlockOffset.back();
+
+  return m_headersize + static_cast<off_t>(m_nx) * m_ny * m_pixelSize;
+}
+
+
 bool
 Array2dFile::labelsRead (frnetorderstream& fs)
 {
-  off_t pos = m_headersize + m_arraySize;
+  off_t pos = labelsOffset();
   fs.seekg (pos);
   if (fs.fail())
     return false;
@@ -601,7 +955,7 @@ Array2dFile::labelsRead (frnetorderstream& fs)
 bool
 Array2dFile::labelsWrite (frnetorderstream& fs)
 {
-  off_t pos = m_headersize + m_arraySize;
+  off_t pos = labelsOffset();
   fs.seekp (pos);
 
   for (constLabelIterator l = m_labels.begin(); l != m_labels.end(); l++) {
@@ -674,16 +1028,10 @@ Array2dFile::labelsCopy (const Array2dFile& copyFile, const char* const pszId)
 void
 Array2dFile::arrayDataClear (void)
 {
-  if (m_arrayData) {
-    int columnSize = m_ny * m_pixelSize;
-    for (unsigned int ix = 0; ix < m_nx; ix++)
-      memset (m_arrayData[ix], 0, columnSize);
-  }
-  if (m_imaginaryArrayData) {
-    int columnSize = m_ny * m_pixelSize;
-    for (unsigned int ix = 0; ix < m_nx; ix++)
-      memset (m_arrayData[ix], 0, columnSize);
-  }
+  if (m_pArrayBlock)
+    memset (m_pArrayBlock, 0, size() * m_pixelSize);
+  if (m_pImaginaryArrayBlock)
+    memset (m_pImaginaryArrayBlock, 0, size() * m_pixelSize);
 }
 
 void
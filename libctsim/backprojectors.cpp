@@ -30,6 +30,7 @@ const int Backprojector::BPROJ_TRIG = 0;
 const int Backprojector::BPROJ_TABLE = 1;
 const int Backprojector::BPROJ_DIFF = 2;
 const int Backprojector::BPROJ_IDIFF = 3;
+const int Backprojector::BPROJ_MATRIX = 4;
 
 const char* const Backprojector::s_aszBackprojectName[] =
 {
@@ -37,6 +38,7 @@ const char* const Backprojector::s_aszBackprojectName[] =
   "table",
   "diff",
   "idiff",
+  "matrix",
 };
 
 const char* const Backprojector::s_aszBackprojectTitle[] =
@@ -45,6 +47,7 @@ const char* const Backprojector::s_aszBackprojectTitle[] =
   "Trigometric Table",
   "Difference Iteration",
   "Integer Difference Iteration",
+  "Sparse System Matrix",
 };
 
 const int Backprojector::s_iBackprojectCount = sizeof(s_aszBackprojectName) / sizeof(const char*);
@@ -157,7 +160,20 @@ Backprojector::initBackprojector (const Projections& proj, ImageFile& im, const
     return false;
   }
 
-  if (proj.geometry() == Scanner::GEOMETRY_EQUILINEAR)
+  if (m_idBackproject == BPROJ_MATRIX) {
+    if (proj.geometry() != Scanner::GEOMETRY_PARALLEL) {
+      m_fail = true;
+      m_failMessage = "Matrix backprojection requires parallel geometry, rebin to parallel first";
+      return false;
+    }
+    BackprojectMatrix* pMatrixImplem = new BackprojectMatrix (proj, im, m_idInterpolation, interpFactor, pROI);
+    m_pBackprojectImplem = static_cast<Backproject*>(pMatrixImplem);
+    if (pMatrixImplem->fail()) {
+      m_fail = true;
+      m_failMessage = pMatrixImplem->failMessage();
+      return false;
+    }
+  } else if (proj.geometry() == Scanner::GEOMETRY_EQUILINEAR)
     m_pBackprojectImplem = static_cast<Backproject*>(new BackprojectEquilinear(proj, im, m_idInterpolation, interpFactor, pROI));
   else if (proj.geometry() == Scanner::GEOMETRY_EQUIANGULAR)
     m_pBackprojectImplem = static_cast<Backproject*>(new BackprojectEquiangular(proj, im, m_idInterpolation, interpFactor, pROI));
@@ -652,6 +668,84 @@ BackprojectIntDiff::BackprojectView (const double* const filteredProj, const dou
     delete pCubicInterp;
 }
 
+// CLASS IDENTICATION
+//   BackprojectMatrix
+//
+// PURPOSE
+//   Backprojects by the transpose of the SystemMatrix. The matrix is read
+//   from the default cache directory when available.
+//
+// NOTES
+//   A pixel collects from each view about xInc*yInc/detInc of ray weight,
+//   which is divided out along with the rotation increment.
+
+BackprojectMatrix::BackprojectMatrix (const Projections& proj, ImageFile& im, int interpType,
+                                      const int interpFactor, const ReconstructionROI* pROI)
+: Backproject (proj, im, interpType, interpFactor, pROI), m_iLastView(-1), m_bFail(false)
+{
+  m_pMatrix = new SystemMatrix (proj, nx, ny, xMin, xMax, yMin, yMax);
+  if (m_pMatrix->fail()) {
+    m_bFail = true;
+    m_strFailMessage = m_pMatrix->failMessage();
+    return;
+  }
+
+  m_vecImage.assign (nx * ny, 0.);
+  m_vecRaysums.resize (nDet);
+}
+
+BackprojectMatrix::~BackprojectMatrix ()
+{
+  delete m_pMatrix;
+}
+
+int
+BackprojectMatrix::findView (double viewAngle)
+{
+  const double dTolerance = 1E-9 * dmax (1., fabs (viewAngle));
+  if (m_iLastView + 1 < proj.nView()
+      && fabs (proj.getDetectorArray (m_iLastView + 1).viewAngle() - viewAngle) <= dTolerance)
+    return m_iLastView + 1;
+
+  for (int iView = 0; iView < proj.nView(); iView++)
+    if (fabs (proj.getDetectorArray (iView).viewAngle() - viewAngle) <= dTolerance)
+      return iView;
+
+  return -1;
+}
+
+void
+BackprojectMatrix::BackprojectView (const double* const filteredProj, const double view_angle)
+{
+  if (m_bFail)
+    return;
+
+  const int iView = findView (view_angle);
+  if (iView < 0) {
+    sys_error (ERR_WARNING, "View angle %f not in system matrix [BackprojectMatrix::BackprojectView]", view_angle);
+    return;
+  }
+  m_iLastView = iView;
+
+  for (int iDet = 0; iDet < nDet; iDet++)
+    m_vecRaysums[iDet] = filteredProj[iDet];
+  m_pMatrix->multiplyTranspose (&m_vecRaysums[0], &m_vecImage[0], iView * nDet, nDet);
+}
+
+void
+BackprojectMatrix::PostProcessing()
+{
+  if (! m_bPostProcessingDone) {
+    const double dScale = rotScale * detInc / (xInc * yInc);
+    for (int ix = 0; ix < nx; ix++) {
+      const double* pdCol = &m_vecImage[ix * ny];
+      for (int iy = 0; iy < ny; iy++)
+        v[ix][iy] = pdCol[iy] * dScale;
+    }
+    m_bPostProcessingDone = true;
+  }
+}
+
 
 void
 BackprojectEquiangular::BackprojectView (const double* const filteredProj, const double view_angle)
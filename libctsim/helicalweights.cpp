@@ -0,0 +1,416 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:         helicalweights.cpp    Helical interpolation and half-scan weight tables
+**   Programmer:   Kevin Rosenberg
+**   Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+static pthread_mutex_t s_mutexWeightCache = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+const int ProjectionWeightMap::MAP_HELICAL_180LI = 0;
+const int ProjectionWeightMap::MAP_HALFSCAN_FEATHER = 1;
+
+std::vector<ProjectionWeightMap*> ProjectionWeightMap::s_vecCache;
+const unsigned int ProjectionWeightMap::s_nMaxCacheEntries = 4;
+
+
+// Fan angle of each detector
+
+static void
+calcDetectorFanAngles (const Projections& proj, std::vector<double>& vecGamma)
+{
+  const int nDet = proj.nDet();
+  vecGamma.resize (nDet);
+  for (int iDet = 0; iDet < nDet; iDet++) {
+    const double dPos = (iDet - (nDet - 1) / 2) * proj.detInc();
+    if (proj.geometry() == Scanner::GEOMETRY_EQUIANGULAR)
+      vecGamma[iDet] = dPos;
+    else if (proj.geometry() == Scanner::GEOMETRY_EQUILINEAR)
+      vecGamma[iDet] = atan (dPos / proj.sourceDetectorLength());
+    else
+      vecGamma[iDet] = 0;
+  }
+}
+
+
+// One weighted source sample of a target sample, collected in the order
+// the sources are visited
+
+struct ProjectionWeightTerm {
+  kuint32 m_iTarget;
+  kuint32 m_iSource;
+  double m_dWeight;
+};
+
+
+class ProjectionWeightTask : public WorkerThreadTask {
+private:
+  const ProjectionWeightMap& m_rMap;
+  const Projections& m_rProj;
+  int m_iSourceOffset;
+  Projections& m_rTarget;
+
+public:
+  ProjectionWeightTask (const ProjectionWeightMap& rMap, const Projections& rProj, int iSourceOffset,
+                        Projections& rTarget)
+    : m_rMap(rMap), m_rProj(rProj), m_iSourceOffset(iSourceOffset), m_rTarget(rTarget)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    for (int iView = iStartUnit; iView < iStartUnit + iNumUnits; iView++)
+      m_rMap.applyView (m_rProj, m_iSourceOffset, iView, m_rTarget.getDetectorArray (iView));
+  }
+};
+
+
+ProjectionWeightMap::ProjectionWeightMap ()
+  : m_iReferences(0), m_nTargetView(0), m_nSourceView(0), m_nDet(0)
+{}
+
+
+// NAME
+//   makeKey              Description of everything a table depends on
+
+std::string
+ProjectionWeightMap::makeKey (const Projections& proj, int idMap)
+{
+  std::ostringstream os;
+  os.precision (17);
+  os << (idMap == MAP_HELICAL_180LI ? "helical180li" : "halfscanfeather")
+     << " geometry=" << Scanner::convertGeometryIDToName (proj.geometry())
+     << " ndet=" << proj.nDet() << " rotinc=" << proj.rotInc() << " detinc=" << proj.detInc()
+     << " fanangle=" << proj.fanBeamAngle();
+  if (proj.geometry() == Scanner::GEOMETRY_EQUILINEAR)
+    os << " sdl=" << proj.sourceDetectorLength();
+  if (idMap == MAP_HALFSCAN_FEATHER)
+    os << " nview=" << proj.nView();
+
+  return os.str();
+}
+
+
+// NAME
+//   acquire              Find or build the table of a kind for a geometry
+//
+// NOTES
+//   Tables are built while holding the cache lock so that threads asking
+//   for the same geometry at once share one table.
+
+const ProjectionWeightMap*
+ProjectionWeightMap::acquire (const Projections& proj, int idMap, std::string& strFailMessage)
+{
+  const std::string strKey = makeKey (proj, idMap);
+
+  ProjectionWeightMap* pMap = NULL;
+  ProjectionWeightMap* pEvicted = NULL;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexWeightCache);
+#endif
+  for (unsigned int i = 0; i < s_vecCache.size(); i++)
+    if (s_vecCache[i]->m_strKey == strKey) {
+      pMap = s_vecCache[i];
+      // most recently used tables are kept at the end
+      s_vecCache.erase (s_vecCache.begin() + i);
+      break;
+    }
+
+  if (! pMap) {
+    pMap = new ProjectionWeightMap;
+    pMap->m_strKey = strKey;
+    pMap->m_iReferences = 1;    // held by the cache
+    bool bOk;
+    if (idMap == MAP_HELICAL_180LI)
+      bOk = pMap->buildHelical180LI (proj, strFailMessage);
+    else
+      bOk = pMap->buildHalfScanFeather (proj, strFailMessage);
+    if (! bOk) {
+      delete pMap;
+      pMap = NULL;
+    } else if (s_vecCache.size() >= s_nMaxCacheEntries) {
+      if (--s_vecCache.front()->m_iReferences == 0)
+        pEvicted = s_vecCache.front();
+      s_vecCache.erase (s_vecCache.begin());
+    }
+  }
+  if (pMap) {
+    pMap->m_iReferences++;
+    s_vecCache.push_back (pMap);
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexWeightCache);
+#endif
+
+  delete pEvicted;
+  return pMap;
+}
+
+void
+ProjectionWeightMap::release (const ProjectionWeightMap* pMap)
+{
+  ProjectionWeightMap* pMapRelease = const_cast<ProjectionWeightMap*>(pMap);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexWeightCache);
+#endif
+  bool bDelete = --pMapRelease->m_iReferences == 0;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexWeightCache);
+#endif
+  if (bDelete)
+    delete pMapRelease;
+}
+
+void
+ProjectionWeightMap::clearCache ()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexWeightCache);
+#endif
+  std::vector<ProjectionWeightMap*> vecCache;
+  vecCache.swap (s_vecCache);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexWeightCache);
+#endif
+  for (unsigned int i = 0; i < vecCache.size(); i++)
+    release (vecCache[i]);
+}
+
+
+// NAME
+//   buildHelical180LI    Crawford and King 180LI weights of a helical scan
+//
+// NOTES
+//   Source views cover gantry angles 0 to 2*(pi+fanAngle) from the first
+//   source view. Rays before pi+fanAngle weight their own sample, later
+//   rays weight the complementary sample at beta+2*gamma-pi, -gamma. The
+//   regions are those listed with Projections::Helical180LI.
+
+bool
+ProjectionWeightMap::buildHelical180LI (const Projections& proj, std::string& strFailMessage)
+{
+  const double dbeta = proj.rotInc();
+  const double fanAngle = proj.fanBeamAngle();
+  if (dbeta <= 0) {
+    strFailMessage = "Invalid rotation increment";
+    return false;
+  }
+
+  m_nDet = proj.nDet();
+  const int last_interp_view = static_cast<int> ((PI+fanAngle)/dbeta);
+  const int last_acq_view = 2*last_interp_view;
+  m_nTargetView = last_interp_view + 1;
+  m_nSourceView = last_acq_view + 1;
+
+  std::vector<double> vecGamma;
+  calcDetectorFanAngles (proj, vecGamma);
+
+  m_vecDirectWeight.assign (static_cast<size_t>(m_nTargetView) * m_nDet, 0.);
+  std::vector<ProjectionWeightTerm> vecTerms;
+  vecTerms.reserve (static_cast<size_t>(m_nTargetView) * m_nDet);
+
+  for (int iView = 0 ; iView <= last_acq_view; iView++) {
+    const double beta = iView * dbeta;
+    for (int iDet = 0; iDet < m_nDet; iDet++) {
+      const double gamma = vecGamma[iDet];
+      if (! (beta > fanAngle - 2*gamma && beta < 2*PI + fanAngle - 2*gamma))
+        continue;   // in region 1 or 8
+
+      double w;
+      if ((beta > fanAngle - 2*gamma && beta <= 2*fanAngle)        // region 2
+          || (beta > 2*fanAngle && beta <= PI - 2*gamma)          // region 3
+          || (beta > PI - 2*gamma && beta <= PI + fanAngle))      // region 4
+        w = (beta + 2*gamma - fanAngle) / (PI + 2*gamma);
+      else if ((beta > PI + fanAngle && beta <= PI + 2*fanAngle - 2*gamma)   // region 5
+               || (beta > PI + 2*fanAngle - 2*gamma && beta <= 2*PI)       // region 6
+               || (beta > 2*PI && beta <= 2*PI + fanAngle - 2*gamma))      // region 7
+        w = (2*PI - beta - 2*gamma + fanAngle) / (PI - 2*gamma);
+      else
+        continue;   // outside region of interest
+
+      if (beta < PI + fanAngle)
+        m_vecDirectWeight[iView * m_nDet + iDet] = w;
+      else {
+        const int newiDet = (m_nDet - 1) - iDet;
+        const int newiView = nearest<int> ((iView*dbeta + 2*gamma - PI) / dbeta);
+        if (newiView < 0 || newiView > last_interp_view)
+          continue;
+        ProjectionWeightTerm term;
+        term.m_iTarget = newiView * m_nDet + newiDet;
+        term.m_iSource = iView * m_nDet + iDet;
+        term.m_dWeight = w;
+        vecTerms.push_back (term);
+      }
+    }
+  }
+
+  // Group the terms by target, keeping the order the sources were visited
+  const size_t nTargets = static_cast<size_t>(m_nTargetView) * m_nDet;
+  m_vecRowStart.assign (nTargets + 1, 0);
+  size_t iTerm;
+  for (iTerm = 0; iTerm < vecTerms.size(); iTerm++)
+    m_vecRowStart[vecTerms[iTerm].m_iTarget + 1]++;
+  for (size_t i = 0; i < nTargets; i++)
+    m_vecRowStart[i + 1] += m_vecRowStart[i];
+
+  std::vector<kuint32> vecNext (m_vecRowStart.begin(), m_vecRowStart.end() - 1);
+  m_vecSource.resize (vecTerms.size());
+  m_vecWeight.resize (vecTerms.size());
+  for (iTerm = 0; iTerm < vecTerms.size(); iTerm++) {
+    kuint32 iPos = vecNext[vecTerms[iTerm].m_iTarget]++;
+    m_vecSource[iPos] = vecTerms[iTerm].m_iSource;
+    m_vecWeight[iPos] = vecTerms[iTerm].m_dWeight;
+  }
+
+  return true;
+}
+
+
+// NAME
+//   buildHalfScanFeather   Crawford and King half-scan feathering weights
+//
+// NOTES
+//   Each sample in the redundant region is copied to its complementary
+//   sample and the two are weighted to sum to one. The copies and weights
+//   are composed here, so every target is one source sample times a
+//   weight. Where the feathering interval is empty, as for parallel
+//   geometry, the two samples are averaged.
+
+bool
+ProjectionWeightMap::buildHalfScanFeather (const Projections& proj, std::string& strFailMessage)
+{
+  const double dbeta = proj.rotInc();
+  const double fanAngle = proj.fanBeamAngle();
+
+  m_nDet = proj.nDet();
+  m_nTargetView = m_nSourceView = proj.nView();
+  const size_t nSamples = static_cast<size_t>(m_nTargetView) * m_nDet;
+
+  std::vector<double> vecGamma;
+  calcDetectorFanAngles (proj, vecGamma);
+
+  std::vector<kuint32> vecSource (nSamples);
+  std::vector<double> vecWeight (nSamples, 1.);
+  for (size_t i = 0; i < nSamples; i++)
+    vecSource[i] = i;
+
+  for (int iView2 = 0 ; iView2 < m_nTargetView; iView2++) {
+    const double beta2 = iView2 * dbeta;
+    for (int iDet2 = 0; iDet2 < m_nDet; iDet2++) {
+      const double gamma2 = vecGamma[iDet2];
+      if (beta2 < PI - 2*gamma2)
+        continue;   // not in redundant data region
+
+      const int iDet1 = (m_nDet - 1) - iDet2;
+      const int iView1 = nearest<int> ((iView2*dbeta + 2*gamma2 - PI) / dbeta);
+      if (iView1 < 0 || iView1 >= m_nTargetView) {
+        strFailMessage = "Complementary ray lies outside of the half-scan data";
+        return false;
+      }
+
+      const double beta1 = iView1 * dbeta;
+      const double gamma1 = -gamma2;
+      double x;
+      if (beta1 <= fanAngle - 2*gamma1)
+        x = fanAngle - 2*gamma1 > 0 ? beta1 / (fanAngle - 2*gamma1) : 0.5;
+      else if (beta1 <= PI - 2*gamma1)
+        x = 1;
+      else if (beta1 <= PI + fanAngle)
+        x = fanAngle + 2*gamma1 > 0 ? (PI + fanAngle - beta1) / (fanAngle + 2*gamma1) : 0.5;
+      else {
+        strFailMessage = "Complementary ray lies beyond the half-scan gantry angles";
+        return false;
+      }
+      const double w1 = (3*x - 2*x*x)*x;
+      const double w2 = 1 - w1;
+
+      const size_t i1 = static_cast<size_t>(iView1) * m_nDet + iDet1;
+      const size_t i2 = static_cast<size_t>(iView2) * m_nDet + iDet2;
+      vecSource[i1] = vecSource[i2];
+      vecWeight[i1] = vecWeight[i2] * w1;
+      vecWeight[i2] *= w2;
+    }
+  }
+
+  // heuristic scaling, why this factor?
+  const double scalefactor = m_nTargetView * dbeta / PI;
+
+  m_vecDirectWeight.assign (nSamples, 0.);
+  m_vecRowStart.assign (nSamples + 1, 0);
+  m_vecSource.clear();
+  m_vecWeight.clear();
+  for (size_t i = 0; i < nSamples; i++) {
+    if (vecSource[i] == i)
+      m_vecDirectWeight[i] = vecWeight[i] * scalefactor;
+    else {
+      m_vecSource.push_back (vecSource[i]);
+      m_vecWeight.push_back (vecWeight[i] * scalefactor);
+    }
+    m_vecRowStart[i + 1] = m_vecSource.size();
+  }
+
+  return true;
+}
+
+
+void
+ProjectionWeightMap::applyView (const Projections& proj, int iSourceOffset, int iTargetView, DetectorArray& rTarget) const
+{
+  DetectorValue* pTarget = rTarget.detValues();
+  const DetectorValue* pDirect = proj.getDetectorArray (iTargetView + iSourceOffset).detValues();
+  const double* pdDirectWeight = &m_vecDirectWeight[static_cast<size_t>(iTargetView) * m_nDet];
+
+  for (int iDet = 0; iDet < m_nDet; iDet++)
+    pTarget[iDet] = static_cast<DetectorValue>(pdDirectWeight[iDet] * pDirect[iDet]);
+
+  const kuint32* pRowStart = &m_vecRowStart[static_cast<size_t>(iTargetView) * m_nDet];
+  if (pRowStart[0] == pRowStart[m_nDet])
+    return;
+  // source samples index the sinogram from the first source view
+  const DetectorValue* pSource = proj.getSinogram();
+  if (pSource) {
+    pSource += static_cast<size_t>(iSourceOffset) * m_nDet;
+    for (int iDet = 0; iDet < m_nDet; iDet++)
+      for (kuint32 iTerm = pRowStart[iDet]; iTerm < pRowStart[iDet + 1]; iTerm++)
+        pTarget[iDet] += m_vecWeight[iTerm] * pSource[m_vecSource[iTerm]];
+  } else {
+    // mapped projections have no sinogram
+    for (int iDet = 0; iDet < m_nDet; iDet++)
+      for (kuint32 iTerm = pRowStart[iDet]; iTerm < pRowStart[iDet + 1]; iTerm++) {
+        const kuint32 iSource = m_vecSource[iTerm];
+        const DetectorValue* pView = proj.getDetectorArray (iSource / m_nDet + iSourceOffset).detValues();
+        pTarget[iDet] += m_vecWeight[iTerm] * pView[iSource % m_nDet];
+      }
+  }
+}
+
+
+void
+ProjectionWeightMap::apply (const Projections& proj, int iSourceOffset, Projections& rTarget, int nThreads) const
+{
+  ProjectionWeightTask task (*this, proj, iSourceOffset, rTarget);
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (m_nTargetView);
+  threads.run (task);
+}
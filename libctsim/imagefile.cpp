@@ -301,13 +301,8 @@ ImageFile::statistics (ImageFileArrayConst v, double& min, double& max, double&
   if (v == NULL || nx == 0 || ny == 0)
     return;
 
-  std::vector<double> vecImage;
-  int iVec = 0;
-  vecImage.resize (nx * ny);
-  for (int ix = 0; ix < nx; ix++) {
-    for (int iy = 0; iy < ny; iy++)
-      vecImage[iVec++] = v[ix][iy];
-  }
+  // the columns of v are adjacent, starting at v[0]
+  std::vector<double> vecImage (v[0], v[0] + nx * ny);
 
   vectorNumericStatistics (vecImage, nx * ny, min, max, mean, mode, median, stddev);
 }
@@ -322,16 +317,10 @@ ImageFile::getMinMax (double& min, double& max) const
   if (v == NULL || nx == 0 || ny == 0)
     return;
 
-  min = v[0][0];
-  max = v[0][0];
-  for (int ix = 0; ix < nx; ix++) {
-    for (int iy = 0; iy < ny; iy++) {
-      if (v[ix][iy] > max)
-        max = v[ix][iy];
-      if (v[ix][iy] < min)
-        min = v[ix][iy];
-    }
-  }
+  ImageFileValue fMin, fMax;
+  minmax_array (data(), nx * ny, fMin, fMax);
+  min = fMin;
+  max = fMax;
 }
 
 bool
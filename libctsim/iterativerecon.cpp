@@ -0,0 +1,322 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:         iterativerecon.cpp      Iterative reconstruction class
+**   Programmer:   Kevin Rosenberg
+**   Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+#include "timer.h"
+
+
+// Accumulates the interpolated image along a ray
+class JosephRaySum {
+public:
+  const double* m_pdImage;
+  int m_ny;
+  double m_dSum;
+  double m_dWeight;
+
+  JosephRaySum (const double* pdImage, int ny)
+    : m_pdImage(pdImage), m_ny(ny), m_dSum(0), m_dWeight(0)
+  {}
+
+  void operator() (int ix, int iy, double dWeight)
+  { m_dSum += dWeight * m_pdImage[ix * m_ny + iy]; m_dWeight += dWeight; }
+};
+
+// Spreads a value back along a ray with the same weights as JosephRaySum
+class JosephRaySpread {
+public:
+  double* m_pdCorrection;
+  double* m_pdWeight;
+  int m_ny;
+  double m_dValue;
+
+  JosephRaySpread (double* pdCorrection, double* pdWeight, int ny, double dValue)
+    : m_pdCorrection(pdCorrection), m_pdWeight(pdWeight), m_ny(ny), m_dValue(dValue)
+  {}
+
+  void operator() (int ix, int iy, double dWeight)
+  { const int i = ix * m_ny + iy; m_pdCorrection[i] += dWeight * m_dValue; m_pdWeight[i] += dWeight; }
+};
+
+
+class IterativeSubsetTask : public WorkerThreadTask {
+private:
+  IterativeReconstructor& m_rRecon;
+
+public:
+  IterativeSubsetTask (IterativeReconstructor& rRecon)
+    : m_rRecon(rRecon)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  { m_rRecon.processRays (iThread, iStartUnit, iNumUnits); }
+};
+
+
+IterativeReconstructor::IterativeReconstructor (const Projections& rProj, ImageFile& rIF,
+                                                const char* const methodName, int nSubsets,
+                                                double dRelaxation, int nThreads, const int iTrace)
+  : m_rProj(rProj), m_rImagefile(rIF), m_nSubsets(nSubsets), m_dRelaxation(dRelaxation),
+    m_iTrace(iTrace), m_bFail(false), m_pProjector(NULL), m_pMatrix(NULL), m_pThreads(NULL)
+{
+  m_idMethod = Reconstructor::convertMethodNameToID (methodName);
+  if (m_idMethod == Reconstructor::METHOD_INVALID || m_idMethod == Reconstructor::METHOD_FBP) {
+    m_bFail = true;
+    m_strFailMessage = "Invalid iterative reconstruction method ";
+    m_strFailMessage += methodName;
+    return;
+  }
+  if (m_rProj.geometry() != Scanner::GEOMETRY_PARALLEL && m_rProj.geometry() != Scanner::GEOMETRY_EQUILINEAR
+      && m_rProj.geometry() != Scanner::GEOMETRY_EQUIANGULAR) {
+    m_bFail = true;
+    m_strFailMessage = "Invalid geometry for iterative reconstruction";
+    return;
+  }
+  if (m_dRelaxation <= 0) {
+    m_bFail = true;
+    m_strFailMessage = "Relaxation factor must be positive";
+    return;
+  }
+
+  if (m_idMethod == Reconstructor::METHOD_SART)
+    m_nSubsets = m_rProj.nView();
+  m_nSubsets = clamp (m_nSubsets, 1, m_rProj.nView());
+
+  // Visit subsets with a stride near the golden section so that consecutive
+  // subsets are far apart in angle
+  int iStride = imax (1, nearest<int> (m_nSubsets * 0.381966));
+  while (iStride > 1) {
+    int a = m_nSubsets, b = iStride;
+    while (b != 0) {
+      int t = a % b;
+      a = b;
+      b = t;
+    }
+    if (a == 1)
+      break;
+    iStride--;
+  }
+  m_vecSubsetOrder.resize (m_nSubsets);
+  for (int i = 0; i < m_nSubsets; i++)
+    m_vecSubsetOrder[i] = (i * iStride) % m_nSubsets;
+
+  // Same image area as Backproject
+  m_nx = m_rImagefile.nx();
+  m_ny = m_rImagefile.ny();
+  m_dXMin = -m_rProj.phmLen() / 2;
+  m_dYMin = -m_rProj.phmLen() / 2;
+  m_dXInc = m_rProj.phmLen() / m_nx;
+  m_dYInc = m_rProj.phmLen() / m_ny;
+  m_rImagefile.setAxisIncrement (m_dXInc, m_dYInc);
+  m_rImagefile.setAxisExtent (m_dXMin, m_dXMin + m_rProj.phmLen(), m_dYMin, m_dYMin + m_rProj.phmLen());
+
+  m_pProjector = new JosephProjector (m_rProj, m_nx, m_ny, m_dXMin, m_dXMin + m_rProj.phmLen(),
+                                      m_dYMin, m_dYMin + m_rProj.phmLen());
+
+  // EM updates are multiplicative and need a positive starting image
+  const double dInitial = (m_idMethod == Reconstructor::METHOD_OS_EM) ? 1. : 0.;
+  m_vecImage.assign (m_nx * m_ny, dInitial);
+  copyImage();
+
+  m_pThreads = new WorkerThreads (nThreads);
+  const int nThreadsUsed = m_pThreads->getNumThreads();
+  m_vecThreadCorrection.resize (nThreadsUsed);
+  m_vecThreadWeight.resize (nThreadsUsed);
+  m_vecThreadResidual.resize (nThreadsUsed);
+  m_vecThreadDataNorm.resize (nThreadsUsed);
+  for (int iThread = 0; iThread < nThreadsUsed; iThread++) {
+    m_vecThreadCorrection[iThread].resize (m_nx * m_ny);
+    m_vecThreadWeight[iThread].resize (m_nx * m_ny);
+  }
+}
+
+IterativeReconstructor::~IterativeReconstructor ()
+{
+  delete m_pThreads;
+  delete m_pProjector;
+}
+
+
+// NAME
+//   setSystemMatrix      Use a precomputed matrix in place of tracing rays
+//
+// NOTES
+//   The matrix must have been built for this projection file and image
+
+bool
+IterativeReconstructor::setSystemMatrix (const SystemMatrix* pMatrix)
+{
+  if (pMatrix && (pMatrix->fail() || pMatrix->key() != SystemMatrix::makeKey (m_rProj, m_nx, m_ny,
+        m_dXMin, m_dXMin + m_rProj.phmLen(), m_dYMin, m_dYMin + m_rProj.phmLen())))
+    return false;
+
+  m_pMatrix = pMatrix;
+  return true;
+}
+
+
+void
+IterativeReconstructor::copyImage ()
+{
+  ImageFileArray v = m_rImagefile.getArray();
+  for (int ix = 0; ix < m_nx; ix++) {
+    ImageFileColumn vCol = v[ix];
+    const double* pdCol = &m_vecImage[ix * m_ny];
+    for (int iy = 0; iy < m_ny; iy++)
+      vCol[iy] = pdCol[iy];
+  }
+}
+
+
+void
+IterativeReconstructor::processRays (int iThread, int iStartRay, int iNumRays)
+{
+  const int nDet = m_rProj.nDet();
+  const double* pdImage = &m_vecImage[0];
+  double* pdCorrection = &m_vecThreadCorrection[iThread][0];
+  double* pdWeight = &m_vecThreadWeight[iThread][0];
+  const bool bEM = m_idMethod == Reconstructor::METHOD_OS_EM;
+  double dResidual = 0;
+  double dDataNorm = 0;
+
+  for (int iRay = iStartRay; iRay < iStartRay + iNumRays; iRay++) {
+    const int iView = m_vecSubsetViews[iRay / nDet];
+    const int iDet = iRay % nDet;
+    const int iRow = iView * nDet + iDet;
+
+    double dRaySum, dRayWeight;
+    if (m_pMatrix)
+      dRaySum = m_pMatrix->rowSum (iRow, pdImage, dRayWeight);
+    else {
+      JosephRaySum raySum (pdImage, m_ny);
+      m_pProjector->traceRay (iView, iDet, raySum);
+      dRaySum = raySum.m_dSum;
+      dRayWeight = raySum.m_dWeight;
+    }
+    if (dRayWeight <= 0)
+      continue;
+
+    const double dMeasured = m_rProj.getDetectorArray (iView).detValues()[iDet];
+    const double dDiff = dMeasured - dRaySum;
+    dResidual += dDiff * dDiff;
+    dDataNorm += dMeasured * dMeasured;
+
+    double dCorrection;
+    if (bEM) {
+      if (dRaySum <= 0)
+        continue;
+      dCorrection = (dMeasured > 0 ? dMeasured : 0) / dRaySum;
+    } else
+      dCorrection = dDiff / dRayWeight;
+
+    if (m_pMatrix)
+      m_pMatrix->rowSpread (iRow, dCorrection, pdCorrection, pdWeight);
+    else {
+      JosephRaySpread raySpread (pdCorrection, pdWeight, m_ny, dCorrection);
+      m_pProjector->traceRay (iView, iDet, raySpread);
+    }
+  }
+
+  m_vecThreadResidual[iThread] += dResidual;
+  m_vecThreadDataNorm[iThread] += dDataNorm;
+}
+
+
+void
+IterativeReconstructor::processSubset (int iSubset)
+{
+  m_vecSubsetViews.clear();
+  for (int iView = iSubset; iView < m_rProj.nView(); iView += m_nSubsets)
+    m_vecSubsetViews.push_back (iView);
+
+  const int nThreads = m_pThreads->getNumThreads();
+  const int nPixels = m_nx * m_ny;
+  for (int iThread = 0; iThread < nThreads; iThread++) {
+    std::fill (m_vecThreadCorrection[iThread].begin(), m_vecThreadCorrection[iThread].end(), 0.);
+    std::fill (m_vecThreadWeight[iThread].begin(), m_vecThreadWeight[iThread].end(), 0.);
+  }
+
+  IterativeSubsetTask task (*this);
+  m_pThreads->setTotalWorkUnits (m_vecSubsetViews.size() * m_rProj.nDet());
+  m_pThreads->run (task);
+
+  double* pdCorrection = &m_vecThreadCorrection[0][0];
+  double* pdWeight = &m_vecThreadWeight[0][0];
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    const double* pdThreadCorrection = &m_vecThreadCorrection[iThread][0];
+    const double* pdThreadWeight = &m_vecThreadWeight[iThread][0];
+    for (int i = 0; i < nPixels; i++) {
+      pdCorrection[i] += pdThreadCorrection[i];
+      pdWeight[i] += pdThreadWeight[i];
+    }
+  }
+
+  double* pdImage = &m_vecImage[0];
+  const bool bEM = m_idMethod == Reconstructor::METHOD_OS_EM;
+  for (int i = 0; i < nPixels; i++) {
+    const double dWeight = pdWeight[i];
+    if (dWeight <= 0)
+      continue;
+    if (bEM)
+      pdImage[i] *= pdCorrection[i] / dWeight;
+    else
+      pdImage[i] += m_dRelaxation * pdCorrection[i] / dWeight;
+  }
+}
+
+
+double
+IterativeReconstructor::reconstructIteration ()
+{
+  Timer timerIteration;
+
+  std::fill (m_vecThreadResidual.begin(), m_vecThreadResidual.end(), 0.);
+  std::fill (m_vecThreadDataNorm.begin(), m_vecThreadDataNorm.end(), 0.);
+  for (int i = 0; i < m_nSubsets; i++)
+    processSubset (m_vecSubsetOrder[i]);
+  copyImage();
+
+  double dResidual = 0;
+  double dDataNorm = 0;
+  for (unsigned int iThread = 0; iThread < m_vecThreadResidual.size(); iThread++) {
+    dResidual += m_vecThreadResidual[iThread];
+    dDataNorm += m_vecThreadDataNorm[iThread];
+  }
+  dResidual = dDataNorm > 0 ? sqrt (dResidual / dDataNorm) : 0.;
+
+  m_vecIterationResidual.push_back (dResidual);
+  m_vecIterationTime.push_back (timerIteration.timerEnd());
+  if (m_iTrace >= Trace::TRACE_CONSOLE)
+    std::cout << "Iteration " << m_vecIterationResidual.size() << ": residual=" << dResidual
+              << ", time=" << m_vecIterationTime.back() << " seconds\n";
+
+  return dResidual;
+}
+
+
+void
+IterativeReconstructor::reconstructIterations (int nIterations)
+{
+  for (int i = 0; i < nIterations; i++)
+    reconstructIteration();
+}
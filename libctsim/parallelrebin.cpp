@@ -0,0 +1,432 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:         parallelrebin.cpp      Rebin divergent beam projections to parallel
+**   Programmer:   Kevin Rosenberg
+**   Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+static pthread_mutex_t s_mutexRebinCache = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+// Source of one parallel raysum: detectors m_iDet and m_iDet + 1 of views
+// m_iView0 and m_iView1. m_iDet is negative for rays outside of the fan.
+
+struct ParallelRebinEntry {
+  kint32 m_iView0;
+  kint32 m_iView1;
+  kint32 m_iDet;
+  kfloat32 m_fViewWeight;    // weight of m_iView1
+  kfloat32 m_fDetWeight;     // weight of m_iDet + 1
+};
+
+struct ParallelRebinTable {
+  std::string m_strKey;
+  int m_iReferences;
+  std::vector<ParallelRebinEntry> m_vecEntries;   // nView * nDet, view major
+};
+
+std::vector<ParallelRebinTable*> ParallelRebinner::s_vecCache;
+const unsigned int ParallelRebinner::s_nMaxCacheEntries = 4;
+
+
+// Fan beam geometry of the source projections and the mapping of a
+// parallel ray to a fractional view and detector position
+
+class FanBeamMapping {
+private:
+  int m_iGeometry;
+  int m_nView;
+  int m_nDet;
+  bool m_bFullRotation;
+  double m_dRotStart;
+  double m_dRotInc;
+  double m_dFocalLength;
+  double m_dSourceDetectorLength;
+  double m_dCenterDetectorLength;
+  double m_dDetInc;
+  double m_dDetCenter;
+
+public:
+  FanBeamMapping (const Projections& proj)
+    : m_iGeometry(proj.geometry()), m_nView(proj.nView()), m_nDet(proj.nDet()),
+      m_dRotStart(proj.rotStart()), m_dRotInc(proj.rotInc()), m_dFocalLength(proj.focalLength()),
+      m_dSourceDetectorLength(proj.sourceDetectorLength()),
+      m_dCenterDetectorLength(proj.sourceDetectorLength() - proj.focalLength()), m_dDetInc(proj.detInc())
+  {
+    m_bFullRotation = m_nView * m_dRotInc >= TWOPI - m_dRotInc / 2;
+
+    // Detectors are placed as by the Scanner, equiangular detectors are
+    // spaced evenly in angle about the center of rotation
+    m_dDetCenter = (m_nDet - 1) / 2;
+    if (m_iGeometry == Scanner::GEOMETRY_EQUIANGULAR) {
+      m_dDetCenter = (m_nDet - 1) / 2.;
+      const double dAngle = -proj.detStart();
+      const double dHalfScan = m_dFocalLength * sin (dAngle);
+      if (dAngle > 0 && m_dCenterDetectorLength > dHalfScan)
+        m_dDetInc *= (HALFPI + dAngle - acos (dHalfScan / m_dCenterDetectorLength)) / dAngle;
+    }
+  }
+
+  // Fractional detector index of fan angle gamma, false if no detector lies there
+  bool detectorPosition (double dGamma, double& dDet) const
+  {
+    double dPos;
+    if (m_iGeometry == Scanner::GEOMETRY_EQUILINEAR)
+      dPos = m_dSourceDetectorLength * tan (dGamma);
+    else {
+      // angle about the center of rotation where the ray meets the detector circle
+      const double dSin = m_dFocalLength * sin (dGamma);
+      const double dDiscrim = m_dCenterDetectorLength * m_dCenterDetectorLength - dSin * dSin;
+      if (dDiscrim < 0)
+        return false;
+      const double dLength = m_dFocalLength * cos (dGamma) + sqrt (dDiscrim);
+      dPos = atan2 (dLength * sin (dGamma), dLength * cos (dGamma) - m_dFocalLength);
+    }
+    dDet = dPos / m_dDetInc + m_dDetCenter;
+    return dDet >= -0.5 && dDet <= m_nDet - 0.5;
+  }
+
+  // Fractional view index of gantry angle beta, false if outside of the scan
+  bool viewPosition (double dBeta, double& dView) const
+  {
+    if (m_bFullRotation) {
+      dView = fmod ((dBeta - m_dRotStart) / m_dRotInc, static_cast<double>(m_nView));
+      if (dView < 0)
+        dView += m_nView;
+      return true;
+    }
+    dView = fmod (dBeta - m_dRotStart, TWOPI);
+    if (dView < 0)
+      dView += TWOPI;
+    dView /= m_dRotInc;
+    return dView <= m_nView - 1;
+  }
+
+  void setEntry (double dTheta, double dT, ParallelRebinEntry& entry) const
+  {
+    entry.m_iView0 = entry.m_iView1 = 0;
+    entry.m_iDet = -1;
+    entry.m_fViewWeight = entry.m_fDetWeight = 0;
+    if (fabs (dT) >= m_dFocalLength)
+      return;
+
+    double dGamma = asin (dT / m_dFocalLength);
+    double dDet, dView;
+    if (! detectorPosition (dGamma, dDet))
+      return;
+    if (! viewPosition (dTheta - dGamma, dView)) {
+      // complementary ray travels the same path in the opposite direction
+      double dDetComplement, dViewComplement;
+      if (detectorPosition (-dGamma, dDetComplement) && viewPosition (dTheta + PI + dGamma, dViewComplement)) {
+        dDet = dDetComplement;
+        dView = dViewComplement;
+      } else
+        dView = clamp (dView, 0., static_cast<double>(m_nView - 1));
+    }
+
+    dDet = clamp (dDet, 0., static_cast<double>(m_nDet - 1));
+    int iDet = std::min (static_cast<int>(dDet), imax (m_nDet - 2, 0));
+    int iView = std::min (static_cast<int>(dView), m_nView - 1);
+    entry.m_iDet = iDet;
+    entry.m_fDetWeight = m_nDet > 1 ? static_cast<kfloat32>(dDet - iDet) : 0;
+    entry.m_iView0 = iView;
+    entry.m_iView1 = iView + 1 < m_nView ? iView + 1 : (m_bFullRotation ? 0 : iView);
+    entry.m_fViewWeight = static_cast<kfloat32>(dView - iView);
+  }
+};
+
+
+class ParallelRebinTableTask : public WorkerThreadTask {
+private:
+  const FanBeamMapping& m_rMapping;
+  ParallelRebinEntry* m_pEntries;
+  int m_nDet;
+  double m_dRotStart;
+  double m_dRotInc;
+  double m_dDetInc;
+
+public:
+  ParallelRebinTableTask (const FanBeamMapping& rMapping, ParallelRebinEntry* pEntries, int nDet,
+                          double dRotStart, double dRotInc, double dDetInc)
+    : m_rMapping(rMapping), m_pEntries(pEntries), m_nDet(nDet), m_dRotStart(dRotStart),
+      m_dRotInc(dRotInc), m_dDetInc(dDetInc)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    const int iDetCenter = (m_nDet - 1) / 2;
+    for (int iView = iStartUnit; iView < iStartUnit + iNumUnits; iView++) {
+      const double dTheta = m_dRotStart + iView * m_dRotInc;
+      ParallelRebinEntry* pEntry = m_pEntries + static_cast<size_t>(iView) * m_nDet;
+      for (int iDet = 0; iDet < m_nDet; iDet++)
+        m_rMapping.setEntry (dTheta, (iDet - iDetCenter) * m_dDetInc, pEntry[iDet]);
+    }
+  }
+};
+
+
+class ParallelRebinViewTask : public WorkerThreadTask {
+private:
+  const ParallelRebinner& m_rRebinner;
+  Projections& m_rParallelProj;
+
+public:
+  ParallelRebinViewTask (const ParallelRebinner& rRebinner, Projections& rParallelProj)
+    : m_rRebinner(rRebinner), m_rParallelProj(rParallelProj)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    for (int iView = iStartUnit; iView < iStartUnit + iNumUnits; iView++)
+      m_rRebinner.rebinView (iView, m_rParallelProj.getDetectorArray (iView));
+  }
+};
+
+
+// NAME
+//   ParallelRebinner     Find or build the rebinning table of a geometry
+//
+// NOTES
+//   The parallel projections cover a full rotation with the same number of
+//   views and detectors, and detectors spanning the view diameter.
+
+ParallelRebinner::ParallelRebinner (const Projections& rProj, int nThreads)
+  : m_rProj(rProj), m_bFail(false), m_bFromCache(false), m_nView(rProj.nView()), m_nDet(rProj.nDet()),
+    m_pTable(NULL)
+{
+  if (rProj.geometry() != Scanner::GEOMETRY_EQUIANGULAR && rProj.geometry() != Scanner::GEOMETRY_EQUILINEAR) {
+    m_bFail = true;
+    m_strFailMessage = "Only equiangular and equilinear projections can be rebinned to parallel";
+    return;
+  }
+  if (m_nView < 1 || m_nDet < 1 || rProj.rotInc() == 0 || rProj.detInc() == 0) {
+    m_bFail = true;
+    m_strFailMessage = "Projections have no views or detectors to rebin";
+    return;
+  }
+
+  m_dRotStart = 0;
+#ifdef CONVERT_PARALLEL_PI
+  m_dRotInc = PI / m_nView;
+#else
+  m_dRotInc = TWOPI / m_nView;
+#endif
+  m_dDetStart = -rProj.viewDiameter() / 2;
+  m_dDetInc = rProj.viewDiameter() / m_nDet;
+  if (isEven (m_nDet))
+    m_dDetInc = rProj.viewDiameter() / (m_nDet - 1);
+
+  m_strKey = makeKey (rProj);
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexRebinCache);
+#endif
+  for (unsigned int i = 0; i < s_vecCache.size(); i++)
+    if (s_vecCache[i]->m_strKey == m_strKey) {
+      m_pTable = s_vecCache[i];
+      m_pTable->m_iReferences++;
+      // most recently used tables are kept at the end
+      s_vecCache.erase (s_vecCache.begin() + i);
+      s_vecCache.push_back (m_pTable);
+      m_bFromCache = true;
+      break;
+    }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexRebinCache);
+#endif
+  if (m_pTable)
+    return;
+
+  ParallelRebinTable* pTable = new ParallelRebinTable;
+  pTable->m_strKey = m_strKey;
+  pTable->m_iReferences = 2;    // this rebinner and the cache
+  buildTable (*pTable, nThreads);
+  m_pTable = pTable;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexRebinCache);
+#endif
+  s_vecCache.push_back (pTable);
+  ParallelRebinTable* pEvicted = NULL;
+  if (s_vecCache.size() > s_nMaxCacheEntries) {
+    pEvicted = s_vecCache.front();
+    s_vecCache.erase (s_vecCache.begin());
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexRebinCache);
+#endif
+  if (pEvicted)
+    releaseTable (pEvicted);
+}
+
+ParallelRebinner::~ParallelRebinner ()
+{
+  if (m_pTable)
+    releaseTable (m_pTable);
+}
+
+void
+ParallelRebinner::releaseTable (ParallelRebinTable* pTable)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexRebinCache);
+#endif
+  bool bDelete = --pTable->m_iReferences == 0;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexRebinCache);
+#endif
+  if (bDelete)
+    delete pTable;
+}
+
+void
+ParallelRebinner::clearCache ()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&s_mutexRebinCache);
+#endif
+  std::vector<ParallelRebinTable*> vecCache;
+  vecCache.swap (s_vecCache);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&s_mutexRebinCache);
+#endif
+  for (unsigned int i = 0; i < vecCache.size(); i++)
+    releaseTable (vecCache[i]);
+}
+
+
+// NAME
+//   makeKey              Description of everything the table depends on
+
+std::string
+ParallelRebinner::makeKey (const Projections& proj)
+{
+  std::ostringstream os;
+  os.precision (17);
+  os << "rebin geometry=" << Scanner::convertGeometryIDToName (proj.geometry())
+     << " nview=" << proj.nView() << " ndet=" << proj.nDet()
+     << " rotstart=" << proj.rotStart() << " rotinc=" << proj.rotInc()
+     << " detstart=" << proj.detStart() << " detinc=" << proj.detInc()
+     << " focal=" << proj.focalLength() << " sdl=" << proj.sourceDetectorLength()
+     << " diameter=" << proj.viewDiameter();
+#ifdef CONVERT_PARALLEL_PI
+  os << " pi";
+#endif
+
+  return os.str();
+}
+
+
+void
+ParallelRebinner::buildTable (ParallelRebinTable& table, int nThreads) const
+{
+  table.m_vecEntries.resize (static_cast<size_t>(m_nView) * m_nDet);
+
+  FanBeamMapping mapping (m_rProj);
+  ParallelRebinTableTask task (mapping, &table.m_vecEntries[0], m_nDet, m_dRotStart, m_dRotInc, m_dDetInc);
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (m_nView);
+  threads.run (task);
+}
+
+
+// NAME
+//   newParallelProjections   Allocate projections with the parallel geometry
+//
+// NOTES
+//   Without allocated views the projections only describe the geometry, as
+//   needed by backprojectors that are handed views from rebinView.
+
+Projections*
+ParallelRebinner::newParallelProjections (bool bAllocateViews) const
+{
+  Projections* pProjNew = new Projections (bAllocateViews ? m_nView : 0, m_nDet);
+  pProjNew->m_nView = m_nView;
+  pProjNew->m_geometry = Scanner::GEOMETRY_PARALLEL;
+  pProjNew->m_dFocalLength = m_rProj.m_dFocalLength;
+  pProjNew->m_dSourceDetectorLength = m_rProj.m_dSourceDetectorLength;
+  pProjNew->m_dViewDiameter = m_rProj.m_dViewDiameter;
+  pProjNew->m_dFanBeamAngle = m_rProj.m_dFanBeamAngle;
+  pProjNew->m_calcTime  = 0;
+  pProjNew->m_remark = m_rProj.m_remark;
+  pProjNew->m_remark += "; Interpolate to Parallel";
+  pProjNew->m_label.setLabelType (Array2dFileLabel::L_HISTORY);
+  pProjNew->m_label.setLabelString (pProjNew->m_remark);
+  pProjNew->m_label.setCalcTime (pProjNew->m_calcTime);
+  pProjNew->m_label.setDateTime (pProjNew->m_year, pProjNew->m_month, pProjNew->m_day, pProjNew->m_hour, pProjNew->m_minute, pProjNew->m_second);
+
+  pProjNew->m_rotStart = m_dRotStart;
+  pProjNew->m_rotInc = m_dRotInc;
+  pProjNew->m_detStart = m_dDetStart;
+  pProjNew->m_detInc = m_dDetInc;
+
+  return pProjNew;
+}
+
+
+void
+ParallelRebinner::rebinView (int iView, DetectorArray& rDetArray) const
+{
+  rDetArray.setViewAngle (m_dRotStart + iView * m_dRotInc);
+  DetectorValue* detval = rDetArray.detValues();
+  const ParallelRebinEntry* pEntry = &m_pTable->m_vecEntries[static_cast<size_t>(iView) * m_nDet];
+  const DetectorValue* pSinogram = m_rProj.getSinogram();
+  const size_t nSourceDet = m_rProj.nDet();
+
+  for (int iDet = 0; iDet < m_nDet; iDet++, pEntry++) {
+    if (pEntry->m_iDet < 0) {
+      detval[iDet] = 0;
+      continue;
+    }
+    const DetectorValue* pView0;
+    const DetectorValue* pView1;
+    if (pSinogram) {
+      pView0 = pSinogram + pEntry->m_iView0 * nSourceDet + pEntry->m_iDet;
+      pView1 = pSinogram + pEntry->m_iView1 * nSourceDet + pEntry->m_iDet;
+    } else {
+      // mapped projections have no sinogram
+      pView0 = m_rProj.getDetectorArray (pEntry->m_iView0).detValues() + pEntry->m_iDet;
+      pView1 = m_rProj.getDetectorArray (pEntry->m_iView1).detValues() + pEntry->m_iDet;
+    }
+    const double dDetWeight = pEntry->m_fDetWeight;
+    double dValue0 = pView0[0];
+    double dValue1 = pView1[0];
+    if (dDetWeight != 0) {
+      dValue0 += dDetWeight * (pView0[1] - dValue0);
+      dValue1 += dDetWeight * (pView1[1] - dValue1);
+    }
+    detval[iDet] = static_cast<DetectorValue>(dValue0 + pEntry->m_fViewWeight * (dValue1 - dValue0));
+  }
+}
+
+
+void
+ParallelRebinner::rebinViews (Projections& rParallelProj, int nThreads) const
+{
+  ParallelRebinViewTask task (*this, rParallelProj);
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (m_nView);
+  threads.run (task);
+}
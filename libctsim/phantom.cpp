@@ -77,6 +77,7 @@ Phantom::init ()
   m_ymax = -1E30;
   m_composition = P_PELEMS;
   m_fail = false;
+  m_bDynamic = false;
   m_id = PHM_INVALID;
 }
 
@@ -179,6 +180,11 @@ Phantom::createFromPhantom (const int phmid)
 * RETURNS
 *   true if pelem were added
 *   false if an pelem not added
+*
+* NOTES
+*   Each line defines a pelem as "type cx cy u v rot atten". A line
+*   "keyframe time cx cy u v rot atten" sets the parameters of the
+*   preceding pelem at that fraction of the scan, 0 < time <= 1.
 */
 
 bool
@@ -196,15 +202,29 @@ Phantom::createFromFile (const char* const fname)
     double cx, cy, u, v, rot, dens;
     char pelemtype[80];
 
-    int status = fscanf (fp, "%79s %lf %lf %lf %lf %lf %lf", pelemtype, &cx, &cy, &u, &v, &rot, &dens);
-
+    int status = fscanf (fp, "%79s", pelemtype);
     if (status == static_cast<int>(EOF))
       break;
-    else if (status != 7) {
-      sys_error (ERR_WARNING, "Insufficient fields reading phantom file %s [Phantom::createFromFile]", fname);
-      bGoodFile = false;
+
+    if (strcasecmp (pelemtype, "keyframe") == 0) {
+      double dTime;
+      status = fscanf (fp, "%lf %lf %lf %lf %lf %lf %lf", &dTime, &cx, &cy, &u, &v, &rot, &dens);
+      if (status != 7) {
+        sys_error (ERR_WARNING, "Insufficient fields reading keyframe in phantom file %s [Phantom::createFromFile]", fname);
+        bGoodFile = false;
+        break;
+      }
+      if (! addKeyframe (dTime, cx, cy, u, v, rot, dens))
+        bGoodFile = false;
+    } else {
+      status = fscanf (fp, "%lf %lf %lf %lf %lf %lf", &cx, &cy, &u, &v, &rot, &dens);
+      if (status != 6) {
+        sys_error (ERR_WARNING, "Insufficient fields reading phantom file %s [Phantom::createFromFile]", fname);
+        bGoodFile = false;
+        break;
+      }
+      addPElem (pelemtype, cx, cy, u, v, rot, dens);
     }
-    addPElem (pelemtype, cx, cy, u, v, rot, dens);
   }
 
   fclose (fp);
@@ -212,6 +232,37 @@ Phantom::createFromFile (const char* const fname)
   return (bGoodFile);
 }
 
+
+/* METHOD IDENTIFICATION
+*   createFromPhantomAtTime   Add pelems of a dynamic phantom at a time
+*
+* SYNOPSIS
+*   createFromPhantomAtTime (phm, dTime)
+*   const Phantom& phm        Phantom whose pelems may have keyframes
+*   double dTime              Fraction of scan, 0 to 1
+*
+* NOTES
+*   The resulting phantom is static, so it may be projected by
+*   several threads while phm is evaluated at other times.
+*/
+
+bool
+Phantom::createFromPhantomAtTime (const Phantom& phm, const double dTime)
+{
+  m_name = phm.m_name;
+  m_id = phm.m_id;
+  m_composition = phm.m_composition;
+
+  // addPElem prepends, so add in reverse to keep phm's order
+  for (std::list<PhantomElement*>::const_reverse_iterator i = phm.m_listPElem.rbegin(); i != phm.m_listPElem.rend(); i++) {
+    double cx, cy, u, v, rot, atten;
+    (*i)->getParametersAtTime (dTime, cx, cy, u, v, rot, atten);
+    addPElem ((*i)->typeName(), cx, cy, u, v, rot, atten);
+  }
+
+  return true;
+}
+
 bool
 Phantom::fileWrite (const char* const fname)
 {
@@ -256,6 +307,43 @@ Phantom::addPElem (const char *type, const double cx, const double cy, const dou
 }
 
 
+/* NAME
+*   addKeyframe         Add keyframe to most recently added pelem
+*
+* SYNOPSIS
+*   addKeyframe (time, cx, cy, u, v, rot, atten)
+*   double time         fraction of scan, 0 < time <= 1
+*
+* NOTES
+*   Phantom limits are enlarged to cover the pelem at the keyframe
+*/
+
+bool
+Phantom::addKeyframe (const double dTime, const double cx, const double cy, const double u, const double v, const double rot, const double atten)
+{
+  if (m_listPElem.empty()) {
+    sys_error (ERR_WARNING, "Keyframe without preceding PhantomElement [Phantom::addKeyframe]");
+    return false;
+  }
+  if (dTime <= 0 || dTime > 1) {
+    sys_error (ERR_WARNING, "Keyframe time %f is not in (0,1] [Phantom::addKeyframe]", dTime);
+    return false;
+  }
+
+  PhantomElement* pelem = m_listPElem.front();
+  pelem->addKeyframe (dTime, cx, cy, u, v, rot, atten);
+  m_bDynamic = true;
+
+  PhantomElement pelemKeyframe (pelem->typeName(), cx, cy, u, v, rot, atten);
+  if (m_xmin > pelemKeyframe.xmin())    m_xmin = pelemKeyframe.xmin();
+  if (m_xmax < pelemKeyframe.xmax())    m_xmax = pelemKeyframe.xmax();
+  if (m_ymin > pelemKeyframe.ymin())    m_ymin = pelemKeyframe.ymin();
+  if (m_ymax < pelemKeyframe.ymax())    m_ymax = pelemKeyframe.ymax();
+
+  return true;
+}
+
+
 /*----------------------------------------------------------------------*/
 /*                      Input-Output Routines                           */
 /*----------------------------------------------------------------------*/
@@ -465,7 +553,8 @@ Phantom::convertToImagefile (ImageFile& im, const int iTotalRasterCols, const do
 {
   const int nx = im.nx();
   const int ny = im.ny();
-  if (nx < 2 || ny < 2)
+  // im may hold only a band of the raster, so check against the full raster width
+  if (iTotalRasterCols < 2 || ny < 2 || iStorageOffset + colCount > nx)
     return;
 
   int nsample = in_nsample;
@@ -578,6 +667,11 @@ PhantomElement::printDefinition (std::ostream& os) const
 {
   os << convertTypeToName (m_type) << " " << m_cx << " " << m_cy << " " << m_u << " "
     << m_v << " " << convertRadiansToDegrees (m_rot) << " " << m_atten << "\n";
+  for (unsigned int i = 1; i < m_vecKeyframes.size(); i++) {
+    const PhantomKeyframe& k = m_vecKeyframes[i];
+    os << "keyframe " << k.m_dTime << " " << k.m_cx << " " << k.m_cy << " " << k.m_u << " "
+      << k.m_v << " " << k.m_rot << " " << k.m_atten << "\n";
+  }
 }
 
 void
@@ -585,8 +679,91 @@ PhantomElement::printDefinition (std::ostringstream& os) const
 {
   os << convertTypeToName (m_type) << " " << m_cx << " " << m_cy << " " << m_u << " "
     << m_v << " " << convertRadiansToDegrees (m_rot) << " " << m_atten << "\n";
+  for (unsigned int i = 1; i < m_vecKeyframes.size(); i++) {
+    const PhantomKeyframe& k = m_vecKeyframes[i];
+    os << "keyframe " << k.m_dTime << " " << k.m_cx << " " << k.m_cy << " " << k.m_u << " "
+      << k.m_v << " " << k.m_rot << " " << k.m_atten << "\n";
+  }
+}
+
+// NAME
+//   addKeyframe         Set pelem parameters at a time within the scan
+//
+// NOTES
+//   The pelem's own parameters are the keyframe at time 0. A keyframe at
+//   an existing time replaces it.
+
+void
+PhantomElement::addKeyframe (const double dTime, const double cx, const double cy, const double u, const double v, const double rot, const double atten)
+{
+  PhantomKeyframe k;
+
+  if (m_vecKeyframes.size() == 0) {
+    k.m_dTime = 0;
+    k.m_cx = m_cx;  k.m_cy = m_cy;
+    k.m_u = m_u;  k.m_v = m_v;
+    k.m_rot = convertRadiansToDegrees (m_rot);
+    k.m_atten = m_atten;
+    m_vecKeyframes.push_back (k);
+  }
+
+  k.m_dTime = dTime;
+  k.m_cx = cx;  k.m_cy = cy;
+  k.m_u = u;  k.m_v = v;
+  k.m_rot = rot;
+  k.m_atten = atten;
+
+  std::vector<PhantomKeyframe>::iterator i = m_vecKeyframes.begin();
+  while (i != m_vecKeyframes.end() && i->m_dTime < dTime)
+    i++;
+  if (i != m_vecKeyframes.end() && i->m_dTime == dTime)
+    *i = k;
+  else
+    m_vecKeyframes.insert (i, k);
 }
 
+// NAME
+//   getParametersAtTime   Interpolate pelem parameters between keyframes
+//
+// NOTES
+//   Parameters vary linearly between keyframes and are held at the last
+//   keyframe thereafter. Rotation is returned in degrees.
+
+void
+PhantomElement::getParametersAtTime (const double dTime, double& cx, double& cy, double& u, double& v, double& rot, double& atten) const
+{
+  if (m_vecKeyframes.size() == 0 || dTime <= 0) {
+    cx = m_cx;  cy = m_cy;
+    u = m_u;  v = m_v;
+    rot = convertRadiansToDegrees (m_rot);
+    atten = m_atten;
+    return;
+  }
+
+  unsigned int iNext = 1;
+  while (iNext < m_vecKeyframes.size() && m_vecKeyframes[iNext].m_dTime < dTime)
+    iNext++;
+  if (iNext == m_vecKeyframes.size()) {
+    const PhantomKeyframe& kLast = m_vecKeyframes[iNext - 1];
+    cx = kLast.m_cx;  cy = kLast.m_cy;
+    u = kLast.m_u;  v = kLast.m_v;
+    rot = kLast.m_rot;
+    atten = kLast.m_atten;
+    return;
+  }
+
+  const PhantomKeyframe& k1 = m_vecKeyframes[iNext - 1];
+  const PhantomKeyframe& k2 = m_vecKeyframes[iNext];
+  double f = (dTime - k1.m_dTime) / (k2.m_dTime - k1.m_dTime);
+  cx = k1.m_cx + f * (k2.m_cx - k1.m_cx);
+  cy = k1.m_cy + f * (k2.m_cy - k1.m_cy);
+  u = k1.m_u + f * (k2.m_u - k1.m_u);
+  v = k1.m_v + f * (k2.m_v - k1.m_v);
+  rot = k1.m_rot + f * (k2.m_rot - k1.m_rot);
+  atten = k1.m_atten + f * (k2.m_atten - k1.m_atten);
+}
+
+
 PhmElemType
 PhantomElement::convertNameToType (const char* const typeName)
 {
@@ -898,6 +1075,202 @@ PhantomElement::clipLineNormalizedCoords (double& x1, double& y1, double& x2, do
 }
 
 
+// METHOD IDENTIFICATION
+//    PhantomElement::addRaysums       Add raysums of pelem along many lines
+//
+// SYNOPSIS
+//    addRaysums (nRays, x1, y1, x2, y2, pdRaysum)
+//    const int nRays           Number of lines
+//    const double* x1..y2      Endpoints of lines (in phantom coords)
+//    double* pdRaysum          Raysums to which this pelem's attenuations are added
+//
+// NOTES
+//    Ellipses and rectangles are intersected with every line in a single loop
+//    without branches so that the compiler can evaluate several lines at once.
+//    The chord is found as a parametric interval [t1,t2] of the line in
+//    normalized pelem coordinates. Since that transform is affine, the world
+//    length is (t2 - t1) times the length of the line. Other pelem types are
+//    clipped line by line with clipLineWorldCoords.
+
+void
+PhantomElement::addRaysums (const int nRays, const double* const x1, const double* const y1,
+                            const double* const x2, const double* const y2, double* const pdRaysum) const
+{
+  const double m00 = m_xformPhmToObj[0][0], m10 = m_xformPhmToObj[1][0], m20 = m_xformPhmToObj[2][0];
+  const double m01 = m_xformPhmToObj[0][1], m11 = m_xformPhmToObj[1][1], m21 = m_xformPhmToObj[2][1];
+  const double dAtten = m_atten;
+  const double dHuge = 1E30;
+
+  if (m_type == PELEM_ELLIPSE) {
+    for (int i = 0; i < nRays; i++) {
+      double px = x1[i] * m00 + y1[i] * m10 + m20;
+      double py = x1[i] * m01 + y1[i] * m11 + m21;
+      double dx = x2[i] * m00 + y2[i] * m10 + m20 - px;
+      double dy = x2[i] * m01 + y2[i] * m11 + m21 - py;
+      double a = dx * dx + dy * dy;
+      double b = px * dx + py * dy;
+      double c = px * px + py * py - 1.0;
+      double disc = b * b - a * c;
+      double root = sqrt (disc > 0 ? disc : 0);
+      double t1 = (-b - root) / a;
+      double t2 = (-b + root) / a;
+      t1 = t1 > 0 ? t1 : 0;
+      t2 = t2 < 1 ? t2 : 1;
+      double dt = (disc > 0 && t2 > t1) ? t2 - t1 : 0;
+      double wx = x2[i] - x1[i];
+      double wy = y2[i] - y1[i];
+      pdRaysum[i] += dt * sqrt (wx * wx + wy * wy) * dAtten;
+    }
+  } else if (m_type == PELEM_RECTANGLE) {
+    for (int i = 0; i < nRays; i++) {
+      double px = x1[i] * m00 + y1[i] * m10 + m20;
+      double py = x1[i] * m01 + y1[i] * m11 + m21;
+      double dx = x2[i] * m00 + y2[i] * m10 + m20 - px;
+      double dy = x2[i] * m01 + y2[i] * m11 + m21 - py;
+      bool bDx = dx != 0;
+      bool bDy = dy != 0;
+      double txa = bDx ? (-1.0 - px) / dx : (px >= -1.0 && px <= 1.0 ? -dHuge : dHuge);
+      double txb = bDx ? (1.0 - px) / dx : (px >= -1.0 && px <= 1.0 ? dHuge : -dHuge);
+      double tya = bDy ? (-1.0 - py) / dy : (py >= -1.0 && py <= 1.0 ? -dHuge : dHuge);
+      double tyb = bDy ? (1.0 - py) / dy : (py >= -1.0 && py <= 1.0 ? dHuge : -dHuge);
+      double tx1 = txa < txb ? txa : txb;
+      double tx2 = txa < txb ? txb : txa;
+      double ty1 = tya < tyb ? tya : tyb;
+      double ty2 = tya < tyb ? tyb : tya;
+      double t1 = tx1 > ty1 ? tx1 : ty1;
+      double t2 = tx2 < ty2 ? tx2 : ty2;
+      t1 = t1 > 0 ? t1 : 0;
+      t2 = t2 < 1 ? t2 : 1;
+      double dt = t2 > t1 ? t2 - t1 : 0;
+      double wx = x2[i] - x1[i];
+      double wy = y2[i] - y1[i];
+      pdRaysum[i] += dt * sqrt (wx * wx + wy * wy) * dAtten;
+    }
+  } else {
+    for (int i = 0; i < nRays; i++) {
+      double cx1 = x1[i], cy1 = y1[i], cx2 = x2[i], cy2 = y2[i];
+      if (clipLineWorldCoords (cx1, cy1, cx2, cy2))
+        pdRaysum[i] += lineLength (cx1, cy1, cx2, cy2) * dAtten;
+    }
+  }
+}
+
+
+// METHOD IDENTIFICATION
+//    PhantomElement::addStripRaysums  Add pelem's integral across strips
+//
+// SYNOPSIS
+//    addStripRaysums (nStrips, xs, ys, xd, yd, pdRaysum)
+//    const int nStrips         Number of strips
+//    const double* xs, ys      Source point of each strip (in phantom coords)
+//    const double* xd, yd      The nStrips+1 edges of the strips at the
+//                              detector. Strip i is bounded by the lines
+//                              from its source to edges i and i+1.
+//    double* pdRaysum          Raysums to which the pelem's average
+//                              attenuation across each strip is added
+//
+// RETURNS
+//    false if pelem type has no analytic strip integral
+//
+// NOTES
+//    In normalized pelem coordinates, the chord of a line is a function
+//    c(h) of the line's distance h from the origin. Its integral C(h) is
+//    closed form for the unit circle and unit square. The average chord
+//    across a strip is then (C(h2) - C(h1)) / (h2 - h1), scaled by the
+//    ratio of world to normalized length along the strip. Strips are
+//    narrow, so their bounding lines are treated as parallel.
+
+bool
+PhantomElement::addStripRaysums (const int nStrips, const double* const xs, const double* const ys,
+                                 const double* const xd, const double* const yd, double* const pdRaysum) const
+{
+  if (m_type != PELEM_ELLIPSE && m_type != PELEM_RECTANGLE)
+    return false;
+
+  for (int iStrip = 0; iStrip < nStrips; iStrip++) {
+    double h[2], scale[2], ux[2], uy[2];
+    for (int iEdge = 0; iEdge < 2; iEdge++) {
+      double nx1 = xs[iStrip], ny1 = ys[iStrip];
+      double nx2 = xd[iStrip + iEdge], ny2 = yd[iStrip + iEdge];
+      xform_mtx2 (m_xformPhmToObj, nx1, ny1);
+      xform_mtx2 (m_xformPhmToObj, nx2, ny2);
+      double normLen = lineLength (nx1, ny1, nx2, ny2);
+      ux[iEdge] = (nx2 - nx1) / normLen;
+      uy[iEdge] = (ny2 - ny1) / normLen;
+      h[iEdge] = nx1 * uy[iEdge] - ny1 * ux[iEdge];     // signed distance of line from origin
+      scale[iEdge] = lineLength (xs[iStrip], ys[iStrip], xd[iStrip + iEdge], yd[iStrip + iEdge]) / normLen;
+    }
+
+    double dScale = (scale[0] + scale[1]) / 2;
+    double dAbsUx = fabs (ux[0] + ux[1]) / 2;
+    double dAbsUy = fabs (uy[0] + uy[1]) / 2;
+    double dChord;
+    if (fabs (h[1] - h[0]) < 1E-12) {
+      double hMid = (h[0] + h[1]) / 2;
+      dChord = (m_type == PELEM_ELLIPSE) ? chordUnitCircle (hMid) : chordUnitSquare (hMid, dAbsUx, dAbsUy);
+    } else if (m_type == PELEM_ELLIPSE)
+      dChord = (chordIntegralUnitCircle (h[1]) - chordIntegralUnitCircle (h[0])) / (h[1] - h[0]);
+    else
+      dChord = (chordIntegralUnitSquare (h[1], dAbsUx, dAbsUy) - chordIntegralUnitSquare (h[0], dAbsUx, dAbsUy)) / (h[1] - h[0]);
+
+    pdRaysum[iStrip] += dChord * dScale * m_atten;
+  }
+
+  return true;
+}
+
+// Chord of unit circle along line at distance h from center, and its integral
+double
+PhantomElement::chordUnitCircle (double h)
+{
+  return (fabs(h) < 1 ? 2 * sqrt (1 - h * h) : 0);
+}
+
+double
+PhantomElement::chordIntegralUnitCircle (double h)
+{
+  h = clamp (h, -1., 1.);
+  return (h * sqrt (1 - h * h) + asin (h));
+}
+
+// Chord of square [-1,1]x[-1,1] along a line with direction (ux,uy) at distance h
+// from center, and its integral. The chord is a trapezoid of height
+// 2/max(|ux|,|uy|), constant for |h| <= ||ux|-|uy|| and zero for |h| >= |ux|+|uy|.
+double
+PhantomElement::chordUnitSquare (double h, double absUx, double absUy)
+{
+  double q1 = fabs (absUx - absUy);
+  double q2 = absUx + absUy;
+  double height = 2 / (absUx > absUy ? absUx : absUy);
+  h = fabs (h);
+  if (h >= q2)
+    return 0;
+  else if (h <= q1)
+    return height;
+  else
+    return height * (q2 - h) / (q2 - q1);
+}
+
+double
+PhantomElement::chordIntegralUnitSquare (double h, double absUx, double absUy)
+{
+  double q1 = fabs (absUx - absUy);
+  double q2 = absUx + absUy;
+  double height = 2 / (absUx > absUy ? absUx : absUy);
+  double sign = h < 0 ? -1 : 1;
+  h = fabs (h);
+  double area;
+  if (h >= q2)
+    area = height * (q1 + q2) / 2;
+  else if (h <= q1)
+    area = height * h;
+  else
+    area = height * (h - (h - q1) * (h - q1) / (2 * (q2 - q1)));
+
+  return (sign * area);
+}
+
+
 // METHOD IDENTIFICATION
 //    PhantomElement::isPointInside             Check if point is inside pelem
 //
@@ -26,8 +26,48 @@
 #include <ctime>
 #include "interpolator.h"
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define HAVE_MAPPED_PROJECTIONS
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+
+// Memory map of a projections file and the decoded views of readMapped
+
+struct ProjectionsFileMap {
+  void* m_pMap;
+  size_t m_nMapBytes;
+  const unsigned char* m_pViewData;   // First view record, start of the map for compressed files
+  size_t m_nViewBytes;                // Bytes of a view record
+  std::vector<kuint64> m_vecViewOffset; // Offsets of compressed view records
+  int m_nCacheViews;                  // Decoded views kept, 0 for all
+  DetectorValue* m_pCache;            // Decoded views, one slot of nDet values each
+  std::vector<int> m_vecViewSlot;     // Slot of each view, -1 when not decoded
+  std::vector<int> m_vecSlotView;     // View in each slot, -1 when empty
+  int m_iNextSlot;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t m_mutex;
+#endif
+
+  const unsigned char* viewRecord (int iView) const
+  { return m_vecViewOffset.empty() ? m_pViewData + iView * m_nViewBytes : m_pViewData + m_vecViewOffset[iView]; }
+};
+
 const kuint16 Projections::m_signature = ('P'*256 + 'J');
 
+// Compressed files have the plain header followed by the ArrayCodec of the
+// views, then an index of nView + 1 file offsets of the view records, the
+// last being the end of the views. A view record holds the view angle, the
+// number of detectors, the number of encoded bytes and the encoded values.
+const kuint16 Projections::m_signatureCompressed = ('P'*256 + 'Z');
+
 const int Projections::POLAR_INTERP_INVALID = -1;
 const int Projections::POLAR_INTERP_NEAREST = 0;
 const int Projections::POLAR_INTERP_BILINEAR = 1;
@@ -63,26 +103,30 @@ const int Projections::s_iInterpCount = sizeof(s_aszInterpName) / sizeof(char*);
 */
 
 Projections::Projections (const Scanner& scanner)
-: m_projData(0)
+: m_pSinogram(0), m_pdViewAngle(0), m_projData(0), m_pFileMap(0), m_bDecodeViews(false),
+  m_iCompression(ArrayCodec::CODEC_NONE), m_pViewStream(0), m_nStreamedViews(0)
 {
   initFromScanner (scanner);
 }
 
 
 Projections::Projections (const int nView, const int nDet)
-: m_projData(0)
+: m_pSinogram(0), m_pdViewAngle(0), m_projData(0), m_pFileMap(0), m_bDecodeViews(false),
+  m_iCompression(ArrayCodec::CODEC_NONE), m_pViewStream(0), m_nStreamedViews(0)
 {
   init (nView, nDet);
 }
 
 Projections::Projections (void)
-: m_projData(0)
+: m_pSinogram(0), m_pdViewAngle(0), m_projData(0), m_pFileMap(0), m_bDecodeViews(false),
+  m_iCompression(ArrayCodec::CODEC_NONE), m_pViewStream(0), m_nStreamedViews(0)
 {
   init (0, 0);
 }
 
 Projections::~Projections (void)
 {
+  delete m_pViewStream;
   deleteProjData();
 }
 
@@ -125,12 +169,13 @@ Projections::convertInterpIDToTitle (const int interpID)
 
 
 void
-Projections::init (const int nView, const int nDet)
+Projections::init (const int nView, const int nDet, bool bStoreViews)
 {
   m_label.setLabelType (Array2dFileLabel::L_HISTORY);
   m_nView = nView;
   m_nDet = nDet;
-  newProjData ();
+  if (bStoreViews)
+    newProjData ();
 
   time_t t = time (NULL);
   tm* lt = localtime (&t);
@@ -142,12 +187,39 @@ Projections::init (const int nView, const int nDet)
   m_second = lt->tm_sec;
 }
 
+// Copies everything but the number of views and the view data
 void
-Projections::initFromScanner (const Scanner& scanner)
+Projections::copyHeaderFields (const Projections& proj)
+{
+  m_geometry = proj.m_geometry;
+  m_remark = proj.m_remark;
+  m_nDet = proj.m_nDet;
+  m_calcTime = proj.m_calcTime;
+  m_rotStart = proj.m_rotStart;
+  m_rotInc = proj.m_rotInc;
+  m_detStart = proj.m_detStart;
+  m_detInc = proj.m_detInc;
+  m_dFocalLength = proj.m_dFocalLength;
+  m_dSourceDetectorLength = proj.m_dSourceDetectorLength;
+  m_dViewDiameter = proj.m_dViewDiameter;
+  m_dFanBeamAngle = proj.m_dFanBeamAngle;
+  m_year = proj.m_year;
+  m_month = proj.m_month;
+  m_day = proj.m_day;
+  m_hour = proj.m_hour;
+  m_minute = proj.m_minute;
+  m_second = proj.m_second;
+  m_label = proj.m_label;
+  m_iCompression = proj.m_iCompression;
+}
+
+// Without bStoreViews only the header is set, for writing views held elsewhere
+void
+Projections::initFromScanner (const Scanner& scanner, bool bStoreViews)
 {
   m_label.setLabelType (Array2dFileLabel::L_HISTORY);
   deleteProjData();
-  init (scanner.nView(), scanner.nDet());
+  init (scanner.nView(), scanner.nDet(), bStoreViews);
 
   m_rotInc = scanner.rotInc();
   m_detInc = scanner.detInc();
@@ -167,6 +239,151 @@ Projections::setNView (int nView)  // used by MPI to reduce # of views
   init (nView, m_nDet);
 }
 
+
+// Order of the values of getHeaderValues
+enum {
+  HV_NVIEW,
+  HV_NDET,
+  HV_GEOMETRY,
+  HV_COMPRESSION,
+  HV_HEADERSIZE,
+  HV_ROTSTART,
+  HV_ROTINC,
+  HV_DETSTART,
+  HV_DETINC,
+  HV_VIEWDIAMETER,
+  HV_FOCALLENGTH,
+  HV_SOURCEDETECTORLENGTH,
+  HV_FANBEAMANGLE,
+  HV_CALCTIME,
+  HV_COUNT
+};
+
+void
+Projections::getHeaderValues (std::vector<double>& vecValues) const
+{
+  vecValues.assign (HV_COUNT, 0.);
+  vecValues[HV_NVIEW] = m_nView;
+  vecValues[HV_NDET] = m_nDet;
+  vecValues[HV_GEOMETRY] = m_geometry;
+  vecValues[HV_COMPRESSION] = m_iCompression;
+  vecValues[HV_HEADERSIZE] = m_headerSize;
+  vecValues[HV_ROTSTART] = m_rotStart;
+  vecValues[HV_ROTINC] = m_rotInc;
+  vecValues[HV_DETSTART] = m_detStart;
+  vecValues[HV_DETINC] = m_detInc;
+  vecValues[HV_VIEWDIAMETER] = m_dViewDiameter;
+  vecValues[HV_FOCALLENGTH] = m_dFocalLength;
+  vecValues[HV_SOURCEDETECTORLENGTH] = m_dSourceDetectorLength;
+  vecValues[HV_FANBEAMANGLE] = m_dFanBeamAngle;
+  vecValues[HV_CALCTIME] = m_calcTime;
+}
+
+// Sets the header and the number of views without allocating the views,
+// setNView then allocates the views to be held
+bool
+Projections::setHeaderValues (const std::vector<double>& vecValues)
+{
+  if (vecValues.size() != HV_COUNT) {
+    sys_error (ERR_SEVERE, "Header has %d values, expected %d [setHeaderValues]", vecValues.size(), HV_COUNT);
+    return false;
+  }
+  deleteProjData();
+  m_nView = static_cast<int>(vecValues[HV_NVIEW]);
+  m_nDet = static_cast<int>(vecValues[HV_NDET]);
+  m_geometry = static_cast<int>(vecValues[HV_GEOMETRY]);
+  m_iCompression = static_cast<int>(vecValues[HV_COMPRESSION]);
+  m_headerSize = static_cast<int>(vecValues[HV_HEADERSIZE]);
+  m_rotStart = vecValues[HV_ROTSTART];
+  m_rotInc = vecValues[HV_ROTINC];
+  m_detStart = vecValues[HV_DETSTART];
+  m_detInc = vecValues[HV_DETINC];
+  m_dViewDiameter = vecValues[HV_VIEWDIAMETER];
+  m_dFocalLength = vecValues[HV_FOCALLENGTH];
+  m_dSourceDetectorLength = vecValues[HV_SOURCEDETECTORLENGTH];
+  m_dFanBeamAngle = vecValues[HV_FANBEAMANGLE];
+  m_calcTime = vecValues[HV_CALCTIME];
+  m_vecViewOffset.clear();
+
+  return true;
+}
+
+kuint64
+Projections::viewRecordOffset (int iView) const
+{
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    return m_vecViewOffset[iView];
+
+  const kuint64 nViewBytes = sizeof(kfloat64) + sizeof(kint32) + static_cast<kuint64>(m_nDet) * sizeof(kfloat32);
+  return m_headerSize + iView * nViewBytes;
+}
+
+
+// NAME
+//   decodeViewRecords    Decode the views from records copied from a file
+//
+// NOTES
+//   The records are those of the views held, in the file format, so a
+//   process can read its range of the views of a file with one read from
+//   the offsets of viewRecordOffset.
+
+bool
+Projections::decodeViewRecords (const unsigned char* pRecords, size_t nBytes)
+{
+  const size_t nFixedBytes = sizeof(kfloat64) + sizeof(kint32);
+  const size_t nValueBytes = static_cast<size_t>(m_nDet) * sizeof(kfloat32);
+  size_t iByte = 0;
+
+  for (int iView = 0; iView < m_nView; iView++) {
+    if (iByte + nFixedBytes > nBytes) {
+      sys_error (ERR_SEVERE, "View records end before view %d [decodeViewRecords]", iView);
+      return false;
+    }
+    kfloat64 viewAngle;
+    kuint32 nDet;
+    memcpy (&viewAngle, pRecords + iByte, sizeof(viewAngle));
+    memcpy (&nDet, pRecords + iByte + sizeof(kfloat64), sizeof(nDet));
+    if (NativeBigEndian()) {
+      SwapBytes8 (&viewAngle);
+      SwapBytes4 (&nDet);
+    }
+    iByte += nFixedBytes;
+    if (nDet != static_cast<kuint32>(m_nDet)) {
+      sys_error (ERR_SEVERE, "View has %d detectors, expected %d [decodeViewRecords]", nDet, m_nDet);
+      return false;
+    }
+    DetectorArray& darray = m_projData[iView];
+    darray.setViewAngle (viewAngle);
+
+    if (m_iCompression != ArrayCodec::CODEC_NONE) {
+      kuint32 nEncodedBytes = 0;
+      if (iByte + sizeof(kuint32) <= nBytes) {
+        memcpy (&nEncodedBytes, pRecords + iByte, sizeof(nEncodedBytes));
+        if (NativeBigEndian())
+          SwapBytes4 (&nEncodedBytes);
+        iByte += sizeof(kuint32);
+      }
+      if (iByte + nEncodedBytes > nBytes
+          || ! ArrayCodec::decode (m_iCompression, pRecords + iByte, nEncodedBytes, darray.detValues(), m_nDet, sizeof(kfloat32))) {
+        sys_error (ERR_SEVERE, "Unable to decode view %d [decodeViewRecords]", iView);
+        return false;
+      }
+      iByte += nEncodedBytes;
+    } else {
+      if (iByte + nValueBytes > nBytes) {
+        sys_error (ERR_SEVERE, "View records end in view %d [decodeViewRecords]", iView);
+        return false;
+      }
+      memcpy (darray.detValues(), pRecords + iByte, nValueBytes);
+      if (NativeBigEndian())
+        SwapBytesArray (darray.detValues(), m_nDet, sizeof(kfloat32));
+      iByte += nValueBytes;
+    }
+  }
+
+  return true;
+}
+
 //  Helical 180 Linear Interpolation.
 //  This member function takes a set of helical scan projections and
 //  performs a linear interpolation between pairs of complementary rays
@@ -196,43 +413,37 @@ Projections::setNView (int nView)  // used by MPI to reduce # of views
 //  zeros, but is actually redundant with data contained in the region
 //  (pi+fanAngle,-fanAngle/2)->(pi+fanAngle, fanAngle/2) ->(pi-fanAngle,
 //  fanAngle/2).
+//  Parallel data sets are treated as having a fan angle of zero. The
+//  weights depend only on the geometry and are kept by ProjectionWeightMap;
+//  the interpolated views are divided among nThreads, 0 for all processors.
 //
 int
-Projections::Helical180LI(int interpolation_view)
+Projections::Helical180LI (int interpView, int nThreads)
+{
+   Projections slice;
+   int status = Helical180LI (interpView, slice, nThreads);
+   if (status != 0)
+       return (status);
+
+   takeProjData (slice);
+
+   return (0);
+}
+
+// The interpolated plane is written to rSlice, which receives the header
+// of these projections, leaving these projections unchanged. Any number
+// of slices may be interpolated at once from the same projections.
+int
+Projections::Helical180LI (int interpView, Projections& rSlice, int nThreads) const
 {
-   if (m_geometry == Scanner::GEOMETRY_INVALID)
+   if (m_geometry != Scanner::GEOMETRY_PARALLEL && m_geometry != Scanner::GEOMETRY_EQUILINEAR
+       && m_geometry != Scanner::GEOMETRY_EQUIANGULAR)
    {
        std::cerr << "Invalid geometry " << m_geometry << std::endl;
        return (2);
    }
-   else if (m_geometry == Scanner::GEOMETRY_PARALLEL)
-   {
-       std::cerr << "Helical 180LI not yet implemented for PARALLEL geometry"
-                   << std::endl;
-       return (2);
-   }
-   else if (m_geometry == Scanner::GEOMETRY_EQUILINEAR)
-   {
-       std::cerr << "Helical 180LI not yet implemented for EQUILINEAR geometry"
-                   << std::endl;
-       return (2);
-   }
-   else if (m_geometry == Scanner::GEOMETRY_EQUIANGULAR)
-   {
-           return Helical180LI_Equiangular(interpolation_view);
-   }
-   else
-   {
-       std::cerr << "Invalid geometry  in projection data file" << m_geometry
-                   << std::endl;
-       return (2);
-   }
-}
-int
-Projections::Helical180LI_Equiangular(int interpView)
-{
+
    double dbeta = m_rotInc;
-   double dgamma =  m_detInc;
    double fanAngle = m_dFanBeamAngle;
    int offsetView=0;
 
@@ -244,11 +455,7 @@ Projections::Helical180LI_Equiangular(int interpView)
        return (1);
    }
 
-   if (interpView < 0)   // use default position at PI+fanAngle
-   {
-       interpView = static_cast<int> ((PI+fanAngle)/dbeta);
-   }
-   else
+   if (interpView >= 0)
    {
        // check if there is PI+fanAngle data on either side of the
        // of the specified image plane
@@ -259,103 +466,32 @@ Projections::Helical180LI_Equiangular(int interpView)
            return(1);
        }
        offsetView = interpView - static_cast<int>((PI+fanAngle)/dbeta);
+   }
 
+   std::string strFailMessage;
+   const ProjectionWeightMap* pMap = ProjectionWeightMap::acquire (*this, ProjectionWeightMap::MAP_HELICAL_180LI, strFailMessage);
+   if (! pMap) {
+       std::cerr << strFailMessage << std::endl;
+       return (1);
    }
-   int last_interp_view = static_cast<int> ((PI+fanAngle)/dbeta);
-
-
-// make a new array for data...
-   class DetectorArray ** newdetarray = new DetectorArray * [last_interp_view+1];
-   for ( int i=0 ; i <= last_interp_view ; i++ ){
-       newdetarray[i] = new DetectorArray (m_nDet);
-       newdetarray[i]->setViewAngle((i+offsetView)*dbeta);
-       DetectorValue* newdetval = (newdetarray[i])->detValues();
-       // and initialize the data to zero
-       for (int j=0; j < m_nDet; j++)
-           newdetval[j] = 0.;
+   if (offsetView + pMap->nSourceView() > m_nView) {
+       std::cerr << "Data set ends before the last view needed for interpolation" << std::endl;
+       ProjectionWeightMap::release (pMap);
+       return (1);
    }
 
-   int last_acq_view = 2*last_interp_view;
-   for ( int iView = 0 ; iView <= last_acq_view; iView++) {
-       double beta = iView * dbeta;
-
-       for ( int iDet = 0; iDet < m_nDet; iDet++) {
-           double gamma = (iDet -(m_nDet-1)/2)* dgamma ;
-           int newiView, newiDet;
-           if (beta < PI+fanAngle) { //if (PI +fanAngle - beta > dbeta )
-               //newbeta = beta;
-               //newgamma = gamma;
-               newiDet = iDet;
-               newiView = iView;
-           }
-           else // (beta > PI+fanAngle)
-           {
-               //newbeta = beta +2*gamma - 180;
-               //newgamma = -gamma;
-               newiDet = -iDet + (m_nDet -1);
-               // newiView = nearest<int>((beta + 2*gamma - PI)/dbeta);
-               //newiView = static_cast<int>(( (iView*dbeta) + 2*(iDet-(m_nDet-1)/2)*dgamma - PI)/dbeta);
-               newiView = nearest<int>(( (iView*dbeta) + 2*(iDet-(m_nDet-1)/2)*dgamma - PI)/dbeta);
-           }
-
-#ifdef DEBUG
-//std::cout << beta << " "<< gamma << " " << newbeta << " " << newgamma <<"    " << iView-offsetView << " " << iDet << " " << newiView << " " << newiDet << std::endl;
-//std::cout << iView-offsetView << " " << iDet << " " << newiView << " " << newiDet << std::endl;
-#endif
-
-           if (   ( beta > fanAngle - 2*gamma)
-               && ( beta < 2*PI + fanAngle -2*gamma)  )
-          {  // not in region  1 or 8
-               DetectorValue* detval = (m_projData[iView+offsetView])->detValues();
-               DetectorValue* newdetval = (newdetarray[newiView])->detValues();
-               if (   beta > fanAngle - 2*gamma
-                   && beta <= 2*fanAngle ) {  // in region 2
-                   newdetval[newiDet] +=
-                       (beta +2*gamma - fanAngle)/(PI+2*gamma)
-                               * detval[iDet];
-               } else if ( beta > 2*fanAngle
-                          && beta <= PI - 2*gamma) {  // in region 3
-                   newdetval[newiDet] +=
-                       (beta +2*gamma - fanAngle)/(PI+2*gamma)
-                               * detval[iDet];
-               }
-               else if (   beta > PI -2*gamma
-                        && beta <= PI + fanAngle ) {  // in region 4
-                   newdetval[newiDet] +=
-                       (beta +2*gamma - fanAngle)/(PI+2*gamma)
-                               * detval[iDet];
-               }
-               else if (   beta > PI + fanAngle
-                        && beta <= PI +2*fanAngle -2*gamma) { // in region 5
-                   newdetval[newiDet] +=
-                       (2*PI - beta - 2*gamma + fanAngle)/(PI-2*gamma)
-                               *detval[iDet];
-               }
-               else if (   beta > PI +2*fanAngle -2*gamma
-                        && beta <= 2*PI) {  // in region 6
-                   newdetval[newiDet] +=
-                       (2*PI - beta - 2*gamma + fanAngle)/(PI-2*gamma)
-                       *detval[iDet];
-               }
-               else if (   beta > 2*PI
-                        && beta <= 2*PI + fanAngle -2*gamma){ // in region 7
-                   newdetval[newiDet] +=
-                       (2*PI - beta -2*gamma + fanAngle)/(PI-2*gamma)
-                       *detval[iDet];
-               }
-               else
-               {
-                   ; // outside region of interest
-               }
-           }
-       }
-   }
-   deleteProjData();
-   m_projData = newdetarray;
-   m_nView = last_interp_view+1;
+   int nNewView = pMap->nTargetView();
+   rSlice.deleteProjData();
+   rSlice.init (nNewView, m_nDet);
+   rSlice.copyHeaderFields (*this);
+   for (int i = 0; i < nNewView; i++)
+       rSlice.m_pdViewAngle[i] = (i+offsetView)*dbeta;
+   pMap->apply (*this, offsetView, rSlice, nThreads);
+   ProjectionWeightMap::release (pMap);
 
    return (0);
 }
+
 // HalfScanFeather:
 // A HalfScan Projection Data Set  for equiangular geometry,
 // covering gantry angles from 0 to  pi+fanBeamAngle
@@ -366,11 +502,12 @@ Projections::Helical180LI_Equiangular(int interpView)
 // This routine makes a copy of the data and applies a weighting to avoid
 // over-representation, as given in Appendix C of Crawford and King, Med
 // Phys 17 1990, p967.
+// Equilinear and parallel data sets are weighted the same way with their
+// own fan angles, a parallel half scan covers gantry angles 0 to pi.
 int
-Projections::HalfScanFeather(void)
+Projections::HalfScanFeather (int nThreads)
 {
    double dbeta = m_rotInc;
-   double dgamma =  m_detInc;
    double fanAngle = m_dFanBeamAngle;
 
 // is there enough data?
@@ -378,68 +515,36 @@ Projections::HalfScanFeather(void)
        std::cerr   << "Data set does seem have enough data to be a halfscan data set"  << std::endl;
        return (1);
    }
-   if (m_geometry == Scanner::GEOMETRY_INVALID) {
+   if (m_geometry != Scanner::GEOMETRY_PARALLEL && m_geometry != Scanner::GEOMETRY_EQUILINEAR
+       && m_geometry != Scanner::GEOMETRY_EQUIANGULAR) {
        std::cerr << "Invalid geometry " << m_geometry << std::endl;
        return (2);
    }
 
-   if (m_geometry == Scanner::GEOMETRY_PARALLEL) {
-       std::cerr << "HalfScanFeather not yet implemented for PARALLEL geometry"<< std::endl;
-       return (2);
+   std::string strFailMessage;
+   const ProjectionWeightMap* pMap = ProjectionWeightMap::acquire (*this, ProjectionWeightMap::MAP_HALFSCAN_FEATHER, strFailMessage);
+   if (! pMap) {
+       std::cerr << strFailMessage << std::endl;
+       return (4);
    }
 
-   for ( int iView2 = 0 ; iView2 < m_nView; iView2++) {
-       double beta2 = iView2 * dbeta;
-       for ( int iDet2 = 0; iDet2 < m_nDet; iDet2++) {
-           double gamma2 = (iDet2 -(m_nDet-1)/2)* dgamma ;
-           if ( ( beta2 >= PI  - 2*gamma2) ) {  // in redundant data region
-               int iView1, iDet1;
-               iDet1 =  (m_nDet -1) - iDet2;
-               //iView1 = nearest<int>((beta2 + 2*gamma2 - PI)/dbeta);
-               iView1 = nearest<int>(( (iView2*dbeta)
-                               + 2*(iDet2-(m_nDet-1)/2)*dgamma - PI)/dbeta);
-
-
-               DetectorValue* detval2 = (m_projData[iView2])->detValues();
-               DetectorValue* detval1 = (m_projData[iView1])->detValues();
-
-               detval1[iDet1] = detval2[iDet2] ;
-
-               double x, w1,w2,beta1, gamma1;
-               beta1= iView1*dbeta;
-               gamma1 = -gamma2;
-               if ( beta1 <= (fanAngle - 2*gamma1) )
-                   x = beta1 / ( fanAngle - 2*gamma1);
-               else if ( (fanAngle  - 2*gamma1 <= beta1 ) && beta1 <= PI - 2*gamma1)
-                   x = 1;
-               else if ( (PI - 2*gamma1 <= beta1 ) && ( beta1 <=PI + fanAngle) )
-                   x = (PI +fanAngle - beta1)/(fanAngle + 2*gamma1);
-               else {
-                   std::cerr << "Shouldn't be here!"<< std::endl;
-                   return(4);
-               }
-               w1 = (3*x - 2*x*x)*x;
-               w2 = 1-w1;
-               detval1[iDet1] *= w1;
-               detval2[iDet2] *= w2;
-
-           }
-       }
-   }
-   // heuristic scaling, why this factor?
-   double scalefactor = m_nView * m_rotInc / PI;
-   for ( int iView = 0 ; iView < m_nView; iView++) {
-       DetectorValue* detval = (m_projData[iView])->detValues();
-       for ( int iDet = 0; iDet < m_nDet; iDet++) {
-           detval[iDet] *= scalefactor;
-       }
-   }
+   Projections feathered (m_nView, m_nDet);
+   for (int i = 0; i < m_nView; i++)
+       feathered.m_pdViewAngle[i] = m_pdViewAngle[i];
+   pMap->apply (*this, 0, feathered, nThreads);
+   ProjectionWeightMap::release (pMap);
+
+   takeProjData (feathered);
 
    return (0);
 }
 
 // NAME
 // newProjData
+//
+// NOTES
+//   The views are rows of one sinogram so whole sinograms can be processed,
+//   read and written at once. Each DetectorArray is a view of its row.
 
 void
 Projections::newProjData (void)
@@ -448,10 +553,15 @@ Projections::newProjData (void)
     sys_error(ERR_WARNING, "m_projData != NULL [newProjData]");
 
   if (m_nView > 0 && m_nDet) {
-    m_projData = new DetectorArray* [m_nView];
+    const size_t nValues = static_cast<size_t>(m_nView) * m_nDet;
+    m_pSinogram = static_cast<DetectorValue*>(alignedAlloc (nValues * sizeof(DetectorValue)));
+    m_pdViewAngle = new double [m_nView];
+    m_projData = new DetectorArray [m_nView];
 
-    for (int i = 0; i < m_nView; i++)
-      m_projData[i] = new DetectorArray (m_nDet);
+    for (int i = 0; i < m_nView; i++) {
+      m_pdViewAngle[i] = 0;
+      m_projData[i].attach (m_pSinogram + static_cast<size_t>(i) * m_nDet, m_pdViewAngle + i, m_nDet);
+    }
   }
 }
 
@@ -467,13 +577,47 @@ Projections::newProjData (void)
 void
 Projections::deleteProjData (void)
 {
-  if (m_projData != NULL) {
-    for (int i = 0; i < m_nView; i++)
-      delete m_projData[i];
-
-    delete m_projData;
-    m_projData = NULL;
+  delete [] m_projData;
+  delete [] m_pdViewAngle;
+  alignedFree (m_pSinogram);
+  m_projData = NULL;
+  m_pdViewAngle = NULL;
+  m_pSinogram = NULL;
+
+  if (m_pFileMap) {
+#ifdef HAVE_MAPPED_PROJECTIONS
+    munmap (m_pFileMap->m_pMap, m_pFileMap->m_nMapBytes);
+#endif
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy (&m_pFileMap->m_mutex);
+#endif
+    delete [] m_pFileMap->m_pCache;
+    delete m_pFileMap;
+    m_pFileMap = NULL;
   }
+  m_bDecodeViews = false;
+}
+
+
+// NAME
+//   takeProjData         Replace the views with those of proj, leaving proj without views
+
+void
+Projections::takeProjData (Projections& proj)
+{
+  deleteProjData();
+  m_nView = proj.m_nView;
+  m_pSinogram = proj.m_pSinogram;
+  m_pdViewAngle = proj.m_pdViewAngle;
+  m_projData = proj.m_projData;
+  m_pFileMap = proj.m_pFileMap;
+  m_bDecodeViews = proj.m_bDecodeViews;
+
+  proj.m_pSinogram = NULL;
+  proj.m_pdViewAngle = NULL;
+  proj.m_projData = NULL;
+  proj.m_pFileMap = NULL;
+  proj.m_bDecodeViews = false;
 }
 
 
@@ -486,7 +630,7 @@ bool
 Projections::headerWrite (fnetorderstream& fs)
 {
   kuint16 _hsize = m_headerSize;
-  kuint16 _signature = m_signature;
+  kuint16 _signature = m_iCompression != ArrayCodec::CODEC_NONE ? m_signatureCompressed : m_signature;
   kuint32 _nView = m_nView;
   kuint32 _nDet = m_nDet;
   kuint32 _geom = m_geometry;
@@ -508,6 +652,16 @@ Projections::headerWrite (fnetorderstream& fs)
   kfloat64 _sourceDetectorLength = m_dSourceDetectorLength;
   kfloat64 _fanBeamAngle = m_dFanBeamAngle;
 
+  // The remark is padded with nulls so that detector values of the views
+  // are aligned, which lets readMapped use them in place. The header size
+  // is known before it is written, so the header is written in order.
+  const int nFixedBytes = 9 * sizeof(kuint16) + 3 * sizeof(kuint32) + 9 * sizeof(kfloat64);
+  const int nPad = (4 - (nFixedBytes + _remarksize) % 4) % 4;
+  _remarksize += nPad;
+  _hsize = nFixedBytes + _remarksize;
+  if (_signature == m_signatureCompressed)
+    _hsize += 2 * sizeof(kuint16);
+
   fs.seekp(0);
   if (! fs)
     return false;
@@ -533,13 +687,18 @@ Projections::headerWrite (fnetorderstream& fs)
   fs.writeInt16 (_minute);
   fs.writeInt16 (_second);
   fs.writeInt16 (_remarksize);
-  fs.write (m_remark.c_str(), _remarksize);
+  fs.write (m_remark.c_str(), m_remark.length());
+  const char szPad[4] = {0, 0, 0, 0};
+  fs.write (szPad, nPad);
+  if (_signature == m_signatureCompressed) {
+    kuint16 _codec = m_iCompression;
+    kuint16 _reserved = 0;
+    fs.writeInt16 (_codec);
+    fs.writeInt16 (_reserved);
+  }
 
-  m_headerSize = fs.tellp();
-  _hsize = m_headerSize;
-  fs.seekp(0);
-  fs.writeInt16 (_hsize);
-  if (! fs)
+  m_headerSize = _hsize;
+  if (! fs || fs.tellp() != m_headerSize)
     return false;
 
   return true;
@@ -587,7 +746,7 @@ Projections::headerRead (fnetorderstream& fs)
     return false;
   }
 
-  if (_signature != m_signature) {
+  if (_signature != m_signature && _signature != m_signatureCompressed) {
     sys_error (ERR_SEVERE, "File %s does not have a valid projection file signature", m_filename.c_str());
     return false;
   }
@@ -602,12 +761,35 @@ Projections::headerRead (fnetorderstream& fs)
   m_remark = pszRemarkStorage;
   delete pszRemarkStorage;
 
+  kuint16 _codec = ArrayCodec::CODEC_NONE;
+  if (_signature == m_signatureCompressed) {
+    kuint16 _reserved;
+    fs.readInt16 (_codec);
+    fs.readInt16 (_reserved);
+    if (! ArrayCodec::isAvailable (_codec)) {
+      sys_error (ERR_SEVERE, "File %s uses compression %d, which is not available", m_filename.c_str(), _codec);
+      return false;
+    }
+  }
+
   off_t _hsizeread = fs.tellg();
   if (!fs || _hsizeread != _hsize) {
     sys_error (ERR_WARNING, "File header size read %ld != file header size stored %ld [read_projections_header]\n_remarksize=%ld", (long int) _hsizeread, _hsize, _remarksize);
     return false;
   }
 
+  // compressed views are located by an index following the header
+  m_vecViewOffset.clear();
+  if (_signature == m_signatureCompressed) {
+    m_vecViewOffset.resize (_nView + 1);
+    fs.readArray (&m_vecViewOffset[0], _nView + 1, sizeof(kuint64));
+    if (! fs) {
+      sys_error (ERR_SEVERE, "Error reading view index of %s", m_filename.c_str());
+      return false;
+    }
+  }
+
+  m_iCompression = _codec;
   m_headerSize = _hsize;
   m_nView = _nView;
   m_nDet = _nDet;
@@ -646,32 +828,519 @@ Projections::read (const std::string& filename)
 bool
 Projections::read (const char* filename)
 {
-  m_filename = filename;
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::isEntryPath (filename) && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+
 #ifdef MSVC
-  frnetorderstream fileRead (m_filename.c_str(), std::ios::in | std::ios::binary);
+  frnetorderstream fileRead (strVolume.c_str(), std::ios::in | std::ios::binary);
 #else
-  frnetorderstream fileRead (m_filename.c_str(), std::ios::in | std::ios::binary); // | std::ios::nocreate);
+  frnetorderstream fileRead (strVolume.c_str(), std::ios::in | std::ios::binary); // | std::ios::nocreate);
 #endif
 
   if (fileRead.fail())
     return false;
+  fileRead.setOrigin (entryOffset);
+  m_filename = filename;
+
+  if (! read (fileRead))
+    return false;
+
+  fileRead.close();
+  return true;
+}
 
+
+// NAME
+//   read                 Read projections from the origin of an open stream
+
+bool
+Projections::read (fnetorderstream& fileRead)
+{
   if (! headerRead (fileRead))
     return false;
 
   deleteProjData ();
   newProjData();
 
+  // views are stored one after another, so they are read without seeking
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    fileRead.seekg (m_vecViewOffset[0]);
+  else
+    fileRead.seekg (m_headerSize);
   for (int i = 0; i < m_nView; i++) {
-    if (! detarrayRead (fileRead, *m_projData[i], i))
+    if (! detarrayReadNext (fileRead, m_projData[i]))
       break;
   }
 
-  fileRead.close();
   return true;
 }
 
 
+// NAME
+//   readViewsBegin       Start reading a file a number of views at a time
+//
+// DESCRIPTION
+//   Reads the header and allocates the views. readViewsNext() then reads
+//   the following views, nStreamedViews() being the number read so far, so
+//   the views of a pipe can be used while later views are still being
+//   written. readViewsEnd() closes the file. When bStoreViews is false no
+//   views are allocated, and each view is read into the caller's array by
+//   readViewNext(), so memory does not grow with the number of views.
+
+bool
+Projections::readViewsBegin (const char* const filename, bool bStoreViews)
+{
+  readViewsEnd ();
+
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::isEntryPath (filename) && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+
+  m_pViewStream = new frnetorderstream (strVolume.c_str(), std::ios::in | std::ios::binary);
+  if (m_pViewStream->fail()) {
+    readViewsEnd ();
+    return false;
+  }
+  m_pViewStream->setOrigin (entryOffset);
+  m_filename = filename;
+
+  if (! headerRead (*m_pViewStream)) {
+    readViewsEnd ();
+    return false;
+  }
+  deleteProjData ();
+  if (bStoreViews)
+    newProjData();
+
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    m_pViewStream->seekg (m_vecViewOffset[0]);
+  else
+    m_pViewStream->seekg (m_headerSize);
+  m_nStreamedViews = 0;
+
+  return true;
+}
+
+bool
+Projections::readViewsNext (int nViews)
+{
+  if (! m_pViewStream || ! m_projData)
+    return false;
+
+  const int iEndView = std::min (m_nView, m_nStreamedViews + nViews);
+  for ( ; m_nStreamedViews < iEndView; m_nStreamedViews++)
+    if (! detarrayReadNext (*m_pViewStream, m_projData[m_nStreamedViews])) {
+      sys_error (ERR_SEVERE, "Error reading view %d of %s [readViewsNext]", m_nStreamedViews, m_filename.c_str());
+      return false;
+    }
+
+  return true;
+}
+
+bool
+Projections::readViewNext (DetectorArray& darray)
+{
+  if (! m_pViewStream || m_nStreamedViews >= m_nView)
+    return false;
+
+  if (! detarrayReadNext (*m_pViewStream, darray)) {
+    sys_error (ERR_SEVERE, "Error reading view %d of %s [readViewNext]", m_nStreamedViews, m_filename.c_str());
+    return false;
+  }
+  m_nStreamedViews++;
+
+  return true;
+}
+
+void
+Projections::readViewsEnd ()
+{
+  delete m_pViewStream;
+  m_pViewStream = NULL;
+}
+
+
+// NAME
+//   writeViewsBegin      Start writing a file a number of views at a time
+//
+// DESCRIPTION
+//   Writes the header, then writeViewsNext() writes the following views
+//   and flushes them, so a reader of a pipe receives views as soon as they
+//   are collected. The views may be this object's or those of another
+//   Projections holding a few views at a time. writeViewsEnd() closes the
+//   file once all views are written; the header of a file, but not of a
+//   pipe, is then rewritten with the final calculation time. The view
+//   index of a compressed file is also written then, so compressed views
+//   can not be written to a pipe. Entries of a volume are written with
+//   write().
+
+bool
+Projections::writeViewsBegin (const char* const filename)
+{
+  writeViewsEnd ();
+
+  if (VolumeFile::isEntryPath (filename)) {
+    sys_error (ERR_SEVERE, "Volume entries can not be written by views [writeViewsBegin]");
+    return false;
+  }
+  if (! ArrayCodec::isAvailable (m_iCompression)) {
+    sys_error (ERR_SEVERE, "Compression %d is not available [writeViewsBegin]", m_iCompression);
+    return false;
+  }
+  if (m_iCompression != ArrayCodec::CODEC_NONE && fnetorderstream::isStandardStream (filename)) {
+    sys_error (ERR_SEVERE, "Compressed projections can not be written to a pipe [writeViewsBegin]");
+    return false;
+  }
+
+  m_filename = filename;
+  m_pViewStream = new frnetorderstream (filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (m_pViewStream->fail()) {
+    sys_error (ERR_SEVERE, "Error opening file %s for output [writeViewsBegin]", filename);
+    writeViewsEnd ();
+    return false;
+  }
+  if (! headerWrite (*m_pViewStream)) {
+    writeViewsEnd ();
+    return false;
+  }
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    // the index is written by writeViewsEnd once the sizes of the views are known
+    m_vecViewOffset.assign (m_nView + 1, 0);
+    m_pViewStream->writeArray (&m_vecViewOffset[0], m_nView + 1, sizeof(kuint64));
+  }
+  m_nStreamedViews = 0;
+
+  return true;
+}
+
+
+// NAME
+//   writeViewsResume     Continue writing the views of an interrupted file
+//
+// NOTES
+//   The header of the file must match the scan, compression and remark of
+//   this object. The complete views already in the file are kept, rounded
+//   down to a multiple of nViewMultiple so that views collected in chunks
+//   are recalculated from the start of a chunk, and writing continues after
+//   them. The views written again are the same as those they replace, so
+//   the finished file is the same as one written without interruption.
+//   A file that does not exist is begun with writeViewsBegin.
+
+bool
+Projections::writeViewsResume (const char* const filename, int nViewMultiple)
+{
+  writeViewsEnd ();
+
+  if (VolumeFile::isEntryPath (filename) || fnetorderstream::isStandardStream (filename)) {
+    sys_error (ERR_SEVERE, "Only projection files can be resumed [writeViewsResume]");
+    return false;
+  }
+  if (nViewMultiple < 1)
+    nViewMultiple = 1;
+
+  frnetorderstream* pStream = new frnetorderstream (filename, std::ios::in | std::ios::out | std::ios::binary);
+  if (pStream->fail()) {
+    delete pStream;
+    return writeViewsBegin (filename);
+  }
+
+  Projections projFile;
+  projFile.m_filename = filename;
+  if (! projFile.headerRead (*pStream) || projFile.m_nView != m_nView || projFile.m_nDet != m_nDet
+      || projFile.m_geometry != m_geometry || projFile.m_iCompression != m_iCompression
+      || projFile.m_rotStart != m_rotStart || projFile.m_rotInc != m_rotInc
+      || projFile.m_detStart != m_detStart || projFile.m_detInc != m_detInc
+      || projFile.m_dViewDiameter != m_dViewDiameter || projFile.m_dFocalLength != m_dFocalLength
+      || projFile.m_dSourceDetectorLength != m_dSourceDetectorLength || projFile.m_remark != m_remark) {
+    sys_error (ERR_SEVERE, "%s is not a projection file of the same scan [writeViewsResume]", filename);
+    delete pStream;
+    return false;
+  }
+
+  m_filename = filename;
+  m_pViewStream = pStream;
+  m_headerSize = projFile.m_headerSize;
+
+  // the start of each complete view, and of the first incomplete one
+  m_vecViewOffset.assign (m_nView + 1, 0);
+  kuint64 offsetView = m_headerSize;
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    offsetView += (m_nView + 1) * sizeof(kuint64);
+  m_pViewStream->seekg (offsetView);
+  DetectorArray darray (m_nDet);
+  int nComplete = 0;
+  while (nComplete < m_nView) {
+    m_vecViewOffset[nComplete] = offsetView;
+    if (! detarrayReadNext (*m_pViewStream, darray))
+      break;
+    nComplete++;
+    offsetView = m_pViewStream->tellg();
+  }
+  m_vecViewOffset[nComplete] = offsetView;
+
+  m_nStreamedViews = nComplete - nComplete % nViewMultiple;
+  if (nComplete == m_nView)
+    m_nStreamedViews = m_nView;
+  m_pViewStream->clear();
+  m_pViewStream->seekp (m_vecViewOffset[m_nStreamedViews]);
+  if (! m_pViewStream->good()) {
+    sys_error (ERR_SEVERE, "Error seeking to view %d of %s [writeViewsResume]", m_nStreamedViews, filename);
+    writeViewsEnd ();
+    return false;
+  }
+
+  return true;
+}
+
+bool
+Projections::writeViewsNext (int nViews)
+{
+  if (! m_pViewStream || ! m_projData)
+    return false;
+
+  const int iEndView = std::min (m_nView, m_nStreamedViews + nViews);
+  while (m_nStreamedViews < iEndView)
+    if (! writeViewNext (getDetectorArray (m_nStreamedViews)))
+      return false;
+  m_pViewStream->flush();
+
+  return m_pViewStream->good();
+}
+
+// Writes the first nViews views of rViews as the next views of the file
+bool
+Projections::writeViewsNext (const Projections& rViews, int nViews)
+{
+  if (! m_pViewStream || nViews > rViews.nView())
+    return false;
+
+  for (int iView = 0; iView < nViews; iView++)
+    if (! writeViewNext (rViews.getDetectorArray (iView)))
+      return false;
+  m_pViewStream->flush();
+
+  return m_pViewStream->good();
+}
+
+bool
+Projections::writeViewNext (const DetectorArray& darray)
+{
+  if (! m_pViewStream || m_nStreamedViews >= m_nView)
+    return false;
+
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    m_vecViewOffset[m_nStreamedViews] = m_pViewStream->tellp();
+  if (! detarrayWriteNext (*m_pViewStream, darray)) {
+    sys_error (ERR_SEVERE, "Error writing view %d of %s [writeViewNext]", m_nStreamedViews, m_filename.c_str());
+    return false;
+  }
+  m_nStreamedViews++;
+
+  return true;
+}
+
+bool
+Projections::writeViewsEnd ()
+{
+  if (! m_pViewStream)
+    return true;
+
+  bool bOk = m_pViewStream->good() && m_nStreamedViews == m_nView;
+  if (bOk && m_iCompression != ArrayCodec::CODEC_NONE) {
+    m_vecViewOffset[m_nView] = m_pViewStream->tellp();
+    m_pViewStream->seekp (m_headerSize);
+    m_pViewStream->writeArray (&m_vecViewOffset[0], m_nView + 1, sizeof(kuint64));
+  }
+  if (bOk && ! m_pViewStream->isSequential())
+    bOk = headerWrite (*m_pViewStream);
+
+  delete m_pViewStream;
+  m_pViewStream = NULL;
+
+  return bOk;
+}
+
+
+bool
+Projections::readMapped (const std::string& filename, int nCacheViews)
+{
+  return readMapped (filename.c_str(), nCacheViews);
+}
+
+
+// NAME
+//   readMapped           Map a projections file and decode views as they are used
+//
+// NOTES
+//   On little endian hosts the detector values of files with aligned views
+//   are used in place from a private mapping, so the operating system pages
+//   them in as needed. Otherwise views are copied from the mapping when
+//   getDetectorArray first asks for them, and when nCacheViews is not zero
+//   only the last nCacheViews decoded views are kept. A DetectorArray from
+//   a bounded cache is valid until nCacheViews other views are decoded.
+//   Views of compressed files are always decoded.
+//   Without mmap the whole file is read.
+
+bool
+Projections::readMapped (const char* filename, int nCacheViews)
+{
+#ifndef HAVE_MAPPED_PROJECTIONS
+  return read (filename);
+#else
+  if (fnetorderstream::isStandardStream (filename))
+    return read (filename);
+
+  // entries of a volume start on a page, so they are mapped like files
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::isEntryPath (filename)) {
+    if (! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+      return false;
+    if (entryOffset % sysconf (_SC_PAGESIZE) != 0)
+      return read (filename);
+  }
+
+  m_filename = filename;
+  {
+    frnetorderstream fileRead (strVolume.c_str(), std::ios::in | std::ios::binary);
+    if (fileRead.fail())
+      return false;
+    fileRead.setOrigin (entryOffset);
+    if (! headerRead (fileRead))
+      return false;
+  }
+  deleteProjData ();
+
+  const bool bCompressed = m_iCompression != ArrayCodec::CODEC_NONE;
+  const size_t nViewBytes = sizeof(kfloat64) + sizeof(kint32) + static_cast<size_t>(m_nDet) * sizeof(kfloat32);
+  size_t nMapBytes = m_headerSize + static_cast<size_t>(m_nView) * nViewBytes;
+  if (bCompressed) {
+    nMapBytes = m_vecViewOffset[m_nView];
+    for (int iView = 0; iView < m_nView; iView++)
+      if (m_vecViewOffset[iView] + sizeof(kfloat64) + 2 * sizeof(kuint32) > m_vecViewOffset[iView + 1]) {
+        sys_error (ERR_SEVERE, "Invalid view index in projection file %s [readMapped]", filename);
+        return false;
+      }
+  }
+
+  int fd = open (strVolume.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat statFile;
+  if (fstat (fd, &statFile) != 0 || static_cast<kuint64>(statFile.st_size) < entryOffset + nMapBytes) {
+    sys_error (ERR_SEVERE, "Projection file %s is shorter than its %d views [readMapped]", filename, m_nView);
+    close (fd);
+    return false;
+  }
+  // private and writable so that views may be changed without changing the file
+  void* pMap = mmap (NULL, nMapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(entryOffset));
+  close (fd);
+  if (pMap == MAP_FAILED) {
+    sys_error (ERR_SEVERE, "Unable to map projection file %s [readMapped]", filename);
+    return false;
+  }
+
+  m_pFileMap = new ProjectionsFileMap;
+  m_pFileMap->m_pMap = pMap;
+  m_pFileMap->m_nMapBytes = nMapBytes;
+  if (bCompressed) {
+    m_pFileMap->m_pViewData = static_cast<const unsigned char*>(pMap);
+    m_pFileMap->m_nViewBytes = 0;
+    m_pFileMap->m_vecViewOffset = m_vecViewOffset;
+  } else {
+    m_pFileMap->m_pViewData = static_cast<const unsigned char*>(pMap) + m_headerSize;
+    m_pFileMap->m_nViewBytes = nViewBytes;
+  }
+  m_pFileMap->m_nCacheViews = nCacheViews < 0 || nCacheViews >= m_nView ? 0 : nCacheViews;
+  m_pFileMap->m_pCache = NULL;
+  m_pFileMap->m_iNextSlot = 0;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init (&m_pFileMap->m_mutex, NULL);
+#endif
+
+  if (m_nView <= 0 || m_nDet <= 0)
+    return true;
+
+  m_pdViewAngle = new double [m_nView];
+  m_projData = new DetectorArray [m_nView];
+  for (int iView = 0; iView < m_nView; iView++) {
+    kfloat64 viewAngle;
+    memcpy (&viewAngle, m_pFileMap->viewRecord (iView), sizeof(viewAngle));
+    if (NativeBigEndian())
+      SwapBytes8 (&viewAngle);
+    m_pdViewAngle[iView] = viewAngle;
+  }
+
+  const size_t iFirstValues = reinterpret_cast<size_t>(m_pFileMap->m_pViewData) + sizeof(kfloat64) + sizeof(kint32);
+  if (! bCompressed && ! NativeBigEndian() && iFirstValues % sizeof(DetectorValue) == 0) {
+    unsigned char* pViewValues = reinterpret_cast<unsigned char*>(iFirstValues);
+    for (int iView = 0; iView < m_nView; iView++)
+      m_projData[iView].attach (reinterpret_cast<DetectorValue*>(pViewValues + iView * nViewBytes), m_pdViewAngle + iView, m_nDet);
+  } else {
+    int nSlots = m_pFileMap->m_nCacheViews > 0 ? m_pFileMap->m_nCacheViews : m_nView;
+    m_pFileMap->m_pCache = new DetectorValue [static_cast<size_t>(nSlots) * m_nDet];
+    m_pFileMap->m_vecViewSlot.assign (m_nView, -1);
+    m_pFileMap->m_vecSlotView.assign (nSlots, -1);
+    m_bDecodeViews = true;
+  }
+
+  return true;
+#endif
+}
+
+
+// NAME
+//   decodeMappedView     Copy a view from the mapped file unless it is decoded
+
+void
+Projections::decodeMappedView (int iView) const
+{
+  ProjectionsFileMap& fileMap = *m_pFileMap;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&fileMap.m_mutex);
+#endif
+  if (fileMap.m_vecViewSlot[iView] < 0) {
+    int iSlot = iView;
+    if (fileMap.m_nCacheViews > 0) {
+      // slots are reused in the order they were filled
+      iSlot = fileMap.m_iNextSlot;
+      fileMap.m_iNextSlot = (iSlot + 1) % fileMap.m_nCacheViews;
+      if (fileMap.m_vecSlotView[iSlot] >= 0)
+        fileMap.m_vecViewSlot[fileMap.m_vecSlotView[iSlot]] = -1;
+      fileMap.m_vecSlotView[iSlot] = iView;
+    }
+
+    DetectorValue* pValues = fileMap.m_pCache + static_cast<size_t>(iSlot) * m_nDet;
+    const unsigned char* pRecordValues = fileMap.viewRecord (iView) + sizeof(kfloat64) + sizeof(kint32);
+    if (m_iCompression != ArrayCodec::CODEC_NONE) {
+      kuint32 nEncodedBytes;
+      memcpy (&nEncodedBytes, pRecordValues, sizeof(nEncodedBytes));
+      if (NativeBigEndian())
+        SwapBytes4 (&nEncodedBytes);
+      const size_t nRecordBytes = fileMap.m_vecViewOffset[iView + 1] - fileMap.m_vecViewOffset[iView];
+      if (nEncodedBytes > nRecordBytes - sizeof(kfloat64) - 2 * sizeof(kuint32)
+          || ! ArrayCodec::decode (m_iCompression, pRecordValues + sizeof(kuint32), nEncodedBytes,
+                                   pValues, m_nDet, sizeof(DetectorValue))) {
+        sys_error (ERR_SEVERE, "Unable to decode view %d of %s [decodeMappedView]", iView, m_filename.c_str());
+        memset (pValues, 0, m_nDet * sizeof(DetectorValue));
+      }
+    } else {
+      memcpy (pValues, pRecordValues, m_nDet * sizeof(DetectorValue));
+      if (NativeBigEndian())
+        SwapBytesArray (pValues, m_nDet, sizeof(DetectorValue));
+    }
+    m_projData[iView].attach (pValues, m_pdViewAngle + iView, m_nDet);
+    fileMap.m_vecViewSlot[iView] = iSlot;
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&fileMap.m_mutex);
+#endif
+}
+
+
 bool
 Projections::copyViewData (const std::string& filename, std::ostream& os, int startView, int endView)
 {
@@ -681,7 +1350,12 @@ Projections::copyViewData (const std::string& filename, std::ostream& os, int st
 bool
 Projections::copyViewData (const char* const filename, std::ostream& os, int startView, int endView)
 {
-  frnetorderstream is (filename, std::ios::in | std::ios::binary);
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::isEntryPath (filename) && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+  frnetorderstream is (strVolume.c_str(), std::ios::in | std::ios::binary);
+  is.setOrigin (entryOffset);
   kuint16 sizeHeader, signature;
   kuint32 _nView, _nDet;
 
@@ -698,7 +1372,7 @@ Projections::copyViewData (const char* const filename, std::ostream& os, int sta
   int nView = _nView;
   int nDet = _nDet;
 
-  if (signature != m_signature) {
+  if (signature != m_signature && signature != m_signatureCompressed) {
     sys_error (ERR_SEVERE, "Illegal signature in projection file %s", filename);
     return false;
   }
@@ -716,6 +1390,38 @@ Projections::copyViewData (const char* const filename, std::ostream& os, int sta
     startView = tempView;
   }
 
+  // views of compressed files are copied in the plain format
+  if (signature == m_signatureCompressed) {
+    Projections proj;
+    proj.m_filename = filename;
+    if (! proj.headerRead (is))
+      return false;
+    DetectorArray darray (nDet);
+    std::vector<unsigned char> vecValues;
+    for (int i = startView; i <= endView; i++) {
+      if (! proj.detarrayRead (is, darray, i))
+        break;
+      kfloat64 viewAngle = darray.viewAngle();
+      kuint32 nDetView = nDet;
+      if (NativeBigEndian()) {
+        SwapBytes8 (&viewAngle);
+        SwapBytes4 (&nDetView);
+      }
+      ArrayCodec::encode (ArrayCodec::CODEC_NONE, darray.detValues(), nDet, sizeof(DetectorValue), vecValues);
+      os.write (reinterpret_cast<char*>(&viewAngle), sizeof(viewAngle));
+      os.write (reinterpret_cast<char*>(&nDetView), sizeof(nDetView));
+      os.write (reinterpret_cast<char*>(&vecValues[0]), vecValues.size());
+      if (os.fail())
+        break;
+    }
+    if (is.fail())
+      sys_error (ERR_SEVERE, "Error reading projection file");
+    if (os.fail())
+      sys_error (ERR_SEVERE, "Error writing projection file");
+
+    return (! (is.fail() | os.fail()));
+  }
+
   int sizeView = 8 /* view_angle */ + 4 /* nDet */ + (4 * nDet);
   unsigned char* pViewData = new unsigned char [sizeView];
 
@@ -745,12 +1451,18 @@ Projections::copyHeader (const std::string& filename, std::ostream& os)
 bool
 Projections::copyHeader (const char* const filename, std::ostream& os)
 {
-  frnetorderstream is (filename, std::ios::in | std::ios::binary);
+  std::string strVolume (filename);
+  kuint64 entryOffset = 0;
+  if (VolumeFile::isEntryPath (filename) && ! VolumeFile::locateEntry (filename, strVolume, entryOffset))
+    return false;
+  frnetorderstream is (strVolume.c_str(), std::ios::in | std::ios::binary);
+  is.setOrigin (entryOffset);
+  is.seekg (0);
   kuint16 sizeHeader, signature;
   is.readInt16 (sizeHeader);
   is.readInt16 (signature);
   is.seekg (0);
-  if (signature != m_signature) {
+  if (signature != m_signature && signature != m_signatureCompressed) {
     sys_error (ERR_SEVERE, "Illegal signature in projection file %s", filename);
     return false;
   }
@@ -762,6 +1474,16 @@ Projections::copyHeader (const char* const filename, std::ostream& os)
     return false;
   }
 
+  // a compressed header is copied as the plain header that copyViewData's views follow,
+  // without the trailing codec fields
+  if (signature == m_signatureCompressed) {
+    sizeHeader -= 2 * sizeof(kuint16);
+    pHdrData[0] = sizeHeader & 0xFF;
+    pHdrData[1] = sizeHeader >> 8;
+    pHdrData[2] = m_signature & 0xFF;
+    pHdrData[3] = m_signature >> 8;
+  }
+
   os.write (reinterpret_cast<char*>(pHdrData), sizeHeader);
   if (os.fail()) {
     sys_error (ERR_SEVERE, "Error writing header");
@@ -780,27 +1502,72 @@ Projections::write (const std::string& filename)
 bool
 Projections::write (const char* filename)
 {
-  frnetorderstream fs (filename, std::ios::out | std::ios::binary | std::ios::trunc | std::ios::ate);
   m_filename = filename;
+
+  std::string strVolume, strEntry;
+  if (VolumeFile::splitEntryPath (filename, strVolume, strEntry)) {
+    VolumeFile volume;
+    if (! volume.open (strVolume.c_str(), true))
+      return false;
+    bool bOk = volume.writeProjections (strEntry.c_str(), *this);
+    return volume.close() && bOk;
+  }
+
+  frnetorderstream fs (filename, std::ios::out | std::ios::binary | std::ios::trunc | std::ios::ate);
   if (! fs) {
     sys_error (ERR_SEVERE, "Error opening file %s for output [projections_create]", filename);
     return false;
   }
 
+  if (! write (fs))
+    return false;
+
+  fs.close();
+
+  return true;
+}
+
+// NAME
+//   write                Write projections at the origin of an open stream
+
+bool
+Projections::write (fnetorderstream& fs)
+{
+  if (! ArrayCodec::isAvailable (m_iCompression)) {
+    sys_error (ERR_SEVERE, "Compression %d is not available [Projections::write]", m_iCompression);
+    return false;
+  }
+  if (m_iCompression != ArrayCodec::CODEC_NONE && fs.isSequential()) {
+    sys_error (ERR_SEVERE, "Compressed projections can not be written to a pipe [Projections::write]");
+    return false;
+  }
   if (! headerWrite (fs))
     return false;
 
-  if (m_projData != NULL) {
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    // the index is written once the sizes of the compressed views are known
+    m_vecViewOffset.assign (m_nView + 1, 0);
+    fs.seekp (m_headerSize);
+    fs.writeArray (&m_vecViewOffset[0], m_nView + 1, sizeof(kuint64));
+    for (int i = 0; i < m_nView && m_projData; i++) {
+      m_vecViewOffset[i] = fs.tellp();
+      if (! detarrayWriteNext (fs, getDetectorArray (i)))
+        return false;
+    }
+    for (int i = m_projData ? m_nView : 0; i <= m_nView; i++)
+      m_vecViewOffset[i] = fs.tellp();
+    fs.seekp (m_headerSize);
+    fs.writeArray (&m_vecViewOffset[0], m_nView + 1, sizeof(kuint64));
+  } else if (m_projData != NULL) {
+    fs.seekp (m_headerSize);
     for (int i = 0; i < m_nView; i++) {
-      if (! detarrayWrite (fs, *m_projData[i], i))
+      if (! detarrayWriteNext (fs, getDetectorArray (i)))
         break;
     }
   }
   if (! fs)
     return false;
 
-  fs.close();
-
   return true;
 }
 
@@ -816,26 +1583,46 @@ Projections::write (const char* filename)
 bool
 Projections::detarrayRead (fnetorderstream& fs, DetectorArray& darray, const int iview)
 {
-  const int detval_bytes = darray.nDet() * sizeof(kfloat32);
-  const int detheader_bytes = sizeof(kfloat64) /* view_angle */ + sizeof(kint32) /* nDet */;
-  const int view_bytes = detheader_bytes + detval_bytes;
-  const off_t start_data = m_headerSize + (iview * view_bytes);
-  DetectorValue* detval_ptr = darray.detValues();
+  const off_t view_bytes = sizeof(kfloat64) /* view_angle */ + sizeof(kint32) /* nDet */ + darray.nDet() * sizeof(kfloat32);
+
+  if (m_iCompression != ArrayCodec::CODEC_NONE)
+    fs.seekg (m_vecViewOffset[iview]);
+  else
+    fs.seekg (m_headerSize + iview * view_bytes);
+
+  return detarrayReadNext (fs, darray);
+}
+
+// Reads the view at the current position of fs, the detector values with one read
+bool
+Projections::detarrayReadNext (fnetorderstream& fs, DetectorArray& darray)
+{
   kfloat64 view_angle;
   kuint32 nDet;
 
-  fs.seekg (start_data);
-
   fs.readFloat64 (view_angle);
   fs.readInt32 (nDet);
+  if (! fs)
+    return false;
+  if (nDet != static_cast<kuint32>(darray.nDet())) {
+    sys_error (ERR_SEVERE, "View has %d detectors, expected %d [detarrayRead]", nDet, darray.nDet());
+    return false;
+  }
   darray.setViewAngle (view_angle);
-  //  darray.setNDet ( nDet);
 
-  for (unsigned int i = 0; i < nDet; i++) {
-    kfloat32 detval;
-    fs.readFloat32 (detval);
-    detval_ptr[i] = detval;
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    kuint32 nEncodedBytes;
+    fs.readInt32 (nEncodedBytes);
+    if (! fs)
+      return false;
+    std::vector<unsigned char> vecEncoded (nEncodedBytes);
+    fs.read (reinterpret_cast<char*>(&vecEncoded[0]), nEncodedBytes);
+    if (! fs || ! ArrayCodec::decode (m_iCompression, &vecEncoded[0], nEncodedBytes, darray.detValues(), nDet, sizeof(kfloat32)))
+      return false;
+    return true;
   }
+
+  fs.readArray (darray.detValues(), nDet, sizeof(kfloat32));
   if (! fs)
     return false;
 
@@ -860,27 +1647,39 @@ Projections::detarrayRead (fnetorderstream& fs, DetectorArray& darray, const int
 bool
 Projections::detarrayWrite (fnetorderstream& fs, const DetectorArray& darray, const int iview)
 {
-  const int detval_bytes = darray.nDet() * sizeof(float);
-  const int detheader_bytes = sizeof(kfloat64) /* view_angle */ + sizeof(kint32) /* nDet */;
-  const int view_bytes = detheader_bytes + detval_bytes;
-  const off_t start_data = m_headerSize + (iview * view_bytes);
-  const DetectorValue* const detval_ptr = darray.detValues();
-  kfloat64 view_angle = darray.viewAngle();
-  kuint32 nDet = darray.nDet();
+  const off_t view_bytes = sizeof(kfloat64) /* view_angle */ + sizeof(kint32) /* nDet */ + darray.nDet() * sizeof(kfloat32);
 
-  fs.seekp (start_data);
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    sys_error (ERR_SEVERE, "Views of compressed files can only be written in order [detarrayWrite]");
+    return false;
+  }
+  fs.seekp (m_headerSize + iview * view_bytes);
   if (! fs) {
     sys_error (ERR_SEVERE, "Error seeking detectory array [detarrayWrite]");
     return false;
   }
 
+  return detarrayWriteNext (fs, darray);
+}
+
+// Writes the view at the current position of fs, the detector values with one write
+bool
+Projections::detarrayWriteNext (fnetorderstream& fs, const DetectorArray& darray)
+{
+  kfloat64 view_angle = darray.viewAngle();
+  kuint32 nDet = darray.nDet();
+
   fs.writeFloat64 (view_angle);
   fs.writeInt32 (nDet);
-
-  for (unsigned int i = 0; i < nDet; i++) {
-    kfloat32 detval = detval_ptr[i];
-    fs.writeFloat32 (detval);
-  }
+  if (m_iCompression != ArrayCodec::CODEC_NONE) {
+    std::vector<unsigned char> vecEncoded;
+    if (! ArrayCodec::encode (m_iCompression, darray.detValues(), nDet, sizeof(kfloat32), vecEncoded))
+      return false;
+    kuint32 nEncodedBytes = vecEncoded.size();
+    fs.writeInt32 (nEncodedBytes);
+    fs.write (reinterpret_cast<const char*>(&vecEncoded[0]), nEncodedBytes);
+  } else
+    fs.writeArray (darray.detValues(), nDet, sizeof(kfloat32));
 
   if (! fs)
     return (false);
@@ -922,9 +1721,10 @@ Projections::printProjectionData (int startView, int endView)
     if (endView > m_nView - 1)
       endView = m_nView - 1;
     for (int ir = startView; ir <= endView - 1; ir++) {
-      printf("View %d: angle %f\n", ir, m_projData[ir]->viewAngle());
-      DetectorValue* detval = m_projData[ir]->detValues();
-      for (int id = 0; id < m_projData[ir]->nDet(); id++)
+      const DetectorArray& detarray = getDetectorArray (ir);
+      printf("View %d: angle %f\n", ir, detarray.viewAngle());
+      const DetectorValue* detval = detarray.detValues();
+      for (int id = 0; id < detarray.nDet(); id++)
         printf("%8.4f  ", detval[id]);
       printf("\n");
     }
@@ -960,9 +1760,19 @@ Projections::convertPolar (ImageFile& rIF, int iInterpolationID)
   if (! v || nx == 0 || ny == 0)
     return false;
 
+  // Divergent beam views are rebinned one at a time as they are copied
   Projections* pProj = this;
-  if (m_geometry == Scanner::GEOMETRY_EQUIANGULAR || m_geometry == Scanner::GEOMETRY_EQUILINEAR)
-    pProj = interpolateToParallel();
+  ParallelRebinner* pRebinner = NULL;
+  DetectorArray* pRebinnedView = NULL;
+  if (m_geometry == Scanner::GEOMETRY_EQUIANGULAR || m_geometry == Scanner::GEOMETRY_EQUILINEAR) {
+    pRebinner = new ParallelRebinner (*this, 0);
+    if (pRebinner->fail()) {
+      delete pRebinner;
+      return false;
+    }
+    pProj = pRebinner->newParallelProjections (false);
+    pRebinnedView = new DetectorArray (pProj->m_nDet);
+  }
 
   Array2d<double> adView (nx, ny);
   Array2d<double> adDet (nx, ny);
@@ -970,10 +1780,16 @@ Projections::convertPolar (ImageFile& rIF, int iInterpolationID)
   double** ppdDet = adDet.getArray();
 
   std::complex<double>** ppcDetValue = new std::complex<double>* [pProj->m_nView];
+  std::complex<double>* pcDetValues = new std::complex<double> [static_cast<size_t>(pProj->m_nView) * pProj->m_nDet];
   int iView;
   for (iView = 0; iView < pProj->m_nView; iView++) {
-    ppcDetValue[iView] = new std::complex<double> [pProj->m_nDet];
-    DetectorValue* detval = pProj->getDetectorArray (iView).detValues();
+    ppcDetValue[iView] = pcDetValues + static_cast<size_t>(iView) * pProj->m_nDet;
+    const DetectorValue* detval;
+    if (pRebinner) {
+      pRebinner->rebinView (iView, *pRebinnedView);
+      detval = pRebinnedView->detValues();
+    } else
+      detval = pProj->getDetectorArray (iView).detValues();
     for (int iDet = 0; iDet < pProj->m_nDet; iDet++)
       ppcDetValue[iView][iDet] = std::complex<double>(detval[iDet], 0);
   }
@@ -983,12 +1799,14 @@ Projections::convertPolar (ImageFile& rIF, int iInterpolationID)
   pProj->interpolatePolar (v, vImag, nx, ny, ppcDetValue, ppdView, ppdDet, pProj->m_nView, pProj->m_nDet,
     pProj->m_nDet, iInterpolationID);
 
-  for (iView = 0; iView < pProj->m_nView; iView++)
-    delete [] ppcDetValue[iView];
+  delete [] pcDetValues;
   delete [] ppcDetValue;
 
-  if (m_geometry == Scanner::GEOMETRY_EQUIANGULAR || m_geometry == Scanner::GEOMETRY_EQUILINEAR)
+  if (pRebinner) {
+    delete pRebinnedView;
     delete pProj;
+    delete pRebinner;
+  }
 
   return true;
 }
@@ -1247,82 +2065,28 @@ Projections::initFromSomatomAR_STAR (int iNViews, int iNDets, unsigned char* pDa
   return true;
 }
 
+// NAME
+//   interpolateToParallel     Rebin divergent beam projections to parallel geometry
+//
+// NOTES
+//   Parallel projections are returned unchanged. The rebinning tables are
+//   computed analytically by ParallelRebinner and the views are divided
+//   among nThreads threads, 0 for all processors.
+
 Projections*
-Projections::interpolateToParallel () const
+Projections::interpolateToParallel (int nThreads) const
 {
   if (m_geometry == Scanner::GEOMETRY_PARALLEL)
     return const_cast<Projections*>(this);
 
-  int nDet = m_nDet;
-  int nView = m_nView;
-  Projections* pProjNew = new Projections (nView, nDet);
-  pProjNew->m_geometry = Scanner::GEOMETRY_PARALLEL;
-  pProjNew->m_dFocalLength = m_dFocalLength;
-  pProjNew->m_dSourceDetectorLength = m_dSourceDetectorLength;
-  pProjNew->m_dViewDiameter = m_dViewDiameter;
-  pProjNew->m_dFanBeamAngle = m_dFanBeamAngle;
-  pProjNew->m_calcTime  = 0;
-  pProjNew->m_remark = m_remark;
-  pProjNew->m_remark += "; Interpolate to Parallel";
-  pProjNew->m_label.setLabelType (Array2dFileLabel::L_HISTORY);
-  pProjNew->m_label.setLabelString (pProjNew->m_remark);
-  pProjNew->m_label.setCalcTime (pProjNew->m_calcTime);
-  pProjNew->m_label.setDateTime (pProjNew->m_year, pProjNew->m_month, pProjNew->m_day, pProjNew->m_hour, pProjNew->m_minute, pProjNew->m_second);
-
-  pProjNew->m_rotStart = 0;
-#ifdef CONVERT_PARALLEL_PI
-  pProjNew->m_rotInc = PI / nView;;
-#else
-  pProjNew->m_rotInc = TWOPI / nView;
-#endif
-  pProjNew->m_detStart = -m_dViewDiameter / 2;
-  pProjNew->m_detInc = m_dViewDiameter / nDet;
-  if (isEven (nDet)) // even
-    pProjNew->m_detInc = m_dViewDiameter / (nDet - 1);
-
-  ParallelRaysums parallel (this, ParallelRaysums::THETA_RANGE_NORMALIZE_TO_TWOPI);
-
-  double* pdThetaValuesForT = new double [pProjNew->nView()];
-  double* pdRaysumsForT = new double [pProjNew->nView()];
-
-  // interpolate to evenly spaced theta (views)
-  double dDetPos = pProjNew->m_detStart;
-  for (int iD = 0; iD < pProjNew->nDet(); iD++, dDetPos += pProjNew->m_detInc) {
-      parallel.getThetaAndRaysumsForT (iD, pdThetaValuesForT, pdRaysumsForT);
-
-    double dViewAngle = m_rotStart;
-    int iLastFloor = -1;
-    LinearInterpolator<double> interp (pdThetaValuesForT, pdRaysumsForT, pProjNew->nView(), false);
-    for (int iV = 0; iV < pProjNew->nView(); iV++, dViewAngle += pProjNew->m_rotInc) {
-      DetectorValue* detValues = pProjNew->getDetectorArray (iV).detValues();
-      detValues[iD] = interp.interpolate (dViewAngle, &iLastFloor);
-    }
+  ParallelRebinner rebinner (*this, nThreads);
+  if (rebinner.fail()) {
+    sys_error (ERR_SEVERE, "%s [Projections::interpolateToParallel]", rebinner.failMessage().c_str());
+    return NULL;
   }
-  delete pdThetaValuesForT;
-  delete pdRaysumsForT;
-
-  // interpolate to evenly space t (detectors)
-  double* pdOriginalDetPositions = new double [pProjNew->nDet()];
-  parallel.getDetPositions (pdOriginalDetPositions);
-
-  double* pdDetValueCopy = new double [pProjNew->nDet()];
-  double dViewAngle = m_rotStart;
-  for (int iV = 0; iV < pProjNew->nView(); iV++, dViewAngle += pProjNew->m_rotInc) {
-    DetectorArray& detArray = pProjNew->getDetectorArray (iV);
-    DetectorValue* detValues = detArray.detValues();
-    detArray.setViewAngle (dViewAngle);
 
-    for (int i = 0; i < pProjNew->nDet(); i++)
-      pdDetValueCopy[i] =   detValues[i];
-
-    double dDetPos = pProjNew->m_detStart;
-    int iLastFloor = -1;
-    LinearInterpolator<double> interp (pdOriginalDetPositions, pdDetValueCopy, pProjNew->nDet(), false);
-    for (int iD = 0; iD < pProjNew->nDet(); iD++, dDetPos += pProjNew->m_detInc)
-      detValues[iD] = interp.interpolate (dDetPos, &iLastFloor);
-  }
-  delete pdDetValueCopy;
-  delete pdOriginalDetPositions;
+  Projections* pProjNew = rebinner.newParallelProjections();
+  rebinner.rebinViews (*pProjNew, nThreads);
 
   return pProjNew;
 }
@@ -1467,3 +2231,181 @@ ParallelRaysums::getDetPositions (double* pdDetPos)
     iPos += m_iNumView;
   }
 }
+
+
+
+ProjectionsWriter::ProjectionsWriter (const Scanner& scanner, int nChunkViews, int nChunks)
+  : m_nChunkViews(nChunkViews), m_nResumedViews(0), m_iCurrentChunk(-1), m_bOpen(false), m_bFail(false)
+{
+  if (m_nChunkViews < 1)
+    m_nChunkViews = 1;
+  if (nChunks < 1)
+    nChunks = 1;
+
+  m_header.initFromScanner (scanner, false);
+  for (int iChunk = 0; iChunk < nChunks; iChunk++) {
+    Projections* pChunk = new Projections;
+    pChunk->initFromScanner (scanner, false);
+    pChunk->setNView (m_nChunkViews);
+    m_vecChunk.push_back (pChunk);
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init (&m_mutexFail, NULL);
+  m_pQueueFree = NULL;
+  m_pQueueWrite = NULL;
+  m_bThreadStarted = false;
+#endif
+}
+
+ProjectionsWriter::~ProjectionsWriter ()
+{
+  if (m_bOpen)
+    close (m_header.calcTime());
+#ifdef HAVE_PTHREAD
+  delete m_pQueueWrite;
+  delete m_pQueueFree;
+  pthread_mutex_destroy (&m_mutexFail);
+#endif
+  for (unsigned int iChunk = 0; iChunk < m_vecChunk.size(); iChunk++)
+    delete m_vecChunk[iChunk];
+}
+
+bool
+ProjectionsWriter::fail () const
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&m_mutexFail);
+#endif
+  const bool bFail = m_bFail;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&m_mutexFail);
+#endif
+
+  return bFail;
+}
+
+void
+ProjectionsWriter::setFail ()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&m_mutexFail);
+#endif
+  m_bFail = true;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&m_mutexFail);
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+extern "C" {
+static void*
+projectionsWriterEntry (void* pArg)
+{
+  static_cast<ProjectionsWriter*>(pArg)->writeQueuedChunks();
+
+  return NULL;
+}
+}
+#endif
+
+bool
+ProjectionsWriter::open (const char* const filename, bool bResume)
+{
+  if (m_bOpen)
+    return false;
+  if (! (bResume ? m_header.writeViewsResume (filename, m_nChunkViews) : m_header.writeViewsBegin (filename)))
+    return false;
+  m_nResumedViews = m_header.nStreamedViews();
+  m_bOpen = true;
+  m_bFail = false;
+
+#ifdef HAVE_PTHREAD
+  // queues are closed when a file is closed, so each file has new ones
+  delete m_pQueueWrite;
+  delete m_pQueueFree;
+  m_pQueueFree = new BoundedQueue<int> (m_vecChunk.size());
+  m_pQueueWrite = new BoundedQueue<ChunkWrite> (m_vecChunk.size());
+  for (unsigned int iChunk = 0; iChunk < m_vecChunk.size(); iChunk++)
+    m_pQueueFree->push (iChunk);
+  m_bThreadStarted = pthread_create (&m_idThread, NULL, projectionsWriterEntry, this) == 0;
+#endif
+
+  return true;
+}
+
+Projections&
+ProjectionsWriter::getChunk ()
+{
+  m_iCurrentChunk = 0;
+#ifdef HAVE_PTHREAD
+  if (m_bThreadStarted && ! m_pQueueFree->pop (m_iCurrentChunk))
+    m_iCurrentChunk = 0;
+#endif
+
+  return *m_vecChunk[m_iCurrentChunk];
+}
+
+bool
+ProjectionsWriter::writeChunk (int nViews)
+{
+  if (! m_bOpen || m_iCurrentChunk < 0 || nViews > m_nChunkViews)
+    return false;
+
+#ifdef HAVE_PTHREAD
+  if (m_bThreadStarted) {
+    ChunkWrite chunkWrite;
+    chunkWrite.m_iChunk = m_iCurrentChunk;
+    chunkWrite.m_nViews = nViews;
+    m_iCurrentChunk = -1;
+    return m_pQueueWrite->push (chunkWrite) && ! fail();
+  }
+#endif
+
+  if (! m_header.writeViewsNext (*m_vecChunk[m_iCurrentChunk], nViews))
+    setFail();
+  m_iCurrentChunk = -1;
+
+  return ! fail();
+}
+
+// NAME
+//   writeQueuedChunks    Write queued chunks until the queue is closed
+//
+// NOTES
+//   After an error the remaining chunks are discarded, so the collecting
+//   thread never waits for a free chunk.
+
+void
+ProjectionsWriter::writeQueuedChunks ()
+{
+#ifdef HAVE_PTHREAD
+  ChunkWrite chunkWrite;
+  while (m_pQueueWrite->pop (chunkWrite)) {
+    if (! fail() && ! m_header.writeViewsNext (*m_vecChunk[chunkWrite.m_iChunk], chunkWrite.m_nViews))
+      setFail();
+    m_pQueueFree->push (chunkWrite.m_iChunk);
+  }
+#endif
+}
+
+bool
+ProjectionsWriter::close (double dCalcTime)
+{
+  if (! m_bOpen)
+    return false;
+
+#ifdef HAVE_PTHREAD
+  if (m_bThreadStarted) {
+    m_pQueueWrite->close();
+    pthread_join (m_idThread, NULL);
+    m_bThreadStarted = false;
+  }
+#endif
+  m_bOpen = false;
+
+  m_header.setCalcTime (dCalcTime);
+  if (! m_header.writeViewsEnd ())
+    setFail();
+
+  return ! fail();
+}
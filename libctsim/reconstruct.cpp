@@ -25,6 +25,33 @@
 #include "ct.h"
 
 
+const int Reconstructor::METHOD_INVALID = -1;
+const int Reconstructor::METHOD_FBP = 0;
+const int Reconstructor::METHOD_SART = 1;
+const int Reconstructor::METHOD_OS_SART = 2;
+const int Reconstructor::METHOD_OS_EM = 3;
+
+const char* const Reconstructor::s_aszMethodName[] =
+{
+  "fbp",
+  "sart",
+  "os-sart",
+  "os-em",
+};
+
+const char* const Reconstructor::s_aszMethodTitle[] =
+{
+  "Filtered Backprojection",
+  "SART",
+  "Ordered Subsets SART",
+  "Ordered Subsets EM",
+};
+
+const int Reconstructor::s_iMethodCount = sizeof(s_aszMethodName) / sizeof(const char*);
+
+const char* const Reconstructor::s_szCheckpointLabel = "Reconstruction checkpoint: %d of %d views";
+
+
 /* NAME
  *   Reconstructor::Reconstructor      Reconstruct Image from Projections
  *
@@ -52,11 +79,32 @@ Reconstructor::Reconstructor (const Projections& rProj, ImageFile& rIF, const ch
                               const char* filterGenerationName, const char* const interpName,
                               int interpFactor, const char* const backprojectName, const int iTrace,
                               ReconstructionROI* pROI, bool bRebinToParallel, SGP* pSGP)
-  : m_rOriginalProj(rProj),
-    m_pProj(bRebinToParallel ? m_rOriginalProj.interpolateToParallel() : &m_rOriginalProj),
+  : m_rOriginalProj(rProj), m_pProj(&rProj), m_pRebinner(0), m_pRebinnedView(0),
     m_rImagefile(rIF), m_pProcessSignal(0), m_pBackprojector(0),
-    m_iTrace(iTrace), m_bRebinToParallel(bRebinToParallel), m_bFail(false), m_adPlotXAxis(0)
+    m_iTrace(iTrace), m_bRebinToParallel(bRebinToParallel), m_bFail(false),
+    m_nBackprojectedViews(0), m_nCheckpointViews(0), m_adPlotXAxis(0)
 {
+  if (bRebinToParallel && rProj.geometry() != Scanner::GEOMETRY_PARALLEL) {
+    m_pRebinner = new ParallelRebinner (rProj, 0);
+    if (m_pRebinner->fail()) {
+      m_bFail = true;
+      m_strFailMessage = "Error rebinning to parallel: ";
+      m_strFailMessage += m_pRebinner->failMessage();
+      delete m_pRebinner; m_pRebinner = NULL;
+      return;
+    }
+    // The matrix backprojector looks up stored views, the others are
+    // handed each view as it is rebinned
+    if (Backprojector::convertBackprojectNameToID (backprojectName) == Backprojector::BPROJ_MATRIX) {
+      Projections* pProjParallel = m_pRebinner->newParallelProjections();
+      m_pRebinner->rebinViews (*pProjParallel, 0);
+      m_pProj = pProjParallel;
+    } else {
+      m_pProj = m_pRebinner->newParallelProjections (false);
+      m_pRebinnedView = new DetectorArray (m_pProj->nDet());
+    }
+  }
+
   m_nFilteredProjections = m_pProj->nDet() * interpFactor;
 
 #ifdef HAVE_BSPLINE_INTERP
@@ -104,8 +152,10 @@ Reconstructor::Reconstructor (const Projections& rProj, ImageFile& rIF, const ch
 
 Reconstructor::~Reconstructor ()
 {
-  if (m_bRebinToParallel)
+  if (m_pProj != &m_rOriginalProj)
     delete m_pProj;
+  delete m_pRebinnedView;
+  delete m_pRebinner;
 
   delete m_pBackprojector;
   delete m_pProcessSignal;
@@ -142,7 +192,8 @@ Reconstructor::plotFilter (SGP* pSGP)
 void
 Reconstructor::reconstructAllViews ()
 {
-  reconstructView (0, m_pProj->nView());
+  if (m_nBackprojectedViews < m_pProj->nView())
+    reconstructView (m_nBackprojectedViews, m_pProj->nView() - m_nBackprojectedViews);
   postProcessing();
 }
 
@@ -153,6 +204,72 @@ Reconstructor::postProcessing()
 }
 
 
+void
+Reconstructor::setCheckpoint (const char* const filename, int nCheckpointViews)
+{
+  m_strCheckpointFile = filename;
+  m_nCheckpointViews = nCheckpointViews;
+}
+
+void
+Reconstructor::viewBackprojected ()
+{
+  m_nBackprojectedViews++;
+  if (m_nCheckpointViews > 0 && m_nBackprojectedViews % m_nCheckpointViews == 0
+      && m_nBackprojectedViews < m_pProj->nView())
+    writeCheckpoint ();
+}
+
+// NAME
+//   writeCheckpoint      Write the image summed so far and its number of views
+//
+// NOTES
+//   The file is written under a temporary name and then renamed, so a job
+//   stopped while writing keeps its previous checkpoint. Pixels are written
+//   in their own format, so a resumed image is the same, bit for bit, as
+//   the one that was interrupted.
+
+bool
+Reconstructor::writeCheckpoint ()
+{
+  ImageFile imCheckpoint (m_rImagefile.nx(), m_rImagefile.ny());
+  memcpy (imCheckpoint.data(), m_rImagefile.data(), m_rImagefile.size() * sizeof(ImageFileValue));
+
+  char szLabel[STR_SIZE];
+  snprintf (szLabel, sizeof(szLabel), s_szCheckpointLabel, m_nBackprojectedViews, m_pProj->nView());
+  imCheckpoint.labelAdd (Array2dFileLabel::L_HISTORY, szLabel);
+
+  std::string strTemp = m_strCheckpointFile + ".tmp";
+  if (! imCheckpoint.fileWrite (strTemp) || rename (strTemp.c_str(), m_strCheckpointFile.c_str()) != 0) {
+    sys_error (ERR_WARNING, "Error writing checkpoint %s [writeCheckpoint]", m_strCheckpointFile.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool
+Reconstructor::resumeCheckpoint (const char* const filename)
+{
+  ImageFile imCheckpoint;
+  if (! imCheckpoint.fileRead (filename))
+    return false;
+
+  int nViews = 0, nViewTotal = 0;
+  if (imCheckpoint.nLabels() < 1 || imCheckpoint.nx() != m_rImagefile.nx() || imCheckpoint.ny() != m_rImagefile.ny()
+      || sscanf (imCheckpoint.labelGet(0).getLabelString().c_str(), s_szCheckpointLabel, &nViews, &nViewTotal) != 2
+      || nViewTotal != m_pProj->nView() || nViews < 0 || nViews > nViewTotal) {
+    sys_error (ERR_SEVERE, "%s is not a checkpoint of this reconstruction [resumeCheckpoint]", filename);
+    return false;
+  }
+
+  memcpy (m_rImagefile.data(), imCheckpoint.data(), m_rImagefile.size() * sizeof(ImageFileValue));
+  m_nBackprojectedViews = nViews;
+
+  return true;
+}
+
+
 void
 Reconstructor::reconstructView (int iStartView, int iViewCount, SGP* pSGP, bool bBackprojectView, double dGraphWidth)
 {
@@ -165,7 +282,9 @@ Reconstructor::reconstructView (int iStartView, int iViewCount, SGP* pSGP, bool
     if (m_iTrace == Trace::TRACE_CONSOLE)
                 std::cout <<"Reconstructing view " << iView << " (last = " << m_pProj->nView() - 1 << ")\n";
 
-    const DetectorArray& rDetArray = m_pProj->getDetectorArray (iView);
+    if (m_pRebinnedView)
+      m_pRebinner->rebinView (iView, *m_pRebinnedView);
+    const DetectorArray& rDetArray = m_pRebinnedView ? *m_pRebinnedView : m_pProj->getDetectorArray (iView);
     const DetectorValue* detval = rDetArray.detValues();
 
     m_pProcessSignal->filterSignal (detval, adFilteredProj);
@@ -182,8 +301,10 @@ Reconstructor::reconstructView (int iStartView, int iViewCount, SGP* pSGP, bool
 #endif
 #endif
 
-        if (bBackprojectView)
+        if (bBackprojectView) {
       m_pBackprojector->BackprojectView (adFilteredProj, rDetArray.viewAngle());
+      viewBackprojected ();
+    }
 
 #ifdef HAVE_SGP
     if (m_iTrace >= Trace::TRACE_PLOT && pSGP) {
@@ -238,3 +359,228 @@ Reconstructor::reconstructView (int iStartView, int iViewCount, SGP* pSGP, bool
   delete adFilteredProj;
 }
 
+
+// NAME
+//   filterView                 Filter one view without backprojecting it
+//   backprojectFilteredView    Backproject a view filtered by filterView
+//
+// NOTES
+//   Filtering does not depend on the image, so threads backprojecting
+//   stripes of one image with their own Reconstructors filter each view
+//   once. A Reconstructor rebins into its own view, so one Reconstructor
+//   must not filter on two threads at once.
+
+double
+Reconstructor::filterView (int iView, double* adFilteredProj)
+{
+  if (m_pRebinnedView)
+    m_pRebinner->rebinView (iView, *m_pRebinnedView);
+  const DetectorArray& rDetArray = m_pRebinnedView ? *m_pRebinnedView : m_pProj->getDetectorArray (iView);
+
+  m_pProcessSignal->filterSignal (rDetArray.detValues(), adFilteredProj);
+
+  return rDetArray.viewAngle();
+}
+
+void
+Reconstructor::backprojectFilteredView (const double* adFilteredProj, double dViewAngle)
+{
+  m_pBackprojector->BackprojectView (adFilteredProj, dViewAngle);
+  viewBackprojected ();
+}
+
+
+
+// Buffers of one view passing through the stages of reconstructStreamedViews
+struct StreamedViewSlot {
+  DetectorArray* m_pDetArray;
+  double* m_adFilteredProj;
+};
+
+#ifdef HAVE_PTHREAD
+// A slot index moves from the free queue to the reader, then through the
+// read and filtered queues back to the free queue, so only the slots'
+// views are held however many views the file has
+struct ReconstructionPipeline {
+  Projections* m_pProj;
+  const ProcessSignal* m_pProcessSignal;
+  std::vector<StreamedViewSlot>& m_vecSlot;
+  BoundedQueue<int> m_queueFree;
+  BoundedQueue<int> m_queueRead;
+  BoundedQueue<int> m_queueFiltered;
+  bool m_bReadFail;
+
+  ReconstructionPipeline (Projections* pProj, const ProcessSignal* pProcessSignal, std::vector<StreamedViewSlot>& vecSlot)
+    : m_pProj(pProj), m_pProcessSignal(pProcessSignal), m_vecSlot(vecSlot), m_queueFree(vecSlot.size()),
+      m_queueRead(vecSlot.size()), m_queueFiltered(vecSlot.size()), m_bReadFail(false)
+  {}
+};
+
+extern "C" {
+static void*
+reconstructReadStage (void* pArg)
+{
+  ReconstructionPipeline* pPipeline = static_cast<ReconstructionPipeline*>(pArg);
+  int iSlot;
+
+  while (pPipeline->m_pProj->nStreamedViews() < pPipeline->m_pProj->nView() && pPipeline->m_queueFree.pop (iSlot)) {
+    if (! pPipeline->m_pProj->readViewNext (*pPipeline->m_vecSlot[iSlot].m_pDetArray)) {
+      pPipeline->m_bReadFail = true;
+      break;
+    }
+    pPipeline->m_queueRead.push (iSlot);
+  }
+  pPipeline->m_queueRead.close();
+
+  return NULL;
+}
+
+static void*
+reconstructFilterStage (void* pArg)
+{
+  ReconstructionPipeline* pPipeline = static_cast<ReconstructionPipeline*>(pArg);
+  int iSlot;
+
+  while (pPipeline->m_queueRead.pop (iSlot)) {
+    StreamedViewSlot& rSlot = pPipeline->m_vecSlot[iSlot];
+    pPipeline->m_pProcessSignal->filterSignal (rSlot.m_pDetArray->detValues(), rSlot.m_adFilteredProj);
+    pPipeline->m_queueFiltered.push (iSlot);
+  }
+  pPipeline->m_queueFiltered.close();
+
+  return NULL;
+}
+}
+#endif
+
+
+// NAME
+//   reconstructStreamedViews   Reconstruct views as they are read from a file
+//
+// SYNOPSIS
+//   bOk = reconstructStreamedViews (rProj, nQueueViews)
+//   Projections& rProj     Projections this Reconstructor was created with,
+//                          opened by readViewsBegin without storing views
+//   int nQueueViews        Views held between the stages
+//
+// DESCRIPTION
+//   A reader thread decodes views from the file, a filter thread runs them
+//   through ProcessSignal and the calling thread backprojects them, the
+//   stages being connected by queues of nQueueViews views. Memory does not
+//   depend on the number of views, and reading the file overlaps filtering
+//   and backprojection. Views are backprojected in file order, so the image
+//   is the same as from reconstructAllViews. Rebinning and the matrix
+//   backprojector need all views and can not be used. Without threads the
+//   stages run in turn for each view.
+
+bool
+Reconstructor::reconstructStreamedViews (Projections& rProj, int nQueueViews)
+{
+  if (m_pProj != &rProj || m_pRebinner) {
+    sys_error (ERR_SEVERE, "Streamed views can not be rebinned [reconstructStreamedViews]");
+    return false;
+  }
+  if (nQueueViews < 1)
+    nQueueViews = 1;
+
+  std::vector<StreamedViewSlot> vecSlot (nQueueViews);
+  for (int iSlot = 0; iSlot < nQueueViews; iSlot++) {
+    vecSlot[iSlot].m_pDetArray = new DetectorArray (rProj.nDet());
+    vecSlot[iSlot].m_adFilteredProj = new double [m_nFilteredProjections];
+  }
+
+  // views already summed into a resumed image are skipped
+  bool bOk = true;
+  while (bOk && rProj.nStreamedViews() < m_nBackprojectedViews)
+    bOk = rProj.readViewNext (*vecSlot[0].m_pDetArray);
+  int iView = rProj.nStreamedViews();
+#ifdef HAVE_PTHREAD
+  ReconstructionPipeline pipeline (&rProj, m_pProcessSignal, vecSlot);
+  for (int iSlot = 0; iSlot < nQueueViews; iSlot++)
+    pipeline.m_queueFree.push (iSlot);
+
+  pthread_t idReader, idFilter;
+  bool bReaderStarted = bOk && pthread_create (&idReader, NULL, reconstructReadStage, &pipeline) == 0;
+  bool bFilterStarted = bReaderStarted && pthread_create (&idFilter, NULL, reconstructFilterStage, &pipeline) == 0;
+  if (bReaderStarted) {
+    // without a filter thread the views are filtered before backprojection
+    BoundedQueue<int>& rQueueIn = bFilterStarted ? pipeline.m_queueFiltered : pipeline.m_queueRead;
+    int iSlot;
+    while (rQueueIn.pop (iSlot)) {
+      StreamedViewSlot& rSlot = vecSlot[iSlot];
+      if (! bFilterStarted)
+        m_pProcessSignal->filterSignal (rSlot.m_pDetArray->detValues(), rSlot.m_adFilteredProj);
+      if (m_iTrace == Trace::TRACE_CONSOLE)
+        std::cout <<"Reconstructing view " << iView << " (last = " << m_pProj->nView() - 1 << ")\n";
+      m_pBackprojector->BackprojectView (rSlot.m_adFilteredProj, rSlot.m_pDetArray->viewAngle());
+      viewBackprojected ();
+      pipeline.m_queueFree.push (iSlot);
+      iView++;
+    }
+    pipeline.m_queueFree.close();
+    if (bFilterStarted)
+      pthread_join (idFilter, NULL);
+    pthread_join (idReader, NULL);
+    bOk = ! pipeline.m_bReadFail;
+  } else
+#endif
+  {
+    StreamedViewSlot& rSlot = vecSlot[0];
+    for ( ; iView < rProj.nView() && bOk; iView++) {
+      bOk = rProj.readViewNext (*rSlot.m_pDetArray);
+      if (bOk) {
+        m_pProcessSignal->filterSignal (rSlot.m_pDetArray->detValues(), rSlot.m_adFilteredProj);
+        if (m_iTrace == Trace::TRACE_CONSOLE)
+          std::cout <<"Reconstructing view " << iView << " (last = " << m_pProj->nView() - 1 << ")\n";
+        m_pBackprojector->BackprojectView (rSlot.m_adFilteredProj, rSlot.m_pDetArray->viewAngle());
+        viewBackprojected ();
+      }
+    }
+  }
+
+  for (int iSlot = 0; iSlot < nQueueViews; iSlot++) {
+    delete vecSlot[iSlot].m_pDetArray;
+    delete [] vecSlot[iSlot].m_adFilteredProj;
+  }
+
+  if (bOk)
+    postProcessing();
+
+  return bOk;
+}
+
+int
+Reconstructor::convertMethodNameToID (const char* const methodName)
+{
+  int methodID = METHOD_INVALID;
+
+  for (int i = 0; i < s_iMethodCount; i++)
+    if (strcasecmp (methodName, s_aszMethodName[i]) == 0) {
+      methodID = i;
+      break;
+    }
+
+  return (methodID);
+}
+
+const char*
+Reconstructor::convertMethodIDToName (const int methodID)
+{
+  static const char *methodName = "";
+
+  if (methodID >= 0 && methodID < s_iMethodCount)
+    return (s_aszMethodName[methodID]);
+
+  return (methodName);
+}
+
+const char*
+Reconstructor::convertMethodIDToTitle (const int methodID)
+{
+  static const char *methodTitle = "";
+
+  if (methodID >= 0 && methodID < s_iMethodCount)
+    return (s_aszMethodTitle[methodID]);
+
+  return (methodTitle);
+}
@@ -50,23 +50,65 @@ const char* const Scanner::s_aszGeometryTitle[] =
 
 const int Scanner::s_iGeometryCount = sizeof(s_aszGeometryName) / sizeof(const char*);
 
+const int Scanner::APERTURE_INVALID = -1;
+const int Scanner::APERTURE_UNIFORM = 0;
+const int Scanner::APERTURE_STRIP = 1;
+
+const char* const Scanner::s_aszApertureName[] =
+{
+  "uniform",
+  "strip",
+};
+
+const char* const Scanner::s_aszApertureTitle[] =
+{
+  "Uniform",
+  "Exact Strip Integral",
+};
+
+const int Scanner::s_iApertureCount = sizeof(s_aszApertureName) / sizeof(const char*);
+
 
 // NAME
 //   DetectorArray       Construct a DetectorArray
 
 DetectorArray::DetectorArray (const int nDet)
+  : m_nDet(nDet), m_viewAngle(0), m_pdViewAngle(&m_viewAngle), m_bOwnValues(true)
 {
-  m_nDet = nDet;
   m_detValues = new DetectorValue [m_nDet];
 }
 
 
+// NAME
+//   DetectorArray       Construct an empty view, see attach
+
+DetectorArray::DetectorArray ()
+  : m_detValues(NULL), m_nDet(0), m_viewAngle(0), m_pdViewAngle(&m_viewAngle), m_bOwnValues(false)
+{}
+
+
+// NAME
+//   attach              Make this array a view of values held elsewhere
+
+void
+DetectorArray::attach (DetectorValue* pDetValues, double* pdViewAngle, int nDet)
+{
+  if (m_bOwnValues)
+    delete [] m_detValues;
+  m_bOwnValues = false;
+  m_detValues = pDetValues;
+  m_pdViewAngle = pdViewAngle;
+  m_nDet = nDet;
+}
+
+
 // NAME
 //   ~DetectorArray             Free memory allocated to a detector array
 
 DetectorArray::~DetectorArray (void)
 {
-  delete [] m_detValues;
+  if (m_bOwnValues)
+    delete [] m_detValues;
 }
 
 
@@ -81,6 +123,7 @@ DetectorArray::~DetectorArray (void)
 *   int nDet                    Number of detector along detector array
 *   int nView                   Number of rotated views
 *   int nSample         Number of rays per detector
+*   char* aperture      Placement and weighting of rays across a detector
 */
 
 Scanner::Scanner (const Phantom& phm, const char* const geometryName,
@@ -88,7 +131,50 @@ Scanner::Scanner (const Phantom& phm, const char* const geometryName,
                                   int nSample, const double rot_anglen,
                   const double dFocalLengthRatio,
                                   const double dCenterDetectorRatio,
+                  const double dViewRatio, const double dScanRatio, const char* const apertureName)
+{
+  init (phm.xmin(), phm.xmax(), phm.ymin(), phm.ymax(), geometryName, nDet, nView, offsetView,
+        nSample, rot_anglen, dFocalLengthRatio, dCenterDetectorRatio, dViewRatio, dScanRatio, apertureName);
+}
+
+
+/* NAME
+*   Scanner                     Construct a Scanner for a pixelized phantom
+*
+* SYNOPSIS
+*   Scanner (im, geometryName, nDet, nView, offsetView, nSample, ...)
+*   ImageFile& im               Image to be scanned
+*
+* NOTES
+*   The image's axis extent takes the place of the phantom's limits.
+*   Without an axis extent, pixels are unit squares centered on the origin.
+*/
+
+Scanner::Scanner (const ImageFile& im, const char* const geometryName,
+                  int nDet, int nView, int offsetView,
+                  int nSample, const double rot_anglen,
+                  const double dFocalLengthRatio, const double dCenterDetectorRatio,
                   const double dViewRatio, const double dScanRatio)
+{
+  double xmin, xmax, ymin, ymax;
+  if (! im.getAxisExtent (xmin, xmax, ymin, ymax)) {
+    xmin = -static_cast<double>(im.nx()) / 2;
+    xmax = static_cast<double>(im.nx()) / 2;
+    ymin = -static_cast<double>(im.ny()) / 2;
+    ymax = static_cast<double>(im.ny()) / 2;
+  }
+
+  init (xmin, xmax, ymin, ymax, geometryName, nDet, nView, offsetView,
+        nSample, rot_anglen, dFocalLengthRatio, dCenterDetectorRatio, dViewRatio, dScanRatio, "uniform");
+}
+
+
+void
+Scanner::init (const double xmin, const double xmax, const double ymin, const double ymax,
+               const char* const geometryName, int nDet, int nView, int offsetView,
+               int nSample, const double rot_anglen,
+               const double dFocalLengthRatio, const double dCenterDetectorRatio,
+               const double dViewRatio, const double dScanRatio, const char* const apertureName)
 {
   m_fail = false;
   m_idGeometry = convertGeometryNameToID (geometryName);
@@ -98,6 +184,13 @@ Scanner::Scanner (const Phantom& phm, const char* const geometryName,
     m_failMessage += geometryName;
     return;
   }
+  m_idAperture = convertApertureNameToID (apertureName);
+  if (m_idAperture == APERTURE_INVALID) {
+    m_fail = true;
+    m_failMessage = "Invalid aperture name ";
+    m_failMessage += apertureName;
+    return;
+  }
 
   if (nView < 1 || nDet < 1) {
     m_fail = true;
@@ -105,7 +198,7 @@ Scanner::Scanner (const Phantom& phm, const char* const geometryName,
     return;
   }
   if (nSample < 1)
-    m_nSample = 1;
+    nSample = 1;
 
   m_nDet     = nDet;
   m_nView    = nView;
@@ -116,14 +209,14 @@ Scanner::Scanner (const Phantom& phm, const char* const geometryName,
   m_dViewRatio = dViewRatio;
   m_dScanRatio = dScanRatio;
 
-  m_dViewDiameter = phm.getDiameterBoundaryCircle() * m_dViewRatio;
+  m_dViewDiameter = SQRT2 * maxValue<double> (xmax - xmin, ymax - ymin) * m_dViewRatio;
   m_dFocalLength = (m_dViewDiameter / 2) * m_dFocalLengthRatio;
   m_dCenterDetectorLength = (m_dViewDiameter / 2) * m_dCenterDetectorRatio;
   m_dSourceDetectorLength = m_dFocalLength + m_dCenterDetectorLength;
   m_dScanDiameter = m_dViewDiameter * m_dScanRatio;
 
-  m_dXCenter = phm.xmin() + (phm.xmax() - phm.xmin()) / 2;
-  m_dYCenter = phm.ymin() + (phm.ymax() - phm.ymin()) / 2;
+  m_dXCenter = xmin + (xmax - xmin) / 2;
+  m_dYCenter = ymin + (ymax - ymin) / 2;
   m_rotLen  = rot_anglen;
   m_rotInc  = m_rotLen / m_nView;
   if (m_idGeometry == GEOMETRY_PARALLEL) {
@@ -212,15 +305,6 @@ Scanner::Scanner (const Phantom& phm, const char* const geometryName,
     m_initPos.ys2 = m_dYCenter + m_dFocalLength;
     m_detLen += dDetectorArrayEndOffset;
   }
-
-  // Calculate incrementatal rotation matrix
-  GRFMTX_2D temp;
-  xlat_mtx2 (m_rotmtxIncrement, -m_dXCenter, -m_dYCenter);
-  rot_mtx2 (temp, m_rotInc);
-  mult_mtx2 (m_rotmtxIncrement, temp, m_rotmtxIncrement);
-  xlat_mtx2 (temp, m_dXCenter, m_dYCenter);
-  mult_mtx2 (m_rotmtxIncrement, temp, m_rotmtxIncrement);
-
 }
 
 Scanner::~Scanner (void)
@@ -265,6 +349,43 @@ Scanner::convertGeometryNameToID (const char* const geomName)
 }
 
 
+const char*
+Scanner::convertApertureIDToName (const int apertureID)
+{
+  const char *name = "";
+
+  if (apertureID >= 0 && apertureID < s_iApertureCount)
+    return (s_aszApertureName[apertureID]);
+
+  return (name);
+}
+
+const char*
+Scanner::convertApertureIDToTitle (const int apertureID)
+{
+  const char *title = "";
+
+  if (apertureID >= 0 && apertureID < s_iApertureCount)
+    return (s_aszApertureTitle[apertureID]);
+
+  return (title);
+}
+
+int
+Scanner::convertApertureNameToID (const char* const apertureName)
+{
+  int id = APERTURE_INVALID;
+
+  for (int i = 0; i < s_iApertureCount; i++)
+    if (strcasecmp (apertureName, s_aszApertureName[i]) == 0) {
+      id = i;
+      break;
+    }
+
+  return (id);
+}
+
+
 /* NAME
 *   collectProjections          Calculate projections for a Phantom
 *
@@ -274,6 +395,9 @@ Scanner::convertGeometryNameToID (const char* const geomName)
 *   Phantom& phm             Phantom for which we collect projections
 *   bool bStoreViewPos      TRUE then storage proj at normal view position
 *   int trace                Trace level
+*
+* NOTES
+*   A phantom with keyframes is evaluated at each view's fraction of the scan
 */
 
 
@@ -298,37 +422,37 @@ Scanner::collectProjections (Projections& proj, const Phantom& phm, const int iS
                              const int trace, SGP* pSGP)
 {
   m_trace = trace;
-  double start_angle = (iStartView + iOffsetView) * proj.rotInc();
-
-  // Calculate initial rotation matrix
-  GRFMTX_2D rotmtx_initial, temp;
-  xlat_mtx2 (rotmtx_initial, -m_dXCenter, -m_dYCenter);
-  rot_mtx2 (temp, start_angle);
-  mult_mtx2 (rotmtx_initial, temp, rotmtx_initial);
-  xlat_mtx2 (temp, m_dXCenter, m_dYCenter);
-  mult_mtx2 (rotmtx_initial, temp, rotmtx_initial);
-
-  double xd1=0, yd1=0, xd2=0, yd2=0;
-  if (m_idGeometry != GEOMETRY_EQUIANGULAR) {
-    xd1 = m_initPos.xd1;
-    yd1 = m_initPos.yd1;
-    xd2 = m_initPos.xd2;
-    yd2 = m_initPos.yd2;
-    xform_mtx2 (rotmtx_initial, xd1, yd1);      // rotate detector endpoints
-    xform_mtx2 (rotmtx_initial, xd2, yd2);      // to initial view_angle
-  }
-
-  double xs1 = m_initPos.xs1;
-  double ys1 = m_initPos.ys1;
-  double xs2 = m_initPos.xs2;
-  double ys2 = m_initPos.ys2;
-  xform_mtx2 (rotmtx_initial, xs1, ys1);      // rotate source endpoints to
-  xform_mtx2 (rotmtx_initial, xs2, ys2);      // initial view angle
 
-  int iView;
-  double viewAngle;
-  for (iView = 0, viewAngle = start_angle;  iView < iNumViews; iView++, viewAngle += proj.rotInc()) {
+  // The angle and the source and detector positions of each view are
+  // calculated from the view number rather than accumulated, so a view is
+  // the same however the views are divided between calls
+  for (int iView = 0; iView < iNumViews; iView++) {
     int iStoragePosition = iView + iStorageOffset;
+    double viewAngle = (iStartView + iView + iOffsetView) * proj.rotInc();
+
+    GRFMTX_2D rotmtx, temp;
+    xlat_mtx2 (rotmtx, -m_dXCenter, -m_dYCenter);
+    rot_mtx2 (temp, viewAngle);
+    mult_mtx2 (rotmtx, temp, rotmtx);
+    xlat_mtx2 (temp, m_dXCenter, m_dYCenter);
+    mult_mtx2 (rotmtx, temp, rotmtx);
+
+    double xd1=0, yd1=0, xd2=0, yd2=0;
+    if (m_idGeometry != GEOMETRY_EQUIANGULAR) {
+      xd1 = m_initPos.xd1;
+      yd1 = m_initPos.yd1;
+      xd2 = m_initPos.xd2;
+      yd2 = m_initPos.yd2;
+      xform_mtx2 (rotmtx, xd1, yd1);      // rotate detector endpoints
+      xform_mtx2 (rotmtx, xd2, yd2);      // to view angle
+    }
+
+    double xs1 = m_initPos.xs1;
+    double ys1 = m_initPos.ys1;
+    double xs2 = m_initPos.xs2;
+    double ys2 = m_initPos.ys2;
+    xform_mtx2 (rotmtx, xs1, ys1);      // rotate source endpoints to
+    xform_mtx2 (rotmtx, xs2, ys2);      // view angle
 
     DetectorArray& detArray = proj.getDetectorArray( iStoragePosition );
 
@@ -401,7 +525,14 @@ Scanner::collectProjections (Projections& proj, const Phantom& phm, const int iS
     if (m_trace == Trace::TRACE_CONSOLE)
       std::cout << "Current View: " << iView+iStartView << std::endl;
 
-    projectSingleView (phm, detArray, xd1, yd1, xd2, yd2, xs1, ys1, xs2, ys2, viewAngle + 3 * HALFPI);
+    if (phm.isDynamic()) {
+      // Evaluate keyframed pelems at this view's fraction of the scan
+      double dTime = (m_nView > 1 ? (iView + iStartView) / static_cast<double>(m_nView - 1) : 0.);
+      Phantom phmView;
+      phmView.createFromPhantomAtTime (phm, dTime);
+      projectSingleView (phmView, detArray, xd1, yd1, xd2, yd2, xs1, ys1, xs2, ys2, viewAngle + 3 * HALFPI);
+    } else
+      projectSingleView (phm, detArray, xd1, yd1, xd2, yd2, xs1, ys1, xs2, ys2, viewAngle + 3 * HALFPI);
     detArray.setViewAngle (viewAngle);
 
 #ifdef HAVE_SGP
@@ -409,12 +540,6 @@ Scanner::collectProjections (Projections& proj, const Phantom& phm, const int iS
       //        rs_plot (detArray, xd1, yd1, dXCenter, dYCenter, theta);
     }
 #endif
-    xform_mtx2 (m_rotmtxIncrement, xs1, ys1);
-    xform_mtx2 (m_rotmtxIncrement, xs2, ys2);
-    if (m_idGeometry != GEOMETRY_EQUIANGULAR) {
-      xform_mtx2 (m_rotmtxIncrement, xd1, yd1);  // rotate detector endpoints
-      xform_mtx2 (m_rotmtxIncrement, xd2, yd2);
-    }
   } /* for each iView */
 }
 
@@ -445,9 +570,91 @@ Scanner::collectProjections (Projections& proj, const Phantom& phm, const int iS
 void
 Scanner::projectSingleView (const Phantom& phm, DetectorArray& detArray, const double xd1, const double yd1, const double xd2, const double yd2, const double xs1, const double ys1, const double xs2, const double ys2, const double dDetAngle)
 {
+  DetectorValue* detval = detArray.detValues();
 
-  double sdx = (xs2 - xs1) / detArray.nDet();  // change in coords
-  double sdy = (ys2 - ys1) / detArray.nDet();  // between source
+  if (phm.getComposition() == P_UNIT_PULSE) {  // put unit pulse in center of view
+    for (int d = 0; d < detArray.nDet(); d++)
+        detval[d] = 0;
+    detval[ detArray.nDet() / 2 ] = 1;
+    return;
+  }
+
+  const int nRays = detArray.nDet() * m_nSample;
+  std::vector<double> vecXD (nRays), vecYD (nRays), vecXS (nRays), vecYS (nRays);
+  calcViewRays (detArray.nDet(), xd1, yd1, xd2, yd2, xs1, ys1, xs2, ys2, dDetAngle,
+                &vecXD[0], &vecYD[0], &vecXS[0], &vecYS[0]);
+
+  int iRay;
+  std::vector<double> vecRaysum (nRays, 0.);
+  std::vector<double> vecStripSum (detArray.nDet(), 0.);
+  if (m_trace >= Trace::TRACE_PROJECTIONS) {
+    // Tracing needs each ray drawn and clipped in turn
+    for (iRay = 0; iRay < nRays; iRay++) {
+#ifdef HAVE_SGP
+      if (m_pSGP) {
+        m_pSGP->setColor (C_YELLOW);
+        m_pSGP->setRasterOp (RO_AND);
+        m_pSGP->moveAbs (vecXS[iRay], vecYS[iRay]);
+        m_pSGP->lineAbs (vecXD[iRay], vecYD[iRay]);
+      }
+#endif
+      vecRaysum[iRay] = projectSingleLine (phm, vecXD[iRay], vecYD[iRay], vecXS[iRay], vecYS[iRay]);
+    }
+  } else if (m_idAperture == APERTURE_STRIP) {
+    // Integrate pelems analytically across each detector's strip, bounded by
+    // the rays from its source to the detector's edges. Other pelems are
+    // sampled by rays.
+    const int nDet = detArray.nDet();
+    const double ddx = (xd2 - xd1) / nDet;
+    const double ddy = (yd2 - yd1) / nDet;
+    std::vector<double> vecXDEdge (nDet + 1), vecYDEdge (nDet + 1), vecXSStrip (nDet), vecYSStrip (nDet);
+    for (int iEdge = 0; iEdge <= nDet; iEdge++) {
+      if (m_idGeometry == GEOMETRY_EQUIANGULAR) {
+        double dAngle = dDetAngle - (m_dAngularDetLen/2) + iEdge * m_dAngularDetIncrement;
+        vecXDEdge[iEdge] = m_dCenterDetectorLength * cos (dAngle);
+        vecYDEdge[iEdge] = m_dCenterDetectorLength * sin (dAngle);
+      } else {
+        vecXDEdge[iEdge] = xd1 + iEdge * ddx;
+        vecYDEdge[iEdge] = yd1 + iEdge * ddy;
+      }
+    }
+    for (int d = 0; d < nDet; d++) {
+      vecXSStrip[d] = vecXS[d * m_nSample];
+      vecYSStrip[d] = vecYS[d * m_nSample];
+    }
+    for (PElemConstIterator i = phm.listPElem().begin(); i != phm.listPElem().end(); i++)
+      if (! (*i)->addStripRaysums (nDet, &vecXSStrip[0], &vecYSStrip[0], &vecXDEdge[0], &vecYDEdge[0], &vecStripSum[0]))
+        (*i)->addRaysums (nRays, &vecXD[0], &vecYD[0], &vecXS[0], &vecYS[0], &vecRaysum[0]);
+  } else {
+    // Intersect all rays of the view with one pelem at a time
+    for (PElemConstIterator i = phm.listPElem().begin(); i != phm.listPElem().end(); i++)
+      (*i)->addRaysums (nRays, &vecXD[0], &vecYD[0], &vecXS[0], &vecYS[0], &vecRaysum[0]);
+  }
+
+  iRay = 0;
+  for (int d = 0; d < detArray.nDet(); d++) {
+    double sum = 0.0;
+    for (unsigned int i = 0; i < m_nSample; i++)
+      sum += vecRaysum[iRay++];
+    detval[d] = sum / m_nSample;
+    if (m_idAperture == APERTURE_STRIP)
+      detval[d] += vecStripSum[d];
+  }
+}
+
+
+// NAME
+//   calcViewRays         Endpoints of every ray in a view, detector major
+//
+// NOTES
+//   See projectSingleView for the placement of rays within a detector
+
+void
+Scanner::calcViewRays (const int nDet, const double xd1, const double yd1, const double xd2, const double yd2, const double xs1, const double ys1, const double xs2, const double ys2, const double dDetAngle,
+                       double* const pXD, double* const pYD, double* const pXS, double* const pYS) const
+{
+  double sdx = (xs2 - xs1) / nDet;  // change in coords
+  double sdy = (ys2 - ys1) / nDet;  // between source
   double xs_maj = xs1 + (sdx / 2);      // put ray source in center of cell
   double ys_maj = ys1 + (sdy / 2);
 
@@ -459,8 +666,8 @@ Scanner::projectSingleView (const Phantom& phm, DetectorArray& detArray, const d
     dAngleSampleOffset = dAngleSampleInc / 2;
     dAngleMajor = dDetAngle - (m_dAngularDetLen/2) + dAngleSampleOffset;
   } else {
-    ddx = (xd2 - xd1) / detArray.nDet();  // change in coords
-    ddy = (yd2 - yd1) / detArray.nDet();  // between detectors
+    ddx = (xd2 - xd1) / nDet;  // change in coords
+    ddy = (yd2 - yd1) / nDet;  // between detectors
     ddx2 = ddx / m_nSample;     // Incr. between rays with detector cell
     ddy2 = ddy / m_nSample;  // Doesn't include detector endpoints
     ddx2_ofs = ddx2 / 2;    // offset of 1st ray from start of detector cell
@@ -470,66 +677,223 @@ Scanner::projectSingleView (const Phantom& phm, DetectorArray& detArray, const d
     yd_maj = yd1 + ddy2_ofs;
   }
 
-  DetectorValue* detval = detArray.detValues();
-
-  if (phm.getComposition() == P_UNIT_PULSE) {  // put unit pulse in center of view
-    for (int d = 0; d < detArray.nDet(); d++)
-        detval[d] = 0;
-    detval[ detArray.nDet() / 2 ] = 1;
-  } else {
-    for (int d = 0; d < detArray.nDet(); d++) {
-      double xs = xs_maj;
-      double ys = ys_maj;
-      double xd=0, yd=0, dAngle=0;
+  int iRay = 0;
+  for (int d = 0; d < nDet; d++) {
+    double xs = xs_maj;
+    double ys = ys_maj;
+    double xd=0, yd=0, dAngle=0;
+    if (m_idGeometry == GEOMETRY_EQUIANGULAR) {
+      dAngle = dAngleMajor;
+    } else {
+      xd = xd_maj;
+      yd = yd_maj;
+    }
+    for (unsigned int i = 0; i < m_nSample; i++) {
       if (m_idGeometry == GEOMETRY_EQUIANGULAR) {
-        dAngle = dAngleMajor;
-      } else {
-        xd = xd_maj;
-        yd = yd_maj;
+        xd = m_dCenterDetectorLength * cos (dAngle);
+        yd = m_dCenterDetectorLength * sin (dAngle);
       }
-      double sum = 0.0;
-      for (unsigned int i = 0; i < m_nSample; i++) {
-        if (m_idGeometry == GEOMETRY_EQUIANGULAR) {
-          xd = m_dCenterDetectorLength * cos (dAngle);
-          yd = m_dCenterDetectorLength * sin (dAngle);
-        }
+      pXD[iRay] = xd;
+      pYD[iRay] = yd;
+      pXS[iRay] = xs;
+      pYS[iRay] = ys;
+      iRay++;
 
-#ifdef HAVE_SGP
-        if (m_pSGP && m_trace >= Trace::TRACE_PROJECTIONS) {
-          m_pSGP->setColor (C_YELLOW);
-          m_pSGP->setRasterOp (RO_AND);
-          m_pSGP->moveAbs (xs, ys);
-          m_pSGP->lineAbs (xd, yd);
-        }
-#endif
+      if (m_idGeometry == GEOMETRY_EQUIANGULAR)
+        dAngle += dAngleSampleInc;
+      else {
+        xd += ddx2;
+        yd += ddy2;
+      }
+    } // for each sample in detector
+
+    xs_maj += sdx;
+    ys_maj += sdy;
+    if (m_idGeometry == GEOMETRY_EQUIANGULAR)
+      dAngleMajor += dAngleInc;
+    else {
+      xd_maj += ddx;
+      yd_maj += ddy;
+    }
+  } /* for each detector */
+}
 
-        sum += projectSingleLine (phm, xd, yd, xs, ys);
 
-#ifdef HAVE_SGP
-        //      if (m_trace >= Trace::TRACE_CLIPPING) {
-        //        traceShowParam ("Attenuation:", "%s", PROJECTION_TRACE_ROW_ATTEN, C_LTMAGENTA, "        ");
-        //        traceShowParam ("Attenuation:", "%.3f", PROJECTION_TRACE_ROW_ATTEN, C_LTMAGENTA, sum);
-        //      }
-#endif
-        if (m_idGeometry == GEOMETRY_EQUIANGULAR)
-          dAngle += dAngleSampleInc;
-        else {
-          xd += ddx2;
-          yd += ddy2;
-        }
-      } // for each sample in detector
+/* NAME
+*   collectProjections          Calculate projections through an image
+*
+* SYNOPSIS
+*   collectProjections (proj, im, iStartView, iNumViews, iOffsetView, iStorageOffset, nThreads, trace)
+*   Projections& proj           Projection storage
+*   ImageFile& im               Pixelized phantom
+*   int nThreads                Number of threads, 0 uses all processors
+*
+* NOTES
+*   Rays are placed exactly as for a Phantom. Each ray's line integral is
+*   found by Joseph's method: the image is interpolated linearly at each
+*   row or column crossed along the ray's major axis. Pixels are taken to
+*   cover the image's axis extent, with pixel (0,0) at (xmin,ymin).
+*/
 
-      detval[d] = sum / m_nSample;
-      xs_maj += sdx;
-      ys_maj += sdy;
-      if (m_idGeometry == GEOMETRY_EQUIANGULAR)
-        dAngleMajor += dAngleInc;
-      else {
-        xd_maj += ddx;
-        yd_maj += ddy;
+class ImageProjectorTask : public WorkerThreadTask {
+private:
+  Scanner& m_rScanner;
+  Projections& m_rProj;
+  const ImageFile& m_rIm;
+  const int m_iStartView;
+  const int m_iOffsetView;
+  const int m_iStorageOffset;
+
+public:
+  ImageProjectorTask (Scanner& rScanner, Projections& rProj, const ImageFile& rIm,
+                      int iStartView, int iOffsetView, int iStorageOffset)
+    : m_rScanner(rScanner), m_rProj(rProj), m_rIm(rIm),
+      m_iStartView(iStartView), m_iOffsetView(iOffsetView), m_iStorageOffset(iStorageOffset)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    m_rScanner.projectImageViews (m_rProj, m_rIm, m_iStartView + iStartUnit, iNumUnits,
+                                  m_iOffsetView, m_iStorageOffset + iStartUnit);
+  }
+};
+
+bool
+Scanner::collectProjections (Projections& proj, const ImageFile& im, const int iStartView,
+                             const int iNumViews, const int iOffsetView, int iStorageOffset,
+                             const int nThreads, const int trace)
+{
+  m_trace = trace;
+  if (im.nx() < 1 || im.ny() < 1)
+    return false;
+
+  ImageProjectorTask task (*this, proj, im, iStartView, iOffsetView, iStorageOffset);
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (iNumViews);
+
+  return threads.run (task);
+}
+
+
+// NAME
+//   projectImageLine     Line integral through an image by Joseph's method
+//
+// NOTES
+//   Pixel centers lie at integer coordinates (px,py); pixels outside the
+//   image are zero
+
+static double
+projectImageLine (ImageFileArrayConst v, const int nx, const int ny,
+                  const double px1, const double py1, const double px2, const double py2,
+                  const double dWorldLength)
+{
+  const double dpx = px2 - px1;
+  const double dpy = py2 - py1;
+  double dSum = 0;
+
+  if (fabs (dpx) >= fabs (dpy)) {
+    if (fabs (dpx) < 1E-12)
+      return 0.;
+    const double dSlope = dpy / dpx;
+    const int ixStart = imax (0, static_cast<int>(ceil (std::min (px1, px2))));
+    const int ixEnd = std::min (nx - 1, static_cast<int>(floor (std::max (px1, px2))));
+    for (int ix = ixStart; ix <= ixEnd; ix++) {
+      const double py = py1 + (ix - px1) * dSlope;
+      const double dFloor = floor (py);
+      const int iy = static_cast<int>(dFloor);
+      const double f = py - dFloor;
+      ImageFileColumnConst vCol = v[ix];
+      if (iy >= 0 && iy < ny)
+        dSum += (1 - f) * vCol[iy];
+      if (iy + 1 >= 0 && iy + 1 < ny)
+        dSum += f * vCol[iy + 1];
+    }
+    return dSum * dWorldLength / fabs (dpx);
+  } else {
+    const double dSlope = dpx / dpy;
+    const int iyStart = imax (0, static_cast<int>(ceil (std::min (py1, py2))));
+    const int iyEnd = std::min (ny - 1, static_cast<int>(floor (std::max (py1, py2))));
+    for (int iy = iyStart; iy <= iyEnd; iy++) {
+      const double px = px1 + (iy - py1) * dSlope;
+      const double dFloor = floor (px);
+      const int ix = static_cast<int>(dFloor);
+      const double f = px - dFloor;
+      if (ix >= 0 && ix < nx)
+        dSum += (1 - f) * v[ix][iy];
+      if (ix + 1 >= 0 && ix + 1 < nx)
+        dSum += f * v[ix + 1][iy];
+    }
+    return dSum * dWorldLength / fabs (dpy);
+  }
+}
+
+
+void
+Scanner::projectImageViews (Projections& proj, const ImageFile& im, const int iStartView,
+                            const int iNumViews, const int iOffsetView, const int iStorageOffset)
+{
+  const int nx = im.nx();
+  const int ny = im.ny();
+  double xmin, xmax, ymin, ymax;
+  if (! im.getAxisExtent (xmin, xmax, ymin, ymax)) {
+    xmin = -static_cast<double>(nx) / 2;
+    xmax = static_cast<double>(nx) / 2;
+    ymin = -static_cast<double>(ny) / 2;
+    ymax = static_cast<double>(ny) / 2;
+  }
+  const double xinc = (xmax - xmin) / nx;
+  const double yinc = (ymax - ymin) / ny;
+  ImageFileArrayConst v = im.getArray();
+
+  const int nDet = proj.nDet();
+  const int nRays = nDet * m_nSample;
+  std::vector<double> vecXD (nRays), vecYD (nRays), vecXS (nRays), vecYS (nRays);
+
+  for (int iView = 0; iView < iNumViews; iView++) {
+    double viewAngle = (iStartView + iView + iOffsetView) * proj.rotInc();
+
+    GRFMTX_2D rotmtx, temp;
+    xlat_mtx2 (rotmtx, -m_dXCenter, -m_dYCenter);
+    rot_mtx2 (temp, viewAngle);
+    mult_mtx2 (rotmtx, temp, rotmtx);
+    xlat_mtx2 (temp, m_dXCenter, m_dYCenter);
+    mult_mtx2 (rotmtx, temp, rotmtx);
+
+    double xd1=0, yd1=0, xd2=0, yd2=0;
+    if (m_idGeometry != GEOMETRY_EQUIANGULAR) {
+      xd1 = m_initPos.xd1;
+      yd1 = m_initPos.yd1;
+      xd2 = m_initPos.xd2;
+      yd2 = m_initPos.yd2;
+      xform_mtx2 (rotmtx, xd1, yd1);
+      xform_mtx2 (rotmtx, xd2, yd2);
+    }
+    double xs1 = m_initPos.xs1;
+    double ys1 = m_initPos.ys1;
+    double xs2 = m_initPos.xs2;
+    double ys2 = m_initPos.ys2;
+    xform_mtx2 (rotmtx, xs1, ys1);
+    xform_mtx2 (rotmtx, xs2, ys2);
+
+    calcViewRays (nDet, xd1, yd1, xd2, yd2, xs1, ys1, xs2, ys2, viewAngle + 3 * HALFPI,
+                  &vecXD[0], &vecYD[0], &vecXS[0], &vecYS[0]);
+
+    DetectorArray& detArray = proj.getDetectorArray (iView + iStorageOffset);
+    DetectorValue* detval = detArray.detValues();
+    int iRay = 0;
+    for (int d = 0; d < nDet; d++) {
+      double sum = 0.0;
+      for (unsigned int i = 0; i < m_nSample; i++, iRay++) {
+        double dLength = lineLength (vecXS[iRay], vecYS[iRay], vecXD[iRay], vecYD[iRay]);
+        sum += projectImageLine (v, nx, ny,
+                                 (vecXS[iRay] - xmin) / xinc - 0.5, (vecYS[iRay] - ymin) / yinc - 0.5,
+                                 (vecXD[iRay] - xmin) / xinc - 0.5, (vecYD[iRay] - ymin) / yinc - 0.5,
+                                 dLength);
       }
-    } /* for each detector */
-  } /* if not unit pulse */
+      detval[d] = sum / m_nSample;
+    }
+    detArray.setViewAngle (viewAngle);
+  }
 }
 
 
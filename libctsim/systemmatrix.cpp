@@ -0,0 +1,616 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:         systemmatrix.cpp      Joseph projector and sparse system matrix
+**   Programmer:   Kevin Rosenberg
+**   Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#define USE_MMAP 1
+#endif
+
+
+JosephProjector::JosephProjector (const Projections& proj, int nx, int ny,
+                                  double xMin, double xMax, double yMin, double yMax)
+  : m_rProj(proj), m_nx(nx), m_ny(ny), m_nDet(proj.nDet()), m_nView(proj.nView()), m_dXMin(xMin), m_dYMin(yMin)
+{
+  m_dXInc = (xMax - xMin) / nx;
+  m_dYInc = (yMax - yMin) / ny;
+
+  if (m_rProj.geometry() == Scanner::GEOMETRY_PARALLEL)
+    m_dRayLength = 2 * m_rProj.phmLen();
+  else
+    m_dRayLength = m_rProj.focalLength() + m_rProj.phmLen();
+
+  // Equiangular detectors are spaced evenly in angle about the center of
+  // rotation rather than about the source, as laid out by the Scanner
+  m_dAngularDetIncrement = m_rProj.detInc();
+  if (m_rProj.geometry() == Scanner::GEOMETRY_EQUIANGULAR) {
+    const double dAngle = -m_rProj.detStart();
+    const double dCenterDetectorLength = m_rProj.sourceDetectorLength() - m_rProj.focalLength();
+    const double dHalfScan = m_rProj.focalLength() * sin (dAngle);
+    if (dAngle > 0 && dCenterDetectorLength > dHalfScan) {
+      const double dA1 = acos (dHalfScan / dCenterDetectorLength);
+      m_dAngularDetIncrement = m_rProj.detInc() * (HALFPI + dAngle - dA1) / dAngle;
+    }
+  }
+}
+
+
+// NAME
+//   calcPixelRay         Endpoints of the ray for a detector of a view
+//
+// NOTES
+//   Detectors are placed as by the Scanner: detector iDet lies
+//   (iDet - iDetCenter) * detInc from the central ray for parallel and
+//   equilinear geometries. Equiangular detectors lie on a circle about the
+//   center of rotation.
+
+void
+JosephProjector::calcPixelRay (int iView, int iDet, double& px1, double& py1, double& px2, double& py2) const
+{
+  const double dBeta = m_rProj.getDetectorArray (iView).viewAngle();
+  const double dCos = cos (dBeta);
+  const double dSin = sin (dBeta);
+  double x1, y1, x2, y2;
+
+  if (m_rProj.geometry() == Scanner::GEOMETRY_PARALLEL) {
+    const double dPos = (iDet - (m_rProj.nDet() - 1) / 2) * m_rProj.detInc();
+    const double xCenter = dPos * dCos;
+    const double yCenter = dPos * dSin;
+    const double dHalfLength = m_dRayLength / 2;
+    x1 = xCenter - dHalfLength * dSin;
+    y1 = yCenter + dHalfLength * dCos;
+    x2 = xCenter + dHalfLength * dSin;
+    y2 = yCenter - dHalfLength * dCos;
+  } else {
+    const double dFocalLength = m_rProj.focalLength();
+    x1 = -dFocalLength * dSin;
+    y1 = dFocalLength * dCos;
+    double dxDir, dyDir;
+    if (m_rProj.geometry() == Scanner::GEOMETRY_EQUILINEAR) {
+      const double dPos = (iDet - (m_rProj.nDet() - 1) / 2) * m_rProj.detInc();
+      const double dGamma = atan (dPos / m_rProj.sourceDetectorLength());
+      dxDir = sin (dGamma) * dCos + cos (dGamma) * dSin;
+      dyDir = sin (dGamma) * dSin - cos (dGamma) * dCos;
+    } else {
+      const double dCenterDetectorLength = m_rProj.sourceDetectorLength() - dFocalLength;
+      const double dDetAngle = dBeta - HALFPI + (iDet - (m_rProj.nDet() - 1) / 2.) * m_dAngularDetIncrement;
+      dxDir = dCenterDetectorLength * cos (dDetAngle) - x1;
+      dyDir = dCenterDetectorLength * sin (dDetAngle) - y1;
+      const double dLength = sqrt (dxDir * dxDir + dyDir * dyDir);
+      dxDir /= dLength;
+      dyDir /= dLength;
+    }
+    x2 = x1 + m_dRayLength * dxDir;
+    y2 = y1 + m_dRayLength * dyDir;
+  }
+
+  px1 = (x1 - m_dXMin) / m_dXInc - 0.5;
+  py1 = (y1 - m_dYMin) / m_dYInc - 0.5;
+  px2 = (x2 - m_dXMin) / m_dXInc - 0.5;
+  py2 = (y2 - m_dYMin) / m_dYInc - 0.5;
+}
+
+
+
+// Cache file layout, in native byte order: header, key padded to 8 bytes,
+// row starts (nRows + 1), weights (nNonZero), column indices (nNonZero)
+
+struct SystemMatrixFileHeader {
+  char m_szMagic[8];
+  kuint32 m_iByteOrder;
+  kuint32 m_iKeyLength;
+  kuint32 m_nRows;
+  kuint32 m_nCols;
+  kuint32 m_nNonZero;
+  kuint32 m_iIndexBytes;
+};
+
+static const char s_szSystemMatrixMagic[8] = "CTSIMSM";
+static const kuint32 s_iSystemMatrixByteOrder = 0x01020304;
+
+static size_t
+systemMatrixKeyOffset ()
+{ return sizeof (SystemMatrixFileHeader); }
+
+static size_t
+systemMatrixRowStartOffset (size_t lKeyLength)
+{ return systemMatrixKeyOffset() + ((lKeyLength + 7) / 8) * 8; }
+
+static size_t
+systemMatrixWeightOffset (size_t lKeyLength, size_t nRows)
+{ return systemMatrixRowStartOffset (lKeyLength) + (nRows + 1) * sizeof (kuint32); }
+
+static size_t
+systemMatrixIndexOffset (size_t lKeyLength, size_t nRows, size_t nNonZero)
+{ return systemMatrixWeightOffset (lKeyLength, nRows) + nNonZero * sizeof (kfloat32); }
+
+static size_t
+systemMatrixFileSize (size_t lKeyLength, size_t nRows, size_t nNonZero, size_t iIndexBytes)
+{ return systemMatrixIndexOffset (lKeyLength, nRows, nNonZero) + nNonZero * iIndexBytes; }
+
+
+std::string SystemMatrix::s_strDefaultCacheDirectory;
+double SystemMatrix::s_dDefaultMemoryLimitMB = 1024.;
+
+void
+SystemMatrix::setDefaultCacheDirectory (const char* const pszDirectory)
+{
+  s_strDefaultCacheDirectory = pszDirectory ? pszDirectory : "";
+}
+
+
+class SystemMatrixCountOp {
+public:
+  kuint32 m_nEntries;
+
+  SystemMatrixCountOp ()
+    : m_nEntries(0)
+  {}
+
+  void operator() (int ix, int iy, double dWeight)
+  { if (dWeight > 0) m_nEntries++; }
+};
+
+class SystemMatrixFillOp {
+public:
+  kfloat32* m_pWeights;
+  kuint16* m_pIndex16;
+  kuint32* m_pIndex32;
+  int m_ny;
+  kuint32 m_iPos;
+
+  SystemMatrixFillOp (kfloat32* pWeights, kuint16* pIndex16, kuint32* pIndex32, int ny, kuint32 iPos)
+    : m_pWeights(pWeights), m_pIndex16(pIndex16), m_pIndex32(pIndex32), m_ny(ny), m_iPos(iPos)
+  {}
+
+  void operator() (int ix, int iy, double dWeight)
+  {
+    if (dWeight > 0) {
+      m_pWeights[m_iPos] = static_cast<kfloat32>(dWeight);
+      if (m_pIndex16)
+        m_pIndex16[m_iPos] = static_cast<kuint16>(ix * m_ny + iy);
+      else
+        m_pIndex32[m_iPos] = static_cast<kuint32>(ix * m_ny + iy);
+      m_iPos++;
+    }
+  }
+};
+
+
+// Counts entries per row on the first pass, fills rows on the second
+class SystemMatrixBuildTask : public WorkerThreadTask {
+private:
+  const JosephProjector& m_rProjector;
+  int m_nDet;
+  kuint32* m_pRowStart;
+  kfloat32* m_pWeights;
+  kuint16* m_pIndex16;
+  kuint32* m_pIndex32;
+
+public:
+  SystemMatrixBuildTask (const JosephProjector& rProjector, int nDet, kuint32* pRowStart,
+                         kfloat32* pWeights = NULL, kuint16* pIndex16 = NULL, kuint32* pIndex32 = NULL)
+    : m_rProjector(rProjector), m_nDet(nDet), m_pRowStart(pRowStart), m_pWeights(pWeights),
+      m_pIndex16(pIndex16), m_pIndex32(pIndex32)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    for (int iRow = iStartUnit; iRow < iStartUnit + iNumUnits; iRow++) {
+      if (m_pWeights) {
+        SystemMatrixFillOp fill (m_pWeights, m_pIndex16, m_pIndex32, m_rProjector.ny(), m_pRowStart[iRow]);
+        m_rProjector.traceRay (iRow / m_nDet, iRow % m_nDet, fill);
+      } else {
+        SystemMatrixCountOp count;
+        m_rProjector.traceRay (iRow / m_nDet, iRow % m_nDet, count);
+        m_pRowStart[iRow + 1] = count.m_nEntries;
+      }
+    }
+  }
+};
+
+
+class SystemMatrixMultiplyTask : public WorkerThreadTask {
+private:
+  const SystemMatrix& m_rMatrix;
+  const double* m_pdImage;
+  double* m_pdRaysums;
+
+public:
+  SystemMatrixMultiplyTask (const SystemMatrix& rMatrix, const double* pdImage, double* pdRaysums)
+    : m_rMatrix(rMatrix), m_pdImage(pdImage), m_pdRaysums(pdRaysums)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  { m_rMatrix.multiply (m_pdImage, m_pdRaysums + iStartUnit, iStartUnit, iNumUnits); }
+};
+
+
+SystemMatrix::SystemMatrix (const Projections& proj, int nx, int ny, double xMin, double xMax,
+                            double yMin, double yMax, int nThreads, const char* const pszCacheDirectory,
+                            double dMemoryLimitMB)
+  : m_bFail(false), m_bFromCache(false), m_nRows(0), m_nCols(0), m_nNonZero(0), m_iIndexBytes(0),
+    m_pMapping(NULL), m_lBufferSize(0), m_pRowStart(NULL), m_pWeights(NULL), m_pIndex16(NULL), m_pIndex32(NULL)
+{
+  if (proj.geometry() != Scanner::GEOMETRY_PARALLEL && proj.geometry() != Scanner::GEOMETRY_EQUILINEAR
+      && proj.geometry() != Scanner::GEOMETRY_EQUIANGULAR) {
+    m_bFail = true;
+    m_strFailMessage = "Invalid geometry for system matrix";
+    return;
+  }
+  if (nx < 1 || ny < 1 || proj.nDet() < 1 || proj.nView() < 1) {
+    m_bFail = true;
+    m_strFailMessage = "Empty system matrix";
+    return;
+  }
+
+  m_nRows = proj.nView() * proj.nDet();
+  m_nCols = nx * ny;
+  m_iIndexBytes = m_nCols <= 65536 ? 2 : 4;
+  m_strKey = makeKey (proj, nx, ny, xMin, xMax, yMin, yMax);
+
+  std::string strCacheDirectory = pszCacheDirectory ? pszCacheDirectory : s_strDefaultCacheDirectory;
+  std::string strCacheFile;
+  if (strCacheDirectory.length() > 0) {
+    // Name the file by two FNV-1a hashes of the key
+    kuint32 iHash1 = 2166136261U, iHash2 = 0x811C9DC5U ^ 0x5BD1E995U;
+    for (unsigned int i = 0; i < m_strKey.length(); i++) {
+      iHash1 = (iHash1 ^ static_cast<unsigned char>(m_strKey[i])) * 16777619U;
+      iHash2 = (iHash2 ^ static_cast<unsigned char>(m_strKey[m_strKey.length() - 1 - i])) * 16777619U;
+    }
+    char szName[64];
+    snprintf (szName, sizeof(szName), "ctsim-%08x%08x.sysmat", iHash1, iHash2);
+    strCacheFile = strCacheDirectory + "/" + szName;
+    if (readCache (strCacheFile)) {
+      m_bFromCache = true;
+      return;
+    }
+  }
+
+  if (dMemoryLimitMB < 0)
+    dMemoryLimitMB = s_dDefaultMemoryLimitMB;
+  const double dEstimateMB = estimateSizeMB (proj, nx, ny);
+  if (dMemoryLimitMB > 0 && dEstimateMB > dMemoryLimitMB) {
+    std::ostringstream os;
+    os << "System matrix would need up to " << static_cast<long>(dEstimateMB + 0.5)
+       << " MB, more than the limit of " << static_cast<long>(dMemoryLimitMB + 0.5) << " MB";
+    m_bFail = true;
+    m_strFailMessage = os.str();
+    return;
+  }
+
+  JosephProjector projector (proj, nx, ny, xMin, xMax, yMin, yMax);
+  if (! build (projector, nThreads))
+    return;
+
+  if (strCacheFile.length() > 0 && ! writeCache (strCacheFile))
+    sys_error (ERR_WARNING, "Unable to write system matrix cache %s", strCacheFile.c_str());
+}
+
+SystemMatrix::~SystemMatrix ()
+{
+  unmap();
+}
+
+
+// NAME
+//   makeKey              Description of everything the matrix depends on
+//
+// NOTES
+//   View angles are folded into a checksum since files may hold any angles.
+
+std::string
+SystemMatrix::makeKey (const Projections& proj, int nx, int ny, double xMin, double xMax, double yMin, double yMax)
+{
+  kuint32 iAngleHash = 2166136261U;
+  for (int iView = 0; iView < proj.nView(); iView++) {
+    double dAngle = proj.getDetectorArray (iView).viewAngle();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&dAngle);
+    for (unsigned int i = 0; i < sizeof(dAngle); i++)
+      iAngleHash = (iAngleHash ^ p[i]) * 16777619U;
+  }
+
+  std::ostringstream os;
+  os.precision (17);
+  os << "joseph geometry=" << Scanner::convertGeometryIDToName (proj.geometry())
+     << " ndet=" << proj.nDet() << " nview=" << proj.nView() << " detinc=" << proj.detInc()
+     << " detstart=" << proj.detStart() << " focal=" << proj.focalLength()
+     << " sdl=" << proj.sourceDetectorLength() << " phmlen=" << proj.phmLen()
+     << " nx=" << nx << " ny=" << ny << " x=" << xMin << "," << xMax << " y=" << yMin << "," << yMax
+     << " angles=" << iAngleHash;
+
+  return os.str();
+}
+
+
+// NAME
+//   estimateSizeMB       Upper bound of the matrix size
+//
+// NOTES
+//   A Joseph ray visits at most two pixels per column or row of the image
+
+double
+SystemMatrix::estimateSizeMB (const Projections& proj, int nx, int ny)
+{
+  const double dRows = static_cast<double>(proj.nView()) * proj.nDet();
+  const double dIndexBytes = static_cast<double>(nx) * ny <= 65536 ? 2 : 4;
+  const double dNonZero = dRows * 2 * imax (nx, ny);
+
+  return (dRows * sizeof (kuint32) + dNonZero * (sizeof (kfloat32) + dIndexBytes)) / 1048576.;
+}
+
+
+bool
+SystemMatrix::build (const JosephProjector& projector, int nThreads)
+{
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (m_nRows);
+
+  std::vector<kuint32> vecRowCount (m_nRows + 1);
+  SystemMatrixBuildTask taskCount (projector, projector.nDet(), &vecRowCount[0]);
+  threads.run (taskCount);
+
+  double dNonZero = 0;
+  for (int iRow = 1; iRow <= m_nRows; iRow++)
+    dNonZero += vecRowCount[iRow];
+  if (dNonZero > 4294967295.) {
+    m_bFail = true;
+    m_strFailMessage = "System matrix has too many entries";
+    return false;
+  }
+  m_nNonZero = static_cast<unsigned long>(dNonZero);
+
+  const size_t lKeyLength = m_strKey.length();
+  m_lBufferSize = systemMatrixFileSize (lKeyLength, m_nRows, m_nNonZero, m_iIndexBytes);
+  m_vecBuffer.resize ((m_lBufferSize + sizeof(double) - 1) / sizeof(double));
+  char* pBuffer = reinterpret_cast<char*>(&m_vecBuffer[0]);
+
+  SystemMatrixFileHeader* pHeader = reinterpret_cast<SystemMatrixFileHeader*>(pBuffer);
+  memcpy (pHeader->m_szMagic, s_szSystemMatrixMagic, sizeof(pHeader->m_szMagic));
+  pHeader->m_iByteOrder = s_iSystemMatrixByteOrder;
+  pHeader->m_iKeyLength = lKeyLength;
+  pHeader->m_nRows = m_nRows;
+  pHeader->m_nCols = m_nCols;
+  pHeader->m_nNonZero = m_nNonZero;
+  pHeader->m_iIndexBytes = m_iIndexBytes;
+  memcpy (pBuffer + systemMatrixKeyOffset(), m_strKey.data(), lKeyLength);
+
+  kuint32* pRowStart = reinterpret_cast<kuint32*>(pBuffer + systemMatrixRowStartOffset (lKeyLength));
+  pRowStart[0] = 0;
+  for (int iRow = 0; iRow < m_nRows; iRow++)
+    pRowStart[iRow + 1] = pRowStart[iRow] + vecRowCount[iRow + 1];
+
+  kfloat32* pWeights = reinterpret_cast<kfloat32*>(pBuffer + systemMatrixWeightOffset (lKeyLength, m_nRows));
+  char* pIndex = pBuffer + systemMatrixIndexOffset (lKeyLength, m_nRows, m_nNonZero);
+  kuint16* pIndex16 = m_iIndexBytes == 2 ? reinterpret_cast<kuint16*>(pIndex) : NULL;
+  kuint32* pIndex32 = m_iIndexBytes == 4 ? reinterpret_cast<kuint32*>(pIndex) : NULL;
+  SystemMatrixBuildTask taskFill (projector, projector.nDet(), pRowStart, pWeights, pIndex16, pIndex32);
+  threads.run (taskFill);
+
+  return setPointers (pBuffer, m_lBufferSize);
+}
+
+
+// NAME
+//   setPointers          Validate a matrix image and point to its arrays
+
+bool
+SystemMatrix::setPointers (const char* pBuffer, size_t lSize)
+{
+  if (lSize < sizeof (SystemMatrixFileHeader))
+    return false;
+
+  const SystemMatrixFileHeader* pHeader = reinterpret_cast<const SystemMatrixFileHeader*>(pBuffer);
+  if (memcmp (pHeader->m_szMagic, s_szSystemMatrixMagic, sizeof(pHeader->m_szMagic)) != 0
+      || pHeader->m_iByteOrder != s_iSystemMatrixByteOrder || pHeader->m_iKeyLength != m_strKey.length()
+      || pHeader->m_nRows != static_cast<kuint32>(m_nRows) || pHeader->m_nCols != static_cast<kuint32>(m_nCols)
+      || pHeader->m_iIndexBytes != static_cast<kuint32>(m_iIndexBytes))
+    return false;
+  const size_t lKeyLength = pHeader->m_iKeyLength;
+  if (lSize != systemMatrixFileSize (lKeyLength, m_nRows, pHeader->m_nNonZero, m_iIndexBytes)
+      || memcmp (pBuffer + systemMatrixKeyOffset(), m_strKey.data(), lKeyLength) != 0)
+    return false;
+
+  const kuint32* pRowStart = reinterpret_cast<const kuint32*>(pBuffer + systemMatrixRowStartOffset (lKeyLength));
+  if (pRowStart[0] != 0 || pRowStart[m_nRows] != pHeader->m_nNonZero)
+    return false;
+
+  m_nNonZero = pHeader->m_nNonZero;
+  m_pRowStart = pRowStart;
+  m_pWeights = reinterpret_cast<const kfloat32*>(pBuffer + systemMatrixWeightOffset (lKeyLength, m_nRows));
+  const char* pIndex = pBuffer + systemMatrixIndexOffset (lKeyLength, m_nRows, m_nNonZero);
+  m_pIndex16 = m_iIndexBytes == 2 ? reinterpret_cast<const kuint16*>(pIndex) : NULL;
+  m_pIndex32 = m_iIndexBytes == 4 ? reinterpret_cast<const kuint32*>(pIndex) : NULL;
+
+  return true;
+}
+
+
+bool
+SystemMatrix::readCache (const std::string& strFilename)
+{
+#ifdef USE_MMAP
+  int fd = open (strFilename.c_str(), O_RDONLY | O_BINARY);
+  if (fd < 0)
+    return false;
+  struct stat statBuf;
+  if (fstat (fd, &statBuf) != 0 || statBuf.st_size <= 0) {
+    close (fd);
+    return false;
+  }
+  const size_t lSize = statBuf.st_size;
+  void* pMapping = mmap (NULL, lSize, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (pMapping == MAP_FAILED)
+    return false;
+  if (! setPointers (static_cast<const char*>(pMapping), lSize)) {
+    munmap (pMapping, lSize);
+    return false;
+  }
+  m_pMapping = pMapping;
+  m_lBufferSize = lSize;
+  return true;
+#else
+  std::ifstream fs (strFilename.c_str(), std::ios::in | std::ios::binary);
+  if (! fs)
+    return false;
+  fs.seekg (0, std::ios::end);
+  const size_t lSize = fs.tellg();
+  fs.seekg (0, std::ios::beg);
+  m_vecBuffer.resize ((lSize + sizeof(double) - 1) / sizeof(double));
+  char* pBuffer = reinterpret_cast<char*>(&m_vecBuffer[0]);
+  if (lSize == 0 || ! fs.read (pBuffer, lSize) || ! setPointers (pBuffer, lSize)) {
+    m_vecBuffer.clear();
+    return false;
+  }
+  m_lBufferSize = lSize;
+  return true;
+#endif
+}
+
+
+// NAME
+//   writeCache           Write the matrix and rename it into place
+//
+// NOTES
+//   Writing under a temporary name keeps concurrent readers and writers
+//   from seeing a partial file.
+
+bool
+SystemMatrix::writeCache (const std::string& strFilename) const
+{
+  std::ostringstream osTemp;
+  osTemp << strFilename << ".tmp";
+#ifdef HAVE_UNISTD_H
+  osTemp << getpid();
+#endif
+  const std::string strTemp = osTemp.str();
+
+  {
+    std::ofstream fs (strTemp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (! fs)
+      return false;
+    fs.write (reinterpret_cast<const char*>(&m_vecBuffer[0]), m_lBufferSize);
+    if (! fs) {
+      fs.close();
+      remove (strTemp.c_str());
+      return false;
+    }
+  }
+  if (rename (strTemp.c_str(), strFilename.c_str()) != 0) {
+    remove (strTemp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+void
+SystemMatrix::unmap ()
+{
+#ifdef USE_MMAP
+  if (m_pMapping)
+    munmap (m_pMapping, m_lBufferSize);
+#endif
+  m_pMapping = NULL;
+}
+
+
+template<class IndexType>
+static inline double
+sparseRowSum (const kfloat32* pWeights, const IndexType* pIndex, kuint32 iStart, kuint32 iEnd,
+              const double* pdImage, double& dRowWeight)
+{
+  double dSum = 0;
+  double dWeight = 0;
+  for (kuint32 i = iStart; i < iEnd; i++) {
+    dSum += pWeights[i] * pdImage[pIndex[i]];
+    dWeight += pWeights[i];
+  }
+  dRowWeight = dWeight;
+  return dSum;
+}
+
+template<class IndexType>
+static inline void
+sparseRowSpread (const kfloat32* pWeights, const IndexType* pIndex, kuint32 iStart, kuint32 iEnd,
+                 double dValue, double* pdImage, double* pdWeight)
+{
+  if (pdWeight) {
+    for (kuint32 i = iStart; i < iEnd; i++) {
+      pdImage[pIndex[i]] += pWeights[i] * dValue;
+      pdWeight[pIndex[i]] += pWeights[i];
+    }
+  } else {
+    for (kuint32 i = iStart; i < iEnd; i++)
+      pdImage[pIndex[i]] += pWeights[i] * dValue;
+  }
+}
+
+
+double
+SystemMatrix::rowSum (int iRow, const double* pdImage, double& dRowWeight) const
+{
+  if (m_pIndex16)
+    return sparseRowSum (m_pWeights, m_pIndex16, m_pRowStart[iRow], m_pRowStart[iRow + 1], pdImage, dRowWeight);
+  else
+    return sparseRowSum (m_pWeights, m_pIndex32, m_pRowStart[iRow], m_pRowStart[iRow + 1], pdImage, dRowWeight);
+}
+
+void
+SystemMatrix::rowSpread (int iRow, double dValue, double* pdImage, double* pdWeight) const
+{
+  if (m_pIndex16)
+    sparseRowSpread (m_pWeights, m_pIndex16, m_pRowStart[iRow], m_pRowStart[iRow + 1], dValue, pdImage, pdWeight);
+  else
+    sparseRowSpread (m_pWeights, m_pIndex32, m_pRowStart[iRow], m_pRowStart[iRow + 1], dValue, pdImage, pdWeight);
+}
+
+
+void
+SystemMatrix::multiply (const double* pdImage, double* pdRaysums, int iStartRow, int nRows) const
+{
+  double dRowWeight;
+  for (int i = 0; i < nRows; i++)
+    pdRaysums[i] = rowSum (iStartRow + i, pdImage, dRowWeight);
+}
+
+void
+SystemMatrix::multiply (const double* pdImage, double* pdRaysums, int nThreads) const
+{
+  SystemMatrixMultiplyTask task (*this, pdImage, pdRaysums);
+  WorkerThreads threads (nThreads);
+  threads.setTotalWorkUnits (m_nRows);
+  threads.run (task);
+}
+
+void
+SystemMatrix::multiplyTranspose (const double* pdRaysums, double* pdImage, int iStartRow, int nRows) const
+{
+  for (int i = 0; i < nRows; i++)
+    if (pdRaysums[i] != 0)
+      rowSpread (iStartRow + i, pdRaysums[i], pdImage, NULL);
+}
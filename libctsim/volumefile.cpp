@@ -0,0 +1,481 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**      Name:         volumefile.cpp
+**      Purpose:      Container file of many image and projection datasets
+**      Programmer:   Kevin Rosenberg
+**      Date Started: October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+
+
+const int VolumeFile::ENTRY_INVALID = -1;
+const int VolumeFile::ENTRY_IMAGE = 0;
+const int VolumeFile::ENTRY_PROJECTIONS = 1;
+
+const char* const VolumeFile::s_szExtension = ".ctv";
+
+// File layout, little endian like the image and projection files
+//
+//   Header of s_iHeaderSize bytes
+//     kuint16 header size, kuint16 signature, kuint32 version,
+//     kuint32 number of entries, kuint32 entry alignment,
+//     kuint64 offset and kuint64 size of the table of contents
+//   Entries, each a complete image or projection dataset starting at a
+//     multiple of the entry alignment
+//   Table of contents, for each entry
+//     kuint16 type, kuint16 name length, kuint16 remark length, kuint16 0,
+//     kuint64 offset, kuint64 size, name, remark
+//
+// Entries written while a volume is open follow the existing table of
+// contents, so the file stays readable until the header points to the new
+// table written by close.
+
+const kuint16 VolumeFile::m_signature = ('C'*256 + 'V');
+const kuint16 VolumeFile::s_iHeaderSize = 32;
+const kuint32 VolumeFile::s_iVersion = 1;
+const kuint32 VolumeFile::s_iEntryAlignment = 4096;
+
+
+VolumeFile::VolumeFile ()
+  : m_pStream(NULL), m_bWrite(false), m_bModified(false), m_endOffset(0)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init (&m_mutex, NULL);
+#endif
+}
+
+VolumeFile::~VolumeFile ()
+{
+  close();
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy (&m_mutex);
+#endif
+}
+
+
+const char*
+VolumeFile::convertEntryTypeIDToName (int iType)
+{
+  if (iType == ENTRY_IMAGE)
+    return "image";
+  else if (iType == ENTRY_PROJECTIONS)
+    return "projections";
+
+  return "";
+}
+
+
+bool
+VolumeFile::splitEntryPath (const char* const path, std::string& strVolume, std::string& strEntry)
+{
+  std::string strPath (path);
+  std::string strExtension (s_szExtension);
+
+  std::string::size_type posColon = strPath.find (strExtension + ":");
+  if (posColon != std::string::npos) {
+    strVolume = strPath.substr (0, posColon + strExtension.size());
+    strEntry = strPath.substr (posColon + strExtension.size() + 1);
+    return true;
+  }
+  if (strPath.size() > strExtension.size()
+      && strPath.compare (strPath.size() - strExtension.size(), strExtension.size(), strExtension) == 0) {
+    strVolume = strPath;
+    strEntry = "";
+    return true;
+  }
+
+  return false;
+}
+
+bool
+VolumeFile::isEntryPath (const char* const path)
+{
+  std::string strVolume, strEntry;
+
+  return splitEntryPath (path, strVolume, strEntry) && strEntry.size() > 0;
+}
+
+bool
+VolumeFile::locateEntry (const char* const path, std::string& strVolume, kuint64& offset)
+{
+  std::string strEntry;
+  if (! splitEntryPath (path, strVolume, strEntry))
+    return false;
+
+  VolumeFile volume;
+  if (! volume.open (strVolume.c_str()))
+    return false;
+  int iEntry = volume.findEntry (strEntry.c_str());
+  if (iEntry < 0) {
+    sys_error (ERR_WARNING, "No entry %s in volume %s [VolumeFile::locateEntry]", strEntry.c_str(), strVolume.c_str());
+    return false;
+  }
+  offset = volume.entryOffset (iEntry);
+
+  return true;
+}
+
+
+bool
+VolumeFile::open (const char* const filename, bool bWrite)
+{
+  close();
+  m_strFilename = filename;
+  m_bWrite = bWrite;
+  m_bModified = false;
+  m_vecEntry.clear();
+
+  std::ios::openmode mode = std::ios::in | std::ios::binary;
+  if (bWrite)
+    mode |= std::ios::out;
+  m_pStream = new frnetorderstream (filename, mode);
+  if (m_pStream->fail() && bWrite) {
+    delete m_pStream;
+    m_pStream = new frnetorderstream (filename, mode | std::ios::trunc);
+    if (! m_pStream->fail()) {
+      m_endOffset = s_iHeaderSize;
+      m_bModified = true;
+      return headerWrite (0, 0);
+    }
+  }
+  if (m_pStream->fail()) {
+    sys_error (ERR_WARNING, "Unable to open volume %s [VolumeFile::open]", filename);
+    delete m_pStream;
+    m_pStream = NULL;
+    return false;
+  }
+
+  if (! headerRead()) {
+    delete m_pStream;
+    m_pStream = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool
+VolumeFile::close ()
+{
+  if (! m_pStream)
+    return true;
+
+  bool bOk = true;
+  if (m_bModified) {
+    frnetorderstream& fs = *m_pStream;
+    fs.clear();
+    fs.setOrigin (0);
+    kuint64 tocOffset = m_endOffset;
+    fs.seekp (tocOffset);
+    for (unsigned int i = 0; i < m_vecEntry.size(); i++) {
+      const Entry& entry = m_vecEntry[i];
+      kuint16 type = entry.m_iType;
+      kuint16 nameLength = entry.m_strName.size();
+      kuint16 remarkLength = entry.m_strRemark.size();
+      kuint16 reserved = 0;
+      fs.writeInt16 (type);
+      fs.writeInt16 (nameLength);
+      fs.writeInt16 (remarkLength);
+      fs.writeInt16 (reserved);
+      fs.writeArray (&entry.m_offset, 1, sizeof(kuint64));
+      fs.writeArray (&entry.m_size, 1, sizeof(kuint64));
+      fs.write (entry.m_strName.c_str(), nameLength);
+      fs.write (entry.m_strRemark.c_str(), remarkLength);
+    }
+    kuint64 tocBytes = static_cast<kuint64>(fs.tellp()) - tocOffset;
+    fs.flush();
+    bOk = ! fs.fail() && headerWrite (tocOffset, tocBytes);
+    if (! bOk)
+      sys_error (ERR_WARNING, "Error writing table of contents of volume %s [VolumeFile::close]", m_strFilename.c_str());
+  }
+
+  delete m_pStream;
+  m_pStream = NULL;
+  m_bModified = false;
+
+  return bOk;
+}
+
+
+bool
+VolumeFile::headerWrite (kuint64 tocOffset, kuint64 tocBytes)
+{
+  frnetorderstream& fs = *m_pStream;
+  kuint16 headerSize = s_iHeaderSize;
+  kuint16 signature = m_signature;
+  kuint32 version = s_iVersion;
+  kuint32 nEntries = m_vecEntry.size();
+  kuint32 alignment = s_iEntryAlignment;
+
+  fs.seekp (0);
+  fs.writeInt16 (headerSize);
+  fs.writeInt16 (signature);
+  fs.writeInt32 (version);
+  fs.writeInt32 (nEntries);
+  fs.writeInt32 (alignment);
+  fs.writeArray (&tocOffset, 1, sizeof(kuint64));
+  fs.writeArray (&tocBytes, 1, sizeof(kuint64));
+  fs.flush();
+
+  return ! fs.fail();
+}
+
+
+bool
+VolumeFile::headerRead ()
+{
+  frnetorderstream& fs = *m_pStream;
+  kuint16 headerSize, signature;
+  kuint32 version, nEntries, alignment;
+  kuint64 tocOffset, tocBytes;
+
+  fs.seekg (0);
+  fs.readInt16 (headerSize);
+  fs.readInt16 (signature);
+  fs.readInt32 (version);
+  fs.readInt32 (nEntries);
+  fs.readInt32 (alignment);
+  fs.readArray (&tocOffset, 1, sizeof(kuint64));
+  fs.readArray (&tocBytes, 1, sizeof(kuint64));
+
+  if (fs.fail() || signature != m_signature || headerSize != s_iHeaderSize) {
+    sys_error (ERR_WARNING, "File %s is not a volume file [VolumeFile::headerRead]", m_strFilename.c_str());
+    return false;
+  }
+  if (version > s_iVersion) {
+    sys_error (ERR_WARNING, "Volume %s has unknown version %d [VolumeFile::headerRead]", m_strFilename.c_str(), version);
+    return false;
+  }
+
+  if (tocBytes == 0) {
+    m_endOffset = s_iHeaderSize;
+    return true;
+  }
+  // new entries follow the current table of contents
+  m_endOffset = tocOffset + tocBytes;
+
+  return tocRead (tocOffset, nEntries);
+}
+
+
+bool
+VolumeFile::tocRead (kuint64 tocOffset, kuint32 nEntries)
+{
+  frnetorderstream& fs = *m_pStream;
+
+  fs.seekg (tocOffset);
+  m_vecEntry.resize (nEntries);
+  std::vector<char> vecString;
+  for (unsigned int i = 0; i < nEntries; i++) {
+    Entry& entry = m_vecEntry[i];
+    kuint16 type, nameLength, remarkLength, reserved;
+    fs.readInt16 (type);
+    fs.readInt16 (nameLength);
+    fs.readInt16 (remarkLength);
+    fs.readInt16 (reserved);
+    fs.readArray (&entry.m_offset, 1, sizeof(kuint64));
+    fs.readArray (&entry.m_size, 1, sizeof(kuint64));
+    entry.m_iType = type;
+    vecString.resize (nameLength + remarkLength + 1);
+    fs.read (&vecString[0], nameLength + remarkLength);
+    entry.m_strName.assign (&vecString[0], nameLength);
+    entry.m_strRemark.assign (&vecString[nameLength], remarkLength);
+    if (fs.fail()) {
+      sys_error (ERR_WARNING, "Error reading table of contents of volume %s", m_strFilename.c_str());
+      m_vecEntry.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int
+VolumeFile::findEntry (const char* const name) const
+{
+  if (name[0] == '#') {
+    char* endptr;
+    long iEntry = strtol (name + 1, &endptr, 10);
+    if (*endptr == 0 && endptr != name + 1 && iEntry >= 0 && iEntry < nEntries())
+      return iEntry;
+    return -1;
+  }
+
+  for (int i = 0; i < nEntries(); i++)
+    if (m_vecEntry[i].m_strName == name)
+      return i;
+
+  return -1;
+}
+
+std::string
+VolumeFile::entryPath (int iEntry) const
+{
+  return m_strFilename + ":" + m_vecEntry[iEntry].m_strName;
+}
+
+
+bool
+VolumeFile::readImage (int iEntry, Array2dFile& rImage) const
+{
+  if (iEntry < 0 || iEntry >= nEntries() || m_vecEntry[iEntry].m_iType != ENTRY_IMAGE) {
+    sys_error (ERR_WARNING, "Entry %d of volume %s is not an image [VolumeFile::readImage]", iEntry, m_strFilename.c_str());
+    return false;
+  }
+
+  frnetorderstream fs (m_strFilename.c_str(), std::ios::in | std::ios::binary);
+  if (fs.fail())
+    return false;
+  fs.setOrigin (m_vecEntry[iEntry].m_offset);
+
+  return rImage.fileRead (fs);
+}
+
+bool
+VolumeFile::readProjections (int iEntry, Projections& rProj) const
+{
+  if (iEntry < 0 || iEntry >= nEntries() || m_vecEntry[iEntry].m_iType != ENTRY_PROJECTIONS) {
+    sys_error (ERR_WARNING, "Entry %d of volume %s is not projections [VolumeFile::readProjections]", iEntry, m_strFilename.c_str());
+    return false;
+  }
+
+  frnetorderstream fs (m_strFilename.c_str(), std::ios::in | std::ios::binary);
+  if (fs.fail())
+    return false;
+  fs.setOrigin (m_vecEntry[iEntry].m_offset);
+
+  return rProj.read (fs);
+}
+
+
+// NAME
+//   beginEntry           Position the stream at the start of a new entry
+//
+// NOTES
+//   Called with m_mutex locked.
+
+bool
+VolumeFile::beginEntry (kuint64& offset)
+{
+  if (! m_pStream || ! m_bWrite) {
+    sys_error (ERR_WARNING, "Volume %s is not open for writing [VolumeFile::beginEntry]", m_strFilename.c_str());
+    return false;
+  }
+
+  offset = (m_endOffset + s_iEntryAlignment - 1) / s_iEntryAlignment * s_iEntryAlignment;
+  m_pStream->clear();
+  m_pStream->setOrigin (offset);
+
+  return true;
+}
+
+void
+VolumeFile::endEntry (int iType, const char* const name, const std::string& strRemark, kuint64 offset)
+{
+  frnetorderstream& fs = *m_pStream;
+  fs.flush();
+  fs.setOrigin (0);
+  fs.fstream::seekp (0, std::ios::end);
+
+  Entry entry;
+  entry.m_iType = iType;
+  entry.m_strName = name;
+  entry.m_strRemark = strRemark;
+  entry.m_offset = offset;
+  entry.m_size = static_cast<kuint64>(fs.tellp()) - offset;
+
+  int iEntry = findEntry (name);
+  if (iEntry >= 0 && name[0] != '#')
+    m_vecEntry[iEntry] = entry;
+  else
+    m_vecEntry.push_back (entry);
+  m_endOffset = offset + entry.m_size;
+  m_bModified = true;
+}
+
+
+bool
+VolumeFile::writeImage (const char* const name, Array2dFile& rImage)
+{
+  if (name[0] == 0 || name[0] == '#') {
+    sys_error (ERR_WARNING, "Invalid entry name \"%s\" [VolumeFile::writeImage]", name);
+    return false;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&m_mutex);
+#endif
+  kuint64 offset;
+  bool bOk = beginEntry (offset) && rImage.fileWrite (*m_pStream);
+  if (bOk) {
+    std::string strRemark;
+    if (rImage.getNumLabels() > 0)
+      strRemark = rImage.labelGet (rImage.getNumLabels() - 1).getLabelString();
+    endEntry (ENTRY_IMAGE, name, strRemark, offset);
+  } else if (m_pStream)
+    m_pStream->setOrigin (0);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&m_mutex);
+#endif
+
+  return bOk;
+}
+
+bool
+VolumeFile::writeProjections (const char* const name, Projections& rProj)
+{
+  if (name[0] == 0 || name[0] == '#') {
+    sys_error (ERR_WARNING, "Invalid entry name \"%s\" [VolumeFile::writeProjections]", name);
+    return false;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock (&m_mutex);
+#endif
+  kuint64 offset;
+  bool bOk = beginEntry (offset) && rProj.write (*m_pStream);
+  if (bOk)
+    endEntry (ENTRY_PROJECTIONS, name, rProj.remark(), offset);
+  else if (m_pStream)
+    m_pStream->setOrigin (0);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock (&m_mutex);
+#endif
+
+  return bOk;
+}
+
+
+void
+VolumeFile::printEntries (std::ostream& os) const
+{
+  os << "Volume: " << m_strFilename << ", " << nEntries() << " entries\n";
+  for (int i = 0; i < nEntries(); i++) {
+    const Entry& entry = m_vecEntry[i];
+    os << std::setw(5) << i << "  " << std::setw(11) << std::left << convertEntryTypeIDToName (entry.m_iType)
+       << std::right << std::setw(12) << entry.m_size << "  " << entry.m_strName;
+    if (entry.m_strRemark.size() > 0)
+      os << ": " << entry.m_strRemark;
+    os << "\n";
+  }
+}
@@ -0,0 +1,302 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:          arraycodec.cpp
+**   Purpose:       Compression of floating point arrays
+**   Programmer:    Kevin Rosenberg
+**   Date Started:  October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ctsupport.h"
+#include "fnetorderstream.h"
+#include "arraycodec.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+
+const int ArrayCodec::CODEC_INVALID = -1;
+const int ArrayCodec::CODEC_NONE = 0;
+const int ArrayCodec::CODEC_DEFLATE = 1;
+const int ArrayCodec::CODEC_FLOAT16 = 2;
+
+const char* const ArrayCodec::s_aszCodecName[] =
+{
+  "none",
+  "deflate",
+  "float16",
+};
+
+const char* const ArrayCodec::s_aszCodecTitle[] =
+{
+  "None",
+  "Lossless Deflate",
+  "Half Precision Deflate",
+};
+
+const int ArrayCodec::s_iCodecCount = sizeof(s_aszCodecName) / sizeof(const char*);
+
+
+int
+ArrayCodec::convertCodecNameToID (const char* const codecName)
+{
+  int codecID = CODEC_INVALID;
+
+  for (int i = 0; i < s_iCodecCount; i++)
+    if (strcasecmp (codecName, s_aszCodecName[i]) == 0) {
+      codecID = i;
+      break;
+    }
+
+  return (codecID);
+}
+
+const char*
+ArrayCodec::convertCodecIDToName (const int codecID)
+{
+  static const char *codecName = "";
+
+  if (codecID >= 0 && codecID < s_iCodecCount)
+    return (s_aszCodecName[codecID]);
+
+  return (codecName);
+}
+
+const char*
+ArrayCodec::convertCodecIDToTitle (const int codecID)
+{
+  static const char *codecTitle = "";
+
+  if (codecID >= 0 && codecID < s_iCodecCount)
+    return (s_aszCodecTitle[codecID]);
+
+  return (codecTitle);
+}
+
+bool
+ArrayCodec::isAvailable (int idCodec)
+{
+  if (idCodec == CODEC_NONE)
+    return true;
+#ifdef HAVE_ZLIB
+  return idCodec == CODEC_DEFLATE || idCodec == CODEC_FLOAT16;
+#else
+  return false;
+#endif
+}
+
+
+// IEEE half precision conversions, rounding to nearest even
+
+static kuint16
+convertFloatToHalf (float f)
+{
+  kuint32 x;
+  memcpy (&x, &f, sizeof(x));
+  const kuint32 sign = (x >> 16) & 0x8000;
+  kuint32 mant = x & 0x7FFFFF;
+  const int exp = (x >> 23) & 0xFF;
+
+  if (exp == 0xFF)              // infinity and nan
+    return static_cast<kuint16>(sign | 0x7C00 | (mant ? 0x200 : 0));
+
+  const int e = exp - 127 + 15;
+  if (e >= 0x1F)
+    return static_cast<kuint16>(sign | 0x7C00);
+  if (e <= 0) {                 // half precision subnormal
+    if (e < -10)
+      return static_cast<kuint16>(sign);
+    mant |= 0x800000;
+    const kuint32 shift = 14 - e;
+    kuint32 h = mant >> shift;
+    const kuint32 rem = mant & ((1u << shift) - 1);
+    const kuint32 halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (h & 1)))
+      h++;
+    return static_cast<kuint16>(sign | h);
+  }
+
+  kuint32 h = (static_cast<kuint32>(e) << 10) | (mant >> 13);
+  const kuint32 rem = mant & 0x1FFF;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+    h++;                        // may carry into the exponent, up to infinity
+  return static_cast<kuint16>(sign | h);
+}
+
+static float
+convertHalfToFloat (kuint16 h)
+{
+  const kuint32 sign = static_cast<kuint32>(h & 0x8000) << 16;
+  int exp = (h >> 10) & 0x1F;
+  kuint32 mant = h & 0x3FF;
+  kuint32 x;
+
+  if (exp == 0) {
+    if (mant == 0)
+      x = sign;
+    else {
+      exp = 1;
+      while (! (mant & 0x400)) {
+        mant <<= 1;
+        exp--;
+      }
+      x = sign | (static_cast<kuint32>(exp + 112) << 23) | ((mant & 0x3FF) << 13);
+    }
+  } else if (exp == 0x1F)
+    x = sign | 0x7F800000 | (mant << 13);
+  else
+    x = sign | (static_cast<kuint32>(exp + 112) << 23) | (mant << 13);
+
+  float f;
+  memcpy (&f, &x, sizeof(f));
+  return f;
+}
+
+
+// NAME
+//   encode               Encode nValues floats or doubles
+//
+// NOTES
+//   Deflate compresses the exponent and high mantissa bytes of smooth data
+//   far better when they are not interleaved with the noisy low bytes, so
+//   byte k of every value is gathered into plane k before deflating.
+
+bool
+ArrayCodec::encode (int idCodec, const void* pValues, size_t nValues, size_t valueSize,
+                    std::vector<unsigned char>& vecEncoded)
+{
+  if ((valueSize != sizeof(kfloat32) && valueSize != sizeof(kfloat64)) || ! isAvailable (idCodec)) {
+    sys_error (ERR_WARNING, "Codec %d is not available for values of %d bytes [ArrayCodec::encode]", idCodec, valueSize);
+    return false;
+  }
+  vecEncoded.clear();
+  if (nValues == 0)
+    return true;
+
+  // values as little endian elements
+  std::vector<unsigned char> vecBytes;
+  size_t nElementBytes = valueSize;
+  if (idCodec == CODEC_FLOAT16) {
+    nElementBytes = 2;
+    vecBytes.resize (nValues * nElementBytes);
+    for (size_t i = 0; i < nValues; i++) {
+      float f;
+      if (valueSize == sizeof(kfloat32))
+        f = static_cast<const kfloat32*>(pValues)[i];
+      else
+        f = static_cast<float>(static_cast<const kfloat64*>(pValues)[i]);
+      const kuint16 h = convertFloatToHalf (f);
+      vecBytes[2 * i] = static_cast<unsigned char>(h & 0xFF);
+      vecBytes[2 * i + 1] = static_cast<unsigned char>(h >> 8);
+    }
+  } else {
+    const unsigned char* p = static_cast<const unsigned char*>(pValues);
+    vecBytes.assign (p, p + nValues * valueSize);
+    if (NativeBigEndian())
+      SwapBytesArray (&vecBytes[0], nValues, valueSize);
+  }
+
+  if (idCodec == CODEC_NONE) {
+    vecEncoded.swap (vecBytes);
+    return true;
+  }
+
+#ifdef HAVE_ZLIB
+  std::vector<unsigned char> vecPlanes (vecBytes.size());
+  for (size_t iByte = 0; iByte < nElementBytes; iByte++) {
+    unsigned char* pPlane = &vecPlanes[iByte * nValues];
+    const unsigned char* p = &vecBytes[iByte];
+    for (size_t i = 0; i < nValues; i++, p += nElementBytes)
+      pPlane[i] = *p;
+  }
+
+  uLongf nCompressed = compressBound (vecPlanes.size());
+  vecEncoded.resize (nCompressed);
+  if (compress2 (&vecEncoded[0], &nCompressed, &vecPlanes[0], vecPlanes.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    sys_error (ERR_WARNING, "Error compressing array [ArrayCodec::encode]");
+    return false;
+  }
+  vecEncoded.resize (nCompressed);
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+bool
+ArrayCodec::decode (int idCodec, const unsigned char* pEncoded, size_t nEncodedBytes,
+                    void* pValues, size_t nValues, size_t valueSize)
+{
+  if ((valueSize != sizeof(kfloat32) && valueSize != sizeof(kfloat64)) || ! isAvailable (idCodec)) {
+    sys_error (ERR_WARNING, "Codec %d is not available for values of %d bytes [ArrayCodec::decode]", idCodec, valueSize);
+    return false;
+  }
+  if (nValues == 0)
+    return true;
+
+  const size_t nElementBytes = idCodec == CODEC_FLOAT16 ? 2 : valueSize;
+  const size_t nBytes = nValues * nElementBytes;
+  std::vector<unsigned char> vecBytes;
+  const unsigned char* pBytes = pEncoded;
+
+  if (idCodec == CODEC_NONE) {
+    if (nEncodedBytes != nBytes) {
+      sys_error (ERR_WARNING, "Encoded array has %d bytes, expected %d [ArrayCodec::decode]", nEncodedBytes, nBytes);
+      return false;
+    }
+  } else {
+#ifdef HAVE_ZLIB
+    std::vector<unsigned char> vecPlanes (nBytes);
+    uLongf nInflated = nBytes;
+    if (uncompress (&vecPlanes[0], &nInflated, pEncoded, nEncodedBytes) != Z_OK || nInflated != nBytes) {
+      sys_error (ERR_WARNING, "Error uncompressing array [ArrayCodec::decode]");
+      return false;
+    }
+    vecBytes.resize (nBytes);
+    for (size_t iByte = 0; iByte < nElementBytes; iByte++) {
+      const unsigned char* pPlane = &vecPlanes[iByte * nValues];
+      unsigned char* p = &vecBytes[iByte];
+      for (size_t i = 0; i < nValues; i++, p += nElementBytes)
+        *p = pPlane[i];
+    }
+    pBytes = &vecBytes[0];
+#else
+    return false;
+#endif
+  }
+
+  if (idCodec == CODEC_FLOAT16) {
+    for (size_t i = 0; i < nValues; i++) {
+      const kuint16 h = static_cast<kuint16>(pBytes[2 * i] | (pBytes[2 * i + 1] << 8));
+      const float f = convertHalfToFloat (h);
+      if (valueSize == sizeof(kfloat32))
+        static_cast<kfloat32*>(pValues)[i] = f;
+      else
+        static_cast<kfloat64*>(pValues)[i] = f;
+    }
+  } else {
+    memcpy (pValues, pBytes, nBytes);
+    if (NativeBigEndian())
+      SwapBytesArray (pValues, nValues, valueSize);
+  }
+
+  return true;
+}
@@ -66,6 +66,167 @@ ConvertReverseNetworkOrder (void* buffer, size_t bytes)
 #endif
 }
 
+// NAME
+//   SwapBytesArray       Reverse the bytes of an array of elements
+//
+// NOTES
+//   Each element is loaded as an integer and its bytes are reversed with
+//   shifts, a loop compilers turn into byte swap or shuffle instructions.
+
+void
+SwapBytesArray (void* buffer, size_t nElements, size_t elementSize)
+{
+  unsigned char* p = static_cast<unsigned char*>(buffer);
+
+  if (elementSize == 2) {
+    for (size_t i = 0; i < nElements; i++, p += 2) {
+      kuint16 n;
+      memcpy (&n, p, 2);
+      n = static_cast<kuint16>((n >> 8) | (n << 8));
+      memcpy (p, &n, 2);
+    }
+  } else if (elementSize == 4) {
+    for (size_t i = 0; i < nElements; i++, p += 4) {
+      kuint32 n;
+      memcpy (&n, p, 4);
+      n = (n >> 24) | ((n >> 8) & 0x0000FF00) | ((n << 8) & 0x00FF0000) | (n << 24);
+      memcpy (p, &n, 4);
+    }
+  } else if (elementSize == 8) {
+    for (size_t i = 0; i < nElements; i++, p += 8) {
+      kuint32 lo, hi;
+      memcpy (&lo, p, 4);
+      memcpy (&hi, p + 4, 4);
+      lo = (lo >> 24) | ((lo >> 8) & 0x0000FF00) | ((lo << 8) & 0x00FF0000) | (lo << 24);
+      hi = (hi >> 24) | ((hi >> 8) & 0x0000FF00) | ((hi << 8) & 0x00FF0000) | (hi << 24);
+      memcpy (p, &hi, 4);
+      memcpy (p + 4, &lo, 4);
+    }
+  } else {
+    for (size_t i = 0; i < nElements; i++, p += elementSize)
+      for (size_t j = 0; j < elementSize / 2; j++) {
+        unsigned char c = p[j];
+        p[j] = p[elementSize - 1 - j];
+        p[elementSize - 1 - j] = c;
+      }
+  }
+}
+
+
+const char*
+fnetorderstream::streamFilename (const char* filename, std::ios::openmode mode)
+{
+  if (! isStandardStream (filename))
+    return filename;
+
+  return (mode & std::ios::out) ? "/dev/stdout" : "/dev/stdin";
+}
+
+// Pipes can not be positioned, so the end is not sought and the standard
+// output is opened only for writing
+std::ios::openmode
+fnetorderstream::streamMode (const char* filename, std::ios::openmode mode)
+{
+  if (! isStandardStream (filename))
+    return mode;
+
+  if (mode & std::ios::out)
+    return std::ios::out | std::ios::trunc | std::ios::binary;
+  return std::ios::in | std::ios::binary;
+}
+
+
+// NAME
+//   seekg                Set the read position
+//
+// NOTES
+//   A sequential stream can only move forward, the bytes up to the position
+//   are skipped
+
+fnetorderstream&
+fnetorderstream::seekg (std::streamoff pos)
+{
+  if (! m_bSequential) {
+    fstream::seekg (pos + m_origin);
+    return *this;
+  }
+
+  if (pos < m_pos)
+    setstate (std::ios::failbit);
+  else if (pos > m_pos) {
+    ignore (pos - m_pos);
+    m_pos += gcount();
+  }
+  return *this;
+}
+
+fnetorderstream&
+fnetorderstream::seekp (std::streamoff pos)
+{
+  if (! m_bSequential) {
+    fstream::seekp (pos + m_origin);
+    return *this;
+  }
+
+  if (pos < m_pos)
+    setstate (std::ios::failbit);
+  else {
+    const char szZero[64] = {0};
+    while (pos > m_pos && good())
+      write (szZero, static_cast<std::streamsize>(std::min<std::streamoff> (pos - m_pos, sizeof(szZero))));
+  }
+  return *this;
+}
+
+
+// NAME
+//   writeArraySwapped    Write an array, swapping bytes through a buffer
+//
+// NOTES
+//   The caller's array is left unchanged, swapped elements are written a
+//   block at a time.
+
+void
+fnetorderstream::writeArraySwapped (const void* buffer, size_t nElements, size_t elementSize, bool bSwap)
+{
+  const char* p = static_cast<const char*>(buffer);
+  if (! bSwap) {
+    write (p, nElements * elementSize);
+    return;
+  }
+
+  const size_t nBlockBytes = 65536;
+  const size_t nBlockElements = nBlockBytes / elementSize;
+  char* pBlock = new char [nBlockElements * elementSize];
+  while (nElements > 0 && good()) {
+    const size_t n = nElements < nBlockElements ? nElements : nBlockElements;
+    memcpy (pBlock, p, n * elementSize);
+    SwapBytesArray (pBlock, n, elementSize);
+    write (pBlock, n * elementSize);
+    p += n * elementSize;
+    nElements -= n;
+  }
+  delete [] pBlock;
+}
+
+void
+fnetorderstream::readArraySwapped (void* buffer, size_t nElements, size_t elementSize, bool bSwap)
+{
+  read (static_cast<char*>(buffer), nElements * elementSize);
+  if (bSwap)
+    SwapBytesArray (buffer, nElements, elementSize);
+}
+
+void
+fnetorderstream::writeArray (const void* buffer, size_t nElements, size_t elementSize) {
+  writeArraySwapped (buffer, nElements, elementSize, ! NativeBigEndian());
+}
+
+void
+fnetorderstream::readArray (void* buffer, size_t nElements, size_t elementSize) {
+  readArraySwapped (buffer, nElements, elementSize, ! NativeBigEndian());
+}
+
 void
 fnetorderstream::writeInt16 (kuint16 n) {
 #ifndef WORDS_BIGENDIAN
@@ -132,6 +293,16 @@ fnetorderstream::readFloat64 (kfloat64& n) {
 
 
 
+void
+frnetorderstream::writeArray (const void* buffer, size_t nElements, size_t elementSize) {
+  writeArraySwapped (buffer, nElements, elementSize, NativeBigEndian());
+}
+
+void
+frnetorderstream::readArray (void* buffer, size_t nElements, size_t elementSize) {
+  readArraySwapped (buffer, nElements, elementSize, NativeBigEndian());
+}
+
 void
 frnetorderstream::writeInt16 (kuint16 n) {
 #ifdef WORDS_BIGENDIAN
@@ -68,9 +68,10 @@ void sys_error (int severity, const char *msg, ...)
     }
   }
   else
-    std::cout << strOutput << "\n";
+    std::cerr << strOutput << "\n";
 #else
-    std::cout << strOutput << "\n";
+    // the standard output may carry a dataset to another tool
+    std::cerr << strOutput << "\n";
 #endif
 
   va_end(arg);
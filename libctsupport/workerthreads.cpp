@@ -0,0 +1,153 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:          workerthreads.cpp
+**   Purpose:       Split work units across POSIX threads
+**   Programmer:    Kevin Rosenberg
+**   Date Started:  October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (c) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ctsupport.h"
+#include "workerthreads.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+
+WorkerThreads::WorkerThreads (int nThreads)
+  : m_nThreads(nThreads), m_iTotalWorkUnits(0)
+{
+  if (m_nThreads < 1)
+    m_nThreads = getNumberOfProcessors();
+
+  m_vLocalWorkUnits.resize (m_nThreads);
+  m_vStartWorkUnit.resize (m_nThreads);
+  m_vEndWorkUnit.resize (m_nThreads);
+}
+
+int
+WorkerThreads::getNumberOfProcessors ()
+{
+  int nProcessors = 1;
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long lProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+  if (lProcessors > 1)
+    nProcessors = static_cast<int>(lProcessors);
+#endif
+
+  return nProcessors;
+}
+
+
+void
+WorkerThreads::setTotalWorkUnits (int totalWorkUnits)
+{
+  m_iTotalWorkUnits = totalWorkUnits;
+
+  int baseLocalWorkUnits = totalWorkUnits / m_nThreads;
+  int remainderWorkUnits = totalWorkUnits % m_nThreads;
+
+  int currWorkUnits = 0;
+  for (int iThread = 0; iThread < m_nThreads; iThread++) {
+    m_vLocalWorkUnits[iThread] = baseLocalWorkUnits;
+    if (iThread < remainderWorkUnits)
+      m_vLocalWorkUnits[iThread]++;
+
+    m_vStartWorkUnit[iThread] = currWorkUnits;
+    m_vEndWorkUnit[iThread] = m_vStartWorkUnit[iThread] + m_vLocalWorkUnits[iThread] - 1;
+
+    currWorkUnits += m_vLocalWorkUnits[iThread];
+  }
+}
+
+
+#ifdef HAVE_PTHREAD
+struct WorkerThreadArgs {
+  WorkerThreadTask* m_pTask;
+  int m_iThread;
+  int m_iStartUnit;
+  int m_iNumUnits;
+};
+
+extern "C" {
+static void*
+workerThreadEntry (void* pArg)
+{
+  WorkerThreadArgs* pArgs = static_cast<WorkerThreadArgs*>(pArg);
+  pArgs->m_pTask->doWorkUnits (pArgs->m_iThread, pArgs->m_iStartUnit, pArgs->m_iNumUnits);
+
+  return NULL;
+}
+}
+#endif
+
+
+// NAME
+//   run                  Run task over all work units and wait for completion
+//
+// DESCRIPTION
+//   Thread 0's range is processed by the calling thread. If a thread can not
+//   be created, its range is also processed by the calling thread.
+
+bool
+WorkerThreads::run (WorkerThreadTask& task)
+{
+#ifdef HAVE_PTHREAD
+  std::vector<WorkerThreadArgs> vArgs (m_nThreads);
+  std::vector<pthread_t> vThreadIds (m_nThreads);
+  std::vector<bool> vStarted (m_nThreads, false);
+
+  for (int iThread = 1; iThread < m_nThreads; iThread++) {
+    if (m_vLocalWorkUnits[iThread] <= 0)
+      continue;
+    vArgs[iThread].m_pTask = &task;
+    vArgs[iThread].m_iThread = iThread;
+    vArgs[iThread].m_iStartUnit = m_vStartWorkUnit[iThread];
+    vArgs[iThread].m_iNumUnits = m_vLocalWorkUnits[iThread];
+    if (pthread_create (&vThreadIds[iThread], NULL, workerThreadEntry, &vArgs[iThread]) == 0)
+      vStarted[iThread] = true;
+    else
+      sys_error (ERR_WARNING, "Unable to create worker thread %d, running in main thread [WorkerThreads::run]", iThread);
+  }
+
+  if (m_vLocalWorkUnits[0] > 0)
+    task.doWorkUnits (0, m_vStartWorkUnit[0], m_vLocalWorkUnits[0]);
+
+  bool bOk = true;
+  for (int iThread = 1; iThread < m_nThreads; iThread++) {
+    if (vStarted[iThread]) {
+      if (pthread_join (vThreadIds[iThread], NULL) != 0)
+        bOk = false;
+    } else if (m_vLocalWorkUnits[iThread] > 0)
+      task.doWorkUnits (iThread, m_vStartWorkUnit[iThread], m_vLocalWorkUnits[iThread]);
+  }
+
+  return bOk;
+#else
+  for (int iThread = 0; iThread < m_nThreads; iThread++)
+    if (m_vLocalWorkUnits[iThread] > 0)
+      task.doWorkUnits (iThread, m_vStartWorkUnit[iThread], m_vLocalWorkUnits[iThread]);
+
+  return true;
+#endif
+}
@@ -108,6 +108,10 @@ SOURCE=..\..\tools\if2.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\tools\if2pj.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\tools\ifexport.cpp
 # End Source File
 # Begin Source File
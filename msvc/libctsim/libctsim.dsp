@@ -89,6 +89,10 @@ SOURCE=..\..\libctsim\array2dfile.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsupport\arraycodec.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsim\backprojectors.cpp
 # End Source File
 # Begin Source File
@@ -137,6 +141,10 @@ SOURCE=..\..\libctsupport\hashtable.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsim\helicalweights.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsim\imagefile.cpp
 # End Source File
 # Begin Source File
@@ -145,6 +153,10 @@ SOURCE=..\..\libctsupport\interpolator.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsim\iterativerecon.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsupport\mathfuncs.cpp
 # End Source File
 # Begin Source File
@@ -153,6 +165,10 @@ SOURCE=..\..\libctsupport\msvc.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsim\parallelrebin.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsim\phantom.cpp
 # End Source File
 # Begin Source File
@@ -193,6 +209,10 @@ SOURCE=..\..\libctsupport\syserror.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsim\systemmatrix.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsim\trace.cpp
 # End Source File
 # Begin Source File
@@ -201,6 +221,14 @@ SOURCE=..\..\libctgraphics\transformmatrix.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\libctsim\volumefile.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\libctsupport\workerthreads.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\libctsupport\xform.cpp
 # End Source File
 # End Group
@@ -217,6 +245,10 @@ SOURCE=..\..\include\array2dfile.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\include\arraycodec.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\include\backprojectors.h
 # End Source File
 # Begin Source File
@@ -257,6 +289,10 @@ SOURCE=..\..\include\hashtable.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\include\helicalweights.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\include\imagefile.h
 # End Source File
 # Begin Source File
@@ -277,6 +313,10 @@ SOURCE=..\..\include\nographics.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\include\parallelrebin.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\include\phantom.h
 # End Source File
 # Begin Source File
@@ -309,6 +349,10 @@ SOURCE=..\..\include\sgp.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\include\systemmatrix.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\include\timer.h
 # End Source File
 # Begin Source File
@@ -319,6 +363,14 @@ SOURCE=..\..\include\trace.h
 
 SOURCE=..\..\include\transformmatrix.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\include\volumefile.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\workerthreads.h
+# End Source File
 # End Group
 # End Target
 # End Project
@@ -364,6 +364,7 @@ EVT_MENU(MAINMENU_HELP_ABOUT, MainFrame::OnAbout)
 EVT_MENU(MAINMENU_HELP_CONTENTS, MainFrame::OnHelpContents)
 EVT_MENU(MAINMENU_HELP_TIPS, MainFrame::OnHelpTips)
 EVT_MENU(MAINMENU_IMPORT, MainFrame::OnImport)
+EVT_MENU(MAINMENU_FILE_OPEN_VOLUME, MainFrame::OnOpenVolume)
 EVT_MENU(IDH_QUICKSTART, MainFrame::OnHelpButton)
 EVT_MENU(MAINMENU_LOG_EVENT, MainFrame::OnLogEvent)
 EVT_MENU(NEW_IMAGEFILE_EVENT, MainFrame::OnNewImageFile)
@@ -430,6 +431,7 @@ MainFrame::MainFrame(wxDocManager *manager, wxFrame *frame, wxWindowID id, const
   file_menu->Append(MAINMENU_FILE_CREATE_PHANTOM, _T("Cr&eate Phantom...\tCtrl-P"));
   file_menu->Append(MAINMENU_FILE_CREATE_FILTER, _T("Create &Filter...\tCtrl-F"));
   file_menu->Append(wxID_OPEN, _T("&Open...\tCtrl-O"));
+  file_menu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
 
   file_menu->AppendSeparator();
   file_menu->Append (MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
@@ -1020,6 +1022,50 @@ MainFrame::OnImport (wxCommandEvent& WXUNUSED(event) )
   }
 }
 
+// Opens one entry of a volume file as an image or projection document.
+// The document is named by the entry path, so saving it rewrites the entry.
+
+void
+MainFrame::OnOpenVolume (wxCommandEvent& WXUNUSED(event) )
+{
+  wxString strFilename = wxFileSelector (_T("Open Volume"), _T(""), _T(""), _T(".ctv"),
+                                         _T("Volume Files (*.ctv)|*.ctv"), wxOPEN);
+  if (strFilename.IsEmpty())
+    return;
+
+  VolumeFile volume;
+  if (! volume.open (strFilename.mb_str(wxConvUTF8))) {
+    ::wxMessageBox (_T("Unable to open volume file"), _T("Open Volume Error"));
+    return;
+  }
+  if (volume.nEntries() == 0) {
+    ::wxMessageBox (_T("Volume file has no entries"), _T("Open Volume Error"));
+    return;
+  }
+
+  wxArrayString astrEntries;
+  for (int i = 0; i < volume.nEntries(); i++) {
+    std::ostringstream os;
+    os << volume.entryName (i) << " (" << VolumeFile::convertEntryTypeIDToName (volume.entryType (i)) << ")";
+    astrEntries.Add (wxConvUTF8.cMB2WX (os.str().c_str()));
+  }
+  int iEntry = ::wxGetSingleChoiceIndex (_T("Entry"), _T("Open Volume Entry"), astrEntries, this);
+  if (iEntry < 0)
+    return;
+
+  wxDocTemplate* pTemplate = theApp->getDocTemplImage();
+  if (volume.entryType (iEntry) == VolumeFile::ENTRY_PROJECTIONS)
+    pTemplate = theApp->getDocTemplProjection();
+  wxString strEntryPath (wxConvUTF8.cMB2WX (volume.entryPath (iEntry).c_str()));
+  volume.close();
+
+  wxDocument* pDoc = pTemplate->CreateDocument (strEntryPath, wxDOC_SILENT);
+  if (pDoc && ! pDoc->OnOpenDocument (strEntryPath)) {
+    pDoc->DeleteAllViews();
+    return;
+  }
+}
+
 #include "./splash.xpm"
 void
 MainFrame::OnAbout(wxCommandEvent& WXUNUSED(event) )
@@ -146,6 +146,7 @@ public:
 
   void OnHelpButton (wxCommandEvent& event);
   void OnImport (wxCommandEvent& event);
+  void OnOpenVolume (wxCommandEvent& event);
 
 #if defined(CTSIM_WINHELP) && (defined(DEBUG) || defined(_DEBUG))
   void OnHelpSecondary (wxCommandEvent& event);
@@ -297,6 +298,7 @@ enum {
     MAINMENU_FILE_PREFERENCES,
     MAINMENU_LOG_EVENT,
     MAINMENU_IMPORT,
+    MAINMENU_FILE_OPEN_VOLUME,
 
     PJMENU_FILE_PROPERTIES,
     PJMENU_RECONSTRUCT_FBP,
@@ -335,6 +337,7 @@ enum {
     IFMENU_IMAGE_SUBTRACT,
     IFMENU_IMAGE_MULTIPLY,
     IFMENU_IMAGE_DIVIDE,
+    IFMENU_IMAGE_PROJECTIONS,
 #ifdef wxUSE_GLCANVAS
     IFMENU_IMAGE_CONVERT3D,
 #endif
@@ -362,6 +365,7 @@ enum {
     PHMMENU_FILE_PROPERTIES,
     PHMMENU_PROCESS_RASTERIZE,
     PHMMENU_PROCESS_PROJECTIONS,
+    PHMMENU_PROCESS_PROJECTIONS_TO_FILE,
 
     PLOTMENU_FILE_PROPERTIES,
     PLOTMENU_VIEW_SCALE_MINMAX,
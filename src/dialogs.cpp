@@ -647,7 +647,7 @@ DialogGetRasterParameters::getViewRatio ()
 DialogGetProjectionParameters::DialogGetProjectionParameters
    (wxWindow* pParent, int iDefaultNDet, int iDefaultNView, int iDefaultOffsetView, int iDefaultNSamples,
     double dDefaultRotAngle, double dDefaultFocalLength, double dDefaultCenterDetectorLength,
-    double dDefaultViewRatio, double dDefaultScanRatio, int iDefaultGeometry, int iDefaultTrace)
+    double dDefaultViewRatio, double dDefaultScanRatio, int iDefaultGeometry, int iDefaultAperture, int iDefaultTrace)
 : wxDialog (pParent, -1, _T("Projection Parameters"), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxCAPTION)
 {
   wxBoxSizer* pTopSizer = new wxBoxSizer (wxVERTICAL);
@@ -662,6 +662,7 @@ DialogGetProjectionParameters::DialogGetProjectionParameters
   m_iDefaultNDet = iDefaultNDet;
   m_iDefaultTrace = iDefaultTrace;
   m_iDefaultGeometry = iDefaultGeometry;
+  m_iDefaultAperture = iDefaultAperture;
 
   pTopSizer->Add (new wxStaticText (this, -1, _T("Projection Parameters")), 0, wxALIGN_CENTER | wxTOP | wxLEFT | wxRIGHT, 5);
 
@@ -671,7 +672,13 @@ DialogGetProjectionParameters::DialogGetProjectionParameters
   m_pRadioBoxGeometry = new StringValueAndTitleRadioBox (this, _T("Geometry"), Scanner::getGeometryCount(), Scanner::getGeometryTitleArray(), Scanner::getGeometryNameArray());
   m_pRadioBoxGeometry->SetSelection (iDefaultGeometry);
 
-  pGridSizer->Add (m_pRadioBoxGeometry, 0, wxALL | wxALIGN_CENTER | wxEXPAND);
+  wxBoxSizer* pScanSizer = new wxBoxSizer (wxVERTICAL);
+  pScanSizer->Add (m_pRadioBoxGeometry, 0, wxALL | wxALIGN_CENTER | wxEXPAND);
+
+  m_pRadioBoxAperture = new StringValueAndTitleRadioBox (this, _T("Detector Aperture"), Scanner::getApertureCount(), Scanner::getApertureTitleArray(), Scanner::getApertureNameArray());
+  m_pRadioBoxAperture->SetSelection (iDefaultAperture);
+  pScanSizer->Add (m_pRadioBoxAperture, 0, wxALL | wxALIGN_CENTER | wxEXPAND);
+  pGridSizer->Add (pScanSizer, 0, wxALL | wxALIGN_CENTER | wxEXPAND);
 
   m_pRadioBoxTrace = new StringValueAndTitleRadioBox (this, _T("Trace Level"), Trace::getTraceCount(), Trace::getTraceTitleArray(), Trace::getTraceNameArray());
   m_pRadioBoxTrace->SetSelection (iDefaultTrace);
@@ -883,6 +890,12 @@ DialogGetProjectionParameters::getGeometry ()
   return m_pRadioBoxGeometry->getSelectionStringValue();
 }
 
+const char*
+DialogGetProjectionParameters::getAperture ()
+{
+  return m_pRadioBoxAperture->getSelectionStringValue();
+}
+
 int
 DialogGetProjectionParameters::getTrace ()
 {
@@ -902,7 +915,8 @@ DialogGetReconstructionParameters::DialogGetReconstructionParameters (wxWindow*
                      int iDefaultYSize, int iDefaultFilterID, double dDefaultHammingParam,
                      int iDefaultFilterMethodID, int iDefaultFilterGenerationID, int iDefaultZeropad,
                      int iDefaultInterpID, int iDefaultInterpParam, int iDefaultBackprojectID, int iTrace,
-                     ReconstructionROI* pDefaultROI)
+                     ReconstructionROI* pDefaultROI, int iDefaultMethodID, int iDefaultIterations,
+                     int iDefaultSubsets, double dDefaultRelaxation)
 : wxDialog (pParent, -1, _T("Reconstruction Parameters"), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxCAPTION)
 {
   wxBoxSizer* pTopSizer = new wxBoxSizer (wxVERTICAL);
@@ -916,8 +930,11 @@ DialogGetReconstructionParameters::DialogGetReconstructionParameters (wxWindow*
   m_dDefaultRoiXMax = pDefaultROI->m_dXMax;
   m_dDefaultRoiYMin = pDefaultROI->m_dYMin;
   m_dDefaultRoiYMax = pDefaultROI->m_dYMax;
+  m_iDefaultIterations = iDefaultIterations;
+  m_iDefaultSubsets = iDefaultSubsets;
+  m_dDefaultRelaxation = dDefaultRelaxation;
 
-  pTopSizer->Add (new wxStaticText (this, -1, _T("Filtered Backprojection Parameters")), 0, wxALIGN_CENTER | wxTOP | wxLEFT | wxRIGHT, 5);
+  pTopSizer->Add (new wxStaticText (this, -1, _T("Reconstruction Parameters")), 0, wxALIGN_CENTER | wxTOP | wxLEFT | wxRIGHT, 5);
   pTopSizer->Add (new wxStaticLine (this, -1, wxDefaultPosition, wxSize(3,3), wxHORIZONTAL), 0, wxEXPAND | wxALL, 5);
 
   wxFlexGridSizer* pGridSizer = NULL;
@@ -926,6 +943,10 @@ DialogGetReconstructionParameters::DialogGetReconstructionParameters (wxWindow*
   else
     pGridSizer = new wxFlexGridSizer (3);
 
+  m_pRadioBoxMethod = new StringValueAndTitleRadioBox (this, _T("Method"), Reconstructor::getMethodCount(), Reconstructor::getMethodTitleArray(), Reconstructor::getMethodNameArray());
+  m_pRadioBoxMethod->SetSelection (iDefaultMethodID);
+  pGridSizer->Add (m_pRadioBoxMethod, 0, wxALL | wxALIGN_LEFT | wxEXPAND);
+
   if (theApp->getAdvancedOptions())
     m_pRadioBoxFilter = new StringValueAndTitleRadioBox (this, _T("Filter"), SignalFilter::getFilterCount(), SignalFilter::getFilterTitleArray(), SignalFilter::getFilterNameArray());
   else
@@ -1000,6 +1021,22 @@ DialogGetReconstructionParameters::DialogGetReconstructionParameters (wxWindow*
     pTextGridSizer->Add (new wxStaticText (this, -1, _T("Zeropad")), 0, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
     pTextGridSizer->Add (m_pTextCtrlZeropad, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL);
   }
+
+  wxString sIterations;
+  sIterations << iDefaultIterations;
+  m_pTextCtrlIterations = new wxTextCtrl (this, -1, sIterations, wxDefaultPosition, wxSize(100, 25), 0);
+  pTextGridSizer->Add (new wxStaticText (this, -1, _T("Iterations")), 0, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+  pTextGridSizer->Add (m_pTextCtrlIterations, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL);
+  wxString sSubsets;
+  sSubsets << iDefaultSubsets;
+  m_pTextCtrlSubsets = new wxTextCtrl (this, -1, sSubsets, wxDefaultPosition, wxSize(100, 25), 0);
+  pTextGridSizer->Add (new wxStaticText (this, -1, _T("Subsets")), 0, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+  pTextGridSizer->Add (m_pTextCtrlSubsets, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL);
+  wxString sRelaxation;
+  sRelaxation << dDefaultRelaxation;
+  m_pTextCtrlRelaxation = new wxTextCtrl (this, -1, sRelaxation, wxDefaultPosition, wxSize(100, 25), 0);
+  pTextGridSizer->Add (new wxStaticText (this, -1, _T("Relaxation")), 0, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+  pTextGridSizer->Add (m_pTextCtrlRelaxation, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL);
   pGridSizer->Add (pTextGridSizer);
 
 #if HAVE_FREQ_PREINTERP
@@ -1126,6 +1163,45 @@ DialogGetReconstructionParameters::getFilterParam ()
     return (m_dDefaultFilterParam);
 }
 
+const char*
+DialogGetReconstructionParameters::getMethodName ()
+{
+  return m_pRadioBoxMethod->getSelectionStringValue();
+}
+
+unsigned int
+DialogGetReconstructionParameters::getIterations ()
+{
+  wxString strCtrl = m_pTextCtrlIterations->GetValue();
+  unsigned long lValue;
+  if (strCtrl.ToULong (&lValue))
+    return lValue;
+  else
+    return (m_iDefaultIterations);
+}
+
+unsigned int
+DialogGetReconstructionParameters::getSubsets ()
+{
+  wxString strCtrl = m_pTextCtrlSubsets->GetValue();
+  unsigned long lValue;
+  if (strCtrl.ToULong (&lValue))
+    return lValue;
+  else
+    return (m_iDefaultSubsets);
+}
+
+double
+DialogGetReconstructionParameters::getRelaxation ()
+{
+  wxString strCtrl = m_pTextCtrlRelaxation->GetValue();
+  double dValue;
+  if (strCtrl.ToDouble (&dValue))
+    return (dValue);
+  else
+    return (m_dDefaultRelaxation);
+}
+
 const char*
 DialogGetReconstructionParameters::getFilterName ()
 {
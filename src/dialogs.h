@@ -199,7 +199,8 @@ class DialogGetProjectionParameters : public wxDialog
     DialogGetProjectionParameters (wxWindow* pParent, int iDefaultNDet = 0,
       int iDefaultNView = 0, int iDefaultOffsetView = 0, int iDefaultNSamples = 1, double dDefaultRotAngle = 1.,
       double dDefaultFocalLength = 1, double dDefaultCenterDetectorLength = 1, double dDefaultViewRatio = 1.,
-      double dDefaultScanRatio = 1., int iDefaultGeometry = Scanner::GEOMETRY_PARALLEL, int iDefaultTrace = Trace::TRACE_NONE);
+      double dDefaultScanRatio = 1., int iDefaultGeometry = Scanner::GEOMETRY_PARALLEL,
+      int iDefaultAperture = Scanner::APERTURE_UNIFORM, int iDefaultTrace = Trace::TRACE_NONE);
     ~DialogGetProjectionParameters ();
 
     unsigned int getNDet ();
@@ -214,6 +215,7 @@ class DialogGetProjectionParameters : public wxDialog
     double getFocalLengthRatio ();
     double getCenterDetectorLengthRatio ();
     const char* getGeometry();
+    const char* getAperture();
 
  private:
     wxTextCtrl* m_pTextCtrlNDet;
@@ -226,6 +228,7 @@ class DialogGetProjectionParameters : public wxDialog
     wxTextCtrl* m_pTextCtrlViewRatio;
     wxTextCtrl* m_pTextCtrlScanRatio;
     StringValueAndTitleRadioBox* m_pRadioBoxGeometry;
+    StringValueAndTitleRadioBox* m_pRadioBoxAperture;
     StringValueAndTitleRadioBox* m_pRadioBoxTrace;
 
     int m_iDefaultNDet;
@@ -234,6 +237,7 @@ class DialogGetProjectionParameters : public wxDialog
     int m_iDefaultNSamples;
     int m_iDefaultTrace;
     int m_iDefaultGeometry;
+    int m_iDefaultAperture;
     double m_dDefaultRotAngle;
     double m_dDefaultFocalLength;
     double m_dDefaultCenterDetectorLength;
@@ -243,6 +247,7 @@ class DialogGetProjectionParameters : public wxDialog
 
 
 #include "backprojectors.h"
+#include "reconstruct.h"
 class DialogGetReconstructionParameters : public wxDialog
 {
  public:
@@ -252,7 +257,9 @@ class DialogGetReconstructionParameters : public wxDialog
       int iDefaultFilterGeneration = ProcessSignal::FILTER_GENERATION_DIRECT,
       int iDefaultZeropad = 3, int iDefaultInterpID = Backprojector::INTERP_LINEAR,
       int iDefaultInterpParam = 1, int iDefaultBackprojectID = Backprojector::BPROJ_IDIFF,
-      int iDefaultTrace = Trace::TRACE_NONE, ReconstructionROI* pROI = NULL);
+      int iDefaultTrace = Trace::TRACE_NONE, ReconstructionROI* pROI = NULL,
+      int iDefaultMethodID = Reconstructor::METHOD_FBP, int iDefaultIterations = 10,
+      int iDefaultSubsets = 10, double dDefaultRelaxation = 1.);
     virtual ~DialogGetReconstructionParameters ();
 
     unsigned int getXSize();
@@ -267,6 +274,10 @@ class DialogGetReconstructionParameters : public wxDialog
     const char* getBackprojectName();
     void getROI (ReconstructionROI* pROI);
     int getTrace ();
+    const char* getMethodName();
+    unsigned int getIterations();
+    unsigned int getSubsets();
+    double getRelaxation();
 
  private:
     wxTextCtrl* m_pTextCtrlXSize;
@@ -278,6 +289,10 @@ class DialogGetReconstructionParameters : public wxDialog
     wxTextCtrl* m_pTextCtrlRoiXMax;
     wxTextCtrl* m_pTextCtrlRoiYMin;
     wxTextCtrl* m_pTextCtrlRoiYMax;
+    wxTextCtrl* m_pTextCtrlIterations;
+    wxTextCtrl* m_pTextCtrlSubsets;
+    wxTextCtrl* m_pTextCtrlRelaxation;
+    StringValueAndTitleRadioBox* m_pRadioBoxMethod;
     StringValueAndTitleRadioBox* m_pRadioBoxFilter;
     StringValueAndTitleRadioBox* m_pRadioBoxFilterMethod;
     StringValueAndTitleRadioBox* m_pRadioBoxFilterGeneration;
@@ -294,6 +309,9 @@ class DialogGetReconstructionParameters : public wxDialog
     double m_dDefaultRoiXMax;
     double m_dDefaultRoiYMin;
     double m_dDefaultRoiYMax;
+    int m_iDefaultIterations;
+    int m_iDefaultSubsets;
+    double m_dDefaultRelaxation;
 };
 
 
@@ -54,12 +54,13 @@ private:
   const double m_dCenterDetectorLength;
   const double m_dViewRatio;
   const double m_dScanRatio;
+  const std::string m_strAperture;
   const wxString m_strLabel;
 
 public:
   ProjectorSupervisorThread(PhantomFileView* pProjView, int iNDet, int iNView, int iOffsetView,
    const char* pszGeometry, int iNSample, double dRotation, double dFocalLength, double dCenterDetectorLength,
-   double dViewRatio, double dScanRatio, wxChar const* strLabel);
+   double dViewRatio, double dScanRatio, const char* pszAperture, wxChar const* strLabel);
 
   virtual wxThread::ExitCode Entry();
 
@@ -86,13 +87,14 @@ private:
   const double m_dCenterDetectorLength;
   const double m_dViewRatio;
   const double m_dScanRatio;
+  const char* const m_pszAperture;
   const wxString m_strLabel;
 
 
 public:
    ProjectorSupervisor (SupervisorThread* pThread, PhantomFileView* pProjView, int iNDet, int iNView,  int iOffsetView,
    const char* pszGeometry, int iNSample, double dRotation, double dFocalLength, double dCenterDetectorLength,
-   double dViewRatio, double dScanRatio, wxChar const* pszLabel);
+   double dViewRatio, double dScanRatio, const char* pszAperture, wxChar const* pszLabel);
 
    virtual BackgroundWorkerThread* createWorker (int iThread, int iStartUnit, int iNumUnits);
 
@@ -242,6 +242,7 @@ EVT_MENU(IFMENU_IMAGE_SUBTRACT, ImageFileView::OnSubtract)
 EVT_MENU(IFMENU_IMAGE_MULTIPLY, ImageFileView::OnMultiply)
 EVT_MENU(IFMENU_IMAGE_DIVIDE, ImageFileView::OnDivide)
 EVT_MENU(IFMENU_IMAGE_SCALESIZE, ImageFileView::OnScaleSize)
+EVT_MENU(IFMENU_IMAGE_PROJECTIONS, ImageFileView::OnProjections)
 #if wxUSE_GLCANVAS
 EVT_MENU(IFMENU_IMAGE_CONVERT3D, ImageFileView::OnConvert3d)
 #endif
@@ -270,7 +271,20 @@ ImageFileView::ImageFileView()
   :  wxView(), m_pBitmap(0), m_pFrame(0), m_pCanvas(0), m_pFileMenu(0),
      m_pFilterMenu(0), m_bMinSpecified(false), m_bMaxSpecified(false),
      m_iDefaultExportFormatID(ImageFile::EXPORT_FORMAT_PNG)
-{}
+{
+  m_iDefaultNDet = 367;
+  m_iDefaultNView = 320;
+  m_iDefaultNSample = 2;
+  m_iDefaultOffsetView = 0;
+  m_dDefaultRotation = 1;
+  m_dDefaultFocalLength = 2;
+  m_dDefaultCenterDetectorLength = 2;
+  m_dDefaultViewRatio = 1;
+  m_dDefaultScanRatio = 1;
+  m_iDefaultGeometry = Scanner::GEOMETRY_PARALLEL;
+  m_iDefaultAperture = Scanner::APERTURE_UNIFORM;
+  m_iDefaultTrace = Trace::TRACE_NONE;
+}
 
 ImageFileView::~ImageFileView()
 {
@@ -934,6 +948,7 @@ ImageFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   m_pFileMenu->Append(wxID_PREVIEW, _T("Print Preview"));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append(MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
+  m_pFileMenu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append (MAINMENU_FILE_PREFERENCES, _T("Prefere&nces..."));
   m_pFileMenu->Append(MAINMENU_FILE_EXIT, _T("E&xit"));
@@ -985,6 +1000,7 @@ ImageFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   image_menu->Append (IFMENU_IMAGE_DIVIDE, _T("&Divide..."));
   image_menu->AppendSeparator();
   image_menu->Append (IFMENU_IMAGE_SCALESIZE, _T("S&cale Size..."));
+  image_menu->Append (IFMENU_IMAGE_PROJECTIONS, _T("&Projections..."));
 #if wxUSE_GLCANVAS
   image_menu->Append (IFMENU_IMAGE_CONVERT3D, _T("Convert &3-D\tCtrl-3"));
 #endif
@@ -1358,6 +1374,94 @@ ImageFileView::OnScaleSize (wxCommandEvent& event)
   }
 }
 
+void
+ImageFileView::OnProjections (wxCommandEvent& event)
+{
+  DialogGetProjectionParameters dialogProjection (getFrameForChild(),
+    m_iDefaultNDet, m_iDefaultNView, m_iDefaultOffsetView, m_iDefaultNSample, m_dDefaultRotation,
+    m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, m_dDefaultScanRatio,
+    m_iDefaultGeometry, m_iDefaultAperture, m_iDefaultTrace);
+  if (dialogProjection.ShowModal() != wxID_OK)
+    return;
+
+  m_iDefaultNDet = dialogProjection.getNDet();
+  m_iDefaultNView = dialogProjection.getNView();
+  m_iDefaultOffsetView = dialogProjection.getOffsetView();
+  m_iDefaultNSample = dialogProjection.getNSamples();
+  m_iDefaultTrace = dialogProjection.getTrace();
+  m_dDefaultRotation = dialogProjection.getRotAngle();
+  m_dDefaultFocalLength = dialogProjection.getFocalLengthRatio();
+  m_dDefaultCenterDetectorLength = dialogProjection.getCenterDetectorLengthRatio();
+  m_dDefaultViewRatio = dialogProjection.getViewRatio();
+  m_dDefaultScanRatio = dialogProjection.getScanRatio();
+  wxString sGeometry (dialogProjection.getGeometry(), wxConvUTF8);
+  m_iDefaultGeometry = Scanner::convertGeometryNameToID (sGeometry.mb_str(wxConvUTF8));
+  double dRotationRadians = m_dDefaultRotation;
+  m_dDefaultRotation /= TWOPI;  // convert back to fraction of a circle
+
+  if (m_iDefaultNDet <= 0 || m_iDefaultNView <= 0 || sGeometry == _T(""))
+    return;
+
+  // Pixel projection has no exact strip integral, so the aperture choice is not used
+  const ImageFile& rIF = GetDocument()->getImageFile();
+  Scanner theScanner (rIF, sGeometry.mb_str(wxConvUTF8), m_iDefaultNDet, m_iDefaultNView, m_iDefaultOffsetView, m_iDefaultNSample,
+    dRotationRadians, m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, m_dDefaultScanRatio);
+  if (theScanner.fail()) {
+    wxString msg = _T("Failed making scanner\n");
+    msg += wxConvUTF8.cMB2WX(theScanner.failMessage().c_str());
+    *theApp->getLog() << msg << _T("\n");
+    wxMessageBox (msg, _T("Error"));
+    return;
+  }
+
+  std::ostringstream os;
+  os << "Projections for " << m_pFrame->GetTitle().mb_str(wxConvUTF8)
+     << ": nDet=" << m_iDefaultNDet
+     << ", nView=" << m_iDefaultNView
+     << ", gantry offset=" << m_iDefaultOffsetView
+     << ", nSamples=" << m_iDefaultNSample
+     << ", RotAngle=" << m_dDefaultRotation
+     << ", FocalLengthRatio=" << m_dDefaultFocalLength
+     << ", CenterDetectorLengthRatio=" << m_dDefaultCenterDetectorLength
+     << ", ViewRatio=" << m_dDefaultViewRatio
+     << ", ScanRatio=" << m_dDefaultScanRatio
+     << ", Geometry=" << sGeometry.mb_str(wxConvUTF8)
+     << ", FanBeamAngle=" << convertRadiansToDegrees (theScanner.fanBeamAngle());
+
+  Timer timer;
+  Projections* pProj = new Projections;
+  pProj->initFromScanner (theScanner);
+  const int iNumThreads = WorkerThreads::getNumberOfProcessors();
+  const int iViewsPerUpdate = imax (ITER_PER_UPDATE, iNumThreads);
+  wxProgressDialog dlgProgress (_T("Projection"), _T("Projection Progress"), pProj->nView() + 1, getFrameForChild(), wxPD_CAN_ABORT );
+  for (int i = 0; i < pProj->nView(); i += iViewsPerUpdate) {
+    const int iNumViews = std::min (iViewsPerUpdate, pProj->nView() - i);
+    theScanner.collectProjections (*pProj, rIF, i, iNumViews, theScanner.offsetView(), i, iNumThreads, m_iDefaultTrace);
+    if (! dlgProgress.Update (i + iNumViews)) {
+      delete pProj;
+      return;
+    }
+  }
+
+  *theApp->getLog() << wxConvUTF8.cMB2WX(os.str().c_str()) << _T("\n");
+  pProj->setRemark (os.str());
+  pProj->setCalcTime (timer.timerEnd());
+
+  ProjectionFileDocument* pProjectionDoc = theApp->newProjectionDoc();
+  if (! pProjectionDoc) {
+    sys_error (ERR_SEVERE, "Unable to create projection document");
+    delete pProj;
+    return;
+  }
+  pProjectionDoc->setProjections (pProj);
+  if (theApp->getAskDeleteNewDocs())
+    pProjectionDoc->Modify (true);
+  OnUpdate(this, NULL);
+  pProjectionDoc->UpdateAllViews (this);
+  pProjectionDoc->getView()->setInitialClientSize();
+  pProjectionDoc->Activate();
+}
+
 #if wxUSE_GLCANVAS
 void
 ImageFileView::OnConvert3d (wxCommandEvent& event)
@@ -2043,6 +2147,7 @@ BEGIN_EVENT_TABLE(PhantomFileView, wxView)
 EVT_MENU(PHMMENU_FILE_PROPERTIES, PhantomFileView::OnProperties)
 EVT_MENU(PHMMENU_PROCESS_RASTERIZE, PhantomFileView::OnRasterize)
 EVT_MENU(PHMMENU_PROCESS_PROJECTIONS, PhantomFileView::OnProjections)
+EVT_MENU(PHMMENU_PROCESS_PROJECTIONS_TO_FILE, PhantomFileView::OnProjections)
 END_EVENT_TABLE()
 
 PhantomFileView::PhantomFileView()
@@ -2064,6 +2169,7 @@ PhantomFileView::PhantomFileView()
   m_dDefaultViewRatio = 1;
   m_dDefaultScanRatio = 1;
   m_iDefaultGeometry = Scanner::GEOMETRY_PARALLEL;
+  m_iDefaultAperture = Scanner::APERTURE_UNIFORM;
   m_iDefaultTrace = Trace::TRACE_NONE;
 
 #ifdef DEBUG
@@ -2108,7 +2214,7 @@ PhantomFileView::OnProjections (wxCommandEvent& event)
   DialogGetProjectionParameters dialogProjection (getFrameForChild(),
     m_iDefaultNDet, m_iDefaultNView, m_iDefaultOffsetView, m_iDefaultNSample, m_dDefaultRotation,
     m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, m_dDefaultScanRatio,
-    m_iDefaultGeometry, m_iDefaultTrace);
+    m_iDefaultGeometry, m_iDefaultAperture, m_iDefaultTrace);
   int retVal = dialogProjection.ShowModal();
   if (retVal != wxID_OK)
     return;
@@ -2125,6 +2231,8 @@ PhantomFileView::OnProjections (wxCommandEvent& event)
   m_dDefaultScanRatio = dialogProjection.getScanRatio();
   wxString sGeometry (dialogProjection.getGeometry(), wxConvUTF8);
   m_iDefaultGeometry = Scanner::convertGeometryNameToID (sGeometry.mb_str(wxConvUTF8));
+  wxString sAperture (dialogProjection.getAperture(), wxConvUTF8);
+  m_iDefaultAperture = Scanner::convertApertureNameToID (sAperture.mb_str(wxConvUTF8));
   double dRotationRadians = m_dDefaultRotation;
   m_dDefaultRotation /= TWOPI;  // convert back to fraction of a circle
 
@@ -2133,7 +2241,8 @@ PhantomFileView::OnProjections (wxCommandEvent& event)
 
   const Phantom& rPhantom = GetDocument()->getPhantom();
   Scanner theScanner (rPhantom, sGeometry.mb_str(wxConvUTF8), m_iDefaultNDet, m_iDefaultNView, m_iDefaultOffsetView, m_iDefaultNSample,
-    dRotationRadians, m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, m_dDefaultScanRatio);
+    dRotationRadians, m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, m_dDefaultScanRatio,
+    sAperture.mb_str(wxConvUTF8));
   if (theScanner.fail()) {
     wxString msg = _T("Failed making scanner\n");
     msg += wxConvUTF8.cMB2WX(theScanner.failMessage().c_str());
@@ -2154,8 +2263,44 @@ PhantomFileView::OnProjections (wxCommandEvent& event)
      << ", ViewRatio=" << m_dDefaultViewRatio
      << ", ScanRatio=" << m_dDefaultScanRatio
      << ", Geometry=" << sGeometry.mb_str(wxConvUTF8)
+     << ", Aperture=" << sAperture.mb_str(wxConvUTF8)
      << ", FanBeamAngle=" << convertRadiansToDegrees (theScanner.fanBeamAngle());
 
+  // Views of large scans are written to a file in the background as they
+  // are collected rather than being held in a new document
+  if (event.GetId() == PHMMENU_PROCESS_PROJECTIONS_TO_FILE) {
+#if WXWIN_COMPATIBILITY_2_4
+    const wxString& strFilename = wxFileSelector (_T("Projections Filename"), _T(""),
+      _T(""), _T(".pj"), _T("Projections (*.pj)|*.pj"), wxOVERWRITE_PROMPT | wxHIDE_READONLY | wxSAVE);
+#else
+    const wxString& strFilename = wxFileSelector (_T("Projections Filename"), _T(""),
+      _T(""), _T(".pj"), _T("Projections (*.pj)|*.pj"), wxOVERWRITE_PROMPT | wxSAVE);
+#endif
+    if (strFilename.IsEmpty())
+      return;
+
+    Timer timer;
+    ProjectionsWriter writer (theScanner);
+    writer.getHeader().setRemark (os.str());
+    if (! writer.open (strFilename.mb_str(wxConvUTF8)))
+      return;
+    wxProgressDialog dlgProgress (_T("Projection"), _T("Projection Progress"), m_iDefaultNView + 1, getFrameForChild(), wxPD_CAN_ABORT);
+    for (int iView = 0; iView < m_iDefaultNView; iView += writer.nChunkViews()) {
+      const int nViews = std::min (writer.nChunkViews(), m_iDefaultNView - iView);
+      theScanner.collectProjections (writer.getChunk(), rPhantom, iView, nViews, theScanner.offsetView(), 0, Trace::TRACE_NONE);
+      if (! writer.writeChunk (nViews))
+        break;
+      if (! dlgProgress.Update (iView + nViews)) {
+        writer.close (timer.timerEnd());
+        ::wxRemoveFile (strFilename);
+        return;
+      }
+    }
+    if (writer.close (timer.timerEnd()))
+      *theApp->getLog() << wxConvUTF8.cMB2WX(os.str().c_str()) << _T("\nWrote ") << strFilename << _T("\n");
+    return;
+  }
+
   Timer timer;
   Projections* pProj = NULL;
   if (m_iDefaultTrace > Trace::TRACE_CONSOLE) {
@@ -2182,7 +2327,7 @@ PhantomFileView::OnProjections (wxCommandEvent& event)
         (this, m_iDefaultNDet, m_iDefaultNView, m_iDefaultOffsetView, 
          sGeometry.mb_str(wxConvUTF8), m_iDefaultNSample, dRotationRadians,
          m_dDefaultFocalLength, m_dDefaultCenterDetectorLength, m_dDefaultViewRatio, 
-         m_dDefaultScanRatio, wxConvUTF8.cMB2WX(os.str().c_str()));
+         m_dDefaultScanRatio, sAperture.mb_str(wxConvUTF8), wxConvUTF8.cMB2WX(os.str().c_str()));
       if (pProjector->Create() != wxTHREAD_NO_ERROR) {
         sys_error (ERR_SEVERE, "Error creating projector thread");
         delete pProjector;
@@ -2346,6 +2491,7 @@ PhantomFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   m_pFileMenu->Append(wxID_PREVIEW, _T("Print Pre&view"));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append(MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
+  m_pFileMenu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append (MAINMENU_FILE_PREFERENCES, _T("Prefere&nces..."));
   m_pFileMenu->Append(MAINMENU_FILE_EXIT, _T("E&xit"));
@@ -2355,6 +2501,7 @@ PhantomFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   wxMenu *process_menu = new wxMenu;
   process_menu->Append(PHMMENU_PROCESS_RASTERIZE, _T("&Rasterize...\tCtrl-R"));
   process_menu->Append(PHMMENU_PROCESS_PROJECTIONS, _T("&Projections...\tCtrl-J"));
+  process_menu->Append(PHMMENU_PROCESS_PROJECTIONS_TO_FILE, _T("Projections to &File..."));
 
   wxMenu *help_menu = new wxMenu;
   help_menu->Append(MAINMENU_HELP_CONTENTS, _T("&Contents\tF1"));
@@ -2534,6 +2681,10 @@ ProjectionFileView::ProjectionFileView()
   m_iDefaultInterpolation = Backprojector::INTERP_LINEAR;
   m_iDefaultInterpParam = 1;
   m_iDefaultTrace = Trace::TRACE_NONE;
+  m_iDefaultReconMethod = Reconstructor::METHOD_FBP;
+  m_iDefaultIterations = 10;
+  m_iDefaultSubsets = 10;
+  m_dDefaultRelaxation = 1.;
 
   m_iDefaultPolarNX = 256;
   m_iDefaultPolarNY = 256;
@@ -2896,7 +3047,8 @@ ProjectionFileView::doReconstructFBP (const Projections& rProj, bool bRebinToPar
   DialogGetReconstructionParameters dialogReconstruction (getFrameForChild(), m_iDefaultNX, m_iDefaultNY,
     m_iDefaultFilter, m_dDefaultFilterParam, m_iDefaultFilterMethod, m_iDefaultFilterGeneration,
     m_iDefaultZeropad, m_iDefaultInterpolation, m_iDefaultInterpParam, m_iDefaultBackprojector,
-    m_iDefaultTrace,  &defaultROI);
+    m_iDefaultTrace,  &defaultROI, m_iDefaultReconMethod, m_iDefaultIterations, m_iDefaultSubsets,
+    m_dDefaultRelaxation);
 
   int retVal = dialogReconstruction.ShowModal();
   if (retVal != wxID_OK)
@@ -2919,10 +3071,20 @@ ProjectionFileView::doReconstructFBP (const Projections& rProj, bool bRebinToPar
   m_iDefaultBackprojector = Backprojector::convertBackprojectNameToID (optBackprojectName.mb_str(wxConvUTF8));
   m_iDefaultTrace = dialogReconstruction.getTrace();
   dialogReconstruction.getROI (&defaultROI);
+  wxString optMethodName (dialogReconstruction.getMethodName(), wxConvUTF8);
+  m_iDefaultReconMethod = Reconstructor::convertMethodNameToID (optMethodName.mb_str(wxConvUTF8));
+  m_iDefaultIterations = dialogReconstruction.getIterations();
+  m_iDefaultSubsets = dialogReconstruction.getSubsets();
+  m_dDefaultRelaxation = dialogReconstruction.getRelaxation();
 
   if (m_iDefaultNX <= 0 && m_iDefaultNY <= 0)
     return;
 
+  if (m_iDefaultReconMethod != Reconstructor::METHOD_FBP) {
+    doReconstructIterative (rProj, bRebinToParallel);
+    return;
+  }
+
   std::ostringstream os;
   os << "Reconstruct " << rProj.getFilename() << ": xSize=" << m_iDefaultNX << ", ySize=" << m_iDefaultNY << ", Filter=" << optFilterName.mb_str(wxConvUTF8) << ", FilterParam=" << m_dDefaultFilterParam << ", FilterMethod=" << optFilterMethodName.mb_str(wxConvUTF8) << ", FilterGeneration=" << optFilterGenerationName.mb_str(wxConvUTF8) << ", Zeropad=" << m_iDefaultZeropad << ", Interpolation=" << optInterpName.mb_str(wxConvUTF8) << ", InterpolationParam=" << m_iDefaultInterpParam << ", Backprojection=" << optBackprojectName.mb_str(wxConvUTF8);
   if (bRebinToParallel)
@@ -3013,6 +3175,74 @@ ProjectionFileView::doReconstructFBP (const Projections& rProj, bool bRebinToPar
 }
 
 
+void
+ProjectionFileView::doReconstructIterative (const Projections& rProj, bool bRebinToParallel)
+{
+  const char* pszMethodName = Reconstructor::convertMethodIDToName (m_iDefaultReconMethod);
+  std::ostringstream os;
+  os << "Reconstruct " << rProj.getFilename() << ": xSize=" << m_iDefaultNX << ", ySize=" << m_iDefaultNY
+     << ", Method=" << pszMethodName << ", Iterations=" << m_iDefaultIterations
+     << ", Subsets=" << m_iDefaultSubsets << ", Relaxation=" << m_dDefaultRelaxation;
+  if (bRebinToParallel)
+    os << "; Interpolate to Parallel";
+
+  Timer timerRecon;
+  const Projections* pProj = bRebinToParallel ? rProj.interpolateToParallel() : &rProj;
+  ImageFile* pImageFile = new ImageFile (m_iDefaultNX, m_iDefaultNY);
+  IterativeReconstructor* pReconstructor = new IterativeReconstructor (*pProj, *pImageFile, pszMethodName,
+    m_iDefaultSubsets, m_dDefaultRelaxation, WorkerThreads::getNumberOfProcessors());
+  if (pReconstructor->fail()) {
+    wxString msg = _T("Failed making iterative reconstructor\n");
+    msg += wxConvUTF8.cMB2WX(pReconstructor->failMessage().c_str());
+    *theApp->getLog() << msg << _T("\n");
+    wxMessageBox (msg, _T("Error"));
+    delete pReconstructor;
+    delete pImageFile;
+    if (bRebinToParallel)
+      delete pProj;
+    return;
+  }
+
+  wxProgressDialog dlgProgress (_T("Reconstruction"), _T("Reconstruction Progress"), m_iDefaultIterations + 1, getFrameForChild(), wxPD_CAN_ABORT );
+  bool bCancelled = false;
+  for (int iIteration = 0; iIteration < m_iDefaultIterations; iIteration++) {
+    pReconstructor->reconstructIteration();
+    std::ostringstream osIteration;
+    osIteration << "Iteration " << iIteration + 1 << ": residual=" << pReconstructor->getIterationResidual (iIteration)
+                << ", time=" << pReconstructor->getIterationTime (iIteration) << " seconds";
+    *theApp->getLog() << wxConvUTF8.cMB2WX(osIteration.str().c_str()) << _T("\n");
+    if (! dlgProgress.Update (iIteration + 1)) {
+      bCancelled = true;
+      break;
+    }
+  }
+  delete pReconstructor;
+  if (bRebinToParallel)
+    delete pProj;
+  if (bCancelled) {
+    delete pImageFile;
+    return;
+  }
+
+  ImageFileDocument* pReconDoc = theApp->newImageDoc();
+  if (! pReconDoc) {
+    sys_error (ERR_SEVERE, "Unable to create image file");
+    delete pImageFile;
+    return;
+  }
+  *theApp->getLog() << wxConvUTF8.cMB2WX(os.str().c_str()) << _T("\n");
+  pImageFile->labelAdd (rProj.getLabel());
+  pImageFile->labelAdd (os.str().c_str(), timerRecon.timerEnd());
+
+  pReconDoc->setImageFile (pImageFile);
+  if (theApp->getAskDeleteNewDocs())
+    pReconDoc->Modify (true);
+  pReconDoc->UpdateAllViews();
+  pReconDoc->getView()->setInitialClientSize();
+  pReconDoc->Activate();
+}
+
+
 void
 ProjectionFileView::OnArtifactReduction (wxCommandEvent& event)
 {
@@ -3067,6 +3297,7 @@ ProjectionFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   m_pFileMenu->Append(wxID_PREVIEW, _T("Print Pre&view"));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append(MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
+  m_pFileMenu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append (MAINMENU_FILE_PREFERENCES, _T("Prefere&nces..."));
   m_pFileMenu->Append(MAINMENU_FILE_EXIT, _T("E&xit"));
@@ -3428,6 +3659,7 @@ PlotFileView::CreateChildFrame(wxDocument *doc, wxView *view)
   m_pFileMenu->Append(wxID_PREVIEW, _T("Print Pre&view"));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append(MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
+  m_pFileMenu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append (MAINMENU_FILE_PREFERENCES, _T("Prefere&nces..."));
   m_pFileMenu->Append(MAINMENU_FILE_EXIT, _T("E&xit"));
@@ -3688,6 +3920,7 @@ TextFileView::CreateChildFrame (wxDocument *doc, wxView *view)
   m_pFileMenu->Append(wxID_PREVIEW, _T("Print Pre&view"));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append(MAINMENU_IMPORT, _T("&Import...\tCtrl-M"));
+  m_pFileMenu->Append(MAINMENU_FILE_OPEN_VOLUME, _T("Open &Volume Entry..."));
   m_pFileMenu->AppendSeparator();
   m_pFileMenu->Append (MAINMENU_FILE_PREFERENCES, _T("Prefere&nces..."));
   m_pFileMenu->Append(MAINMENU_FILE_EXIT, _T("E&xit"));
@@ -65,6 +65,19 @@ private:
 
   int m_iDefaultExportFormatID;
 
+  int m_iDefaultNDet;
+  int m_iDefaultNView;
+  int m_iDefaultOffsetView;
+  int m_iDefaultNSample;
+  int m_iDefaultGeometry;
+  int m_iDefaultAperture;
+  int m_iDefaultTrace;
+  double m_dDefaultRotation;
+  double m_dDefaultFocalLength;
+  double m_dDefaultCenterDetectorLength;
+  double m_dDefaultViewRatio;
+  double m_dDefaultScanRatio;
+
   wxFrame* getFrameForChild()
 #if CTSIM_MDI
   { return theApp->getMainFrame(); }
@@ -96,6 +109,7 @@ public:
 
   void OnCompare (wxCommandEvent& event);
   void OnScaleSize (wxCommandEvent& event);
+  void OnProjections (wxCommandEvent& event);
   void OnInvertValues (wxCommandEvent& event);
   void OnSquare (wxCommandEvent& event);
   void OnSquareRoot (wxCommandEvent& event);
@@ -215,6 +229,10 @@ private:
   int m_iDefaultInterpolation;
   int m_iDefaultInterpParam;
   int m_iDefaultBackprojector;
+  int m_iDefaultReconMethod;
+  int m_iDefaultIterations;
+  int m_iDefaultSubsets;
+  double m_dDefaultRelaxation;
   int m_iDefaultTrace;
 
   int m_iDefaultPolarNX;
@@ -252,6 +270,7 @@ public:
   void OnArtifactReduction (wxCommandEvent& event);
 
   void doReconstructFBP (const Projections& rProj, bool bRebinToParallel);
+  void doReconstructIterative (const Projections& rProj, bool bRebinToParallel);
 
 #if CTSIM_MDI
   wxDocMDIChildFrame* getFrame() { return m_pFrame; }
@@ -309,6 +328,7 @@ private:
   int m_iDefaultOffsetView;
   int m_iDefaultNSample;
   int m_iDefaultGeometry;
+  int m_iDefaultAperture;
   int m_iDefaultTrace;
   double m_dDefaultRotation;
   double m_dDefaultFocalLength;
@@ -52,6 +52,7 @@ extern int if1_main (int argc, char* const argv[]);
 extern int if2_main (int argc, char* const argv[]);
 extern int ifexport_main (int argc, char* const argv[]);
 extern int ifinfo_main (int argc, char* const argv[]);
+extern int if2pj_main (int argc, char* const argv[]);
 extern int phm2if_main (int argc, char* const argv[]);
 extern int phm2pj_main (int argc, char* const argv[]);
 extern int phm2helix_main (int argc, char* const argv[]);
@@ -78,6 +79,7 @@ ctsimtext_usage (const char *program)
   std::cout << "  if2           Dual image file conversions\n";
   std::cout << "  ifexport      Export an imagefile to a graphics file\n";
   std::cout << "  ifinfo        Image file information\n";
+  std::cout << "  if2pj         Take projections of an imagefile\n";
   std::cout << "  pj2if         Convert an projection file into an imagefile\n";
   std::cout << "  pjinfo        Projection file information\n";
   std::cout << "  pjrec         Projection reconstruction\n";
@@ -97,6 +99,7 @@ interactive_usage ()
   std::cout << "  ifinfo        Image file information\n";
   std::cout << "  if1           Single image file conversion\n";
   std::cout << "  if2           Dual image file conversions\n";
+  std::cout << "  if2pj         Take projections of an imagefile\n";
   std::cout << "  phm2if        Convert a geometric phantom into an imagefile\n";
   std::cout << "  phm2pj        Take projections of a phantom object\n";
   std::cout << "  phm2helix     Take projections of a phantom object\n";
@@ -253,6 +256,8 @@ processCommand (int argc, char* const argv[])
       return ifexport_main (argc, argv);
     else if (strcasecmp (pszFunction, "ifinfo") == 0)
       return ifinfo_main (argc, argv);
+    else if (strcasecmp (pszFunction, "if2pj") == 0)
+      return if2pj_main (argc, argv);
     else if (strcasecmp (pszFunction, "phm2if") == 0)
       return phm2if_main (argc, argv);
     else if (strcasecmp (pszFunction, "phm2pj") == 0)
@@ -131,7 +131,7 @@ if1_main (int argc, char *const argv[])
 
   if (opt_invert || opt_log || opt_exp || opt_sqr || opt_sqrt) {
     ImageFile im_in;
-    im_in.fileRead (in_file);
+    im_in.fileReadMapped (in_file);
     int nx = im_in.nx();
     int ny = im_in.ny();
     ImageFile im_out (nx, ny);
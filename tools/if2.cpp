@@ -167,7 +167,7 @@ if2_main (int argc, char *const argv[])
   ImageFile& im_in1 = *pim_in1;
   ImageFile& im_in2 = *pim_in2;
 
-  if (! im_in1.fileRead(in_file1) || ! im_in2.fileRead(in_file2)) {
+  if (! im_in1.fileReadMapped (in_file1.c_str()) || ! im_in2.fileReadMapped (in_file2.c_str())) {
     sys_error (ERR_WARNING, "Error reading an image");
     return (1);
   }
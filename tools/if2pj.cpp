@@ -0,0 +1,392 @@
+/*****************************************************************************
+** FILE IDENTIFICATION
+**
+**   Name:          if2pj.cpp
+**   Purpose:       Take projections of an imagefile
+**   Programmer:    Kevin Rosenberg
+**   Date Started:  October 2026
+**
+**  This is part of the CTSim program
+**  Copyright (C) 1983-2009 Kevin Rosenberg
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License (version 2) as
+**  published by the Free Software Foundation.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+******************************************************************************/
+
+#include "ct.h"
+#include "timer.h"
+
+
+enum { O_DESC, O_NRAY, O_ROTANGLE, O_GEOMETRY, O_FOCAL_LENGTH, O_CENTER_DETECTOR_LENGTH,
+O_VIEW_RATIO, O_SCAN_RATIO, O_OFFSETVIEW, O_THREADS, O_SYSTEM_MATRIX, O_MATRIX_CACHE,
+O_MATRIX_LIMIT, O_VERBOSE, O_HELP, O_VERSION };
+
+static struct option if2pj_options[] =
+{
+  {"desc", 1, 0, O_DESC},
+  {"nray", 1, 0, O_NRAY},
+  {"rotangle", 1, 0, O_ROTANGLE},
+  {"geometry", 1, 0, O_GEOMETRY},
+  {"focal-length", 1, 0, O_FOCAL_LENGTH},
+  {"center-detector-length", 1, 0, O_CENTER_DETECTOR_LENGTH},
+  {"offsetview", 1, 0, O_OFFSETVIEW},
+  {"view-ratio", 1, 0, O_VIEW_RATIO},
+  {"scan-ratio", 1, 0, O_SCAN_RATIO},
+  {"threads", 1, 0, O_THREADS},
+  {"system-matrix", 0, 0, O_SYSTEM_MATRIX},
+  {"matrix-cache", 1, 0, O_MATRIX_CACHE},
+  {"matrix-limit", 1, 0, O_MATRIX_LIMIT},
+  {"verbose", 0, 0, O_VERBOSE},
+  {"help", 0, 0, O_HELP},
+  {"version", 0, 0, O_VERSION},
+  {0, 0, 0, 0}
+};
+
+static const char* g_szIdStr = "$Id$";
+
+
+void
+if2pj_usage (const char *program)
+{
+  std::cout << "usage: " << fileBasename(program) << " infile outfile ndet nview [OPTIONS]\n";
+  std::cout << "Calculate (projections) through a pixelized phantom in an imagefile\n\n";
+  std::cout << "     infile           Name of input imagefile\n";
+  std::cout << "     outfile          Name of output file for projections\n";
+  std::cout << "     ndet             Number of detectors\n";
+  std::cout << "     nview            Number of rotated views\n";
+  std::cout << "     --desc           Description of raysum\n";
+  std::cout << "     --nray           Number of rays per detector (default = 1)\n";
+  std::cout << "     --rotangle       Angle to rotate view through (fraction of a circle)\n";
+  std::cout << "                      (default = select appropriate for geometry)\n";
+  std::cout << "     --geometry       Geometry of scanning\n";
+  std::cout << "        parallel      Parallel scan beams (default)\n";
+  std::cout << "        equilinear    Equilinear divergent scan beams\n";
+  std::cout << "        equiangular   Equiangular divergent scan beams\n";
+  std::cout << "     --focal-length   Focal length ratio (ratio to radius of phantom)\n";
+  std::cout << "                      (default = 2)\n";
+  std::cout << "     --center-detector-length  Distance from center of phantom to detector array\n";
+  std::cout << "                      (ratio to radius of phantom) (default = 2)\n";
+  std::cout << "     --view-ratio     Length to view (view diameter to phantom diameter)\n";
+  std::cout << "                      (default = 1)\n";
+  std::cout << "     --scan-ratio     Length to scan (scan diameter to view diameter)\n";
+  std::cout << "                      (default = 1)\n";
+  std::cout << "     --offsetview     Intial gantry offset in 'views' (default = 0)\n";
+  std::cout << "     --threads        Number of projecting threads, 0 for all processors (default = 1)\n";
+  std::cout << "     --system-matrix  Project with the precomputed sparse system matrix\n";
+  std::cout << "                      (central ray of each detector, requires --nray 1)\n";
+  std::cout << "     --matrix-cache   Directory to keep system matrices between runs\n";
+  std::cout << "     --matrix-limit   Largest system matrix to build in megabytes, 0 for no limit\n";
+  std::cout << "                      (default = 1024)\n";
+  std::cout << "     --verbose        Verbose mode\n";
+  std::cout << "     --version        Print version\n";
+  std::cout << "     --help           Print this help message\n";
+}
+
+
+// NAME
+//   projectWithSystemMatrix    Projections as one sparse matrix product
+//
+// NOTES
+//   Rotation is about the image center as with the Scanner, so the matrix is
+//   built for the image's extent moved to the origin.
+
+static bool
+projectWithSystemMatrix (Projections& proj, const ImageFile& im, int iOffsetView, int nThreads, bool bVerbose)
+{
+  const int nx = im.nx();
+  const int ny = im.ny();
+  double xmin, xmax, ymin, ymax;
+  if (! im.getAxisExtent (xmin, xmax, ymin, ymax)) {
+    xmin = -static_cast<double>(nx) / 2;
+    xmax = static_cast<double>(nx) / 2;
+    ymin = -static_cast<double>(ny) / 2;
+    ymax = static_cast<double>(ny) / 2;
+  }
+  for (int iView = 0; iView < proj.nView(); iView++)
+    proj.getDetectorArray (iView).setViewAngle ((iView + iOffsetView) * proj.rotInc());
+
+  Timer timerMatrix;
+  const double dHalfWidth = (xmax - xmin) / 2;
+  const double dHalfHeight = (ymax - ymin) / 2;
+  SystemMatrix matrix (proj, nx, ny, -dHalfWidth, dHalfWidth, -dHalfHeight, dHalfHeight, nThreads);
+  if (matrix.fail()) {
+    std::cerr << matrix.failMessage() << std::endl;
+    return false;
+  }
+  if (bVerbose)
+    std::cout << "System matrix: " << matrix.nNonZero() << " entries, " << matrix.sizeMB() << " MB, "
+              << (matrix.fromCache() ? "read from cache" : "built") << " in " << timerMatrix.timerEnd() << " seconds\n";
+
+  std::vector<double> vecImage (nx * ny);
+  ImageFileArrayConst v = im.getArray();
+  for (int ix = 0; ix < nx; ix++)
+    for (int iy = 0; iy < ny; iy++)
+      vecImage[ix * ny + iy] = v[ix][iy];
+
+  const int nDet = proj.nDet();
+  std::vector<double> vecRaysums (matrix.nRows());
+  matrix.multiply (&vecImage[0], &vecRaysums[0], nThreads);
+  for (int iView = 0; iView < proj.nView(); iView++) {
+    DetectorValue* detval = proj.getDetectorArray (iView).detValues();
+    for (int iDet = 0; iDet < nDet; iDet++)
+      detval[iDet] = vecRaysums[iView * nDet + iDet];
+  }
+
+  return true;
+}
+
+
+int
+if2pj_main (int argc, char* const argv[])
+{
+  std::string optGeometryName = Scanner::convertGeometryIDToName(Scanner::GEOMETRY_PARALLEL);
+  char *opt_infile = NULL;
+  char *opt_outfile = NULL;
+  std::string opt_desc;
+  int opt_ndet;
+  int opt_nview;
+  int opt_offsetview = 0;
+  int opt_nray = 1;
+  int opt_threads = 1;
+  bool bOptSystemMatrix = false;
+  double dOptFocalLength = 2.;
+  double dOptCenterDetectorLength = 2.;
+  double dOptViewRatio = 1.;
+  double dOptScanRatio = 1.;
+  int opt_verbose = 0;
+  double opt_rotangle = -1;
+  char* endptr = NULL;
+  char* endstr;
+
+  Timer timerProgram;
+
+  while (1) {
+    int c = getopt_long(argc, argv, "", if2pj_options, NULL);
+
+    if (c == -1)
+      break;
+
+    switch (c) {
+    case O_VERBOSE:
+      opt_verbose = 1;
+      break;
+    case O_DESC:
+      opt_desc = optarg;
+      break;
+    case O_ROTANGLE:
+      opt_rotangle = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --rotangle to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_GEOMETRY:
+      optGeometryName = optarg;
+      break;
+    case O_FOCAL_LENGTH:
+      dOptFocalLength = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --focal-length to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_CENTER_DETECTOR_LENGTH:
+      dOptCenterDetectorLength = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --center-detector-length to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_VIEW_RATIO:
+      dOptViewRatio = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --view-ratio to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_SCAN_RATIO:
+      dOptScanRatio = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --scan-ratio to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_NRAY:
+      opt_nray = strtol(optarg, &endptr, 10);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --nray to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_OFFSETVIEW:
+      opt_offsetview = strtol(optarg, &endptr, 10);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr) {
+        std::cerr << "Error setting --offsetview to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_THREADS:
+      opt_threads = strtol(optarg, &endptr, 10);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr || opt_threads < 0) {
+        std::cerr << "Error setting --threads to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      break;
+    case O_SYSTEM_MATRIX:
+      bOptSystemMatrix = true;
+      break;
+    case O_MATRIX_CACHE:
+      SystemMatrix::setDefaultCacheDirectory (optarg);
+      bOptSystemMatrix = true;
+      break;
+    case O_MATRIX_LIMIT: {
+      double dLimit = strtod(optarg, &endptr);
+      endstr = optarg + strlen(optarg);
+      if (endptr != endstr || dLimit < 0) {
+        std::cerr << "Error setting --matrix-limit to " << optarg << std::endl;
+        if2pj_usage(argv[0]);
+        return (1);
+      }
+      SystemMatrix::setDefaultMemoryLimitMB (dLimit);
+      break;
+    }
+    case O_VERSION:
+#ifdef VERSION
+      std::cout << "Version: " << VERSION << std::endl << g_szIdStr << std::endl;
+#else
+      std::cout << "Unknown version number\n";
+#endif
+      return (0);
+    case O_HELP:
+    case '?':
+      if2pj_usage(argv[0]);
+      return (0);
+    default:
+      if2pj_usage(argv[0]);
+      return (1);
+    }
+  }
+
+  if (optind + 4 != argc) {
+    if2pj_usage(argv[0]);
+    return (1);
+  }
+
+  opt_infile = argv[optind];
+  opt_outfile = argv[optind+1];
+  opt_ndet = strtol(argv[optind+2], &endptr, 10);
+  endstr = argv[optind+2] + strlen(argv[optind+2]);
+  if (endptr != endstr) {
+    std::cerr << "Error setting --ndet to " << argv[optind+2] << std::endl;
+    if2pj_usage(argv[0]);
+    return (1);
+  }
+  opt_nview = strtol(argv[optind+3], &endptr, 10);
+  endstr = argv[optind+3] + strlen(argv[optind+3]);
+  if (endptr != endstr) {
+    std::cerr << "Error setting --nview to " << argv[optind+3] << std::endl;
+    if2pj_usage(argv[0]);
+    return (1);
+  }
+
+  if (opt_rotangle < 0) {
+    if (optGeometryName.compare ("parallel") == 0)
+      opt_rotangle = 0.5;
+    else
+      opt_rotangle = 1.0;
+  }
+
+  std::ostringstream desc;
+  desc << "if2pj: NDet=" << opt_ndet << ", Nview=" << opt_nview << ", NRay=" << opt_nray << ", RotAngle=" << opt_rotangle << ", OffsetView=" << opt_offsetview << ", Geometry=" << optGeometryName << ", ImageFile=" << opt_infile;
+  if (opt_desc.length()) {
+    desc << ": " << opt_desc;
+  }
+  opt_desc = desc.str();
+
+  ImageFile im;
+  if (! im.fileRead (opt_infile)) {
+    std::cerr << "Unable to read imagefile " << opt_infile << std::endl;
+    return (1);
+  }
+  if (im.isComplex())
+    std::cerr << "Projecting real component of complex imagefile\n";
+
+  opt_rotangle *= TWOPI;
+  Scanner scanner (im, optGeometryName.c_str(), opt_ndet, opt_nview, opt_offsetview, opt_nray,
+                   opt_rotangle, dOptFocalLength, dOptCenterDetectorLength, dOptViewRatio, dOptScanRatio);
+  if (scanner.fail()) {
+    std::cout << "Scanner Creation Error: " << scanner.failMessage() << std::endl;
+    return (1);
+  }
+
+  Projections pjGlobal (scanner);
+  if (bOptSystemMatrix) {
+    if (opt_nray != 1) {
+      std::cerr << "--system-matrix requires --nray 1\n";
+      return (1);
+    }
+    if (! projectWithSystemMatrix (pjGlobal, im, opt_offsetview, opt_threads, opt_verbose != 0))
+      return (1);
+  } else if (! scanner.collectProjections (pjGlobal, im, 0, opt_nview, opt_offsetview, 0, opt_threads)) {
+    std::cerr << "Error collecting projections from " << opt_infile << std::endl;
+    return (1);
+  }
+
+  pjGlobal.setCalcTime (timerProgram.timerEnd());
+  pjGlobal.setRemark (opt_desc);
+  pjGlobal.write (opt_outfile);
+  if (opt_verbose) {
+    std::ostringstream os;
+    pjGlobal.printScanInfo (os);
+    std::cout << os.str() << std::endl;
+    std::cout << "  Remark: " << pjGlobal.remark() << std::endl;
+    std::cout << "Run time: " << pjGlobal.calcTime() << " seconds\n";
+  }
+
+  return (0);
+}
+
+
+#ifndef NO_MAIN
+int
+main (int argc, char* argv[])
+{
+  int retval = 1;
+
+  try {
+    retval = if2pj_main(argc, argv);
+  } catch (exception e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Unknown exception\n";
+  }
+
+  return (retval);
+}
+#endif
@@ -267,7 +267,7 @@ ifexport_main (int argc, char *const argv[])
 
   pim = new ImageFile ();
   ImageFile& im = *pim;
-  if (! im.fileRead(in_file)) {
+  if (! im.fileReadMapped (in_file)) {
     sys_error (ERR_FATAL, "File %s does not exist", in_file);
     return (1);
   }
@@ -53,7 +53,7 @@ ifinfo_usage (const char *program)
   std::cout << "usage: " << fileBasename(program) << " image-filename [OPTIONS]\n";
   std::cout << "Imagefile information\n";
   std::cout << std::endl;
-  std::cout << "     infile       Name of input IF file\n";
+  std::cout << "     infile       Name of input IF file, or volume.ctv to list its entries\n";
   std::cout << "     --display    Display image\n";
   std::cout << "     --labels     Print image labels (default)\n";
   std::cout << "     --no-labels  Do not print image labels\n";
@@ -126,8 +126,18 @@ ifinfo_main (int argc, char *const argv[])
 
   in_file = argv[optind];
 
+  // a volume without an entry name lists its entries
+  std::string strVolume, strEntry;
+  if (VolumeFile::splitEntryPath (in_file.c_str(), strVolume, strEntry) && strEntry.empty()) {
+    VolumeFile volume;
+    if (! volume.open (strVolume.c_str()))
+      return (1);
+    volume.printEntries (std::cout);
+    return (0);
+  }
+
   im = new ImageFile ();
-  if (! im->fileRead (in_file)) {
+  if (! im->fileReadMapped (in_file.c_str())) {
     sys_error (ERR_WARNING, "Unable to read file %s", in_file.c_str());
     return (1);
   }
@@ -29,7 +29,7 @@
 
 MPIWorld::MPIWorld (int& argc, char* const *& argv)
 {
-  MPI::Init (argc, const_cast<char**&>(argv));
+  m_iThreadSupport = MPI::Init_thread (argc, const_cast<char**&>(argv), MPI::THREAD_FUNNELED);
   m_comm = MPI::COMM_WORLD.Dup();
   m_nProcessors = m_comm.Get_size();
   m_myRank = m_comm.Get_rank();
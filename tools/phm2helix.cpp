@@ -27,14 +27,15 @@
 #include "timer.h"
 
 
-enum { O_PHANTOMPROG, O_PHMFILE,  O_DESC, O_NRAY, O_ROTANGLE, O_GEOMETRY, O_FOCAL_LENGTH, O_CENTER_DETECTOR_LENGTH,
-  O_VIEW_RATIO, O_SCAN_RATIO, O_OFFSETVIEW,  O_TRACE, O_VERBOSE, O_HELP, O_DEBUG, O_VERSION };
+enum { O_PHANTOMPROG, O_PHMFILE, O_DYNPHM, O_DESC, O_NRAY, O_ROTANGLE, O_GEOMETRY, O_FOCAL_LENGTH, O_CENTER_DETECTOR_LENGTH,
+  O_VIEW_RATIO, O_SCAN_RATIO, O_OFFSETVIEW, O_APERTURE, O_TRACE, O_VERBOSE, O_HELP, O_DEBUG, O_VERSION };
 
 static struct option phm2helix_options[] =
 {
   {"phantom", 1, 0, O_PHANTOMPROG},
   {"desc", 1, 0, O_DESC},
   {"nray", 1, 0, O_NRAY},
+  {"aperture", 1, 0, O_APERTURE},
   {"rotangle", 1, 0, O_ROTANGLE},
   {"geometry", 1, 0, O_GEOMETRY},
   {"focal-length", 1, 0, O_FOCAL_LENGTH},
@@ -48,6 +49,7 @@ static struct option phm2helix_options[] =
   {"debug", 0, 0, O_DEBUG},
   {"version", 0, 0, O_VERSION},
   {"phmfile", 1, 0, O_PHMFILE},
+  {"dynphm", 1, 0, O_DYNPHM},
   {0, 0, 0, 0}
 };
 
@@ -58,14 +60,19 @@ void
 phm2helix_usage (const char *program)
 {
           std::cout << "usage: " << fileBasename(program) << " outfile ndet nview phmprog [OPTIONS]\n";
+          std::cout << "       " << fileBasename(program) << " outfile ndet nview --dynphm phmfile [OPTIONS]\n";
           std::cout << "Calculate (projections) through time varying phantom object  \n\n";
           std::cout << "     outfile          Name of output file for projectsions\n";
           std::cout << "     ndet             Number of detectors\n";
           std::cout << "     nview            Number of rotated views\n";
           std::cout << "     phmprog          Name of phm generation executable\n";
           std::cout << "     --phmfile        Temp phantom file name \n";
+          std::cout << "     --dynphm         Phantom file with keyframes, used instead of phmprog\n";
           std::cout << "     --desc           Description of raysum\n";
           std::cout << "     --nray           Number of rays per detector (default = 1)\n";
+          std::cout << "     --aperture       Integration across each detector\n";
+          std::cout << "        uniform       Equally spaced, equally weighted rays (default)\n";
+          std::cout << "        strip         Exact strip integral for ellipses and rectangles\n";
           std::cout << "     --rotangle       Angle to rotate view through (fraction of a circle)\n";
           std::cout << "                      (default = select appropriate for geometry)\n";
           std::cout << "     --geometry       Geometry of scanning\n";
@@ -94,10 +101,12 @@ phm2helix_main (int argc, char* const argv[])
 {
         Phantom phm;
         std::string optGeometryName = Scanner::convertGeometryIDToName(Scanner::GEOMETRY_PARALLEL);
+        std::string optApertureName = Scanner::convertApertureIDToName(Scanner::APERTURE_UNIFORM);
         char *opt_outfile = NULL;
         std::string opt_desc;
         std::string opt_PhmProg;
         std::string opt_PhmFileName = "tmpphmfile";
+        std::string opt_DynPhmFileName;
         int opt_ndet;
         int opt_nview;
         int opt_offsetview = 0;
@@ -138,6 +147,9 @@ phm2helix_main (int argc, char* const argv[])
                           case O_PHMFILE:
                                 opt_PhmFileName = optarg;
                                 break;
+                          case O_DYNPHM:
+                                opt_DynPhmFileName = optarg;
+                                break;
                           case O_DESC:
                                 opt_desc = optarg;
                                 break;
@@ -198,6 +210,9 @@ phm2helix_main (int argc, char* const argv[])
                                   return (1);
                                 }
                                 break;
+                          case O_APERTURE:
+                                optApertureName = optarg;
+                                break;
                           case O_OFFSETVIEW:
                                 opt_offsetview = strtol(optarg, &endptr, 10);
                                 endstr = optarg + strlen(optarg);
@@ -224,7 +239,8 @@ phm2helix_main (int argc, char* const argv[])
                         } // end of switch
           } // end of while loop
 
-          if (optind + 4 != argc) {
+          bool bDynPhm = opt_DynPhmFileName.length() > 0;
+          if (optind + (bDynPhm ? 3 : 4) != argc) {
                 phm2helix_usage(argv[0]);
                 return (1);
           }
@@ -244,7 +260,8 @@ phm2helix_main (int argc, char* const argv[])
                 phm2helix_usage(argv[0]);
                 return (1);
           }
-          opt_PhmProg = argv[optind+3];
+          if (! bDynPhm)
+                opt_PhmProg = argv[optind+3];
 
           if (opt_rotangle < 0) {
                 if (optGeometryName.compare ("parallel") == 0)
@@ -260,8 +277,12 @@ phm2helix_main (int argc, char* const argv[])
                    << ", RotAngle=" << opt_rotangle
                    << ", OffsetView =" << opt_offsetview
                    << ", Geometry=" << optGeometryName
-                   << ", PhantomProg=" << opt_PhmProg
-                   << ", PhmFileName=" << opt_PhmFileName;
+                   << ", Aperture=" << optApertureName;
+          if (bDynPhm)
+                desc << ", DynPhmFileName=" << opt_DynPhmFileName;
+          else
+                desc << ", PhantomProg=" << opt_PhmProg
+                     << ", PhmFileName=" << opt_PhmFileName;
           if (opt_desc.length()) {
                 desc << ": " << opt_desc;
           }
@@ -271,22 +292,30 @@ phm2helix_main (int argc, char* const argv[])
 
           int stat;
           char extcommand[100];
-          if(opt_debug != 0)
-                        std::cout  <<  opt_PhmProg  <<  " " << 0 << " " <<  opt_nview << " " << opt_PhmFileName  << std::endl;
-           //extcommand <<  opt_PhmProg  <<  " " << 0 << " " <<  opt_nview << " " << opt_PhmFileName ;
+          if (bDynPhm) {
+                if (! phm.createFromFile (opt_DynPhmFileName.c_str())) {
+                        std::cerr << "Unable to read phantom file " << opt_DynPhmFileName << std::endl;
+                        return (1);
+                }
+          } else {
+            if(opt_debug != 0)
+                          std::cout  <<  opt_PhmProg  <<  " " << 0 << " " <<  opt_nview << " " << opt_PhmFileName  << std::endl;
+             //extcommand <<  opt_PhmProg  <<  " " << 0 << " " <<  opt_nview << " " << opt_PhmFileName ;
 
-          sprintf(extcommand, "%s %d %d %s",    opt_PhmProg.c_str(), 0, opt_nview, opt_PhmFileName.c_str() );
+            sprintf(extcommand, "%s %d %d %s",    opt_PhmProg.c_str(), 0, opt_nview, opt_PhmFileName.c_str() );
 
-           stat = system( extcommand );
-          if (stat != 0 )
-                        std::cerr << "Error executing external phantom program " << opt_PhmProg << " with command " << extcommand << std::endl;
+             stat = system( extcommand );
+            if (stat != 0 )
+                          std::cerr << "Error executing external phantom program " << opt_PhmProg << " with command " << extcommand << std::endl;
 
-          phm.createFromFile (opt_PhmFileName.c_str());
-          remove(opt_PhmFileName.c_str());
+            phm.createFromFile (opt_PhmFileName.c_str());
+            remove(opt_PhmFileName.c_str());
+          }
 
           Scanner scanner (phm, optGeometryName.c_str(), opt_ndet, opt_nview,
                                 opt_offsetview, opt_nray, opt_rotangle, dOptFocalLength,
-                                dOptCenterDetectorLength, dOptViewRatio, dOptScanRatio);
+                                dOptCenterDetectorLength, dOptViewRatio, dOptScanRatio,
+                                optApertureName.c_str());
           if (scanner.fail()) {
                  std::cout << "Scanner Creation Error: " << scanner.failMessage()
                                                         << std::endl;
@@ -296,24 +325,28 @@ phm2helix_main (int argc, char* const argv[])
           Projections pjGlobal(scanner);
 
 
-          for( int iView = 0; iView < opt_nview; iView++ ){
-                if(opt_debug != 0)
-                        std::cout  <<  opt_PhmProg  <<  " " << iView << " " <<  opt_nview << " " << opt_PhmFileName  << std::endl;
-           //extcommand <<  opt_PhmProg  <<  " " << iView << " " <<  opt_nview << " " << opt_PhmFileName ;
-
-                sprintf(extcommand, "%s %d %d %s",      
-                        opt_PhmProg.c_str(), iView, opt_nview, 
-                        opt_PhmFileName.c_str() );
-                stat = system( extcommand );
-
-                if (stat != 0 )
-                        std::cerr << "Error executing external phantom program " << opt_PhmProg << " with command " << extcommand << std::endl;
-                Phantom phmtmp;
-                phmtmp.createFromFile (opt_PhmFileName.c_str());
-
-                scanner.collectProjections (pjGlobal, phmtmp, iView,
-                          1, scanner.offsetView(), true, opt_trace);
-                remove(opt_PhmFileName.c_str());
+          if (bDynPhm)
+                scanner.collectProjections (pjGlobal, phm, 0, opt_nview, scanner.offsetView(), true, opt_trace);
+          else {
+            for( int iView = 0; iView < opt_nview; iView++ ){
+                  if(opt_debug != 0)
+                          std::cout  <<  opt_PhmProg  <<  " " << iView << " " <<  opt_nview << " " << opt_PhmFileName  << std::endl;
+             //extcommand <<  opt_PhmProg  <<  " " << iView << " " <<  opt_nview << " " << opt_PhmFileName ;
+
+                  sprintf(extcommand, "%s %d %d %s",      
+                          opt_PhmProg.c_str(), iView, opt_nview, 
+                          opt_PhmFileName.c_str() );
+                  stat = system( extcommand );
+
+                  if (stat != 0 )
+                          std::cerr << "Error executing external phantom program " << opt_PhmProg << " with command " << extcommand << std::endl;
+                  Phantom phmtmp;
+                  phmtmp.createFromFile (opt_PhmFileName.c_str());
+
+                  scanner.collectProjections (pjGlobal, phmtmp, iView,
+                            1, scanner.offsetView(), true, opt_trace);
+                  remove(opt_PhmFileName.c_str());
+            }
           }
 
 
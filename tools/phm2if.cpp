@@ -28,7 +28,7 @@
 
 
 enum { O_PHANTOM, O_DESC, O_NSAMPLE, O_FILTER, O_VIEW_RATIO, O_TRACE, O_VERBOSE, O_HELP,
-O_PHMFILE, O_FILTER_DOMAIN, O_FILTER_BW, O_FILTER_PARAM, O_DEBUG, O_VERSION };
+O_PHMFILE, O_FILTER_DOMAIN, O_FILTER_BW, O_FILTER_PARAM, O_THREADS, O_BAND_COLS, O_COMPRESS, O_DEBUG, O_VERSION };
 
 static struct option my_options[] =
 {
@@ -42,6 +42,9 @@ static struct option my_options[] =
   {"filter-param", 1, 0, O_FILTER_PARAM},
   {"trace", 1, 0, O_TRACE},
   {"view-ratio", 1, 0, O_VIEW_RATIO},
+  {"threads", 1, 0, O_THREADS},
+  {"band-cols", 1, 0, O_BAND_COLS},
+  {"compress", 1, 0, O_COMPRESS},
   {"verbose", 0, 0, O_VERBOSE},
   {"debug", 0, 0, O_DEBUG},
   {"help", 0, 0, O_HELP},
@@ -84,6 +87,12 @@ phm2if_usage (const char *program)
   std::cout << "     --filter-bw     Filter bandwidth (default = 1)\n";
   std::cout << "     --desc          Description of raysum\n";
   std::cout << "     --nsample       Number of samples per axis per pixel (default = 1)\n";
+  std::cout << "     --threads       Number of rasterizing threads, 0 for all processors (default = 1)\n";
+  std::cout << "     --band-cols     Rasterize and write image in bands of this many columns\n";
+  std::cout << "     --compress      Compression of the output file\n";
+  std::cout << "        none         Plain image file (default)\n";
+  std::cout << "        deflate      Lossless\n";
+  std::cout << "        float16      Half precision pixels, lossy\n";
   std::cout << "     --trace         Trace level to use\n";
   std::cout << "        none         No tracing (default)\n";
   std::cout << "        console      Trace text level\n";
@@ -97,6 +106,54 @@ phm2if_usage (const char *program)
 void mpi_gather_image (MPIWorld& mpiWorld, ImageFile* pImGlobal, ImageFile* pImLocal, const int optDebug);
 #endif
 
+
+// Rasterizes a band of image columns. Each thread rasterizes its columns a
+// chunk at a time into a small child image which is copied into the band.
+class PhantomRasterTask : public WorkerThreadTask {
+private:
+  enum { CHUNK_COLUMNS = 16 };
+
+  const Phantom& m_rPhantom;
+  ImageFile& m_rImBand;
+  const int m_iTotalNX;
+  const double m_dViewRatio;
+  const int m_iNSample;
+  const int m_iTrace;
+  int m_iBandStart;
+
+public:
+  PhantomRasterTask (const Phantom& rPhantom, ImageFile& rImBand, int iTotalNX, double dViewRatio, int iNSample, int iTrace)
+    : m_rPhantom(rPhantom), m_rImBand(rImBand), m_iTotalNX(iTotalNX), m_dViewRatio(dViewRatio),
+      m_iNSample(iNSample), m_iTrace(iTrace), m_iBandStart(0)
+  {}
+
+  void setBandStart (int iBandStart)
+  { m_iBandStart = iBandStart; }
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits);
+};
+
+void
+PhantomRasterTask::doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+{
+  const int ny = m_rImBand.ny();
+  const size_t iColSize = sizeof(ImageFileValue) * ny;
+  const int nChunkCols = iNumUnits < CHUNK_COLUMNS ? iNumUnits : CHUNK_COLUMNS;
+
+  ImageFile imChunk (nChunkCols, ny);
+  ImageFileArray vBand = m_rImBand.getArray();
+  ImageFileArray vChunk = imChunk.getArray();
+  for (int iUnit = 0; iUnit < iNumUnits; iUnit += nChunkCols) {
+    int nCols = iNumUnits - iUnit;
+    if (nCols > nChunkCols)
+      nCols = nChunkCols;
+    m_rPhantom.convertToImagefile (imChunk, m_iTotalNX, m_dViewRatio, m_iNSample, m_iTrace,
+                                   m_iBandStart + iStartUnit + iUnit, nCols, 0);
+    for (int iCol = 0; iCol < nCols; iCol++)
+      memcpy (vBand[iStartUnit + iUnit + iCol], vChunk[iCol], iColSize);
+  }
+}
+
 int
 phm2if_main (int argc, char* const argv[])
 {
@@ -111,6 +168,10 @@ phm2if_main (int argc, char* const argv[])
   int opt_nx = 0;
   int opt_ny = 0;
   int opt_nsample = 1;
+  int optThreads = 1;
+  int optBandCols = 0;
+  int optCompression = ArrayCodec::CODEC_NONE;
+  bool bBandWrite = false;
   double optViewRatio = 1.;
   double optFilterParam = 1.;
   double optFilterBW = 1.;
@@ -195,6 +256,32 @@ phm2if_main (int argc, char* const argv[])
           return (1);
         }
         break;
+      case O_THREADS:
+        optThreads = strtol(optarg, &endptr, 10);
+        endstr = optarg + strlen(optarg);
+        if (endptr != endstr || optThreads < 0) {
+          sys_error(ERR_SEVERE,"Error setting --threads to %s\n", optarg);
+          phm2if_usage(argv[0]);
+          return (1);
+        }
+        break;
+      case O_BAND_COLS:
+        optBandCols = strtol(optarg, &endptr, 10);
+        endstr = optarg + strlen(optarg);
+        if (endptr != endstr || optBandCols < 1) {
+          sys_error(ERR_SEVERE,"Error setting --band-cols to %s\n", optarg);
+          phm2if_usage(argv[0]);
+          return (1);
+        }
+        break;
+      case O_COMPRESS:
+        optCompression = ArrayCodec::convertCodecNameToID (optarg);
+        if (! ArrayCodec::isAvailable (optCompression)) {
+          sys_error(ERR_SEVERE,"Compression %s is not available\n", optarg);
+          phm2if_usage(argv[0]);
+          return (1);
+        }
+        break;
       case O_VERSION:
 #ifdef VERSION
         std::cout << "Version " << VERSION << std::endl << g_szIdStr << std::endl;
@@ -217,6 +304,18 @@ phm2if_main (int argc, char* const argv[])
       return (1);
     }
 
+    if (optBandCols > 0 && optFilterName != "") {
+      std::cerr << "Can't use --band-cols with --filter\n" << std::endl;
+      phm2if_usage(argv[0]);
+      return (1);
+    }
+
+    if (optBandCols > 0 && optCompression != ArrayCodec::CODEC_NONE) {
+      std::cerr << "Can't use --band-cols with --compress\n" << std::endl;
+      phm2if_usage(argv[0]);
+      return (1);
+    }
+
     if (optind + 3 != argc) {
       phm2if_usage(argv[0]);
       return (1);
@@ -283,6 +382,7 @@ phm2if_main (int argc, char* const argv[])
   mpiWorld.getComm().Bcast (&opt_nx, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_ny, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_nsample, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&optThreads, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&optViewRatio, 1, MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&optFilterParam, 1, MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&optFilterBW, 1, MPI::DOUBLE, 0);
@@ -301,9 +401,20 @@ phm2if_main (int argc, char* const argv[])
   if (mpiWorld.getRank() == 0) {
     pImGlobal = new ImageFile (opt_nx, opt_ny);
   }
-  pImLocal = new ImageFile (opt_nx, opt_ny);
+  // each process rasterizes its own columns, with threads of its own
+  pImLocal = new ImageFile (mpiWorld.getMyLocalWorkUnits(), opt_ny);
+  if (optThreads != 1 && ! mpiWorld.threadsSupported()) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "MPI library does not support threads, using --threads 1\n";
+    optThreads = 1;
+  }
 #else
-  pImGlobal = new ImageFile (opt_nx, opt_ny);
+  int nBandCols = opt_nx;
+  if (optBandCols > 0 && optBandCols < opt_nx) {
+    nBandCols = optBandCols;
+    bBandWrite = true;
+  }
+  pImGlobal = new ImageFile (nBandCols, opt_ny);
 #endif
 
   ImageFileArray v = NULL;
@@ -321,7 +432,16 @@ phm2if_main (int argc, char* const argv[])
     }
   } else {
     TimerCollectiveMPI timerRasterize (mpiWorld.getComm());
-    phm.convertToImagefile (*pImLocal, optViewRatio, opt_nsample, optTrace, mpiWorld.getMyStartWorkUnit(), mpiWorld.getMyLocalWorkUnits(), false);
+    WorkerThreads workerThreads (optThreads);
+    PhantomRasterTask rasterTask (phm, *pImLocal, opt_nx, optViewRatio, opt_nsample, optTrace);
+    if (optVerbose && mpiWorld.getRank() == 0 && workerThreads.getNumThreads() > 1)
+      std::cout << "Rasterizing with " << workerThreads.getNumThreads() << " threads per process\n";
+    // A zero column raster sets the axis extent and increment of the whole image
+    if (mpiWorld.getRank() == 0)
+      phm.convertToImagefile (*pImGlobal, opt_nx, optViewRatio, opt_nsample, optTrace, 0, 0, 0);
+    rasterTask.setBandStart (mpiWorld.getMyStartWorkUnit());
+    workerThreads.setTotalWorkUnits (mpiWorld.getMyLocalWorkUnits());
+    workerThreads.run (rasterTask);
     if (optVerbose)
       timerRasterize.timerEndAndReport ("Time to rasterize phantom");
 
@@ -332,12 +452,44 @@ phm2if_main (int argc, char* const argv[])
   }
 #else
   v = pImGlobal->getArray ();
-  if (phm.getComposition() == P_UNIT_PULSE) {
-    v[opt_nx/2][opt_ny/2] = 1.;
-  } else if (optFilterName != "") {
-    pImGlobal->filterResponse (optDomainName.c_str(), optFilterBW, optFilterName.c_str(), optFilterParam);
-  } else {
-    phm.convertToImagefile (*pImGlobal, optViewRatio, opt_nsample, optTrace);
+  if (bBandWrite && ! pImGlobal->fileBandWriteBegin (optOutFilename.c_str(), opt_nx)) {
+    delete pImGlobal;
+    return (1);
+  }
+
+  WorkerThreads workerThreads (optThreads);
+  PhantomRasterTask rasterTask (phm, *pImGlobal, opt_nx, optViewRatio, opt_nsample, optTrace);
+  if (optVerbose && workerThreads.getNumThreads() > 1)
+    std::cout << "Rasterizing with " << workerThreads.getNumThreads() << " threads\n";
+
+  // A zero column raster sets the axis extent and increment of the whole image
+  if (workerThreads.getNumThreads() > 1 || bBandWrite)
+    phm.convertToImagefile (*pImGlobal, opt_nx, optViewRatio, opt_nsample, optTrace, 0, 0, 0);
+
+  for (int iBandStart = 0; iBandStart < opt_nx; iBandStart += nBandCols) {
+    int iBandCols = opt_nx - iBandStart;
+    if (iBandCols > nBandCols)
+      iBandCols = nBandCols;
+
+    if (phm.getComposition() == P_UNIT_PULSE) {
+      if (bBandWrite)
+        pImGlobal->arrayDataClear();
+      if (opt_nx/2 >= iBandStart && opt_nx/2 < iBandStart + iBandCols)
+        v[opt_nx/2 - iBandStart][opt_ny/2] = 1.;
+    } else if (optFilterName != "") {
+      pImGlobal->filterResponse (optDomainName.c_str(), optFilterBW, optFilterName.c_str(), optFilterParam);
+    } else if (workerThreads.getNumThreads() == 1 && ! bBandWrite) {
+      phm.convertToImagefile (*pImGlobal, optViewRatio, opt_nsample, optTrace);
+    } else {
+      rasterTask.setBandStart (iBandStart);
+      workerThreads.setTotalWorkUnits (iBandCols);
+      workerThreads.run (rasterTask);
+    }
+
+    if (bBandWrite && ! pImGlobal->fileBandWrite (iBandStart, iBandCols)) {
+      delete pImGlobal;
+      return (1);
+    }
   }
 #endif
 
@@ -347,7 +499,12 @@ phm2if_main (int argc, char* const argv[])
   {
     double calctime = timerProgram.timerEnd ();
     pImGlobal->labelAdd (Array2dFileLabel::L_HISTORY, optDesc.c_str(), calctime);
-    pImGlobal->fileWrite (optOutFilename.c_str());
+    if (bBandWrite)
+      pImGlobal->fileBandWriteEnd ();
+    else {
+      pImGlobal->setCompression (optCompression);
+      pImGlobal->fileWrite (optOutFilename.c_str());
+    }
     if (optVerbose)
       std::cout << "Time to rasterize phantom: " << calctime << " seconds\n";
   }
@@ -355,6 +512,7 @@ phm2if_main (int argc, char* const argv[])
   delete pImGlobal;
 #ifdef HAVE_MPI
   delete pImLocal;
+  MPI::Finalize();
 #endif
 
   return (0);
@@ -365,25 +523,19 @@ phm2if_main (int argc, char* const argv[])
 #ifdef HAVE_MPI
 void mpi_gather_image (MPIWorld& mpiWorld, ImageFile* pImGlobal, ImageFile* pImLocal, const int optDebug)
 {
-  ImageFileArray vLocal = pImLocal->getArray();
-  ImageFileArray vGlobal = NULL;
-  int nyLocal = pImLocal->ny();
-
-  if (mpiWorld.getRank() == 0)
-    vGlobal = pImGlobal->getArray();
-
-  for (int iw = 0; iw < mpiWorld.getMyLocalWorkUnits(); iw++)
-    mpiWorld.getComm().Send(vLocal[iw], nyLocal, pImLocal->getMPIDataType(), 0, 0);
-
-  if (mpiWorld.getRank() == 0) {
-    for (int iProc = 0; iProc < mpiWorld.getNumProcessors(); iProc++) {
-      for (int iw = mpiWorld.getStartWorkUnit(iProc); iw <= mpiWorld.getEndWorkUnit(iProc); iw++) {
-        MPI::Status status;
-        mpiWorld.getComm().Recv(vGlobal[iw], nyLocal, pImLocal->getMPIDataType(), iProc, 0, status);
-      }
-    }
+  // The columns of the processes are contiguous in the image array, in the
+  // order of the processes, so one collective gathers them
+  const int nProc = mpiWorld.getNumProcessors();
+  const int ny = pImLocal->ny();
+  std::vector<int> vecCount (nProc), vecDispl (nProc);
+  for (int iProc = 0; iProc < nProc; iProc++) {
+    vecCount[iProc] = mpiWorld.getLocalWorkUnits (iProc) * ny;
+    vecDispl[iProc] = mpiWorld.getStartWorkUnit (iProc) * ny;
   }
 
+  mpiWorld.getComm().Gatherv (pImLocal->data(), pImLocal->size(), pImLocal->getMPIDataType(),
+                              mpiWorld.getRank() == 0 ? pImGlobal->data() : NULL, &vecCount[0], &vecDispl[0],
+                              pImLocal->getMPIDataType(), 0);
 }
 #endif
 
@@ -28,7 +28,7 @@
 
 
 enum { O_PHANTOM, O_DESC, O_NRAY, O_ROTANGLE, O_PHMFILE, O_GEOMETRY, O_FOCAL_LENGTH, O_CENTER_DETECTOR_LENGTH,
-O_VIEW_RATIO, O_SCAN_RATIO, O_OFFSETVIEW, O_TRACE, O_VERBOSE, O_HELP, O_DEBUG, O_VERSION };
+O_VIEW_RATIO, O_SCAN_RATIO, O_OFFSETVIEW, O_APERTURE, O_COMPRESS, O_RESUME, O_THREADS, O_TRACE, O_VERBOSE, O_HELP, O_DEBUG, O_VERSION };
 
 static struct option phm2pj_options[] =
 {
@@ -36,6 +36,7 @@ static struct option phm2pj_options[] =
   {"phmfile", 1, 0, O_PHMFILE},
   {"desc", 1, 0, O_DESC},
   {"nray", 1, 0, O_NRAY},
+  {"aperture", 1, 0, O_APERTURE},
   {"rotangle", 1, 0, O_ROTANGLE},
   {"geometry", 1, 0, O_GEOMETRY},
   {"focal-length", 1, 0, O_FOCAL_LENGTH},
@@ -43,6 +44,9 @@ static struct option phm2pj_options[] =
   {"offsetview", 1, 0, O_OFFSETVIEW},
   {"view-ratio", 1, 0, O_VIEW_RATIO},
   {"scan-ratio", 1, 0, O_SCAN_RATIO},
+  {"compress", 1, 0, O_COMPRESS},
+  {"resume", 0, 0, O_RESUME},
+  {"threads", 1, 0, O_THREADS},
   {"trace", 1, 0, O_TRACE},
   {"verbose", 0, 0, O_VERBOSE},
   {"help", 0, 0, O_HELP},
@@ -69,6 +73,9 @@ phm2pj_usage (const char *program)
   std::cout << "     --phmfile        Get Phantom from phantom file\n";
   std::cout << "     --desc           Description of raysum\n";
   std::cout << "     --nray           Number of rays per detector (default = 1)\n";
+  std::cout << "     --aperture       Integration across each detector\n";
+  std::cout << "        uniform       Equally spaced, equally weighted rays (default)\n";
+  std::cout << "        strip         Exact strip integral for ellipses and rectangles\n";
   std::cout << "     --rotangle       Angle to rotate view through (fraction of a circle)\n";
   std::cout << "                      (default = select appropriate for geometry)\n";
   std::cout << "     --geometry       Geometry of scanning\n";
@@ -84,6 +91,12 @@ phm2pj_usage (const char *program)
   std::cout << "     --scan-ratio     Length to scan (scan diameter to view diameter)\n";
   std::cout << "                      (default = 1)\n";
   std::cout << "     --offsetview     Initial gantry offset in 'views' (default = 0)\n";
+  std::cout << "     --compress       Compression of the views in the output file\n";
+  std::cout << "        none          Plain projection file (default)\n";
+  std::cout << "        deflate       Lossless\n";
+  std::cout << "        float16       Half precision values, lossy\n";
+  std::cout << "     --resume         Continue an interrupted outfile from its last complete views\n";
+  std::cout << "     --threads        Number of projecting threads, 0 for all processors (default = 1)\n";
   std::cout << "     --trace          Trace level to use\n";
   std::cout << "        none          No tracing (default)\n";
   std::cout << "        console       Trace text level\n";
@@ -97,11 +110,49 @@ phm2pj_usage (const char *program)
 void GatherProjectionsMPI (MPIWorld& mpiWorld, Projections& pjGlobal, Projections& pjLocal, const int opt_debug);
 #endif
 
+
+// Projects a range of views of the phantom, each thread a contiguous run
+// of the views. Scanner::collectProjections keeps no state between views
+// besides the trace level, which is the same for every thread.
+class PhantomProjectorTask : public WorkerThreadTask {
+private:
+  Scanner& m_rScanner;
+  Projections& m_rProj;
+  const Phantom& m_rPhantom;
+  const int m_iStartView;
+  const int m_iOffsetView;
+  const int m_iStorageOffset;
+  const int m_iTrace;
+
+public:
+  PhantomProjectorTask (Scanner& rScanner, Projections& rProj, const Phantom& rPhantom,
+                        int iStartView, int iOffsetView, int iStorageOffset, int iTrace)
+    : m_rScanner(rScanner), m_rProj(rProj), m_rPhantom(rPhantom), m_iStartView(iStartView),
+      m_iOffsetView(iOffsetView), m_iStorageOffset(iStorageOffset), m_iTrace(iTrace)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    m_rScanner.collectProjections (m_rProj, m_rPhantom, m_iStartView + iStartUnit, iNumUnits,
+                                   m_iOffsetView, m_iStorageOffset + iStartUnit, m_iTrace);
+  }
+};
+
+static void
+collectProjectionsThreaded (WorkerThreads& threads, Scanner& scanner, Projections& proj, const Phantom& phm,
+                            int iStartView, int nViews, int iOffsetView, int iStorageOffset, int iTrace)
+{
+  PhantomProjectorTask task (scanner, proj, phm, iStartView, iOffsetView, iStorageOffset, iTrace);
+  threads.setTotalWorkUnits (nViews);
+  threads.run (task);
+}
+
 int
 phm2pj_main (int argc, char* const argv[])
 {
   Phantom phm;
   std::string optGeometryName = Scanner::convertGeometryIDToName(Scanner::GEOMETRY_PARALLEL);
+  std::string optApertureName = Scanner::convertApertureIDToName(Scanner::APERTURE_UNIFORM);
   char *opt_outfile = NULL;
   std::string opt_desc;
   std::string optPhmName;
@@ -118,6 +169,9 @@ phm2pj_main (int argc, char* const argv[])
   int opt_verbose = 0;
   int opt_debug = 0;
   double opt_rotangle = -1;
+  int iOptCompression = ArrayCodec::CODEC_NONE;
+  bool bOptResume = false;
+  int iOptThreads = 1;
   char* endptr = NULL;
   char* endstr;
 
@@ -215,6 +269,29 @@ phm2pj_main (int argc, char* const argv[])
           phm2pj_usage(argv[0]);
           return (1);
         }
+        break;
+      case O_APERTURE:
+        optApertureName = optarg;
+        break;
+      case O_COMPRESS:
+        iOptCompression = ArrayCodec::convertCodecNameToID (optarg);
+        if (! ArrayCodec::isAvailable (iOptCompression)) {
+          std::cerr << "Compression " << optarg << " is not available" << std::endl;
+          phm2pj_usage(argv[0]);
+          return (1);
+        }
+        break;
+      case O_RESUME:
+        bOptResume = true;
+        break;
+      case O_THREADS:
+        iOptThreads = strtol(optarg, &endptr, 10);
+        endstr = optarg + strlen(optarg);
+        if (endptr != endstr || iOptThreads < 0) {
+          std::cerr << "Error setting --threads to " << optarg << std::endl;
+          phm2pj_usage(argv[0]);
+          return (1);
+        }
         break;
           case O_OFFSETVIEW:
                 opt_offsetview = strtol(optarg, &endptr, 10);
@@ -278,6 +355,8 @@ phm2pj_main (int argc, char* const argv[])
 
     std::ostringstream desc;
     desc << "phm2pj: NDet=" << opt_ndet << ", Nview=" << opt_nview << ", NRay=" << opt_nray << ", RotAngle=" << opt_rotangle << "OffsetView =" << opt_offsetview << ", Geometry=" << optGeometryName << ", ";
+    if (Scanner::convertApertureNameToID (optApertureName.c_str()) != Scanner::APERTURE_UNIFORM)
+      desc << "Aperture=" << optApertureName << ", ";
     if (optPhmFileName.length()) {
       desc << "PhantomFile=" << optPhmFileName;
     } else if (optPhmName != "") {
@@ -310,8 +389,20 @@ phm2pj_main (int argc, char* const argv[])
 #endif
 
 #ifdef HAVE_MPI
+  // only the first process parsed the options
+  int bResume = bOptResume;
+  mpiWorld.getComm().Bcast (&bResume, 1, MPI::INT, 0);
+  if (bResume) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "--resume is not available with MPI" << std::endl;
+    MPI::Finalize();
+    return (1);
+  }
+
   TimerCollectiveMPI timerBcast(mpiWorld.getComm());
   mpiWorld.BcastString (optPhmName);
+  mpiWorld.BcastString (optApertureName);
+  mpiWorld.BcastString (optGeometryName);
   mpiWorld.getComm().Bcast (&opt_rotangle, 1, MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&dOptFocalLength, 1, MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&dOptCenterDetectorLength, 1, MPI::DOUBLE, 0);
@@ -320,6 +411,8 @@ phm2pj_main (int argc, char* const argv[])
   mpiWorld.getComm().Bcast (&opt_nview, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_ndet, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_nray, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&opt_offsetview, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&iOptThreads, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_verbose, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_debug, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&opt_trace, 1, MPI::INT, 0);
@@ -328,11 +421,19 @@ phm2pj_main (int argc, char* const argv[])
 
   if (mpiWorld.getRank() > 0 && optPhmName != "")
     phm.createFromPhantom (optPhmName.c_str());
+
+  if (iOptThreads != 1 && ! mpiWorld.threadsSupported()) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "MPI library does not support threads, using --threads 1" << std::endl;
+    iOptThreads = 1;
+  }
 #endif
 
   opt_rotangle *= TWOPI;
+  bool bViewsWritten = false;
   Scanner scanner (phm, optGeometryName.c_str(), opt_ndet, opt_nview, opt_offsetview, opt_nray,
-                opt_rotangle, dOptFocalLength, dOptCenterDetectorLength, dOptViewRatio, dOptScanRatio);
+                opt_rotangle, dOptFocalLength, dOptCenterDetectorLength, dOptViewRatio, dOptScanRatio,
+                optApertureName.c_str());
   if (scanner.fail()) {
     std::cout << "Scanner Creation Error: " << scanner.failMessage() << std::endl;
     return (1);
@@ -350,14 +451,19 @@ phm2pj_main (int argc, char* const argv[])
     std::cout << os.str();
   }
 
-  Projections pjLocal (scanner);
+  Projections pjLocal;
+  pjLocal.initFromScanner (scanner, false);
   pjLocal.setNView (mpiWorld.getMyLocalWorkUnits());
 
   if (opt_debug)
     std::cout << "pjLocal->nview = " << pjLocal.nView() << " (process " << mpiWorld.getRank() << ")\n";;
 
+  // each process projects its own views, with threads of its own
+  WorkerThreads threads (iOptThreads);
+  if (opt_verbose && mpiWorld.getRank() == 0 && threads.getNumThreads() > 1)
+    std::cout << "Projecting with " << threads.getNumThreads() << " threads per process" << std::endl;
   TimerCollectiveMPI timerProject (mpiWorld.getComm());
-  scanner.collectProjections (pjLocal, phm, mpiWorld.getMyStartWorkUnit(), mpiWorld.getMyLocalWorkUnits(), false, opt_trace);
+  collectProjectionsThreaded (threads, scanner, pjLocal, phm, mpiWorld.getMyStartWorkUnit(), mpiWorld.getMyLocalWorkUnits(), opt_offsetview, 0, opt_trace);
   if (opt_verbose)
     timerProject.timerEndAndReport ("Time to collect projections");
 
@@ -367,17 +473,53 @@ phm2pj_main (int argc, char* const argv[])
     timerGather.timerEndAndReport ("Time to gather projections");
 
 #else
-  Projections pjGlobal (scanner);
-  scanner.collectProjections (pjGlobal, phm, 0, opt_nview, opt_offsetview, true, opt_trace);
+  // views are written in the background as chunks of them are collected,
+  // so memory does not grow with the number of views and a reader of a
+  // pipe can start on them before the last view is done
+  ProjectionsWriter writer (scanner);
+  WorkerThreads threads (iOptThreads);
+  if (opt_verbose && threads.getNumThreads() > 1)
+    std::cout << "Projecting with " << threads.getNumThreads() << " threads" << std::endl;
+  // a volume entry is written whole, after all views are collected
+  const bool bVolumeEntry = VolumeFile::isEntryPath (opt_outfile);
+  Projections pjEntry;
+  Projections& pjGlobal = bVolumeEntry ? pjEntry : writer.getHeader();
+  if (bVolumeEntry) {
+    if (bOptResume) {
+      std::cerr << "--resume needs a projection file, not a volume entry" << std::endl;
+      return (1);
+    }
+    pjEntry.initFromScanner (scanner);
+    collectProjectionsThreaded (threads, scanner, pjEntry, phm, 0, opt_nview, opt_offsetview, 0, opt_trace);
+  } else {
+    pjGlobal.setRemark (opt_desc);
+    pjGlobal.setCompression (iOptCompression);
+    if (! writer.open (opt_outfile, bOptResume))
+      return (1);
+    if (opt_verbose && writer.nResumedViews() > 0)
+      std::cout << "Resuming after view " << writer.nResumedViews() - 1 << std::endl;
+    for (int iView = writer.nResumedViews(); iView < opt_nview; iView += writer.nChunkViews()) {
+      const int nViews = std::min (writer.nChunkViews(), opt_nview - iView);
+      collectProjectionsThreaded (threads, scanner, writer.getChunk(), phm, iView, nViews, opt_offsetview, 0, opt_trace);
+      if (! writer.writeChunk (nViews))
+        break;
+    }
+    if (! writer.close (timerProgram.timerEnd()))
+      return (1);
+    bViewsWritten = true;
+  }
 #endif
 
 #ifdef HAVE_MPI
   if (mpiWorld.getRank() == 0)
 #endif
   {
-    pjGlobal.setCalcTime (timerProgram.timerEnd());
-    pjGlobal.setRemark (opt_desc);
-    pjGlobal.write (opt_outfile);
+    if (! bViewsWritten) {
+      pjGlobal.setCalcTime (timerProgram.timerEnd());
+      pjGlobal.setRemark (opt_desc);
+      pjGlobal.setCompression (iOptCompression);
+      pjGlobal.write (opt_outfile);
+    }
     if (opt_verbose) {
       phm.print (std::cout);
       std::cout << std::endl;
@@ -388,6 +530,9 @@ phm2pj_main (int argc, char* const argv[])
       std::cout << "Run time: " << pjGlobal.calcTime() << " seconds\n";
     }
   }
+#ifdef HAVE_MPI
+  MPI::Finalize();
+#endif
 
   return (0);
 }
@@ -403,33 +548,28 @@ phm2pj_main (int argc, char* const argv[])
 #ifdef HAVE_MPI
 void GatherProjectionsMPI (MPIWorld& mpiWorld, Projections& pjGlobal, Projections& pjLocal, const int opt_debug)
 {
-  for (int iw = 0; iw < mpiWorld.getMyLocalWorkUnits(); iw++) {
-    DetectorArray& detArray = pjLocal.getDetectorArray(iw);
-    double viewAngle = detArray.viewAngle();
-    int nDet = detArray.nDet();
-    DetectorValue* detval = detArray.detValues();
-
-    mpiWorld.getComm().Send(&viewAngle, 1, MPI::DOUBLE, 0, 0);
-    mpiWorld.getComm().Send(&nDet, 1, MPI::INT, 0, 0);
-    mpiWorld.getComm().Send(detval, nDet, MPI::FLOAT, 0, 0);
+  // The views of a process are contiguous rows of the sinogram, in the
+  // order of the processes, so the sinogram is gathered in place by one
+  // collective and the view angles by a second
+  const int nProc = mpiWorld.getNumProcessors();
+  const int nDet = pjLocal.nDet();
+  std::vector<int> vecAngleCount (nProc), vecAngleDispl (nProc), vecValueCount (nProc), vecValueDispl (nProc);
+  for (int iProc = 0; iProc < nProc; iProc++) {
+    vecAngleCount[iProc] = mpiWorld.getLocalWorkUnits (iProc);
+    vecAngleDispl[iProc] = mpiWorld.getStartWorkUnit (iProc);
+    vecValueCount[iProc] = vecAngleCount[iProc] * nDet;
+    vecValueDispl[iProc] = vecAngleDispl[iProc] * nDet;
   }
 
-  if (mpiWorld.getRank() == 0) {
-    for (int iProc = 0; iProc < mpiWorld.getNumProcessors(); iProc++) {
-      for (int iw = mpiWorld.getStartWorkUnit(iProc); iw <= mpiWorld.getEndWorkUnit(iProc); iw++) {
-        MPI::Status status;
-        double viewAngle;
-        int nDet;
-        DetectorArray& detArray = pjGlobal.getDetectorArray(iw);
-        DetectorValue* detval = detArray.detValues();
-
-        mpiWorld.getComm().Recv(&viewAngle, 1, MPI::DOUBLE, iProc, 0, status);
-        mpiWorld.getComm().Recv(&nDet, 1, MPI::INT, iProc, 0, status);
-        mpiWorld.getComm().Recv(detval, nDet, MPI::FLOAT, iProc, 0, status);
-        detArray.setViewAngle (viewAngle);
-      }
-    }
-  }
+  const bool bRoot = mpiWorld.getRank() == 0;
+  const int nLocalView = mpiWorld.getMyLocalWorkUnits();
+  mpiWorld.getComm().Gatherv (pjLocal.getViewAngles(), nLocalView, MPI::DOUBLE,
+                              bRoot ? pjGlobal.getViewAngles() : NULL, &vecAngleCount[0], &vecAngleDispl[0], MPI::DOUBLE, 0);
+  mpiWorld.getComm().Gatherv (pjLocal.getSinogram(), nLocalView * nDet, MPI::FLOAT,
+                              bRoot ? pjGlobal.getSinogram() : NULL, &vecValueCount[0], &vecValueDispl[0], MPI::FLOAT, 0);
+
+  if (opt_debug && bRoot)
+    std::cout << "Gathered " << pjGlobal.nView() << " views from " << nProc << " processes" << std::endl;
 }
 #endif
 
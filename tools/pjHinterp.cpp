@@ -27,11 +27,13 @@
 #include "timer.h"
 
 
-enum { O_INTERPVIEW, O_VERBOSE, O_TRACE, O_HELP, O_DEBUG, O_VERSION};
+enum { O_INTERPVIEW, O_INTERPVIEWS, O_THREADS, O_VERBOSE, O_TRACE, O_HELP, O_DEBUG, O_VERSION};
 
 static struct option my_options[] =
 {
         {"interpview", 1, 0, O_INTERPVIEW},
+        {"interpviews", 1, 0, O_INTERPVIEWS},
+        {"threads", 1, 0, O_THREADS},
         {"trace", 1, 0, O_TRACE},
         {"debug", 0, 0, O_DEBUG},
         {"verbose", 0, 0, O_VERBOSE},
@@ -42,12 +44,123 @@ static struct option my_options[] =
 
 static const char* g_szIdStr = "$Id$";
 
+// Parses a list of views such as 100,200-240,300-400:20
+
+static bool
+parseInterpViews (const char* pszList, std::vector<int>& vecViews)
+{
+  std::istringstream is (pszList);
+  std::string strItem;
+  while (std::getline (is, strItem, ',')) {
+    int iFirst, iLast, iStep = 1;
+    char* endptr;
+    const char* psz = strItem.c_str();
+    iFirst = strtol (psz, &endptr, 10);
+    if (endptr == psz || iFirst < 0)
+      return false;
+    iLast = iFirst;
+    if (*endptr == '-') {
+      psz = endptr + 1;
+      iLast = strtol (psz, &endptr, 10);
+      if (endptr == psz || iLast < iFirst)
+        return false;
+      if (*endptr == ':') {
+        psz = endptr + 1;
+        iStep = strtol (psz, &endptr, 10);
+        if (endptr == psz || iStep <= 0)
+          return false;
+      }
+    }
+    if (*endptr != 0)
+      return false;
+    for (int iView = iFirst; iView <= iLast; iView += iStep)
+      vecViews.push_back (iView);
+  }
+
+  return vecViews.size() > 0;
+}
+
+// Output filename of a plane, name.pj becomes name.view.pj. For a volume
+// the entry name is changed the same way, vol.ctv:name becomes
+// vol.ctv:name.view and vol.ctv becomes vol.ctv:view.view
+
+static std::string
+makeSliceFilename (const char* pszFilename, int iView)
+{
+  std::string strVolume, strEntry;
+  if (VolumeFile::splitEntryPath (pszFilename, strVolume, strEntry)) {
+    if (strEntry.empty())
+      strEntry = "view";
+    return strVolume + ":" + makeSliceFilename (strEntry.c_str(), iView);
+  }
+
+  std::string strFilename (pszFilename);
+  std::ostringstream os;
+  os << "." << iView;
+
+  std::string::size_type posSlash = strFilename.find_last_of ("/\\");
+  std::string::size_type posDot = strFilename.find_last_of ('.');
+  if (posDot == std::string::npos || (posSlash != std::string::npos && posDot < posSlash))
+    posDot = strFilename.size();
+  strFilename.insert (posDot, os.str());
+
+  return strFilename;
+}
+
+
+// Interpolates and writes planes, each plane is processed by one thread.
+// Planes written to a volume share one open VolumeFile, which serializes
+// the writes of the threads.
+
+class HelicalSliceTask : public WorkerThreadTask {
+private:
+  const Projections& m_rProj;
+  const std::vector<int>& m_rvecViews;
+  const std::vector<std::string>& m_rvecFilenames;
+  std::vector<int>& m_rvecStatus;
+  VolumeFile* m_pVolume;
+
+public:
+  HelicalSliceTask (const Projections& rProj, const std::vector<int>& rvecViews,
+                    const std::vector<std::string>& rvecFilenames, std::vector<int>& rvecStatus,
+                    VolumeFile* pVolume = NULL)
+    : m_rProj(rProj), m_rvecViews(rvecViews), m_rvecFilenames(rvecFilenames), m_rvecStatus(rvecStatus),
+      m_pVolume(pVolume)
+  {}
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    for (int i = iStartUnit; i < iStartUnit + iNumUnits; i++) {
+      Projections slice;
+      int status = m_rProj.Helical180LI (m_rvecViews[i], slice, 1);
+      if (status == 0)
+        status = slice.HalfScanFeather (1);
+      if (status == 0) {
+        std::string strVolume, strEntry;
+        if (m_pVolume && VolumeFile::splitEntryPath (m_rvecFilenames[i].c_str(), strVolume, strEntry)) {
+          if (! m_pVolume->writeProjections (strEntry.c_str(), slice))
+            status = 1;
+        } else if (! slice.write (m_rvecFilenames[i].c_str()))
+          status = 1;
+      }
+      m_rvecStatus[i] = status;
+    }
+  }
+};
+
+
 void pjHinterp_usage ( const char *program )
 {
   std::cout << "usage: " << fileBasename(program) << " projection-file interp-projection-file [OPTIONS]" << std::endl;
   std::cout << "Interpolation of helical data in raw data space" << std::endl;
   std::cout << "  projection-file Input projection file" << std::endl;
   std::cout << "  interp-file     Output interpolated projection file " << std::endl;
+  std::cout << "  --interpview n  View at the plane to interpolate" << std::endl;
+  std::cout << "  --interpviews list  Views of several planes, interpolated in one pass" << std::endl;
+  std::cout << "                  list of n, first-last or first-last:step separated by commas" << std::endl;
+  std::cout << "                  Each plane is written to interp-file with .view inserted" << std::endl;
+  std::cout << "                  before the extension" << std::endl;
+  std::cout << "  --threads n     Number of threads, 0 for all processors (default = 0)" << std::endl;
   std::cout << "  --trace         Set tracing to level" << std::endl;
   std::cout << "     none         No tracing (default)" << std::endl;
   std::cout << "     console      Text level tracing" << std::endl;
@@ -70,6 +183,8 @@ pjHinterp_main(int argc, char * const argv[])
   char *endptr = NULL;
   char *endstr;
   int opt_interpview=-1;
+  std::vector<int> vecInterpViews;
+  int iOptThreads = 0;
 
   while (1) {
     int c = getopt_long(argc, argv, "", my_options, NULL);
@@ -87,6 +202,21 @@ pjHinterp_main(int argc, char * const argv[])
         return(1);
       }
       break;
+    case O_INTERPVIEWS:
+      if (! parseInterpViews (optarg, vecInterpViews)) {
+        std::cerr << "Error setting --interpviews to " << optarg << std::endl;
+        pjHinterp_usage(argv[0]);
+        return(1);
+      }
+      break;
+    case O_THREADS:
+      iOptThreads = strtol(optarg, &endptr, 10);
+      if (endptr != optarg + strlen(optarg) || iOptThreads < 0) {
+        std::cerr << "Error setting --threads to " << optarg << std::endl;
+        pjHinterp_usage(argv[0]);
+        return(1);
+      }
+      break;
     case O_VERBOSE:
       bOptVerbose = true;
       break;
@@ -139,9 +269,42 @@ pjHinterp_main(int argc, char * const argv[])
     std::cout << os.str();
   }
 
-  int status = projections.Helical180LI(opt_interpview);
+  if (vecInterpViews.size() > 0) {
+    // The helical data is read once and its weight tables are shared by all planes
+    const int nSlices = vecInterpViews.size();
+    std::vector<std::string> vecFilenames (nSlices);
+    std::vector<int> vecStatus (nSlices, 1);
+    for (int i = 0; i < nSlices; i++)
+      vecFilenames[i] = makeSliceFilename (pszInterpFilename, vecInterpViews[i]);
+
+    VolumeFile volume;
+    std::string strVolume, strEntry;
+    if (VolumeFile::splitEntryPath (pszInterpFilename, strVolume, strEntry)
+        && ! volume.open (strVolume.c_str(), true))
+      return (1);
+
+    WorkerThreads threads (iOptThreads);
+    threads.setTotalWorkUnits (nSlices);
+    HelicalSliceTask task (projections, vecInterpViews, vecFilenames, vecStatus,
+                           volume.isOpen() ? &volume : NULL);
+    threads.run (task);
+
+    int retval = 0;
+    if (volume.isOpen() && ! volume.close())
+      retval = 1;
+    for (int i = 0; i < nSlices; i++) {
+      if (vecStatus[i] != 0) {
+        std::cerr << "Error interpolating view " << vecInterpViews[i] << std::endl;
+        retval = 1;
+      } else if (bOptVerbose)
+        std::cout << "Wrote " << vecFilenames[i] << std::endl;
+    }
+    return (retval);
+  }
+
+  int status = projections.Helical180LI(opt_interpview, iOptThreads);
   if ( status != 0 )  return (1);
-  status = projections.HalfScanFeather();
+  status = projections.HalfScanFeather(iOptThreads);
   if ( status != 0 )  return (1);
   projections.write( pszInterpFilename  );
 
@@ -55,6 +55,7 @@ pjinfo_usage (const char *program)
 {
   std::cout << "usage: " << fileBasename(program) << " proj-file [OPTIONS]\n";
   std::cout << "Display projection file information\n";
+  std::cout << "A volume file name without an entry lists the entries of the volume\n";
   std::cout << "\n";
   std::cout << "   --binaryheader  Dump binary header data\n";
   std::cout << "   --binaryviews   Dump binary view data\n";
@@ -138,13 +139,24 @@ pjinfo_main (const int argc, char *const argv[])
 
   pj_name = argv[optind];
 
+  // a volume without an entry name lists its entries
+  std::string strVolume, strEntry;
+  if (VolumeFile::splitEntryPath (pj_name.c_str(), strVolume, strEntry) && strEntry.empty()) {
+    VolumeFile volume;
+    if (! volume.open (strVolume.c_str()))
+      return (1);
+    volume.printEntries (std::cout);
+    return (0);
+  }
+
   if (optBinaryHeader)
     Projections::copyHeader (pj_name, std::cout);
   else if (optBinaryViews)
     Projections::copyViewData (pj_name, std::cout, optStartView, optEndView);
   else {
+    // views are only decoded when they are printed
     Projections pj;
-    if (! pj.read (pj_name)) {
+    if (! pj.readMapped (pj_name, 16)) {
       sys_error (ERR_SEVERE, "Can not open projection file %s", pj_name.c_str());
       return (1);
     }
@@ -26,10 +26,20 @@
 #include "ct.h"
 #include "timer.h"
 
-enum {O_INTERP, O_FILTER, O_FILTER_METHOD, O_ZEROPAD, O_FILTER_PARAM, O_FILTER_GENERATION, O_BACKPROJ, O_PREINTERPOLATION_FACTOR, O_VERBOSE, O_TRACE, O_HELP, O_DEBUG, O_VERSION};
+enum {O_METHOD, O_ITERATIONS, O_SUBSETS, O_RELAXATION, O_THREADS, O_SYSTEM_MATRIX, O_MATRIX_CACHE, O_MATRIX_LIMIT, O_INTERP, O_FILTER, O_FILTER_METHOD, O_ZEROPAD, O_FILTER_PARAM, O_FILTER_GENERATION, O_BACKPROJ, O_REBIN_PARALLEL, O_MMAP, O_MMAP_CACHE, O_QUEUE_VIEWS, O_CHECKPOINT, O_RESUME, O_READ_VIEWS, O_DECOMP, O_COMPRESS, O_PREINTERPOLATION_FACTOR, O_VERBOSE, O_TRACE, O_HELP, O_DEBUG, O_VERSION};
 
 static struct option my_options[] =
 {
+  {"method", 1, 0, O_METHOD},
+  {"iterations", 1, 0, O_ITERATIONS},
+  {"subsets", 1, 0, O_SUBSETS},
+  {"relaxation", 1, 0, O_RELAXATION},
+  {"threads", 1, 0, O_THREADS},
+#ifndef HAVE_MPI
+  {"system-matrix", 0, 0, O_SYSTEM_MATRIX},
+  {"matrix-cache", 1, 0, O_MATRIX_CACHE},
+  {"matrix-limit", 1, 0, O_MATRIX_LIMIT},
+#endif
   {"interp", 1, 0, O_INTERP},
   {"preinterpolation-factor", 1, 0, O_PREINTERPOLATION_FACTOR},
   {"filter", 1, 0, O_FILTER},
@@ -38,6 +48,17 @@ static struct option my_options[] =
   {"filter-generation", 1, 0, O_FILTER_GENERATION},
   {"filter-param", 1, 0, O_FILTER_PARAM},
   {"backproj", 1, 0, O_BACKPROJ},
+  {"rebin-parallel", 0, 0, O_REBIN_PARALLEL},
+  {"mmap", 0, 0, O_MMAP},
+  {"mmap-cache", 1, 0, O_MMAP_CACHE},
+  {"queue-views", 1, 0, O_QUEUE_VIEWS},
+  {"checkpoint", 1, 0, O_CHECKPOINT},
+  {"resume", 0, 0, O_RESUME},
+#ifdef HAVE_MPI
+  {"read-views", 1, 0, O_READ_VIEWS},
+  {"decomp", 1, 0, O_DECOMP},
+#endif
+  {"compress", 1, 0, O_COMPRESS},
   {"trace", 1, 0, O_TRACE},
   {"debug", 0, 0, O_DEBUG},
   {"verbose", 0, 0, O_VERBOSE},
@@ -58,6 +79,21 @@ pjrec_usage (const char *program)
   std::cout << "  image-file      Output image file in SDF2D format" << std::endl;
   std::cout << "  nx-image        Number of columns in output image" << std::endl;
   std::cout << "  ny-image        Number of rows in output image" << std::endl;
+  std::cout << "  --method        Reconstruction method" << std::endl;
+  std::cout << "    fbp             Filtered backprojection (default)" << std::endl;
+  std::cout << "    sart            Simultaneous algebraic reconstruction, one view per update" << std::endl;
+  std::cout << "    os-sart         SART with ordered subsets of views" << std::endl;
+  std::cout << "    os-em           Expectation maximization with ordered subsets of views" << std::endl;
+  std::cout << "  --iterations n  Number of iterations for iterative methods (default = 10)" << std::endl;
+  std::cout << "  --subsets n     Number of ordered subsets for os-sart and os-em (default = 10)" << std::endl;
+  std::cout << "  --relaxation r  Relaxation factor for sart and os-sart (default = 1)" << std::endl;
+  std::cout << "  --threads n     Number of threads for iterative methods, and for each MPI process, 0 for all" << std::endl;
+  std::cout << "                  processors (default = 1)" << std::endl;
+#ifndef HAVE_MPI
+  std::cout << "  --system-matrix Precompute the sparse system matrix for iterative methods" << std::endl;
+  std::cout << "  --matrix-cache dir  Directory to keep system matrices between runs" << std::endl;
+  std::cout << "  --matrix-limit mb   Largest system matrix to build in megabytes, 0 for no limit (default = 1024)" << std::endl;
+#endif
   std::cout << "  --interp        Interpolation method during backprojection" << std::endl;
   std::cout << "    nearest         Nearest neighbor interpolation" << std::endl;
   std::cout << "    linear          Linear interpolation (default)" << std::endl;
@@ -99,6 +135,33 @@ pjrec_usage (const char *program)
   std::cout << "    table       Trigometric functions with precalculated table" << std::endl;
   std::cout << "    diff        Difference method" << std::endl;
   std::cout << "    idiff       Difference method with integer math [default]" << std::endl;
+  std::cout << "    matrix      Transpose of the sparse system matrix, parallel geometry only" << std::endl;
+  std::cout << "  --rebin-parallel Rebin divergent beam projections to parallel before backprojection" << std::endl;
+#ifndef HAVE_MPI
+  std::cout << "  --mmap         Map the raysum file and read views as they are reconstructed" << std::endl;
+  std::cout << "  --mmap-cache n Keep at most n decoded views of a mapped file, 0 for no limit (default = 0)" << std::endl;
+  std::cout << "                 Limited caches need filtered backprojection without rebinning" << std::endl;
+#endif
+  std::cout << "  --queue-views n Views held between the threads reading, filtering and backprojecting" << std::endl;
+  std::cout << "                 a file for filtered backprojection without rebinning (default = 16)" << std::endl;
+#ifndef HAVE_MPI
+  std::cout << "  --checkpoint n Write the partial image to outfile.ckpt every n views, for filtered" << std::endl;
+  std::cout << "                 backprojection (default = 0, no checkpoints)" << std::endl;
+  std::cout << "  --resume       Continue from the checkpoint outfile.ckpt when there is one" << std::endl;
+#endif
+#ifdef HAVE_MPI
+  std::cout << "  --read-views   How MPI processes read their views of the raysum file" << std::endl;
+  std::cout << "    mpiio       Collective MPI-IO reads by every process [default]" << std::endl;
+  std::cout << "    pread       Independent reads by every process, for a shared file system" << std::endl;
+  std::cout << "    root        The first process reads the file and scatters the views" << std::endl;
+  std::cout << "  --decomp       How MPI processes divide the reconstruction" << std::endl;
+  std::cout << "    view        Each process backprojects its views into a whole image [default]" << std::endl;
+  std::cout << "    image       Each process backprojects all views into a stripe of the image" << std::endl;
+#endif
+  std::cout << "  --compress     Compression of the image file" << std::endl;
+  std::cout << "    none        Plain image file [default]" << std::endl;
+  std::cout << "    deflate     Lossless" << std::endl;
+  std::cout << "    float16     Half precision pixels, lossy" << std::endl;
   std::cout << "  --filter-param Alpha level for Hamming filter" << std::endl;
   std::cout << "  --trace        Set tracing to level" << std::endl;
   std::cout << "     none        No tracing (default)" << std::endl;
@@ -111,8 +174,73 @@ pjrec_usage (const char *program)
 
 
 #ifdef HAVE_MPI
+// How the MPI processes read their views of the raysum file
+enum {READ_VIEWS_MPIIO, READ_VIEWS_PREAD, READ_VIEWS_ROOT};
+// How the MPI processes divide the reconstruction
+enum {DECOMP_VIEW, DECOMP_IMAGE};
+
 static void ScatterProjectionsMPI (MPIWorld& mpiWorld, Projections& projGlobal, Projections& projLocal, const bool bDebug);
+static bool ReadViewRangeMPI (MPIWorld& mpiWorld, const std::string& strFile, int iReadViews,
+                              kuint64 offsetBegin, kuint64 offsetEnd, Projections& projLocal);
 static void ReduceImageMPI (MPIWorld& mpiWorld, ImageFile* imLocal, ImageFile* imGlobal);
+static void GatherImageMPI (MPIWorld& mpiWorld, ImageFile* imLocal, ImageFile* imGlobal);
+
+// Each thread backprojects into its own stripe of the columns of an image
+// with its own reconstructor, and every view is filtered once. Views are
+// taken in blocks: the threads filter the views of a block between them,
+// each with the reconstructor of its stripe, and then each backprojects
+// the whole block into its stripe. The reconstructors are made before the
+// threads start, as making a filter may plan FFTs, which is not thread safe.
+class StripeReconstructTask : public WorkerThreadTask {
+private:
+  std::vector<Reconstructor*>& m_rvecReconstructor;
+  const int m_nFilteredProjections;
+  std::vector<double> m_vecFilteredProj;    // filtered views of the block, one after another
+  std::vector<double> m_vecViewAngle;
+  int m_iBlockStartView;
+  int m_nBlockViews;
+  bool m_bFilter;
+
+public:
+  static const int s_nBlockViews = 64;
+
+  StripeReconstructTask (std::vector<Reconstructor*>& rvecReconstructor)
+    : m_rvecReconstructor(rvecReconstructor), m_nFilteredProjections(rvecReconstructor[0]->nFilteredProjections()),
+      m_vecFilteredProj(s_nBlockViews * m_nFilteredProjections), m_vecViewAngle(s_nBlockViews),
+      m_iBlockStartView(0), m_nBlockViews(0), m_bFilter(false)
+  {}
+
+  // Threads must have a reconstructor each, and nViews be at most s_nBlockViews
+  bool filterViews (WorkerThreads& threads, int iStartView, int nViews)
+  {
+    m_iBlockStartView = iStartView;
+    m_nBlockViews = nViews;
+    m_bFilter = true;
+    threads.setTotalWorkUnits (nViews);
+    return threads.run (*this);
+  }
+
+  bool backprojectViews (WorkerThreads& threads, int nColumns)
+  {
+    m_bFilter = false;
+    threads.setTotalWorkUnits (nColumns);
+    return threads.run (*this);
+  }
+
+  virtual void doWorkUnits (int iThread, int iStartUnit, int iNumUnits)
+  {
+    Reconstructor* pReconstructor = m_rvecReconstructor[iThread];
+    if (m_bFilter) {
+      for (int iView = iStartUnit; iView < iStartUnit + iNumUnits; iView++)
+        m_vecViewAngle[iView] = pReconstructor->filterView (m_iBlockStartView + iView, &m_vecFilteredProj[iView * m_nFilteredProjections]);
+    } else {
+      for (int iView = 0; iView < m_nBlockViews; iView++)
+        pReconstructor->backprojectFilteredView (&m_vecFilteredProj[iView * m_nFilteredProjections], m_vecViewAngle[iView]);
+    }
+  }
+};
+
+const int StripeReconstructTask::s_nBlockViews;
 #endif
 
 
@@ -135,12 +263,28 @@ pjrec_main (int argc, char * const argv[])
   std::string sOptInterpName (Backprojector::convertInterpIDToName (Backprojector::INTERP_LINEAR));
   std::string sOptBackprojectName (Backprojector::convertBackprojectIDToName (Backprojector::BPROJ_IDIFF));
   int iOptPreinterpolationFactor = 1;
+  int iOptMethod = Reconstructor::METHOD_FBP;
+  int iOptIterations = 10;
+  int iOptSubsets = 10;
+  double dOptRelaxation = 1.;
+  int iOptThreads = 1;
+#ifndef HAVE_MPI
+  bool bOptSystemMatrix = false;
+#endif
+  bool bOptRebinParallel = false;
+  bool bOptMmap = false;
+  int iOptMmapCache = 0;
+  int iOptQueueViews = 16;
+  int iOptCheckpointViews = 0;
+  bool bOptResume = false;
+  int iOptCompression = ArrayCodec::CODEC_NONE;
   int nx, ny;
   char *endptr;
 #ifdef HAVE_MPI
   ImageFile* imLocal;
-  int mpi_nview, mpi_ndet;
-  double mpi_detinc, mpi_rotinc, mpi_phmlen;
+  int mpi_nview;
+  int iOptReadViews = READ_VIEWS_MPIIO;
+  int iOptDecomp = DECOMP_VIEW;
   MPIWorld mpiWorld (argc, argv);
 #endif
 
@@ -158,6 +302,59 @@ pjrec_main (int argc, char * const argv[])
 
       switch (c)
         {
+        case O_METHOD:
+          if ((iOptMethod = Reconstructor::convertMethodNameToID (optarg)) == Reconstructor::METHOD_INVALID) {
+            std::cerr << "Invalid reconstruction method " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+        case O_ITERATIONS:
+          iOptIterations = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptIterations < 1) {
+            pjrec_usage(argv[0]);
+            return(1);
+          }
+          break;
+        case O_SUBSETS:
+          iOptSubsets = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptSubsets < 1) {
+            pjrec_usage(argv[0]);
+            return(1);
+          }
+          break;
+        case O_RELAXATION:
+          dOptRelaxation = strtod(optarg, &endptr);
+          if (endptr != optarg + strlen(optarg) || dOptRelaxation <= 0) {
+            pjrec_usage(argv[0]);
+            return(1);
+          }
+          break;
+        case O_THREADS:
+          iOptThreads = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptThreads < 0) {
+            pjrec_usage(argv[0]);
+            return(1);
+          }
+          break;
+#ifndef HAVE_MPI
+        case O_SYSTEM_MATRIX:
+          bOptSystemMatrix = true;
+          break;
+        case O_MATRIX_CACHE:
+          SystemMatrix::setDefaultCacheDirectory (optarg);
+          bOptSystemMatrix = true;
+          break;
+        case O_MATRIX_LIMIT: {
+          double dLimit = strtod(optarg, &endptr);
+          if (endptr != optarg + strlen(optarg) || dLimit < 0) {
+            pjrec_usage(argv[0]);
+            return(1);
+          }
+          SystemMatrix::setDefaultMemoryLimitMB (dLimit);
+          break;
+        }
+#endif
         case O_INTERP:
           sOptInterpName = optarg;
           break;
@@ -194,6 +391,74 @@ pjrec_main (int argc, char * const argv[])
         case O_BACKPROJ:
           sOptBackprojectName = optarg;
           break;
+        case O_REBIN_PARALLEL:
+          bOptRebinParallel = true;
+          break;
+        case O_MMAP:
+          bOptMmap = true;
+          break;
+        case O_MMAP_CACHE:
+          bOptMmap = true;
+          iOptMmapCache = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptMmapCache < 0) {
+            std::cerr << "Error setting --mmap-cache to " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+        case O_QUEUE_VIEWS:
+          iOptQueueViews = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptQueueViews < 1) {
+            std::cerr << "Error setting --queue-views to " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+        case O_CHECKPOINT:
+          iOptCheckpointViews = strtol(optarg, &endptr, 10);
+          if (endptr != optarg + strlen(optarg) || iOptCheckpointViews < 0) {
+            std::cerr << "Error setting --checkpoint to " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+        case O_RESUME:
+          bOptResume = true;
+          break;
+#ifdef HAVE_MPI
+        case O_READ_VIEWS:
+          if (strcmp (optarg, "mpiio") == 0)
+            iOptReadViews = READ_VIEWS_MPIIO;
+          else if (strcmp (optarg, "pread") == 0)
+            iOptReadViews = READ_VIEWS_PREAD;
+          else if (strcmp (optarg, "root") == 0)
+            iOptReadViews = READ_VIEWS_ROOT;
+          else {
+            std::cerr << "Invalid --read-views " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+        case O_DECOMP:
+          if (strcmp (optarg, "view") == 0)
+            iOptDecomp = DECOMP_VIEW;
+          else if (strcmp (optarg, "image") == 0)
+            iOptDecomp = DECOMP_IMAGE;
+          else {
+            std::cerr << "Invalid --decomp " << optarg << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
+#endif
+        case O_COMPRESS:
+          iOptCompression = ArrayCodec::convertCodecNameToID (optarg);
+          if (! ArrayCodec::isAvailable (iOptCompression)) {
+            std::cerr << "Compression " << optarg << " is not available" << std::endl;
+            pjrec_usage(argv[0]);
+            return (1);
+          }
+          break;
         case O_VERBOSE:
           bOptVerbose = true;
           break;
@@ -242,7 +507,11 @@ pjrec_main (int argc, char * const argv[])
       filterDesc << sOptFilterName;
 
     std::ostringstream label;
-    label << "pjrec: " << nx << "x" << ny << ", " << filterDesc.str() << ", " << sOptInterpName << ", preinterpolationFactor=" << iOptPreinterpolationFactor << ", " << sOptBackprojectName;
+    if (iOptMethod == Reconstructor::METHOD_FBP)
+      label << "pjrec: " << nx << "x" << ny << ", " << filterDesc.str() << ", " << sOptInterpName << ", preinterpolationFactor=" << iOptPreinterpolationFactor << ", " << sOptBackprojectName
+            << (bOptRebinParallel ? ", rebin-parallel" : "");
+    else
+      label << "pjrec: " << nx << "x" << ny << ", " << Reconstructor::convertMethodIDToName (iOptMethod) << ", iterations=" << iOptIterations << ", subsets=" << iOptSubsets << ", relaxation=" << dOptRelaxation;
     sRemark = label.str();
 
     if (bOptVerbose)
@@ -252,62 +521,226 @@ pjrec_main (int argc, char * const argv[])
 #endif
 
 #ifdef HAVE_MPI
+  // only the first process parsed the options, so options that are not
+  // distributed are broadcast before every process checks them
+  mpiWorld.getComm().Bcast (&iOptMethod, 1, MPI::INT, 0);
+  if (iOptMethod != Reconstructor::METHOD_FBP) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "Iterative reconstruction is not distributed with MPI, use --threads" << std::endl;
+    MPI::Finalize();
+    return (1);
+  }
+  int bRebinParallel = bOptRebinParallel;
+  mpiWorld.getComm().Bcast (&bRebinParallel, 1, MPI::INT, 0);
+  if (bRebinParallel) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "Rebinning to parallel is not distributed with MPI" << std::endl;
+    MPI::Finalize();
+    return (1);
+  }
+  int bMmap = bOptMmap;
+  mpiWorld.getComm().Bcast (&bMmap, 1, MPI::INT, 0);
+  if (bMmap) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "Mapped raysum files are not distributed with MPI" << std::endl;
+    MPI::Finalize();
+    return (1);
+  }
+  int bCheckpoint = iOptCheckpointViews > 0 || bOptResume;
+  mpiWorld.getComm().Bcast (&bCheckpoint, 1, MPI::INT, 0);
+  if (bCheckpoint) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "--checkpoint and --resume are not available with MPI" << std::endl;
+    MPI::Finalize();
+    return (1);
+  }
+
+  // Only the header is read by the first process and broadcast, each
+  // process then reads the records of its own views, unless the views
+  // come through a pipe
+  std::string strFilenameProj;
+  std::string strViewFile;      // file holding the view records
+  kuint64 offsetDataset = 0;    // start of the dataset in strViewFile
+  int bReadOk = 1;
   if (mpiWorld.getRank() == 0) {
-    projGlobal.read (pszFilenameProj);
-    if (bOptVerbose) {
+    if (fnetorderstream::isStandardStream (pszFilenameProj))
+      iOptReadViews = READ_VIEWS_ROOT;
+    strFilenameProj = pszFilenameProj;
+    strViewFile = pszFilenameProj;
+    if (iOptReadViews == READ_VIEWS_ROOT)
+      bReadOk = projGlobal.read (pszFilenameProj);
+    else {
+      bReadOk = (! VolumeFile::isEntryPath (pszFilenameProj) || VolumeFile::locateEntry (pszFilenameProj, strViewFile, offsetDataset))
+        && projGlobal.readViewsBegin (pszFilenameProj, false);
+      projGlobal.readViewsEnd ();
+    }
+    if (! bReadOk)
+      fprintf(stderr, "Unable to read projectfile file %s\n", pszFilenameProj);
+    else if (bOptVerbose) {
       ostringstream os;
       projGlobal.printScanInfo (os);
       std::cout << os.str();
     }
-
-    mpi_ndet = projGlobal.nDet();
-    mpi_nview = projGlobal.nView();
-    mpi_detinc = projGlobal.detInc();
-    mpi_phmlen = projGlobal.phmLen();
-    mpi_rotinc = projGlobal.rotInc();
   }
+  mpiWorld.getComm().Bcast (&bReadOk, 1, MPI::INT, 0);
+  if (! bReadOk) {
+    MPI::Finalize();
+    return (1);
+  }
+
+  std::vector<double> vecHeader;
+  projGlobal.getHeaderValues (vecHeader);
 
   TimerCollectiveMPI timerBcast (mpiWorld.getComm());
   mpiWorld.BcastString (sOptBackprojectName);
   mpiWorld.BcastString (sOptFilterName);
   mpiWorld.BcastString (sOptFilterMethodName);
   mpiWorld.BcastString (sOptInterpName);
+  mpiWorld.BcastString (strFilenameProj);
+  mpiWorld.BcastString (strViewFile);
   mpiWorld.getComm().Bcast (&bOptVerbose, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&bOptDebug, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&optTrace, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&dOptFilterParam, 1, MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&iOptZeropad, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&iOptPreinterpolationFactor, 1, MPI::INT, 0);
-  mpiWorld.getComm().Bcast (&mpi_ndet, 1, MPI::INT, 0);
-  mpiWorld.getComm().Bcast (&mpi_nview, 1, MPI::INT, 0);
-  mpiWorld.getComm().Bcast (&mpi_detinc, 1, MPI::DOUBLE, 0);
-  mpiWorld.getComm().Bcast (&mpi_phmlen, 1, MPI::DOUBLE, 0);
-  mpiWorld.getComm().Bcast (&mpi_rotinc, 1, MPI::DOUBLE, 0);
+  mpiWorld.getComm().Bcast (&iOptReadViews, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&iOptDecomp, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&iOptQueueViews, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&iOptThreads, 1, MPI::INT, 0);
+  mpiWorld.getComm().Bcast (&vecHeader[0], vecHeader.size(), MPI::DOUBLE, 0);
   mpiWorld.getComm().Bcast (&nx, 1, MPI::INT, 0);
   mpiWorld.getComm().Bcast (&ny, 1, MPI::INT, 0);
   if (bOptVerbose)
       timerBcast.timerEndAndReport ("Time to broadcast variables");
 
-  mpiWorld.setTotalWorkUnits (mpi_nview);
+  // Each process either backprojects its own views into a whole image,
+  // and the images are summed, or backprojects all views into its own
+  // stripe of image columns, and the stripes are gathered. Image stripes
+  // need less memory per process and communication as processes are added,
+  // at the cost of every process reading and filtering every view.
+  const bool bDecompImage = iOptDecomp == DECOMP_IMAGE;
+  Projections projLocal;
+  projLocal.setHeaderValues (vecHeader);
+  mpi_nview = projLocal.nView();
+  mpiWorld.setTotalWorkUnits (bDecompImage ? nx : mpi_nview);
 
-  Projections projLocal (mpiWorld.getMyLocalWorkUnits(), mpi_ndet);
-  projLocal.setDetInc (mpi_detinc);
-  projLocal.setPhmLen (mpi_phmlen);
-  projLocal.setRotInc (mpi_rotinc);
+  // with threads, each thread backprojects a stripe of this process's
+  // columns, and only one image is held per process
+  if (iOptThreads != 1 && ! mpiWorld.threadsSupported()) {
+    if (mpiWorld.getRank() == 0)
+      std::cerr << "MPI library does not support threads, using --threads 1" << std::endl;
+    iOptThreads = 1;
+  }
+  WorkerThreads threads (iOptThreads);
 
-  TimerCollectiveMPI timerScatter (mpiWorld.getComm());
-  ScatterProjectionsMPI (mpiWorld, projGlobal, projLocal, bOptDebug);
-  if (bOptVerbose)
-      timerScatter.timerEndAndReport ("Time to scatter projections");
+  // image stripes stream the views of a file through the reconstruction
+  const bool bStreamViews = bDecompImage && iOptReadViews != READ_VIEWS_ROOT && sOptBackprojectName != "matrix"
+    && threads.getNumThreads() == 1;
+  Projections& projViews = bDecompImage && iOptReadViews == READ_VIEWS_ROOT && mpiWorld.getRank() == 0 ? projGlobal : projLocal;
+  if (! bDecompImage) {
+    projLocal.setNView (mpiWorld.getMyLocalWorkUnits());
+    if (iOptReadViews == READ_VIEWS_ROOT) {
+      TimerCollectiveMPI timerScatter (mpiWorld.getComm());
+      ScatterProjectionsMPI (mpiWorld, projGlobal, projLocal, bOptDebug);
+      if (bOptVerbose)
+        timerScatter.timerEndAndReport ("Time to scatter projections");
+    } else {
+      TimerCollectiveMPI timerRead (mpiWorld.getComm());
+      // the first and end byte of the view records of each process
+      const int nProc = mpiWorld.getNumProcessors();
+      std::vector<kuint64> vecRange (2 * nProc);
+      if (mpiWorld.getRank() == 0)
+        for (int iProc = 0; iProc < nProc; iProc++) {
+          const int iStartView = mpiWorld.getStartWorkUnit (iProc);
+          vecRange[2 * iProc] = offsetDataset + projGlobal.viewRecordOffset (iStartView);
+          vecRange[2 * iProc + 1] = offsetDataset + projGlobal.viewRecordOffset (iStartView + mpiWorld.getLocalWorkUnits (iProc));
+        }
+      kuint64 range[2];
+      mpiWorld.getComm().Scatter (&vecRange[0], sizeof(range), MPI::BYTE, range, sizeof(range), MPI::BYTE, 0);
+      if (! ReadViewRangeMPI (mpiWorld, strViewFile, iOptReadViews, range[0], range[1], projLocal)) {
+        if (mpiWorld.getRank() == 0)
+          fprintf(stderr, "Unable to read projectfile file %s\n", pszFilenameProj);
+        MPI::Finalize();
+        return (1);
+      }
+      if (bOptVerbose)
+        timerRead.timerEndAndReport ("Time to read projections");
+    }
+  } else if (iOptReadViews == READ_VIEWS_ROOT) {
+    TimerCollectiveMPI timerBcastViews (mpiWorld.getComm());
+    if (mpiWorld.getRank() > 0)
+      projLocal.setNView (mpi_nview);
+    mpiWorld.getComm().Bcast (projViews.getViewAngles(), mpi_nview, MPI::DOUBLE, 0);
+    mpiWorld.getComm().Bcast (projViews.getSinogram(), mpi_nview * projViews.nDet(), MPI::FLOAT, 0);
+    if (bOptVerbose)
+      timerBcastViews.timerEndAndReport ("Time to broadcast projections");
+  } else {
+    int bLocalReadOk = bStreamViews ? projLocal.readViewsBegin (strFilenameProj.c_str(), false) : projLocal.read (strFilenameProj.c_str());
+    mpiWorld.getComm().Allreduce (&bLocalReadOk, &bReadOk, 1, MPI::INT, MPI::MIN);
+    if (! bReadOk) {
+      if (mpiWorld.getRank() == 0)
+        fprintf(stderr, "Unable to read projectfile file %s\n", pszFilenameProj);
+      MPI::Finalize();
+      return (1);
+    }
+  }
 
   if (mpiWorld.getRank() == 0) {
     imGlobal = new ImageFile (nx, ny);
   }
 
-  imLocal = new ImageFile (nx, ny);
+  const int nLocalColumns = bDecompImage ? mpiWorld.getMyLocalWorkUnits() : nx;
+  imLocal = new ImageFile (nLocalColumns, ny);
+  // the stripe of columns of this process
+  ReconstructionROI roiLocal;
+  const double dColumnWidth = projLocal.phmLen() / nx;
+  const int iFirstColumn = bDecompImage ? mpiWorld.getMyStartWorkUnit() : 0;
+  roiLocal.m_dXMin = -projLocal.phmLen() / 2 + iFirstColumn * dColumnWidth;
+  roiLocal.m_dXMax = roiLocal.m_dXMin + nLocalColumns * dColumnWidth;
+  roiLocal.m_dYMin = -projLocal.phmLen() / 2;
+  roiLocal.m_dYMax = projLocal.phmLen() / 2;
+
+  if (bOptVerbose && mpiWorld.getRank() == 0) {
+    const int nProc = mpiWorld.getNumProcessors();
+    const double dImageMB = static_cast<double>(nx) * ny * sizeof(ImageFileValue) / (1024. * 1024.);
+    if (bDecompImage)
+      std::cout << "Image decomposition: " << nProc << " processes, " << mpiWorld.getLocalWorkUnits (0) << " of " << nx
+                << " columns and " << dImageMB * mpiWorld.getLocalWorkUnits (0) / nx << " MB of image per process, "
+                << dImageMB << " MB gathered" << std::endl;
+    else
+      std::cout << "View decomposition: " << nProc << " processes, " << mpiWorld.getLocalWorkUnits (0) << " of " << mpi_nview
+                << " views and " << dImageMB << " MB of image per process, " << dImageMB * nProc << " MB reduced" << std::endl;
+    if (threads.getNumThreads() > 1)
+      std::cout << "Backprojecting with " << threads.getNumThreads() << " threads per process" << std::endl;
+  }
 #else
 
-  if (! projGlobal.read (pszFilenameProj)) {
+  // the checkpoint of a partial image is named after the image file
+  const std::string strCheckpoint = std::string (pszFilenameImage) + ".ckpt";
+  if ((iOptCheckpointViews > 0 || bOptResume)
+      && (iOptMethod != Reconstructor::METHOD_FBP || sOptBackprojectName == "matrix" || fnetorderstream::isStandardStream (pszFilenameImage))) {
+    std::cerr << "--checkpoint and --resume need filtered backprojection, not the matrix backprojector, to an image file" << std::endl;
+    return (1);
+  }
+
+  if (bOptMmap && iOptMmapCache > 0
+      && (iOptMethod != Reconstructor::METHOD_FBP || bOptRebinParallel || sOptBackprojectName == "matrix")) {
+    std::cerr << "--mmap-cache needs filtered backprojection without rebinning, use --mmap-cache 0" << std::endl;
+    return (1);
+  }
+
+  // filtered backprojection uses each view once, in order, so views are
+  // reconstructed as they are read, while a pipe is still delivering the
+  // rest, and only the views in the queues are held
+  const bool bStreamViews = ! bOptMmap && iOptMethod == Reconstructor::METHOD_FBP
+    && ! bOptRebinParallel && sOptBackprojectName != "matrix";
+  bool bReadOk;
+  if (bStreamViews)
+    bReadOk = projGlobal.readViewsBegin (pszFilenameProj, false);
+  else
+    bReadOk = bOptMmap ? projGlobal.readMapped (pszFilenameProj, iOptMmapCache) : projGlobal.read (pszFilenameProj);
+  if (! bReadOk) {
     fprintf(stderr, "Unable to read projectfile file %s\n", pszFilenameProj);
     exit(1);
   }
@@ -324,27 +757,145 @@ pjrec_main (int argc, char * const argv[])
 #ifdef HAVE_MPI
   TimerCollectiveMPI timerReconstruct (mpiWorld.getComm());
 
-  Reconstructor reconstruct (projLocal, *imLocal, sOptFilterName.c_str(), dOptFilterParam, sOptFilterMethodName.c_str(), iOptZeropad, sOptFilterGenerationName.c_str(), sOptInterpName.c_str(), iOptPreinterpolationFactor, sOptBackprojectName.c_str(), optTrace);
-  if (reconstruct.fail()) {
-    std::cout << reconstruct.failMessage();
+  int bReconstructOk = 1;
+  if (nLocalColumns > 0 && threads.getNumThreads() > 1) {
+    // every thread has a stripe, so every thread can filter
+    WorkerThreads stripeThreads (std::min (threads.getNumThreads(), nLocalColumns));
+    stripeThreads.setTotalWorkUnits (nLocalColumns);
+    const int nStripes = stripeThreads.getNumThreads();
+    std::vector<int> vecStripeStart (nStripes);
+    std::vector<ImageFile*> vecStripe (nStripes, static_cast<ImageFile*>(NULL));
+    std::vector<Reconstructor*> vecReconstructor (nStripes, static_cast<Reconstructor*>(NULL));
+    for (int iStripe = 0; bReconstructOk && iStripe < nStripes; iStripe++) {
+      const int nStripeColumns = stripeThreads.getLocalWorkUnits (iStripe);
+      vecStripeStart[iStripe] = stripeThreads.getStartWorkUnit (iStripe);
+      ReconstructionROI roiStripe = roiLocal;
+      roiStripe.m_dXMin = roiLocal.m_dXMin + vecStripeStart[iStripe] * dColumnWidth;
+      roiStripe.m_dXMax = roiStripe.m_dXMin + nStripeColumns * dColumnWidth;
+      vecStripe[iStripe] = new ImageFile (nStripeColumns, ny);
+      vecReconstructor[iStripe] = new Reconstructor (projViews, *vecStripe[iStripe], sOptFilterName.c_str(), dOptFilterParam, sOptFilterMethodName.c_str(), iOptZeropad, sOptFilterGenerationName.c_str(), sOptInterpName.c_str(), iOptPreinterpolationFactor, sOptBackprojectName.c_str(), Trace::TRACE_NONE, &roiStripe);
+      if (vecReconstructor[iStripe]->fail()) {
+        std::cout << vecReconstructor[iStripe]->failMessage();
+        bReconstructOk = 0;
+      }
+    }
+    if (bReconstructOk) {
+      StripeReconstructTask task (vecReconstructor);
+      for (int iView = 0; iView < projViews.nView(); iView += StripeReconstructTask::s_nBlockViews) {
+        task.filterViews (stripeThreads, iView, std::min (StripeReconstructTask::s_nBlockViews, projViews.nView() - iView));
+        task.backprojectViews (stripeThreads, nLocalColumns);
+      }
+      for (int iStripe = 0; iStripe < nStripes; iStripe++) {
+        vecReconstructor[iStripe]->postProcessing();
+        memcpy (imLocal->getArray()[vecStripeStart[iStripe]], vecStripe[iStripe]->data(), vecStripe[iStripe]->size() * sizeof(ImageFileValue));
+      }
+    }
+    for (int iStripe = 0; iStripe < nStripes; iStripe++) {
+      delete vecReconstructor[iStripe];
+      delete vecStripe[iStripe];
+    }
+  } else if (nLocalColumns > 0) {
+    Reconstructor reconstruct (projViews, *imLocal, sOptFilterName.c_str(), dOptFilterParam, sOptFilterMethodName.c_str(), iOptZeropad, sOptFilterGenerationName.c_str(), sOptInterpName.c_str(), iOptPreinterpolationFactor, sOptBackprojectName.c_str(), optTrace, bDecompImage ? &roiLocal : NULL);
+    if (reconstruct.fail()) {
+      std::cout << reconstruct.failMessage();
+      bReconstructOk = 0;
+    } else if (bStreamViews) {
+      if (! reconstruct.reconstructStreamedViews (projLocal, iOptQueueViews)) {
+        fprintf(stderr, "Unable to read projectfile file %s\n", strFilenameProj.c_str());
+        bReconstructOk = 0;
+      }
+      projLocal.readViewsEnd ();
+    } else
+      reconstruct.reconstructAllViews();
+  }
+
+  // a process that failed leaves a hole in the image, so no process
+  // gathers or writes it
+  mpiWorld.getComm().Allreduce (MPI::IN_PLACE, &bReconstructOk, 1, MPI::INT, MPI::MIN);
+  if (! bReconstructOk) {
+    MPI::Finalize();
     return (1);
   }
-  reconstruct.reconstructAllViews();
+
+  if (! bDecompImage) {
+    // the backprojector scales the image by the rotation of each of this
+    // process's views as if they were the whole scan
+    const int nLocalView = mpiWorld.getMyLocalWorkUnits();
+    if (nLocalView > 0) {
+      const double dScale = static_cast<double>(nLocalView) / mpi_nview;
+      ImageFileValue* pPixel = imLocal->data();
+      for (size_t i = 0; i < imLocal->size(); i++)
+        pPixel[i] *= dScale;
+    } else
+      imLocal->arrayDataClear();
+  }
 
   if (bOptVerbose)
       timerReconstruct.timerEndAndReport ("Time to reconstruct");
 
-  TimerCollectiveMPI timerReduce (mpiWorld.getComm());
-  ReduceImageMPI (mpiWorld, imLocal, imGlobal);
-  if (bOptVerbose)
+  if (bDecompImage) {
+    TimerCollectiveMPI timerGather (mpiWorld.getComm());
+    GatherImageMPI (mpiWorld, imLocal, imGlobal);
+    if (bOptVerbose)
+      timerGather.timerEndAndReport ("Time to gather image");
+  } else {
+    TimerCollectiveMPI timerReduce (mpiWorld.getComm());
+    ReduceImageMPI (mpiWorld, imLocal, imGlobal);
+    if (bOptVerbose)
       timerReduce.timerEndAndReport ("Time to reduce image");
+  }
 #else
-  Reconstructor reconstruct (projGlobal, *imGlobal, sOptFilterName.c_str(), dOptFilterParam, sOptFilterMethodName.c_str(), iOptZeropad, sOptFilterGenerationName.c_str(), sOptInterpName.c_str(), iOptPreinterpolationFactor, sOptBackprojectName.c_str(), optTrace);
-  if (reconstruct.fail()) {
-    std::cout << reconstruct.failMessage();
-    return (1);
+  if (iOptMethod == Reconstructor::METHOD_FBP) {
+    Reconstructor reconstruct (projGlobal, *imGlobal, sOptFilterName.c_str(), dOptFilterParam, sOptFilterMethodName.c_str(), iOptZeropad, sOptFilterGenerationName.c_str(), sOptInterpName.c_str(), iOptPreinterpolationFactor, sOptBackprojectName.c_str(), optTrace, NULL, bOptRebinParallel);
+    if (reconstruct.fail()) {
+      std::cout << reconstruct.failMessage();
+      return (1);
+    }
+    if (iOptCheckpointViews > 0)
+      reconstruct.setCheckpoint (strCheckpoint.c_str(), iOptCheckpointViews);
+    if (bOptResume && std::ifstream (strCheckpoint.c_str())) {
+      if (! reconstruct.resumeCheckpoint (strCheckpoint.c_str()))
+        return (1);
+      if (bOptVerbose)
+        std::cout << "Resuming after view " << reconstruct.nBackprojectedViews() - 1 << std::endl;
+    }
+    if (bStreamViews) {
+      if (! reconstruct.reconstructStreamedViews (projGlobal, iOptQueueViews)) {
+        fprintf(stderr, "Unable to read projectfile file %s\n", pszFilenameProj);
+        return (1);
+      }
+      projGlobal.readViewsEnd ();
+    } else
+      reconstruct.reconstructAllViews();
+  } else {
+    IterativeReconstructor reconstruct (projGlobal, *imGlobal, Reconstructor::convertMethodIDToName (iOptMethod), iOptSubsets, dOptRelaxation, iOptThreads, optTrace);
+    if (reconstruct.fail()) {
+      std::cout << reconstruct.failMessage() << std::endl;
+      return (1);
+    }
+    SystemMatrix* pMatrix = NULL;
+    if (bOptSystemMatrix) {
+      Timer timerMatrix;
+      const double dHalfLength = projGlobal.phmLen() / 2;
+      pMatrix = new SystemMatrix (projGlobal, nx, ny, -dHalfLength, dHalfLength, -dHalfLength, dHalfLength, iOptThreads);
+      if (pMatrix->fail()) {
+        std::cerr << pMatrix->failMessage() << std::endl;
+        delete pMatrix;
+        return (1);
+      }
+      reconstruct.setSystemMatrix (pMatrix);
+      if (bOptVerbose)
+        std::cout << "System matrix: " << pMatrix->nNonZero() << " entries, " << pMatrix->sizeMB() << " MB, "
+                  << (pMatrix->fromCache() ? "read from cache" : "built") << " in " << timerMatrix.timerEnd() << " seconds" << std::endl;
+    }
+    for (int iIteration = 0; iIteration < iOptIterations; iIteration++) {
+      reconstruct.reconstructIteration();
+      if (bOptVerbose && optTrace < Trace::TRACE_CONSOLE)
+        std::cout << "Iteration " << iIteration + 1 << ": residual=" << reconstruct.getIterationResidual (iIteration)
+                  << ", time=" << reconstruct.getIterationTime (iIteration) << " seconds" << std::endl;
+    }
+    delete pMatrix;
   }
-  reconstruct.reconstructAllViews();
 #endif
 
 #ifdef HAVE_MPI
@@ -354,7 +905,12 @@ pjrec_main (int argc, char * const argv[])
       double dCalcTime = timerProgram.timerEnd();
       imGlobal->labelAdd (projGlobal.getLabel());
       imGlobal->labelAdd (Array2dFileLabel::L_HISTORY, sRemark.c_str(), dCalcTime);
+      imGlobal->setCompression (iOptCompression);
       imGlobal->fileWrite (pszFilenameImage);
+#ifndef HAVE_MPI
+      if (iOptCheckpointViews > 0 || bOptResume)
+        remove (strCheckpoint.c_str());
+#endif
       if (bOptVerbose)
         std::cout << "Run time: " << dCalcTime << " seconds" << std::endl;
     }
@@ -374,32 +930,92 @@ pjrec_main (int argc, char * const argv[])
 #ifdef HAVE_MPI
 static void ScatterProjectionsMPI (MPIWorld& mpiWorld, Projections& projGlobal, Projections& projLocal, const bool bOptDebug)
 {
-  if (mpiWorld.getRank() == 0) {
-    for (int iProc = 0; iProc < mpiWorld.getNumProcessors(); iProc++) {
-      for (int iw = mpiWorld.getStartWorkUnit(iProc); iw <= mpiWorld.getEndWorkUnit(iProc); iw++) {
-        DetectorArray& detarray = projGlobal.getDetectorArray( iw );
-        int nDet = detarray.nDet();
-        DetectorValue* detval = detarray.detValues();
-
-        double viewAngle = detarray.viewAngle();
-        mpiWorld.getComm().Send(&nDet, 1, MPI::INT, iProc, 0);
-        mpiWorld.getComm().Send(&viewAngle, 1, MPI::DOUBLE, iProc, 0);
-        mpiWorld.getComm().Send(detval, nDet, MPI::FLOAT, iProc, 0);
+  // The views of a process are contiguous rows of the sinogram, in the
+  // order of the processes, so the sinogram is scattered in place by one
+  // collective and the view angles by a second
+  const int nProc = mpiWorld.getNumProcessors();
+  const int nDet = projLocal.nDet();
+  std::vector<int> vecAngleCount (nProc), vecAngleDispl (nProc), vecValueCount (nProc), vecValueDispl (nProc);
+  for (int iProc = 0; iProc < nProc; iProc++) {
+    vecAngleCount[iProc] = mpiWorld.getLocalWorkUnits (iProc);
+    vecAngleDispl[iProc] = mpiWorld.getStartWorkUnit (iProc);
+    vecValueCount[iProc] = vecAngleCount[iProc] * nDet;
+    vecValueDispl[iProc] = vecAngleDispl[iProc] * nDet;
+  }
+
+  const bool bRoot = mpiWorld.getRank() == 0;
+  const int nLocalView = mpiWorld.getMyLocalWorkUnits();
+  mpiWorld.getComm().Scatterv (bRoot ? projGlobal.getViewAngles() : NULL, &vecAngleCount[0], &vecAngleDispl[0], MPI::DOUBLE,
+                               projLocal.getViewAngles(), nLocalView, MPI::DOUBLE, 0);
+  mpiWorld.getComm().Scatterv (bRoot ? projGlobal.getSinogram() : NULL, &vecValueCount[0], &vecValueDispl[0], MPI::FLOAT,
+                               projLocal.getSinogram(), nLocalView * nDet, MPI::FLOAT, 0);
+
+  if (bOptDebug && bRoot)
+    std::cout << "Scattered " << projGlobal.nView() << " views to " << nProc << " processes" << std::endl;
+}
+
+
+// NAME
+//   ReadViewRangeMPI     Each process reads the records of its own views
+//
+// NOTES
+//   With MPI-IO every process takes part in each collective read, so the
+//   MPI library may merge the requests for a parallel file system. Each
+//   read is at most s_nReadChunkBytes and every process makes as many reads
+//   as the process with the largest range. With pread the processes read
+//   independently, for processes sharing an ordinary file system.
+
+static const kuint64 s_nReadChunkBytes = 1 << 30;
+
+static bool
+ReadViewRangeMPI (MPIWorld& mpiWorld, const std::string& strFile, int iReadViews,
+                  kuint64 offsetBegin, kuint64 offsetEnd, Projections& projLocal)
+{
+  const kuint64 nBytes = offsetEnd - offsetBegin;
+  std::vector<unsigned char> vecRecords (nBytes + 1);
+  int bOk = 1;
+
+  if (iReadViews == READ_VIEWS_MPIIO) {
+    int nLocalReads = static_cast<int>((nBytes + s_nReadChunkBytes - 1) / s_nReadChunkBytes);
+    int nReads;
+    mpiWorld.getComm().Allreduce (&nLocalReads, &nReads, 1, MPI::INT, MPI::MAX);
+    try {
+      MPI::FILE_NULL.Set_errhandler (MPI::ERRORS_THROW_EXCEPTIONS);
+      MPI::File file = MPI::File::Open (mpiWorld.getComm(), strFile.c_str(), MPI::MODE_RDONLY, MPI::INFO_NULL);
+      file.Set_errhandler (MPI::ERRORS_RETURN);
+      for (int iRead = 0; iRead < nReads; iRead++) {
+        const kuint64 iByte = std::min (nBytes, iRead * s_nReadChunkBytes);
+        const int nReadBytes = static_cast<int>(std::min (nBytes - iByte, s_nReadChunkBytes));
+        MPI::Status status;
+        file.Read_at_all (offsetBegin + iByte, &vecRecords[iByte], nReadBytes, MPI::BYTE, status);
+        if (status.Get_count (MPI::BYTE) != nReadBytes)
+          bOk = 0;
       }
+      file.Close();
+    } catch (MPI::Exception& e) {
+      bOk = 0;
+    }
+  } else {
+    const int fd = open (strFile.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0)
+      bOk = 0;
+    for (kuint64 iByte = 0; bOk && iByte < nBytes; ) {
+      const ssize_t nRead = pread (fd, &vecRecords[iByte], std::min (nBytes - iByte, s_nReadChunkBytes), offsetBegin + iByte);
+      if (nRead > 0)
+        iByte += nRead;
+      else if (nRead == 0 || errno != EINTR)
+        bOk = 0;
     }
+    if (fd >= 0)
+      close (fd);
   }
 
-  for (int iw = 0; iw < mpiWorld.getMyLocalWorkUnits(); iw++) {
-    MPI::Status status;
-    int nDet;
-    double viewAngle;
-    DetectorValue* detval = projLocal.getDetectorArray(iw).detValues();
+  if (bOk && ! projLocal.decodeViewRecords (&vecRecords[0], nBytes))
+    bOk = 0;
 
-    mpiWorld.getComm().Recv(&nDet, 1, MPI::INT, 0, 0, status);
-    mpiWorld.getComm().Recv(&viewAngle, 1, MPI::DOUBLE, 0, 0, status);
-    mpiWorld.getComm().Recv(detval, nDet, MPI::FLOAT, 0, 0, status);
-    projLocal.getDetectorArray(iw).setViewAngle( viewAngle );
-  }
+  int bAllOk;
+  mpiWorld.getComm().Allreduce (&bOk, &bAllOk, 1, MPI::INT, MPI::MIN);
+  return bAllOk != 0;
 }
 
 static void
@@ -417,6 +1033,24 @@ ReduceImageMPI (MPIWorld& mpiWorld, ImageFile* imLocal, ImageFile* imGlobal)
   }
 }
 
+static void
+GatherImageMPI (MPIWorld& mpiWorld, ImageFile* imLocal, ImageFile* imGlobal)
+{
+  // The stripes of the processes are contiguous runs of whole columns of
+  // the image array, in the order of the processes
+  const int nProc = mpiWorld.getNumProcessors();
+  const int ny = imLocal->ny();
+  std::vector<int> vecCount (nProc), vecDispl (nProc);
+  for (int iProc = 0; iProc < nProc; iProc++) {
+    vecCount[iProc] = mpiWorld.getLocalWorkUnits (iProc) * ny;
+    vecDispl[iProc] = mpiWorld.getStartWorkUnit (iProc) * ny;
+  }
+
+  mpiWorld.getComm().Gatherv (imLocal->data(), imLocal->size(), imLocal->getMPIDataType(),
+                              mpiWorld.getRank() == 0 ? imGlobal->data() : NULL, &vecCount[0], &vecDispl[0],
+                              imLocal->getMPIDataType(), 0);
+}
+
 #endif
 
 